@@ -0,0 +1,74 @@
+#include "AliasAnalysis/aliasanalysis.hpp"
+
+std::optional<MemoryLocation> AliasAnalysis::GetLocation(Instruction* access) {
+    auto *base = access->GetInputs().empty() ? nullptr : access->GetInputs()[0].GetValue();
+    auto fieldOffset = [](uint32_t field) { return 8 * static_cast<int64_t>(field); };
+
+    MemoryLocation location;
+    switch(access->GetOpType()) {
+        case OpType::LOAD:
+            location = {base, static_cast<LoadInstr*>(access)->GetOffset(), GetAccessSize(access->GetResultType())};
+            break;
+        case OpType::STORE:
+            location = {base, static_cast<StoreInstr*>(access)->GetOffset(),
+                        GetAccessSize(access->GetInputs()[1].GetValue()->GetResultType())};
+            break;
+        case OpType::LOAD_FIELD:
+            location = {base, fieldOffset(static_cast<LoadFieldInstr*>(access)->GetField()), sizeof(uint64_t)};
+            break;
+        case OpType::STORE_FIELD:
+            location = {base, fieldOffset(static_cast<StoreFieldInstr*>(access)->GetField()), sizeof(uint64_t)};
+            break;
+        default:
+            return std::nullopt;
+    }
+    if(location.size == 0) {
+        return std::nullopt;
+    }
+    return location;
+}
+
+AliasResult AliasAnalysis::Alias(const MemoryLocation &lhs, const MemoryLocation &rhs) {
+    if(lhs.base != rhs.base) {
+        if(IsDistinctObject(lhs.base, rhs.base) || IsDistinctObject(rhs.base, lhs.base)) {
+            return AliasResult::NO_ALIAS;
+        }
+        return AliasResult::MAY_ALIAS;
+    }
+
+    if(lhs.offset == rhs.offset && lhs.size == rhs.size) {
+        return AliasResult::MUST_ALIAS;
+    }
+    auto &first = lhs.offset < rhs.offset ? lhs : rhs;
+    auto &second = lhs.offset < rhs.offset ? rhs : lhs;
+    if(static_cast<uint64_t>(second.offset) - static_cast<uint64_t>(first.offset) >= first.size) {
+        return AliasResult::NO_ALIAS;
+    }
+    return AliasResult::MAY_ALIAS;
+}
+
+AliasResult AliasAnalysis::Alias(Instruction* lhs, Instruction* rhs) {
+    auto lhsLocation = GetLocation(lhs);
+    auto rhsLocation = GetLocation(rhs);
+    if(!lhsLocation.has_value() || !rhsLocation.has_value()) {
+        return AliasResult::MAY_ALIAS;
+    }
+    return Alias(*lhsLocation, *rhsLocation);
+}
+
+// Whether `base` is known to refer to another object than `other` does.
+bool AliasAnalysis::IsDistinctObject(Instruction* base, Instruction* other) {
+    if(base->GetOpType() != OpType::NEW_OBJECT) {
+        return false;
+    }
+    return other->GetOpType() == OpType::NEW_OBJECT || IsOnlyAccessBase(base);
+}
+
+bool AliasAnalysis::IsOnlyAccessBase(Instruction* allocation) {
+    for(auto &use: allocation->GetUses()) {
+        if(use.GetIndex() != 0 || !GetLocation(use.GetUser()).has_value()) {
+            return false;
+        }
+    }
+    return true;
+}
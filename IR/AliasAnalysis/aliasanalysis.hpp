@@ -0,0 +1,43 @@
+#ifndef IR_ALIAS_ANALYSIS_HPP
+#define IR_ALIAS_ANALYSIS_HPP
+
+#include "Instr/instruction.hpp"
+
+#include <cstdint>
+#include <optional>
+
+enum class AliasResult {
+    NO_ALIAS,
+    MAY_ALIAS,
+    MUST_ALIAS,
+};
+
+// Bytes an access touches: `size` bytes from `offset` into the object `base`
+// refers to.
+struct MemoryLocation {
+    Instruction* base = nullptr;
+    int64_t offset = 0;
+    uint32_t size = 0;
+};
+
+// Answers whether two memory accesses may touch the same bytes. Memory holds
+// untyped bytes and a load may read back a store of another type, so the
+// type of an access only tells how wide it is. Accesses through one reference
+// alias when their bytes overlap. References to different allocations never
+// alias, and neither does an allocation used only as an access base with any
+// other reference, as nothing else can ever hold it.
+class AliasAnalysis final {
+public:
+    // Location of a load, store or field access, nothing for other
+    // instructions and for accesses of types memory does not hold.
+    static std::optional<MemoryLocation> GetLocation(Instruction* access);
+
+    static AliasResult Alias(const MemoryLocation &lhs, const MemoryLocation &rhs);
+    static AliasResult Alias(Instruction* lhs, Instruction* rhs);
+
+private:
+    static bool IsDistinctObject(Instruction* base, Instruction* other);
+    static bool IsOnlyAccessBase(Instruction* allocation);
+};
+
+#endif  // IR_ALIAS_ANALYSIS_HPP
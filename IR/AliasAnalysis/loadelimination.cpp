@@ -0,0 +1,99 @@
+#include "AliasAnalysis/loadelimination.hpp"
+
+#include <unordered_set>
+#include <utility>
+
+size_t LoadElimination::Run() {
+    domTree_.Build();
+
+    std::vector<Instruction*> removed;
+    std::vector<std::pair<BasicBlock*, std::vector<KnownValue>>> stack;
+    stack.emplace_back(graph_->GetStartBlock(), std::vector<KnownValue>{});
+    while(!stack.empty()) {
+        auto [block, known] = std::move(stack.back());
+        stack.pop_back();
+
+        Process(block, known, removed);
+        for(auto *dominated: domTree_.GetImmediateDominatedBlocks(block)) {
+            auto dominatedKnown = known;
+            for(auto *regionBlock: GetRegion(dominated)) {
+                for(auto *instr = regionBlock->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+                    Kill(dominatedKnown, instr);
+                }
+            }
+            stack.emplace_back(dominated, std::move(dominatedKnown));
+        }
+    }
+
+    for(auto *load: removed) {
+        graph_->RemoveInstruction(load);
+    }
+    return removed.size();
+}
+
+void LoadElimination::Process(BasicBlock* block, std::vector<KnownValue> &known,
+                              std::vector<Instruction*> &removed) const {
+    for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+        auto op = instr->GetOpType();
+        if(op == OpType::STORE || op == OpType::STORE_FIELD) {
+            Kill(known, instr);
+            if(auto location = AliasAnalysis::GetLocation(instr)) {
+                auto *value = instr->GetInputs()[1].GetValue();
+                known.push_back({*location, value->GetResultType(), value});
+            }
+            continue;
+        }
+        if(op != OpType::LOAD && op != OpType::LOAD_FIELD) {
+            continue;
+        }
+
+        auto location = AliasAnalysis::GetLocation(instr);
+        if(!location.has_value()) {
+            continue;
+        }
+        Instruction* value = nullptr;
+        for(auto &entry: known) {
+            if(entry.type == instr->GetResultType() &&
+               AliasAnalysis::Alias(entry.location, *location) == AliasResult::MUST_ALIAS) {
+                value = entry.value;
+                break;
+            }
+        }
+        // The same bytes were accessed before, so the load cannot trap.
+        if(value != nullptr) {
+            instr->ReplaceAllUsesWith(value);
+            removed.push_back(instr);
+        } else {
+            known.push_back({*location, instr->GetResultType(), instr});
+        }
+    }
+}
+
+std::vector<BasicBlock*> LoadElimination::GetRegion(BasicBlock* block) const {
+    auto *idom = domTree_.GetImmediateDominator(block);
+    std::vector<BasicBlock*> region;
+    std::unordered_set<BasicBlock*> visited = {idom};
+    std::vector<BasicBlock*> worklist(block->GetPredecessors().begin(), block->GetPredecessors().end());
+    while(!worklist.empty()) {
+        auto *current = worklist.back();
+        worklist.pop_back();
+        if(!visited.insert(current).second) {
+            continue;
+        }
+        region.push_back(current);
+        worklist.insert(worklist.end(), current->GetPredecessors().begin(), current->GetPredecessors().end());
+    }
+    return region;
+}
+
+// Drops the known values `store` may overwrite; other instructions keep them.
+void LoadElimination::Kill(std::vector<KnownValue> &known, Instruction* store) {
+    auto op = store->GetOpType();
+    if(op != OpType::STORE && op != OpType::STORE_FIELD) {
+        return;
+    }
+    auto location = AliasAnalysis::GetLocation(store);
+    std::erase_if(known, [&location](const KnownValue &entry) {
+        return !location.has_value() || AliasAnalysis::Alias(entry.location, *location) != AliasResult::NO_ALIAS;
+    });
+}
@@ -0,0 +1,39 @@
+#ifndef IR_LOAD_ELIMINATION_HPP
+#define IR_LOAD_ELIMINATION_HPP
+
+#include "AliasAnalysis/aliasanalysis.hpp"
+#include "DominatorTree/dominatortree.hpp"
+#include "Graph/graph.hpp"
+
+#include <vector>
+
+// Removes loads whose value is already known: the value stored to or loaded
+// from the same bytes with the same type by a dominating access, with no store
+// that may alias in between. The known values flow down the dominator tree;
+// entering a block drops those that a store on any path from its immediate
+// dominator, loop back edges included, may overwrite.
+class LoadElimination final {
+public:
+    LoadElimination(Graph* graph): graph_(graph), domTree_(graph) {}
+
+    // Returns the number of removed loads.
+    size_t Run();
+
+private:
+    struct KnownValue {
+        MemoryLocation location;
+        DataType type = DataType::UNDEFINED;
+        Instruction* value = nullptr;
+    };
+
+    void Process(BasicBlock* block, std::vector<KnownValue> &known, std::vector<Instruction*> &removed) const;
+    // Blocks a path from the immediate dominator of `block` to it passes.
+    std::vector<BasicBlock*> GetRegion(BasicBlock* block) const;
+    static void Kill(std::vector<KnownValue> &known, Instruction* store);
+
+private:
+    Graph* graph_ = nullptr;
+    DominatorTree domTree_;
+};
+
+#endif  // IR_LOAD_ELIMINATION_HPP
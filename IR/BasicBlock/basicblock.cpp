@@ -1,5 +1,6 @@
 #include "BasicBlock/basicblock.hpp"
 
+#include <algorithm>
 #include <iomanip>
 
 void BasicBlock::PushInstruction(Instruction* instr) {
@@ -13,6 +14,40 @@ void BasicBlock::PushInstruction(Instruction* instr) {
     }
 }
 
+void BasicBlock::InsertBefore(Instruction* pos, Instruction* instr) {
+    auto *prev = pos->GetPrev();
+
+    instr->SetPrev(prev);
+    instr->SetNext(pos);
+    pos->SetPrev(instr);
+    if (prev == nullptr) {
+        firstInstr_ = instr;
+    } else {
+        prev->SetNext(instr);
+    }
+    instr->SetParentBB(this);
+}
+
+void BasicBlock::RemoveInstruction(Instruction* instr) {
+    auto *prev = instr->GetPrev();
+    auto *next = instr->GetNext();
+
+    if (prev == nullptr) {
+        firstInstr_ = next;
+    } else {
+        prev->SetNext(next);
+    }
+    if (next == nullptr) {
+        lastInstr_ = prev;
+    } else {
+        next->SetPrev(prev);
+    }
+
+    instr->SetPrev(nullptr);
+    instr->SetNext(nullptr);
+    instr->SetParentBB(nullptr);
+}
+
 void BasicBlock::SetId(size_t id) {
     bbId_ = id;
 }
@@ -24,6 +59,10 @@ void BasicBlock::SetGraph(Graph* graph) {
     graph_ = graph;
 }
 
+Graph* BasicBlock::GetGraph() const {
+    return graph_;
+}
+
 void BasicBlock::AddSuccessor(BasicBlock* block) {
     successors_.push_back(block);
 }
@@ -32,6 +71,43 @@ void BasicBlock::AddPredecessor(BasicBlock* block) {
     predecessors_.push_back(block);
 }
 
+void BasicBlock::RemoveSuccessor(BasicBlock* block) {
+    auto it = std::find(successors_.begin(), successors_.end(), block);
+    if (it != successors_.end()) {
+        successors_.erase(it);
+    }
+}
+
+void BasicBlock::RemovePredecessor(BasicBlock* block) {
+    auto it = std::find(predecessors_.begin(), predecessors_.end(), block);
+    if (it == predecessors_.end()) {
+        return;
+    }
+
+    size_t predIdx = it - predecessors_.begin();
+    predecessors_.erase(it);
+
+    for (auto *instr = firstInstr_; instr != nullptr && instr->IsPhi(); instr = instr->GetNext()) {
+        if (predIdx < instr->GetInputs().size()) {
+            instr->RemoveInput(predIdx);
+        }
+    }
+}
+
+void BasicBlock::ReplaceSuccessor(BasicBlock* from, BasicBlock* to) {
+    auto it = std::find(successors_.begin(), successors_.end(), from);
+    if (it != successors_.end()) {
+        *it = to;
+    }
+}
+
+void BasicBlock::ReplacePredecessor(BasicBlock* from, BasicBlock* to) {
+    auto it = std::find(predecessors_.begin(), predecessors_.end(), from);
+    if (it != predecessors_.end()) {
+        *it = to;
+    }
+}
+
 const std::vector<BasicBlock*>& BasicBlock::GetSuccessors() const {
     return successors_;
 }
@@ -40,6 +116,10 @@ const std::vector<BasicBlock*>& BasicBlock::GetPredecessors() const {
     return predecessors_;
 }
 
+Instruction* BasicBlock::GetFirstInstr() const {
+    return firstInstr_;
+}
+
 Instruction* BasicBlock::GetLastInstr() const {
     return lastInstr_;
 }
@@ -13,14 +13,23 @@ class Graph;
 class BasicBlock final {
 public:
     void PushInstruction(Instruction* instr);
+    void InsertBefore(Instruction* pos, Instruction* instr);
+    void RemoveInstruction(Instruction* instr);
 
     void SetId(size_t id);
     size_t GetId() const;
     void SetGraph(Graph* graph);
+    Graph* GetGraph() const;
+    Instruction* GetFirstInstr() const;
     Instruction* GetLastInstr() const;
 
     void AddSuccessor(BasicBlock* block);
     void AddPredecessor(BasicBlock* block);
+    void RemoveSuccessor(BasicBlock* block);
+    void RemovePredecessor(BasicBlock* block);
+    // Keep the position of the replaced block, so phi inputs stay in place.
+    void ReplaceSuccessor(BasicBlock* from, BasicBlock* to);
+    void ReplacePredecessor(BasicBlock* from, BasicBlock* to);
     const std::vector<BasicBlock *> &GetSuccessors() const;
     const std::vector<BasicBlock *> &GetPredecessors() const;
 
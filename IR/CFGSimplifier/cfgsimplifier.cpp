@@ -0,0 +1,145 @@
+#include "CFGSimplifier/cfgsimplifier.hpp"
+#include "Instr/optraits.hpp"
+
+#include <algorithm>
+
+namespace {
+
+// Edges are fixed by the callers, which know where they go in the lists.
+void AppendJump(Graph* graph, BasicBlock* block, BasicBlock* target) {
+    auto jmp = std::make_unique<JmpInstr>(target);
+    jmp->SetParentBB(block);
+    block->PushInstruction(jmp.get());
+    graph->AddInstruction(std::move(jmp));
+}
+
+}  // namespace
+
+// Merged and bypassed blocks are only detached while walking the blocks; they
+// are freed by removing unreachable blocks once the walk is over.
+size_t CFGSimplifier::Run() {
+    auto blocksCount = graph_->GetBlocks().size();
+    graph_->RemoveUnreachableBlocks();
+    size_t simplified = blocksCount - graph_->GetBlocks().size();
+
+    for(bool changed = true; changed;) {
+        changed = false;
+        std::vector<BasicBlock*> blocks;
+        for(auto &block: graph_->GetBlocks()) {
+            blocks.push_back(block.get());
+        }
+        for(auto *block: blocks) {
+            if(block != graph_->GetStartBlock() && block->GetPredecessors().empty()) {
+                continue;
+            }
+            if(CollapseBranch(block) || MergeIntoPredecessor(block) || BypassEmptyBlock(block)) {
+                ++simplified;
+                changed = true;
+            }
+        }
+        graph_->RemoveUnreachableBlocks();
+    }
+    return simplified;
+}
+
+bool CFGSimplifier::CollapseBranch(BasicBlock* block) {
+    auto *terminator = block->GetLastInstr();
+    auto *branch = terminator == nullptr ? nullptr : terminator->As<CjmpInstr>();
+    if(branch == nullptr || branch->GetTrueBranchBB() != branch->GetFalseBranchBB()) {
+        return false;
+    }
+
+    // Phis read the input of the first edge, so the edge that stays takes it.
+    auto *target = branch->GetTrueBranchBB();
+    auto &preds = target->GetPredecessors();
+    auto first = std::find(preds.begin(), preds.end(), block);
+    auto second = std::find(first + 1, preds.end(), block);
+    auto firstIdx = static_cast<size_t>(first - preds.begin());
+    auto secondIdx = static_cast<size_t>(second - preds.begin());
+    for(auto *phi = target->GetFirstInstr(); phi != nullptr && phi->IsPhi(); phi = phi->GetNext()) {
+        phi->SetInput(secondIdx, phi->GetInputs()[firstIdx].GetValue());
+    }
+    target->RemovePredecessor(block);
+    block->RemoveSuccessor(target);
+
+    auto *condition = branch->GetInputs()[0].GetValue();
+    graph_->RemoveInstruction(branch);
+    AppendJump(graph_, block, target);
+    if(!condition->HasUses() && !HasSideEffects(condition->GetOpType())) {
+        graph_->RemoveInstruction(condition);
+    }
+    return true;
+}
+
+bool CFGSimplifier::MergeIntoPredecessor(BasicBlock* block) {
+    auto &preds = block->GetPredecessors();
+    if(block == graph_->GetStartBlock() || preds.size() != 1) {
+        return false;
+    }
+    auto *pred = preds[0];
+    if(pred == block || pred->GetSuccessors().size() != 1) {
+        return false;
+    }
+
+    while(block->GetFirstInstr() != nullptr && block->GetFirstInstr()->IsPhi()) {
+        auto *phi = block->GetFirstInstr();
+        phi->ReplaceAllUsesWith(phi->GetInputs()[0].GetValue());
+        graph_->RemoveInstruction(phi);
+    }
+    graph_->RemoveInstruction(pred->GetLastInstr());
+    while(auto *instr = block->GetFirstInstr()) {
+        block->RemoveInstruction(instr);
+        pred->PushInstruction(instr);
+        instr->SetParentBB(pred);
+    }
+
+    // The successors see the predecessor in the place of the block, so their
+    // phi inputs stay where they are.
+    pred->RemoveSuccessor(block);
+    block->RemovePredecessor(pred);
+    auto succs = block->GetSuccessors();
+    for(auto *succ: succs) {
+        pred->AddSuccessor(succ);
+        succ->ReplacePredecessor(block, pred);
+        block->RemoveSuccessor(succ);
+    }
+    return true;
+}
+
+bool CFGSimplifier::BypassEmptyBlock(BasicBlock* block) {
+    auto *jump = block->GetFirstInstr();
+    if(block == graph_->GetStartBlock() || jump == nullptr || jump != block->GetLastInstr() ||
+       jump->GetOpType() != OpType::JMP) {
+        return false;
+    }
+    auto *target = static_cast<JmpInstr*>(jump)->GetBBToJmp();
+    if(target == block) {
+        return false;
+    }
+
+    bool hasPhis = target->GetFirstInstr() != nullptr && target->GetFirstInstr()->IsPhi();
+    bool bypassed = false;
+    auto preds = block->GetPredecessors();
+    for(auto *pred: preds) {
+        auto &targetPreds = target->GetPredecessors();
+        if(std::count(preds.begin(), preds.end(), pred) != 1 ||
+           (hasPhis && std::find(targetPreds.begin(), targetPreds.end(), pred) != targetPreds.end())) {
+            continue;
+        }
+
+        auto *terminator = pred->GetLastInstr();
+        if(auto *branch = terminator->As<CjmpInstr>()) {
+            branch->ReplaceTarget(block, target);
+        } else {
+            static_cast<JmpInstr*>(terminator)->SetBBToJmp(target);
+        }
+        pred->ReplaceSuccessor(block, target);
+        target->AddPredecessor(pred);
+        for(auto *phi = target->GetFirstInstr(); phi != nullptr && phi->IsPhi(); phi = phi->GetNext()) {
+            phi->AddInput(static_cast<PhiInstr*>(phi)->GetPhiInput(block));
+        }
+        block->RemovePredecessor(pred);
+        bypassed = true;
+    }
+    return bypassed;
+}
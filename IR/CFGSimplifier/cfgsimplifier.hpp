@@ -0,0 +1,32 @@
+#ifndef IR_CFG_SIMPLIFIER_HPP
+#define IR_CFG_SIMPLIFIER_HPP
+
+#include "Graph/graph.hpp"
+
+// Removes the jumps the builder and other passes leave behind:
+// - a conditional jump with the same block on both sides becomes a jump;
+// - a block with a single predecessor that only leads to it is merged into
+//   that predecessor, its phis replaced by their only input;
+// - predecessors of a block that only jumps go straight to its target, unless
+//   the target would need two different phi inputs for one predecessor;
+// - unreachable blocks are removed.
+// The rules run until none applies. Critical edges are split by
+// Graph::SplitCriticalEdges, which passes call when they need it.
+class CFGSimplifier final {
+public:
+    CFGSimplifier(Graph* graph): graph_(graph) {}
+
+    // Returns the number of applied rules plus the number of blocks that were
+    // unreachable to begin with.
+    size_t Run();
+
+private:
+    bool CollapseBranch(BasicBlock* block);
+    bool MergeIntoPredecessor(BasicBlock* block);
+    bool BypassEmptyBlock(BasicBlock* block);
+
+private:
+    Graph* graph_ = nullptr;
+};
+
+#endif  // IR_CFG_SIMPLIFIER_HPP
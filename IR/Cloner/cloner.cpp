@@ -0,0 +1,224 @@
+#include "Cloner/cloner.hpp"
+#include "DFS/rpo.hpp"
+
+#include <unordered_set>
+
+void InstructionCloner::MapValue(Instruction* from, Instruction* to) {
+    valueMap_[from] = to;
+}
+
+void InstructionCloner::MapBlock(BasicBlock* from, BasicBlock* to) {
+    blockMap_[from] = to;
+}
+
+Instruction* InstructionCloner::GetMappedValue(Instruction* instr) const {
+    auto it = valueMap_.find(instr);
+    return it == valueMap_.end() ? instr : it->second;
+}
+
+BasicBlock* InstructionCloner::GetMappedBlock(BasicBlock* block) const {
+    auto it = blockMap_.find(block);
+    return it == blockMap_.end() ? block : it->second;
+}
+
+Instruction* InstructionCloner::Clone(Instruction* instr) {
+    auto &inputs = instr->GetInputs();
+    auto input = [this, &inputs](size_t idx) { return GetMappedValue(inputs[idx].GetValue()); };
+    auto type = instr->GetResultType();
+
+    Instruction* copy = nullptr;
+    switch(instr->GetOpType()) {
+        case OpType::ADD:
+            copy = builder_->CreateAdd(type, input(0), input(1));
+            break;
+        case OpType::SUB:
+            copy = builder_->CreateSub(type, input(0), input(1));
+            break;
+        case OpType::MUL:
+            copy = builder_->CreateMul(type, input(0), input(1));
+            break;
+        case OpType::DIV:
+            copy = builder_->CreateDiv(type, input(0), input(1));
+            break;
+        case OpType::MOD:
+            copy = builder_->CreateMod(type, input(0), input(1));
+            break;
+        case OpType::MULH:
+            copy = builder_->CreateMulHigh(type, input(0), input(1));
+            break;
+        case OpType::AND:
+            copy = builder_->CreateAnd(type, input(0), input(1));
+            break;
+        case OpType::SHR:
+            copy = builder_->CreateShr(type, input(0), input(1));
+            break;
+        case OpType::CMP:
+            copy = builder_->CreateCmp(input(0), input(1));
+            break;
+        case OpType::JMP:
+            copy = builder_->CreateJmp(GetMappedBlock(static_cast<JmpInstr*>(instr)->GetBBToJmp()));
+            break;
+        case OpType::JA:
+        case OpType::JAE:
+        case OpType::JE: {
+            auto *branch = static_cast<CjmpInstr*>(instr);
+            auto *ifTrue = GetMappedBlock(branch->GetTrueBranchBB());
+            auto *ifFalse = GetMappedBlock(branch->GetFalseBranchBB());
+            if(instr->GetOpType() == OpType::JA) {
+                copy = builder_->CreateJa(input(0), ifTrue, ifFalse);
+            } else if(instr->GetOpType() == OpType::JAE) {
+                copy = builder_->CreateJae(input(0), ifTrue, ifFalse);
+            } else {
+                copy = builder_->CreateJe(input(0), ifTrue, ifFalse);
+            }
+            break;
+        }
+        case OpType::RET:
+            copy = builder_->CreateRet(type, input(0));
+            break;
+        case OpType::SPLAT:
+            copy = builder_->CreateSplat(type, input(0));
+            break;
+        case OpType::IOTA:
+            copy = builder_->CreateIota(type);
+            break;
+        case OpType::REDUCE:
+            copy = builder_->CreateReduce(static_cast<ReduceInstr*>(instr)->GetReduceOp(), type, input(0));
+            break;
+        case OpType::BOUNDS_CHECK:
+            copy = builder_->CreateBoundsCheck(input(0), input(1));
+            break;
+        case OpType::OVERFLOW_CHECK: {
+            auto *check = static_cast<OverflowCheckInstr*>(instr);
+            copy = builder_->CreateOverflowCheck(check->GetCheckedOp(), check->GetCheckedType(), input(0), input(1));
+            break;
+        }
+        case OpType::NEW_OBJECT:
+            copy = builder_->CreateNewObject(static_cast<NewObjectInstr*>(instr)->GetFieldsCount());
+            break;
+        case OpType::LOAD_FIELD:
+            copy = builder_->CreateLoadField(type, input(0), static_cast<LoadFieldInstr*>(instr)->GetField());
+            break;
+        case OpType::STORE_FIELD:
+            copy = builder_->CreateStoreField(input(0), static_cast<StoreFieldInstr*>(instr)->GetField(), input(1));
+            break;
+        case OpType::LOAD:
+            copy = builder_->CreateLoad(type, input(0), static_cast<LoadInstr*>(instr)->GetOffset());
+            break;
+        case OpType::STORE:
+            copy = builder_->CreateStore(input(0), static_cast<StoreInstr*>(instr)->GetOffset(), input(1));
+            break;
+        case OpType::SELECT:
+            copy = builder_->CreateSelect(type, static_cast<SelectInstr*>(instr)->GetCondition(),
+                                          input(0), input(1), input(2));
+            break;
+        case OpType::DEOPT: {
+            auto *guard = static_cast<GuardInstr*>(instr);
+            auto *guardCopy = static_cast<GuardInstr*>(builder_->CreateInstruction<GuardInstr>(
+                input(0), guard->GetCondition(), guard->IsTakenExpected(),
+                guard->GetResumeBlock(), guard->GetResumePrevBlock()));
+            auto &stateValues = guard->GetStateValues();
+            for(size_t idx = 0; idx < stateValues.size(); ++idx) {
+                guardCopy->AddStateValue(stateValues[idx], input(idx + 1));
+            }
+            copy = guardCopy;
+            break;
+        }
+        case OpType::PHI:
+            copy = builder_->CreatePhi(type);
+            break;
+        case OpType::PRM:
+            copy = builder_->CreateParameter(static_cast<ParameterInstr*>(instr)->GetArgNum());
+            break;
+        case OpType::CONST: {
+            auto *constant = static_cast<ConstantInstr*>(instr);
+            if(constant->IsSignedInt()) {
+                copy = builder_->CreateConstant(constant->GetAsSignedInt(), type);
+            } else {
+                copy = builder_->CreateConstant(constant->GetAsUnsignedInt(), type);
+            }
+            break;
+        }
+        default:
+            return nullptr;
+    }
+
+    MapValue(instr, copy);
+    return copy;
+}
+
+
+//--------------------------------------------------------------------
+
+std::unique_ptr<Graph> GraphCloner::Run() {
+    clonedValues_.clear();
+    clonedBlocks_.clear();
+    originalValues_.clear();
+    originalBlocks_.clear();
+
+    auto graph = std::make_unique<Graph>();
+    IrBuilder builder(graph.get());
+    InstructionCloner cloner(&builder);
+
+    for(auto &block: graph_->GetBlocks()) {
+        auto *copy = builder.CreateBB();
+        cloner.MapBlock(block.get(), copy);
+        clonedBlocks_[block.get()] = copy;
+        originalBlocks_[copy] = block.get();
+    }
+
+    RPO rpo(graph_);
+    auto order = rpo.Run();
+    std::unordered_set<BasicBlock*> reachable(order.begin(), order.end());
+    for(auto &block: graph_->GetBlocks()) {
+        if(reachable.count(block.get()) == 0) {
+            order.push_back(block.get());
+        }
+    }
+
+    std::vector<PhiInstr*> phis;
+    for(auto *block: order) {
+        builder.SetBasicBlockScope(clonedBlocks_[block]);
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            auto *copy = cloner.Clone(instr);
+            if(copy == nullptr) {
+                return nullptr;
+            }
+            clonedValues_[instr] = copy;
+            originalValues_[copy] = instr;
+            if(instr->IsPhi()) {
+                phis.push_back(static_cast<PhiInstr*>(instr));
+            }
+        }
+    }
+
+    for(auto *phi: phis) {
+        auto *phiCopy = clonedValues_[phi];
+        for(auto *pred: phiCopy->GetParentBB()->GetPredecessors()) {
+            auto *input = phi->GetPhiInput(originalBlocks_[pred]);
+            phiCopy->AddInput(cloner.GetMappedValue(input));
+        }
+    }
+
+    return graph;
+}
+
+Instruction* GraphCloner::GetClonedValue(Instruction* instr) const {
+    auto it = clonedValues_.find(instr);
+    return it == clonedValues_.end() ? nullptr : it->second;
+}
+
+BasicBlock* GraphCloner::GetClonedBlock(BasicBlock* block) const {
+    auto it = clonedBlocks_.find(block);
+    return it == clonedBlocks_.end() ? nullptr : it->second;
+}
+
+Instruction* GraphCloner::GetOriginalValue(Instruction* instr) const {
+    auto it = originalValues_.find(instr);
+    return it == originalValues_.end() ? nullptr : it->second;
+}
+
+BasicBlock* GraphCloner::GetOriginalBlock(BasicBlock* block) const {
+    auto it = originalBlocks_.find(block);
+    return it == originalBlocks_.end() ? nullptr : it->second;
+}
\ No newline at end of file
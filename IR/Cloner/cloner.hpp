@@ -0,0 +1,54 @@
+#ifndef IR_CLONER_HPP
+#define IR_CLONER_HPP
+
+#include "irbuilder.hpp"
+
+#include <unordered_map>
+
+// Copies instructions through an IrBuilder, rewriting inputs and branch targets
+// through the value and block maps. Values and blocks without a mapping are
+// kept as they are, which is what cloning inside one graph wants. Phis are
+// created without inputs; filling them is up to the caller since it depends on
+// the predecessor order of the new block.
+class InstructionCloner final {
+public:
+    InstructionCloner(IrBuilder* builder): builder_(builder) {}
+
+    void MapValue(Instruction* from, Instruction* to);
+    void MapBlock(BasicBlock* from, BasicBlock* to);
+
+    Instruction* GetMappedValue(Instruction* instr) const;
+    BasicBlock* GetMappedBlock(BasicBlock* block) const;
+
+    Instruction* Clone(Instruction* instr);
+
+private:
+    IrBuilder* builder_ = nullptr;
+
+    std::unordered_map<Instruction*, Instruction*> valueMap_;
+    std::unordered_map<BasicBlock*, BasicBlock*> blockMap_;
+};
+
+// Copies a whole graph. Blocks keep their ids; instructions are cloned in
+// reverse post-order so that every value exists before its users.
+class GraphCloner final {
+public:
+    GraphCloner(Graph* graph): graph_(graph) {}
+
+    std::unique_ptr<Graph> Run();
+
+    Instruction* GetClonedValue(Instruction* instr) const;
+    BasicBlock* GetClonedBlock(BasicBlock* block) const;
+    Instruction* GetOriginalValue(Instruction* instr) const;
+    BasicBlock* GetOriginalBlock(BasicBlock* block) const;
+
+private:
+    Graph* graph_ = nullptr;
+
+    std::unordered_map<Instruction*, Instruction*> clonedValues_;
+    std::unordered_map<BasicBlock*, BasicBlock*> clonedBlocks_;
+    std::unordered_map<Instruction*, Instruction*> originalValues_;
+    std::unordered_map<BasicBlock*, BasicBlock*> originalBlocks_;
+};
+
+#endif  // IR_CLONER_HPP
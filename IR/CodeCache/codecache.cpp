@@ -0,0 +1,80 @@
+#include "CodeCache/codecache.hpp"
+
+CodeCache::CodePtr CodeCache::Lookup(uint64_t hash, const GraphKey &key) {
+    auto it = entries_.find(hash);
+    if(it == entries_.end() || it->second->key != key) {
+        ++stats_.misses;
+        return nullptr;
+    }
+
+    ++stats_.hits;
+    lruList_.splice(lruList_.begin(), lruList_, it->second);
+    return it->second->code;
+}
+
+CodeCache::CodePtr CodeCache::Insert(uint64_t hash, GraphKey key, CompiledCode code) {
+    auto codePtr = std::make_shared<const CompiledCode>(std::move(code));
+    size_t size = codePtr->GetSize();
+
+    auto it = entries_.find(hash);
+    if(it != entries_.end()) {
+        bytesUsed_ -= it->second->code->GetSize();
+        lruList_.erase(it->second);
+        entries_.erase(it);
+    }
+
+    if(size > byteBudget_) {
+        return codePtr;
+    }
+
+    EvictUntilFits(size);
+
+    lruList_.push_front(Entry {hash, std::move(key), codePtr});
+    entries_[hash] = lruList_.begin();
+    bytesUsed_ += size;
+    ++stats_.insertions;
+
+    return codePtr;
+}
+
+CodeCache::CodePtr CodeCache::GetOrCompile(Graph* graph, const CompileFn &compile) {
+    GraphHasher hasher(graph);
+    uint64_t hash = hasher.Run();
+
+    if(auto code = Lookup(hash, hasher.GetKey())) {
+        return code;
+    }
+    return Insert(hash, hasher.GetKey(), compile(graph));
+}
+
+void CodeCache::Clear() {
+    lruList_.clear();
+    entries_.clear();
+    bytesUsed_ = 0;
+}
+
+size_t CodeCache::GetEntriesCount() const {
+    return entries_.size();
+}
+
+size_t CodeCache::GetBytesUsed() const {
+    return bytesUsed_;
+}
+
+size_t CodeCache::GetByteBudget() const {
+    return byteBudget_;
+}
+
+const CodeCacheStats& CodeCache::GetStats() const {
+    return stats_;
+}
+
+void CodeCache::EvictUntilFits(size_t size) {
+    while(!lruList_.empty() && bytesUsed_ + size > byteBudget_) {
+        auto &victim = lruList_.back();
+        bytesUsed_ -= victim.code->GetSize();
+        entries_.erase(victim.hash);
+        lruList_.pop_back();
+        ++stats_.evictions;
+    }
+}
@@ -0,0 +1,86 @@
+#ifndef IR_CODE_CACHE_HPP
+#define IR_CODE_CACHE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "GraphHash/graphhash.hpp"
+
+class Graph;
+
+enum class RelocationKind: uint32_t {
+    ABS64,
+    REL32,
+};
+
+struct Relocation {
+    uint64_t offset = 0;
+    RelocationKind kind = RelocationKind::ABS64;
+    uint32_t reserved = 0;
+    uint64_t target = 0;
+};
+
+struct CompiledCode {
+    std::vector<uint8_t> code;
+    std::vector<Relocation> relocations;
+
+    size_t GetSize() const {
+        return code.size() + relocations.size() * sizeof(Relocation);
+    }
+};
+
+struct CodeCacheStats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    size_t insertions = 0;
+};
+
+// Compiled code keyed by the structural hash of its graph. Each entry also
+// keeps the full structural key, so a hash collision is a miss rather than a
+// wrong hit. The least recently used entries are evicted once the total code
+// size exceeds the byte budget. Entries are handed out as shared pointers, so
+// code stays alive for callers even after the cache has dropped it.
+class CodeCache final {
+public:
+    using CodePtr = std::shared_ptr<const CompiledCode>;
+    using CompileFn = std::function<CompiledCode(Graph*)>;
+
+    CodeCache(size_t byteBudget): byteBudget_(byteBudget) {}
+
+    CodePtr Lookup(uint64_t hash, const GraphKey &key);
+    CodePtr Insert(uint64_t hash, GraphKey key, CompiledCode code);
+    CodePtr GetOrCompile(Graph* graph, const CompileFn &compile);
+
+    void Clear();
+
+    size_t GetEntriesCount() const;
+    size_t GetBytesUsed() const;
+    size_t GetByteBudget() const;
+    const CodeCacheStats& GetStats() const;
+
+private:
+    struct Entry {
+        uint64_t hash = 0;
+        GraphKey key;
+        CodePtr code;
+    };
+
+    void EvictUntilFits(size_t size);
+
+private:
+    size_t byteBudget_ = 0;
+    size_t bytesUsed_ = 0;
+
+    std::list<Entry> lruList_;
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> entries_;
+
+    CodeCacheStats stats_;
+};
+
+#endif  // IR_CODE_CACHE_HPP
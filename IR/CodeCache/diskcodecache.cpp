@@ -0,0 +1,282 @@
+#include "CodeCache/diskcodecache.hpp"
+
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char FILE_MAGIC[8] = {'I', 'R', 'C', 'O', 'D', 'E', 'S', '\0'};
+constexpr uint32_t RECORD_MAGIC = 0x43455243;  // "CREC"
+
+struct FileHeader {
+    char magic[8];
+    uint32_t formatVersion;
+    uint32_t reserved;
+};
+
+struct RecordHeader {
+    uint32_t magic;
+    uint32_t compilerVersion;
+    uint64_t graphHash;
+    uint64_t keyDigest;
+    uint64_t codeSize;
+    uint64_t relocationsCount;
+    uint64_t checksum;
+};
+
+static_assert(sizeof(FileHeader) % 8 == 0);
+static_assert(sizeof(RecordHeader) % 8 == 0);
+static_assert(sizeof(Relocation) % 8 == 0);
+
+size_t AlignTo8(size_t size) {
+    return (size + 7) & ~size_t {7};
+}
+
+uint64_t Fnv1a(uint64_t hash, const void* data, size_t size) {
+    auto *bytes = static_cast<const uint8_t*>(data);
+    for(size_t idx = 0; idx < size; ++idx) {
+        hash ^= bytes[idx];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// FNV-1a shares nothing with the graph hash mixing, so a collision of both is
+// as unlikely as two independent 64-bit hashes colliding.
+uint64_t KeyDigest(const GraphKey &key) {
+    return Fnv1a(0xcbf29ce484222325ULL, key.data(), key.size() * sizeof(uint64_t));
+}
+
+uint64_t RecordChecksum(const RecordHeader &header, const uint8_t* code, const Relocation* relocations) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    hash = Fnv1a(hash, &header.compilerVersion, sizeof(header.compilerVersion));
+    hash = Fnv1a(hash, &header.graphHash, sizeof(header.graphHash));
+    hash = Fnv1a(hash, &header.keyDigest, sizeof(header.keyDigest));
+    hash = Fnv1a(hash, &header.codeSize, sizeof(header.codeSize));
+    hash = Fnv1a(hash, &header.relocationsCount, sizeof(header.relocationsCount));
+    hash = Fnv1a(hash, code, header.codeSize);
+    hash = Fnv1a(hash, relocations, header.relocationsCount * sizeof(Relocation));
+    return hash;
+}
+
+bool WriteAll(int fd, const void* data, size_t size) {
+    auto *bytes = static_cast<const uint8_t*>(data);
+    while(size > 0) {
+        ssize_t written = write(fd, bytes, size);
+        if(written <= 0) {
+            return false;
+        }
+        bytes += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+}  // namespace
+
+DiskCodeCache::~DiskCodeCache() {
+    Close();
+}
+
+bool DiskCodeCache::Open() {
+    Close();
+
+    fd_ = open(path_.c_str(), O_RDWR | O_CREAT, 0644);
+    if(fd_ < 0) {
+        return false;
+    }
+
+    struct stat st {};
+    if(fstat(fd_, &st) != 0) {
+        Close();
+        return false;
+    }
+
+    if(static_cast<size_t>(st.st_size) < sizeof(FileHeader)) {
+        if(!CreateFile()) {
+            Close();
+            return false;
+        }
+        validSize_ = sizeof(FileHeader);
+        return true;
+    }
+
+    mappingSize_ = static_cast<size_t>(st.st_size);
+    if(!MapFile()) {
+        Close();
+        return false;
+    }
+
+    FileHeader header {};
+    std::memcpy(&header, mapping_, sizeof(header));
+    if(std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 ||
+       header.formatVersion != FORMAT_VERSION) {
+        munmap(const_cast<uint8_t*>(mapping_), mappingSize_);
+        mapping_ = nullptr;
+        mappingSize_ = 0;
+        if(!CreateFile()) {
+            Close();
+            return false;
+        }
+        validSize_ = sizeof(FileHeader);
+        return true;
+    }
+
+    IndexRecords();
+    return true;
+}
+
+void DiskCodeCache::Close() {
+    if(mapping_ != nullptr) {
+        munmap(const_cast<uint8_t*>(mapping_), mappingSize_);
+    }
+    if(fd_ >= 0) {
+        close(fd_);
+    }
+
+    fd_ = -1;
+    mapping_ = nullptr;
+    mappingSize_ = 0;
+    validSize_ = 0;
+    mappedEntries_.clear();
+    storedEntries_.clear();
+    stats_ = DiskCodeCacheStats {};
+}
+
+std::optional<CachedCodeView> DiskCodeCache::Lookup(uint64_t hash, const GraphKey &key) const {
+    uint64_t keyDigest = KeyDigest(key);
+
+    auto storedIt = storedEntries_.find(hash);
+    if(storedIt != storedEntries_.end()) {
+        if(storedIt->second.keyDigest != keyDigest) {
+            return std::nullopt;
+        }
+        auto &code = *storedIt->second.code;
+        return CachedCodeView {code.code.data(), code.code.size(),
+                               code.relocations.data(), code.relocations.size()};
+    }
+
+    auto mappedIt = mappedEntries_.find(hash);
+    if(mappedIt != mappedEntries_.end() && mappedIt->second.keyDigest == keyDigest) {
+        return mappedIt->second.view;
+    }
+
+    return std::nullopt;
+}
+
+bool DiskCodeCache::Store(uint64_t hash, const GraphKey &key, const CompiledCode &code) {
+    if(fd_ < 0) {
+        return false;
+    }
+
+    if(ftruncate(fd_, static_cast<off_t>(validSize_)) != 0 ||
+       lseek(fd_, static_cast<off_t>(validSize_), SEEK_SET) < 0) {
+        return false;
+    }
+
+    RecordHeader header {};
+    header.magic = RECORD_MAGIC;
+    header.compilerVersion = compilerVersion_;
+    header.graphHash = hash;
+    header.keyDigest = KeyDigest(key);
+    header.codeSize = code.code.size();
+    header.relocationsCount = code.relocations.size();
+    header.checksum = RecordChecksum(header, code.code.data(), code.relocations.data());
+
+    std::vector<uint8_t> record(sizeof(header) + AlignTo8(code.code.size()) +
+                                code.relocations.size() * sizeof(Relocation));
+    std::memcpy(record.data(), &header, sizeof(header));
+    if(!code.code.empty()) {
+        std::memcpy(record.data() + sizeof(header), code.code.data(), code.code.size());
+    }
+    if(!code.relocations.empty()) {
+        std::memcpy(record.data() + sizeof(header) + AlignTo8(code.code.size()), code.relocations.data(),
+                    code.relocations.size() * sizeof(Relocation));
+    }
+
+    if(!WriteAll(fd_, record.data(), record.size())) {
+        return false;
+    }
+    validSize_ += record.size();
+
+    storedEntries_[hash] = StoredEntry {header.keyDigest, std::make_unique<CompiledCode>(code)};
+    return true;
+}
+
+size_t DiskCodeCache::GetEntriesCount() const {
+    size_t count = storedEntries_.size();
+    for(auto &[hash, entry]: mappedEntries_) {
+        if(storedEntries_.find(hash) == storedEntries_.end()) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+const DiskCodeCacheStats& DiskCodeCache::GetStats() const {
+    return stats_;
+}
+
+bool DiskCodeCache::CreateFile() {
+    FileHeader header {};
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    header.formatVersion = FORMAT_VERSION;
+
+    if(ftruncate(fd_, 0) != 0 || lseek(fd_, 0, SEEK_SET) < 0) {
+        return false;
+    }
+    return WriteAll(fd_, &header, sizeof(header));
+}
+
+bool DiskCodeCache::MapFile() {
+    void* mapping = mmap(nullptr, mappingSize_, PROT_READ, MAP_SHARED, fd_, 0);
+    if(mapping == MAP_FAILED) {
+        mapping_ = nullptr;
+        return false;
+    }
+
+    mapping_ = static_cast<const uint8_t*>(mapping);
+    return true;
+}
+
+void DiskCodeCache::IndexRecords() {
+    size_t offset = sizeof(FileHeader);
+
+    while(offset + sizeof(RecordHeader) <= mappingSize_) {
+        RecordHeader header {};
+        std::memcpy(&header, mapping_ + offset, sizeof(header));
+        if(header.magic != RECORD_MAGIC) {
+            break;
+        }
+
+        size_t available = mappingSize_ - offset - sizeof(header);
+        if(header.codeSize > available || AlignTo8(header.codeSize) > available ||
+           header.relocationsCount > (available - AlignTo8(header.codeSize)) / sizeof(Relocation)) {
+            break;
+        }
+
+        const uint8_t* code = mapping_ + offset + sizeof(header);
+        auto *relocations = reinterpret_cast<const Relocation*>(code + AlignTo8(header.codeSize));
+        if(RecordChecksum(header, code, relocations) != header.checksum) {
+            break;
+        }
+
+        if(header.compilerVersion == compilerVersion_) {
+            CachedCodeView view {code, header.codeSize, relocations, header.relocationsCount};
+            mappedEntries_[header.graphHash] = MappedEntry {header.keyDigest, view};
+            ++stats_.loadedRecords;
+        } else {
+            ++stats_.skippedRecords;
+        }
+
+        offset += sizeof(header) + AlignTo8(header.codeSize) + header.relocationsCount * sizeof(Relocation);
+    }
+
+    validSize_ = offset;
+    stats_.corruptedBytes = mappingSize_ - offset;
+}
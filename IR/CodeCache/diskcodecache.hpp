@@ -0,0 +1,86 @@
+#ifndef IR_DISK_CODE_CACHE_HPP
+#define IR_DISK_CODE_CACHE_HPP
+
+#include "CodeCache/codecache.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+// Zero-copy view into a record of the mapped cache file.
+struct CachedCodeView {
+    const uint8_t* code = nullptr;
+    size_t codeSize = 0;
+    const Relocation* relocations = nullptr;
+    size_t relocationsCount = 0;
+};
+
+struct DiskCodeCacheStats {
+    size_t loadedRecords = 0;
+    size_t skippedRecords = 0;
+    size_t corruptedBytes = 0;
+};
+
+// Append-only file of compiled code records keyed by graph hash and compiler
+// version. Each record also keeps a second, independent digest of the graph
+// key, so a hash collision is a miss rather than code for another graph. Open() maps the file read-only and indexes every record whose
+// checksum holds; a torn or corrupted tail is ignored and cut off by the next
+// Store(). Records stored after Open() are served from memory until the file
+// is reopened.
+//
+// File layout:
+//     FileHeader
+//     { RecordHeader, code (padded to 8 bytes), Relocation[] }*
+class DiskCodeCache final {
+public:
+    DiskCodeCache(std::string path, uint32_t compilerVersion):
+        path_(std::move(path)), compilerVersion_(compilerVersion) {}
+    ~DiskCodeCache();
+
+    DiskCodeCache(const DiskCodeCache&) = delete;
+    DiskCodeCache& operator=(const DiskCodeCache&) = delete;
+
+    bool Open();
+    void Close();
+
+    std::optional<CachedCodeView> Lookup(uint64_t hash, const GraphKey &key) const;
+    bool Store(uint64_t hash, const GraphKey &key, const CompiledCode &code);
+
+    size_t GetEntriesCount() const;
+    const DiskCodeCacheStats& GetStats() const;
+
+    static constexpr uint32_t FORMAT_VERSION = 2;
+
+private:
+    struct MappedEntry {
+        uint64_t keyDigest = 0;
+        CachedCodeView view;
+    };
+
+    struct StoredEntry {
+        uint64_t keyDigest = 0;
+        std::unique_ptr<CompiledCode> code;
+    };
+
+    bool CreateFile();
+    bool MapFile();
+    void IndexRecords();
+
+private:
+    std::string path_;
+    uint32_t compilerVersion_ = 0;
+
+    int fd_ = -1;
+    const uint8_t* mapping_ = nullptr;
+    size_t mappingSize_ = 0;
+    size_t validSize_ = 0;
+
+    std::unordered_map<uint64_t, MappedEntry> mappedEntries_;
+    std::unordered_map<uint64_t, StoredEntry> storedEntries_;
+
+    DiskCodeCacheStats stats_;
+};
+
+#endif  // IR_DISK_CODE_CACHE_HPP
@@ -0,0 +1,383 @@
+#include "Codegen/instrselector.hpp"
+
+#include "BasicBlock/basicblock.hpp"
+#include "Instr/datatraits.hpp"
+
+namespace {
+
+int64_t GetConditionBound(OpType condition) {
+    // CMP result is 0 (below), 1 (equal) or 2 (above).
+    return condition == OpType::JA ? 2 : 1;
+}
+
+MOpcode GetRegCondition(OpType condition) {
+    return condition == OpType::JAE ? MOpcode::JAE : MOpcode::JE;
+}
+
+}  // namespace
+
+MachineFunction InstructionSelector::Run() {
+    function_ = MachineFunction();
+    states_.clear();
+
+    LoweringContext context(graph_, &function_, false);
+    context_ = &context;
+
+    for(auto &block: graph_->GetBlocks()) {
+        blockIdx_ = context.GetBlockIdx(block.get());
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            if(instr->IsPhi() || instr->GetOpType() == OpType::CONST || IsFolded(instr)) {
+                continue;
+            }
+            Label(instr);
+            // Terminators and guards derive STMT, everything else is computed into a register.
+            bool isStmt = states_.at(instr).costs[static_cast<size_t>(NonTerminal::STMT)] < INFINITE_COST;
+            Reduce(instr, isStmt ? NonTerminal::STMT : GetRegister(instr));
+        }
+    }
+
+    context_ = nullptr;
+    return std::move(function_);
+}
+
+bool InstructionSelector::IsFolded(Instruction* instr) const {
+    switch(instr->GetOpType()) {
+        case OpType::PHI:
+        case OpType::PRM:
+        case OpType::CONST:
+        // Folding would move memory accesses past the stores in between.
+        case OpType::NEW_OBJECT:
+        case OpType::LOAD_FIELD:
+        case OpType::LOAD:
+            return false;
+        default:
+            break;
+    }
+    if(instr->GetResultType() == DataType::VOID || instr->GetUsesCount() != 1) {
+        return false;
+    }
+
+    auto &use = *instr->GetUses().begin();
+    auto *user = use.GetUser();
+    return user->GetParentBB() == instr->GetParentBB() && !user->IsPhi() && !IsValueInput(user, use.GetIndex());
+}
+
+// Inputs past the condition of guards and selects are plain registers.
+bool InstructionSelector::IsValueInput(Instruction* user, size_t inputIdx) {
+    return (user->GetOpType() == OpType::DEOPT || user->GetOpType() == OpType::SELECT) && inputIdx != 0;
+}
+
+bool InstructionSelector::IsTreeEdge(Instruction* user, size_t inputIdx) const {
+    if(user->IsPhi() || IsValueInput(user, inputIdx)) {
+        return false;
+    }
+    auto *input = user->GetInputs()[inputIdx].GetValue();
+    return input->GetOpType() == OpType::CONST || IsFolded(input);
+}
+
+NonTerminal InstructionSelector::GetRegister(Instruction* instr) {
+    return IsVectorType(instr->GetResultType()) ? NonTerminal::VREG : NonTerminal::REG;
+}
+
+bool InstructionSelector::MatchesPredicate(const SelectionRule &rule, Instruction* instr) const {
+    if(instr->GetInputs().size() < rule.GetArity()) {
+        return false;
+    }
+    // Vector and scalar forms of the same opcode are told apart by the result type.
+    if((rule.result == NonTerminal::VREG) != (GetRegister(instr) == NonTerminal::VREG)) {
+        return false;
+    }
+    if(rule.id != RuleId::CONST_IMM && rule.id != RuleId::CONST_SCALE) {
+        return true;
+    }
+
+    int64_t value = static_cast<ConstantInstr*>(instr)->GetAsSignedInt();
+    if(rule.id == RuleId::CONST_IMM) {
+        return value >= std::numeric_limits<int32_t>::min() && value <= std::numeric_limits<int32_t>::max();
+    }
+    return value == 1 || value == 2 || value == 4 || value == 8;
+}
+
+uint32_t InstructionSelector::GetInputCost(Instruction* user, size_t inputIdx, NonTerminal nt) const {
+    if(IsTreeEdge(user, inputIdx)) {
+        return states_.at(user->GetInputs()[inputIdx].GetValue()).costs[static_cast<size_t>(nt)];
+    }
+    return nt == GetRegister(user->GetInputs()[inputIdx].GetValue()) ? 0 : INFINITE_COST;
+}
+
+void InstructionSelector::Label(Instruction* instr) {
+    if(states_.count(instr) != 0) {
+        return;
+    }
+
+    auto &inputs = instr->GetInputs();
+    for(size_t idx = 0; idx < inputs.size(); ++idx) {
+        if(IsTreeEdge(instr, idx)) {
+            Label(inputs[idx].GetValue());
+        }
+    }
+
+    NodeState state;
+    state.costs.fill(INFINITE_COST);
+    state.rules.fill(RuleId::COUNT);
+
+    size_t op = static_cast<size_t>(instr->GetOpType());
+    for(size_t idx = 0; idx < RULE_TABLE.counts[op]; ++idx) {
+        auto &rule = SELECTION_RULES[static_cast<size_t>(RULE_TABLE.rules[RULE_TABLE.offsets[op] + idx])];
+        if(!MatchesPredicate(rule, instr)) {
+            continue;
+        }
+
+        uint32_t cost = rule.cost;
+        for(size_t child = 0; child < rule.GetArity(); ++child) {
+            cost += GetInputCost(instr, child, rule.children[child]);
+        }
+
+        size_t result = static_cast<size_t>(rule.result);
+        if(cost < state.costs[result]) {
+            state.costs[result] = cost;
+            state.rules[result] = rule.id;
+        }
+    }
+
+    size_t chainOp = static_cast<size_t>(OpType::UNDEFINED);
+    for(bool changed = true; changed;) {
+        changed = false;
+        for(size_t idx = 0; idx < RULE_TABLE.counts[chainOp]; ++idx) {
+            auto &rule = SELECTION_RULES[static_cast<size_t>(RULE_TABLE.rules[RULE_TABLE.offsets[chainOp] + idx])];
+            uint32_t cost = state.costs[static_cast<size_t>(rule.children[0])] + rule.cost;
+            size_t result = static_cast<size_t>(rule.result);
+            if(cost < state.costs[result]) {
+                state.costs[result] = cost;
+                state.rules[result] = rule.id;
+                changed = true;
+            }
+        }
+    }
+
+    states_[instr] = state;
+}
+
+MachineOperand InstructionSelector::Reduce(Instruction* instr, NonTerminal nt) {
+    auto ruleId = states_.at(instr).rules[static_cast<size_t>(nt)];
+    auto &rule = SELECTION_RULES[static_cast<size_t>(ruleId)];
+
+    std::array<MachineOperand, 2> ops;
+    if(rule.IsChain()) {
+        ops[0] = Reduce(instr, rule.children[0]);
+    } else {
+        for(size_t child = 0; child < rule.GetArity(); ++child) {
+            ops[child] = ReduceInput(instr, child, rule.children[child]);
+        }
+    }
+    return EmitRule(rule, instr, ops);
+}
+
+MachineOperand InstructionSelector::ReduceInput(Instruction* user, size_t inputIdx, NonTerminal nt) {
+    auto *input = user->GetInputs()[inputIdx].GetValue();
+    if(IsTreeEdge(user, inputIdx)) {
+        return Reduce(input, nt);
+    }
+    return context_->GetValue(input);
+}
+
+MachineOperand InstructionSelector::EmitRule(const SelectionRule &rule, Instruction* instr,
+                                             const std::array<MachineOperand, 2> &ops) {
+    auto dst = MachineOperand::VReg(instr->GetId());
+    auto rax = MachineOperand::PReg(PhysReg::RAX);
+    auto &[lhs, rhs] = ops;
+
+    switch(rule.id) {
+        case RuleId::CONST_REG: {
+            auto reg = MachineOperand::VReg(function_.NewVReg());
+            function_.Emit(blockIdx_, MOpcode::MOV,
+                           {reg, MachineOperand::Imm(static_cast<ConstantInstr*>(instr)->GetAsSignedInt())});
+            return reg;
+        }
+        case RuleId::CONST_IMM:
+        case RuleId::CONST_SCALE:
+            return MachineOperand::Imm(static_cast<ConstantInstr*>(instr)->GetAsSignedInt());
+        case RuleId::PARAM_REG:
+            function_.Emit(blockIdx_, MOpcode::MOV,
+                           {dst, context_->GetParameterLocation(static_cast<ParameterInstr*>(instr)->GetArgNum())});
+            return dst;
+        case RuleId::INDEX_REG:
+            function_.Emit(blockIdx_, MOpcode::LEA, {dst, lhs});
+            return dst;
+        case RuleId::FLAGS_REG: {
+            auto tmp = MachineOperand::VReg(function_.NewVReg());
+            function_.Emit(blockIdx_, MOpcode::SETA, {tmp});
+            function_.Emit(blockIdx_, MOpcode::SETAE, {dst});
+            function_.Emit(blockIdx_, MOpcode::ADD, {dst, tmp});
+            return dst;
+        }
+        case RuleId::ADD_RR:
+            function_.Emit(blockIdx_, MOpcode::LEA, {dst, MachineOperand::Address(lhs.reg, rhs.reg, 1, 0)});
+            return dst;
+        case RuleId::ADD_RI:
+        case RuleId::SUB_RI: {
+            int64_t disp = rule.id == RuleId::SUB_RI ? -rhs.imm : rhs.imm;
+            function_.Emit(blockIdx_, MOpcode::LEA,
+                           {dst, MachineOperand::Address(lhs.reg, MachineOperand::NO_REG, 1, disp)});
+            return dst;
+        }
+        case RuleId::ADD_IR:
+            function_.Emit(blockIdx_, MOpcode::LEA,
+                           {dst, MachineOperand::Address(rhs.reg, MachineOperand::NO_REG, 1, lhs.imm)});
+            return dst;
+        case RuleId::ADD_R_INDEX:
+            function_.Emit(blockIdx_, MOpcode::LEA, {dst, MachineOperand::Address(lhs.reg, rhs.index, rhs.scale, 0)});
+            return dst;
+        case RuleId::ADD_INDEX_R:
+            function_.Emit(blockIdx_, MOpcode::LEA, {dst, MachineOperand::Address(rhs.reg, lhs.index, lhs.scale, 0)});
+            return dst;
+        case RuleId::SUB_RR:
+        case RuleId::MUL_RR:
+            function_.Emit(blockIdx_, MOpcode::MOV, {dst, lhs});
+            function_.Emit(blockIdx_, rule.id == RuleId::SUB_RR ? MOpcode::SUB : MOpcode::IMUL, {dst, rhs});
+            return dst;
+        case RuleId::AND_RR:
+        case RuleId::AND_RI:
+            function_.Emit(blockIdx_, MOpcode::MOV, {dst, lhs});
+            function_.Emit(blockIdx_, MOpcode::AND, {dst, rhs});
+            return dst;
+        case RuleId::MUL_RI:
+            function_.Emit(blockIdx_, MOpcode::IMUL, {dst, lhs, rhs});
+            return dst;
+        case RuleId::MUL_IR:
+            function_.Emit(blockIdx_, MOpcode::IMUL, {dst, rhs, lhs});
+            return dst;
+        case RuleId::INDEX_MUL_RS:
+            return MachineOperand::Address(MachineOperand::NO_REG, lhs.reg, static_cast<uint8_t>(rhs.imm), 0);
+        case RuleId::INDEX_MUL_SR:
+            return MachineOperand::Address(MachineOperand::NO_REG, rhs.reg, static_cast<uint8_t>(lhs.imm), 0);
+        case RuleId::DIV_RR:
+        case RuleId::MOD_RR:
+            context_->EmitDivision(blockIdx_, instr->GetOpType(), instr->GetResultType(), dst, lhs, rhs);
+            return dst;
+        case RuleId::MULH_RR:
+            context_->EmitMulHigh(blockIdx_, instr->GetResultType(), dst, lhs, rhs);
+            return dst;
+        case RuleId::SHR_RR:
+        case RuleId::SHR_RI:
+            context_->EmitShiftRight(blockIdx_, instr->GetResultType(), dst, lhs, rhs);
+            return dst;
+        case RuleId::VADD_VV:
+        case RuleId::VSUB_VV:
+        case RuleId::VMUL_VV:
+        case RuleId::VAND_VV:
+            context_->EmitVectorBinary(blockIdx_, instr->GetOpType(), instr->GetResultType(), dst, lhs, rhs);
+            return dst;
+        case RuleId::SPLAT_R:
+            context_->EmitSplat(blockIdx_, instr->GetResultType(), dst, lhs);
+            return dst;
+        case RuleId::IOTA_V:
+            context_->EmitIota(blockIdx_, instr->GetResultType(), dst);
+            return dst;
+        case RuleId::REDUCE_V:
+            context_->EmitReduce(blockIdx_, static_cast<ReduceInstr*>(instr)->GetReduceOp(),
+                                 instr->GetInputs()[0].GetValue()->GetResultType(), dst, lhs);
+            return dst;
+        case RuleId::CMP_RR:
+        case RuleId::CMP_RI:
+            function_.Emit(blockIdx_, MOpcode::CMP, {lhs, rhs});
+            return MachineOperand::Imm(0);
+        case RuleId::MOV_R:
+        case RuleId::CAST_R:
+            function_.Emit(blockIdx_, MOpcode::MOV, {dst, lhs});
+            return dst;
+        case RuleId::JMP:
+            context_->EmitJmp(blockIdx_, instr->GetParentBB(), static_cast<JmpInstr*>(instr)->GetBBToJmp());
+            return {};
+        case RuleId::JA_FLAGS:
+        case RuleId::JAE_FLAGS:
+        case RuleId::JE_FLAGS:
+        case RuleId::JA_REG:
+        case RuleId::JAE_REG:
+        case RuleId::JE_REG: {
+            auto *branch = static_cast<CjmpInstr*>(instr);
+            auto cc = LoweringContext::GetCondition(instr->GetOpType());
+            if(rule.children[0] == NonTerminal::REG) {
+                function_.Emit(blockIdx_, MOpcode::CMP,
+                               {lhs, MachineOperand::Imm(GetConditionBound(instr->GetOpType()))});
+                cc = GetRegCondition(instr->GetOpType());
+            }
+            context_->EmitCondBranch(blockIdx_, instr->GetParentBB(), cc,
+                                     branch->GetTrueBranchBB(), branch->GetFalseBranchBB());
+            return {};
+        }
+        case RuleId::SELECT_FLAGS:
+        case RuleId::SELECT_REG: {
+            auto condition = static_cast<SelectInstr*>(instr)->GetCondition();
+            auto cc = LoweringContext::GetCondition(condition);
+            if(rule.id == RuleId::SELECT_REG) {
+                function_.Emit(blockIdx_, MOpcode::CMP, {lhs, MachineOperand::Imm(GetConditionBound(condition))});
+                cc = GetRegCondition(condition);
+            }
+            // Moves leave the flags alone; cmov needs its source in a register.
+            auto &inputs = instr->GetInputs();
+            auto ifTrue = context_->GetValue(inputs[1].GetValue());
+            if(ifTrue.kind == MOperandKind::IMM) {
+                auto reg = MachineOperand::VReg(function_.NewVReg());
+                function_.Emit(blockIdx_, MOpcode::MOV, {reg, ifTrue});
+                ifTrue = reg;
+            }
+            function_.Emit(blockIdx_, MOpcode::MOV, {dst, context_->GetValue(inputs[2].GetValue())});
+            function_.Emit(blockIdx_, LoweringContext::GetMoveCondition(cc), {dst, ifTrue});
+            return dst;
+        }
+        case RuleId::GUARD_FLAGS:
+        case RuleId::GUARD_REG: {
+            auto *guard = static_cast<GuardInstr*>(instr);
+            auto cc = LoweringContext::GetCondition(guard->GetCondition());
+            if(rule.id == RuleId::GUARD_REG) {
+                function_.Emit(blockIdx_, MOpcode::CMP,
+                               {lhs, MachineOperand::Imm(GetConditionBound(guard->GetCondition()))});
+                cc = GetRegCondition(guard->GetCondition());
+            }
+            context_->EmitGuard(blockIdx_, guard, cc);
+            return {};
+        }
+        case RuleId::BOUNDS_CHECK_RR:
+        case RuleId::BOUNDS_CHECK_RI:
+            context_->EmitBoundsCheck(blockIdx_, static_cast<BoundsCheckInstr*>(instr), lhs, rhs);
+            return {};
+        case RuleId::OVERFLOW_CHECK_RR:
+        case RuleId::OVERFLOW_CHECK_RI:
+            context_->EmitOverflowCheck(blockIdx_, static_cast<OverflowCheckInstr*>(instr), lhs, rhs);
+            return {};
+        case RuleId::NEW_OBJECT_R:
+            function_.Emit(blockIdx_, MOpcode::NEWOBJ,
+                           {dst, MachineOperand::Imm(static_cast<NewObjectInstr*>(instr)->GetFieldsCount())});
+            return dst;
+        case RuleId::LOAD_FIELD_R: {
+            auto field = static_cast<LoadFieldInstr*>(instr)->GetField();
+            function_.Emit(blockIdx_, MOpcode::MOV, {dst, LoweringContext::GetFieldAddress(lhs, field)});
+            return dst;
+        }
+        case RuleId::STORE_FIELD_RR:
+        case RuleId::STORE_FIELD_RI: {
+            auto field = static_cast<StoreFieldInstr*>(instr)->GetField();
+            function_.Emit(blockIdx_, MOpcode::MOV, {LoweringContext::GetFieldAddress(lhs, field), rhs});
+            return {};
+        }
+        case RuleId::LOAD_R: {
+            auto offset = static_cast<LoadInstr*>(instr)->GetOffset();
+            function_.Emit(blockIdx_, MOpcode::MOV, {dst, LoweringContext::GetAddress(lhs, offset)});
+            return dst;
+        }
+        case RuleId::STORE_RR:
+        case RuleId::STORE_RI: {
+            auto offset = static_cast<StoreInstr*>(instr)->GetOffset();
+            function_.Emit(blockIdx_, MOpcode::MOV, {LoweringContext::GetAddress(lhs, offset), rhs});
+            return {};
+        }
+        case RuleId::RET_R:
+        case RuleId::RET_I:
+            function_.Emit(blockIdx_, MOpcode::MOV, {rax, lhs});
+            function_.Emit(blockIdx_, MOpcode::RET);
+            return {};
+        default:
+            return {};
+    }
+}
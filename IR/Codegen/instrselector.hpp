@@ -0,0 +1,141 @@
+#ifndef IR_INSTR_SELECTOR_HPP
+#define IR_INSTR_SELECTOR_HPP
+
+#include "Codegen/loweringcontext.hpp"
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+
+enum class NonTerminal: uint8_t {
+    NONE,
+    REG,
+    IMM,
+    SCALE,
+    INDEX,
+    FLAGS,
+    STMT,
+    VREG,
+    COUNT,
+};
+
+enum class RuleId: uint16_t {
+    #define RULE_DEF(name, result, opcode, child0, child1, cost) name,
+
+    #include "selectionrules.hpp"
+    #undef RULE_DEF
+    COUNT,
+};
+
+struct SelectionRule {
+    RuleId id = RuleId::COUNT;
+    NonTerminal result = NonTerminal::NONE;
+    OpType opcode = OpType::UNDEFINED;
+    std::array<NonTerminal, 2> children = {NonTerminal::NONE, NonTerminal::NONE};
+    uint32_t cost = 0;
+
+    constexpr bool IsChain() const {
+        return opcode == OpType::UNDEFINED;
+    }
+    constexpr size_t GetArity() const {
+        return static_cast<size_t>(children[0] != NonTerminal::NONE) +
+               static_cast<size_t>(children[1] != NonTerminal::NONE);
+    }
+};
+
+inline constexpr size_t RULES_COUNT = static_cast<size_t>(RuleId::COUNT);
+inline constexpr size_t NON_TERMINALS_COUNT = static_cast<size_t>(NonTerminal::COUNT);
+
+inline constexpr std::array<SelectionRule, RULES_COUNT> SELECTION_RULES = {{
+    #define RULE_DEF(name, result, opcode, child0, child1, cost) \
+        SelectionRule {RuleId::name, NonTerminal::result, OpType::opcode, {NonTerminal::child0, NonTerminal::child1}, cost},
+
+    #include "selectionrules.hpp"
+    #undef RULE_DEF
+}};
+
+// Rules grouped by opcode; chain rules live under OpType::UNDEFINED.
+struct RuleTable {
+    std::array<size_t, OPCODES_COUNT> offsets {};
+    std::array<size_t, OPCODES_COUNT> counts {};
+    std::array<RuleId, RULES_COUNT> rules {};
+};
+
+constexpr RuleTable BuildRuleTable() {
+    RuleTable table;
+    for(auto &rule: SELECTION_RULES) {
+        ++table.counts[static_cast<size_t>(rule.opcode)];
+    }
+    for(size_t op = 1; op < OPCODES_COUNT; ++op) {
+        table.offsets[op] = table.offsets[op - 1] + table.counts[op - 1];
+    }
+    std::array<size_t, OPCODES_COUNT> filled {};
+    for(auto &rule: SELECTION_RULES) {
+        size_t op = static_cast<size_t>(rule.opcode);
+        table.rules[table.offsets[op] + filled[op]++] = rule.id;
+    }
+    return table;
+}
+
+inline constexpr RuleTable RULE_TABLE = BuildRuleTable();
+
+constexpr bool RulesAreWellFormed() {
+    for(size_t idx = 0; idx < RULES_COUNT; ++idx) {
+        auto &rule = SELECTION_RULES[idx];
+        if(static_cast<size_t>(rule.id) != idx || rule.result == NonTerminal::NONE) {
+            return false;
+        }
+        if(rule.IsChain() && (rule.GetArity() != 1 || rule.children[0] == rule.result)) {
+            return false;
+        }
+        if(rule.children[0] == NonTerminal::NONE && rule.children[1] != NonTerminal::NONE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(RulesAreWellFormed(), "malformed instruction selection rule");
+static_assert(RULE_TABLE.offsets[OPCODES_COUNT - 1] + RULE_TABLE.counts[OPCODES_COUNT - 1] == RULES_COUNT);
+
+// Bottom-up rewriting instruction selector. The block is cut into trees: an
+// instruction with a single use in the same block is folded into its user,
+// constants are folded everywhere. Every tree is labelled with the cheapest
+// rule per non-terminal and reduced from the root.
+class InstructionSelector final {
+public:
+    explicit InstructionSelector(Graph* graph): graph_(graph) {}
+
+    MachineFunction Run();
+
+private:
+    static constexpr uint32_t INFINITE_COST = std::numeric_limits<uint32_t>::max() / 4;
+
+    struct NodeState {
+        std::array<uint32_t, NON_TERMINALS_COUNT> costs;
+        std::array<RuleId, NON_TERMINALS_COUNT> rules;
+    };
+
+    bool IsFolded(Instruction* instr) const;
+    static bool IsValueInput(Instruction* user, size_t inputIdx);
+    bool IsTreeEdge(Instruction* user, size_t inputIdx) const;
+    static NonTerminal GetRegister(Instruction* instr);
+    bool MatchesPredicate(const SelectionRule &rule, Instruction* instr) const;
+    uint32_t GetInputCost(Instruction* user, size_t inputIdx, NonTerminal nt) const;
+
+    void Label(Instruction* instr);
+    MachineOperand Reduce(Instruction* instr, NonTerminal nt);
+    MachineOperand ReduceInput(Instruction* user, size_t inputIdx, NonTerminal nt);
+    MachineOperand EmitRule(const SelectionRule &rule, Instruction* instr, const std::array<MachineOperand, 2> &ops);
+
+private:
+    Graph* graph_ = nullptr;
+    MachineFunction function_;
+    LoweringContext* context_ = nullptr;
+    size_t blockIdx_ = 0;
+
+    std::unordered_map<Instruction*, NodeState> states_;
+};
+
+#endif  // IR_INSTR_SELECTOR_HPP
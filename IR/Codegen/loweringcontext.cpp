@@ -0,0 +1,439 @@
+#include "Codegen/loweringcontext.hpp"
+
+#include "Instr/datatraits.hpp"
+
+#include <algorithm>
+
+namespace {
+
+bool IsSignedType(DataType type) {
+    return type == DataType::I8 || type == DataType::I16 || type == DataType::I32 || type == DataType::I64;
+}
+
+bool IsAvxType(DataType type) {
+    return GetElementBits(type) * GetLanesCount(type) > 128;
+}
+
+MOpcode GetMoveOpcode(DataType type) {
+    if(!IsVectorType(type)) {
+        return MOpcode::MOV;
+    }
+    return IsAvxType(type) ? MOpcode::VMOVDQA : MOpcode::MOVDQA;
+}
+
+MOpcode GetVectorOpcode(OpType op, uint32_t bits, bool avx) {
+    switch(op) {
+        case OpType::ADD:
+            if(bits == 16) {
+                return avx ? MOpcode::VPADDW : MOpcode::PADDW;
+            }
+            if(bits == 32) {
+                return avx ? MOpcode::VPADDD : MOpcode::PADDD;
+            }
+            return avx ? MOpcode::VPADDQ : MOpcode::PADDQ;
+        case OpType::SUB:
+            if(bits == 16) {
+                return avx ? MOpcode::VPSUBW : MOpcode::PSUBW;
+            }
+            if(bits == 32) {
+                return avx ? MOpcode::VPSUBD : MOpcode::PSUBD;
+            }
+            return avx ? MOpcode::VPSUBQ : MOpcode::PSUBQ;
+        case OpType::MUL:
+            // The vectorizer only emits 16-bit multiplications and 32-bit ones on AVX2.
+            if(bits == 32) {
+                return MOpcode::VPMULLD;
+            }
+            return avx ? MOpcode::VPMULLW : MOpcode::PMULLW;
+        default:
+            return avx ? MOpcode::VPAND : MOpcode::PAND;
+    }
+}
+
+}  // namespace
+
+LoweringContext::LoweringContext(Graph* graph, MachineFunction* function, bool constantsInRegisters):
+    graph_(graph), function_(function), constantsInRegisters_(constantsInRegisters) {
+    for(auto &block: graph_->GetBlocks()) {
+        blockIdx_[block.get()] = function_->AddBlock("BB_" + std::to_string(block->GetId()));
+    }
+    function_->ReserveVRegs(graph_->GetInstructions().size());
+}
+
+size_t LoweringContext::GetBlockIdx(BasicBlock* block) const {
+    return blockIdx_.at(block);
+}
+
+MachineOperand LoweringContext::GetValue(Instruction* value) const {
+    if(!constantsInRegisters_ && value->GetOpType() == OpType::CONST) {
+        return MachineOperand::Imm(static_cast<ConstantInstr*>(value)->GetAsSignedInt());
+    }
+    return MachineOperand::VReg(value->GetId());
+}
+
+MachineOperand LoweringContext::GetParameterLocation(uint32_t argNum) const {
+    static constexpr PhysReg ARG_REGS[] = {PhysReg::RDI, PhysReg::RSI, PhysReg::RDX,
+                                           PhysReg::RCX, PhysReg::R8,  PhysReg::R9};
+    constexpr uint32_t ARG_REGS_COUNT = sizeof(ARG_REGS) / sizeof(ARG_REGS[0]);
+
+    if(argNum < ARG_REGS_COUNT) {
+        return MachineOperand::PReg(ARG_REGS[argNum]);
+    }
+    return MachineOperand::Address(MachineOperand::NO_REG, MachineOperand::NO_REG, 1,
+                                   8 * static_cast<int64_t>(argNum - ARG_REGS_COUNT + 1));
+}
+
+MachineOperand LoweringContext::GetFieldAddress(MachineOperand object, uint32_t field) {
+    return GetAddress(object, 8 * static_cast<int64_t>(field));
+}
+
+MachineOperand LoweringContext::GetAddress(MachineOperand base, int64_t offset) {
+    return MachineOperand::Address(base.reg, MachineOperand::NO_REG, 1, offset);
+}
+
+void LoweringContext::EmitJmp(size_t blockIdx, BasicBlock* from, BasicBlock* to) {
+    EmitPhiMoves(blockIdx, from, to);
+
+    size_t target = GetBlockIdx(to);
+    if(target != blockIdx + 1) {
+        function_->Emit(blockIdx, MOpcode::JMP, {MachineOperand::Label(target)});
+    }
+}
+
+void LoweringContext::EmitCondBranch(size_t blockIdx, BasicBlock* from, MOpcode cc,
+                                     BasicBlock* ifTrue, BasicBlock* ifFalse) {
+    size_t trueTarget = GetEdgeTarget(from, ifTrue);
+    size_t falseTarget = GetEdgeTarget(from, ifFalse);
+
+    if(falseTarget == blockIdx + 1) {
+        function_->Emit(blockIdx, cc, {MachineOperand::Label(trueTarget)});
+    } else if(trueTarget == blockIdx + 1) {
+        function_->Emit(blockIdx, InvertCondition(cc), {MachineOperand::Label(falseTarget)});
+    } else {
+        function_->Emit(blockIdx, cc, {MachineOperand::Label(trueTarget)});
+        function_->Emit(blockIdx, MOpcode::JMP, {MachineOperand::Label(falseTarget)});
+    }
+}
+
+void LoweringContext::EmitGuard(size_t blockIdx, GuardInstr* guard, MOpcode cc) {
+    size_t stub = AddDeoptStub(guard);
+    auto deoptCc = guard->IsTakenExpected() ? InvertCondition(cc) : cc;
+    function_->Emit(blockIdx, deoptCc, {MachineOperand::Label(stub)});
+}
+
+void LoweringContext::EmitBoundsCheck(size_t blockIdx, BoundsCheckInstr* check, MachineOperand index,
+                                      MachineOperand length) {
+    size_t stub = AddDeoptStub(check);
+    function_->Emit(blockIdx, MOpcode::CMP, {index, length});
+    function_->Emit(blockIdx, MOpcode::JAE, {MachineOperand::Label(stub)});
+}
+
+void LoweringContext::EmitOverflowCheck(size_t blockIdx, OverflowCheckInstr* check, MachineOperand lhs,
+                                        MachineOperand rhs) {
+    size_t stub = AddDeoptStub(check);
+    auto type = check->GetCheckedType();
+    auto op = check->GetCheckedOp();
+    uint32_t bits = GetElementBits(type);
+    bool isSigned = IsSignedType(type);
+
+    if(bits >= 64 && !isSigned && op == OpType::MUL) {
+        // Unlike IMUL, MUL flags products that do not fit 64 unsigned bits.
+        auto rax = MachineOperand::PReg(PhysReg::RAX);
+        if(rhs.kind == MOperandKind::IMM) {
+            auto reg = MachineOperand::VReg(function_->NewVReg());
+            function_->Emit(blockIdx, MOpcode::MOV, {reg, rhs});
+            rhs = reg;
+        }
+        function_->Emit(blockIdx, MOpcode::MOV, {rax, lhs});
+        function_->Emit(blockIdx, MOpcode::MUL, {rhs});
+        function_->Emit(blockIdx, MOpcode::JO, {MachineOperand::Label(stub)});
+        return;
+    }
+
+    auto tmp = MachineOperand::VReg(function_->NewVReg());
+    auto opcode = op == OpType::ADD ? MOpcode::ADD : op == OpType::SUB ? MOpcode::SUB : MOpcode::IMUL;
+    function_->Emit(blockIdx, MOpcode::MOV, {tmp, lhs});
+    function_->Emit(blockIdx, opcode, {tmp, rhs});
+    if(bits >= 64) {
+        auto cc = isSigned || op == OpType::MUL ? MOpcode::JO : MOpcode::JB;
+        function_->Emit(blockIdx, cc, {MachineOperand::Label(stub)});
+        return;
+    }
+
+    // Narrower operands cannot overflow 64 bits, so the exact result is at
+    // hand and only has to be compared with the limits of the type.
+    uint64_t mask = (1ULL << bits) - 1;
+    if(isSigned) {
+        function_->Emit(blockIdx, MOpcode::ADD, {tmp, MachineOperand::Imm(static_cast<int64_t>(1ULL << (bits - 1)))});
+    }
+    function_->Emit(blockIdx, MOpcode::CMP, {tmp, MachineOperand::Imm(static_cast<int64_t>(mask))});
+    function_->Emit(blockIdx, MOpcode::JA, {MachineOperand::Label(stub)});
+}
+
+void LoweringContext::EmitDivision(size_t blockIdx, OpType op, DataType type, MachineOperand dst,
+                                   MachineOperand lhs, MachineOperand rhs) {
+    auto rax = MachineOperand::PReg(PhysReg::RAX);
+    auto rdx = MachineOperand::PReg(PhysReg::RDX);
+    bool isSigned = IsSignedType(type);
+    function_->Emit(blockIdx, MOpcode::MOV, {rax, lhs});
+    if(isSigned) {
+        function_->Emit(blockIdx, MOpcode::CQO);
+    } else {
+        function_->Emit(blockIdx, MOpcode::XOR, {rdx, rdx});
+    }
+    function_->Emit(blockIdx, isSigned ? MOpcode::IDIV : MOpcode::DIV, {rhs});
+    function_->Emit(blockIdx, MOpcode::MOV, {dst, op == OpType::MOD ? rdx : rax});
+}
+
+void LoweringContext::EmitMulHigh(size_t blockIdx, DataType type, MachineOperand dst, MachineOperand lhs,
+                                  MachineOperand rhs) {
+    uint32_t bits = GetElementBits(type);
+    bool isSigned = IsSignedType(type);
+    if(bits >= 64) {
+        auto rax = MachineOperand::PReg(PhysReg::RAX);
+        if(rhs.kind == MOperandKind::IMM) {
+            auto reg = MachineOperand::VReg(function_->NewVReg());
+            function_->Emit(blockIdx, MOpcode::MOV, {reg, rhs});
+            rhs = reg;
+        }
+        function_->Emit(blockIdx, MOpcode::MOV, {rax, lhs});
+        function_->Emit(blockIdx, isSigned ? MOpcode::IMUL : MOpcode::MUL, {rhs});
+        function_->Emit(blockIdx, MOpcode::MOV, {dst, MachineOperand::PReg(PhysReg::RDX)});
+        return;
+    }
+
+    // The whole product of narrower operands fits 64 bits.
+    function_->Emit(blockIdx, MOpcode::MOV, {dst, lhs});
+    function_->Emit(blockIdx, MOpcode::IMUL, {dst, rhs});
+    function_->Emit(blockIdx, isSigned ? MOpcode::SAR : MOpcode::SHR, {dst, MachineOperand::Imm(bits)});
+}
+
+void LoweringContext::EmitShiftRight(size_t blockIdx, DataType type, MachineOperand dst, MachineOperand lhs,
+                                     MachineOperand amount) {
+    if(amount.kind != MOperandKind::IMM) {
+        auto rcx = MachineOperand::PReg(PhysReg::RCX);
+        function_->Emit(blockIdx, MOpcode::MOV, {rcx, amount});
+        amount = rcx;
+    }
+    function_->Emit(blockIdx, MOpcode::MOV, {dst, lhs});
+    function_->Emit(blockIdx, IsSignedType(type) ? MOpcode::SAR : MOpcode::SHR, {dst, amount});
+}
+
+void LoweringContext::EmitVectorBinary(size_t blockIdx, OpType op, DataType type, MachineOperand dst,
+                                       MachineOperand lhs, MachineOperand rhs) {
+    bool avx = IsAvxType(type);
+    auto opcode = GetVectorOpcode(op, GetElementBits(type), avx);
+    if(avx || opcode == MOpcode::VPMULLD) {
+        function_->Emit(blockIdx, opcode, {dst, lhs, rhs});
+        return;
+    }
+    function_->Emit(blockIdx, MOpcode::MOVDQA, {dst, lhs});
+    function_->Emit(blockIdx, opcode, {dst, rhs});
+}
+
+void LoweringContext::EmitSplat(size_t blockIdx, DataType type, MachineOperand dst, MachineOperand scalar) {
+    if(scalar.kind == MOperandKind::IMM) {
+        auto reg = MachineOperand::VReg(function_->NewVReg());
+        function_->Emit(blockIdx, MOpcode::MOV, {reg, scalar});
+        scalar = reg;
+    }
+
+    uint32_t bits = GetElementBits(type);
+    if(IsAvxType(type)) {
+        auto tmp = MachineOperand::VReg(function_->NewVReg());
+        auto broadcast = bits == 16 ? MOpcode::VPBROADCASTW :
+                         bits == 32 ? MOpcode::VPBROADCASTD : MOpcode::VPBROADCASTQ;
+        function_->Emit(blockIdx, MOpcode::VMOVQ, {tmp, scalar});
+        function_->Emit(blockIdx, broadcast, {dst, tmp});
+        return;
+    }
+
+    function_->Emit(blockIdx, MOpcode::MOVQ, {dst, scalar});
+    if(bits == 32) {
+        function_->Emit(blockIdx, MOpcode::PSHUFD, {dst, dst, MachineOperand::Imm(0)});
+        return;
+    }
+    if(bits == 16) {
+        function_->Emit(blockIdx, MOpcode::PSHUFLW, {dst, dst, MachineOperand::Imm(0)});
+    }
+    function_->Emit(blockIdx, MOpcode::PUNPCKLQDQ, {dst, dst});
+}
+
+void LoweringContext::EmitIota(size_t blockIdx, DataType type, MachineOperand dst) {
+    uint32_t bits = GetElementBits(type);
+    uint32_t lanesPerQword = 64 / bits;
+    uint32_t qwordsCount = GetLanesCount(type) / lanesPerQword;
+
+    std::vector<int64_t> qwords(qwordsCount, 0);
+    for(uint32_t lane = 0; lane < GetLanesCount(type); ++lane) {
+        auto shift = (lane % lanesPerQword) * bits;
+        qwords[lane / lanesPerQword] |= static_cast<int64_t>(static_cast<uint64_t>(lane) << shift);
+    }
+
+    if(!IsAvxType(type)) {
+        auto lo = EmitQwordPair(blockIdx, false, qwords[0], qwords[1]);
+        function_->Emit(blockIdx, MOpcode::MOVDQA, {dst, lo});
+        return;
+    }
+    auto lo = EmitQwordPair(blockIdx, true, qwords[0], qwords[1]);
+    auto hi = EmitQwordPair(blockIdx, true, qwords[2], qwords[3]);
+    function_->Emit(blockIdx, MOpcode::VINSERTI128, {dst, lo, hi, MachineOperand::Imm(1)});
+}
+
+void LoweringContext::EmitReduce(size_t blockIdx, OpType op, DataType type, MachineOperand dst,
+                                 MachineOperand vector) {
+    bool avx = IsAvxType(type);
+    uint32_t bits = GetElementBits(type);
+    auto opcode = GetVectorOpcode(op, bits, avx);
+
+    // Fold the upper half onto the lower one until a single lane is left.
+    auto acc = MachineOperand::VReg(function_->NewVReg());
+    if(avx) {
+        auto hi = MachineOperand::VReg(function_->NewVReg());
+        function_->Emit(blockIdx, MOpcode::VEXTRACTI128, {hi, vector, MachineOperand::Imm(1)});
+        function_->Emit(blockIdx, opcode, {acc, vector, hi});
+    } else {
+        function_->Emit(blockIdx, MOpcode::MOVDQA, {acc, vector});
+    }
+
+    for(int64_t shift = 8; shift * 8 >= bits; shift /= 2) {
+        auto tmp = MachineOperand::VReg(function_->NewVReg());
+        if(avx || opcode == MOpcode::VPMULLD) {
+            function_->Emit(blockIdx, MOpcode::VPSRLDQ, {tmp, acc, MachineOperand::Imm(shift)});
+            function_->Emit(blockIdx, opcode, {acc, acc, tmp});
+        } else {
+            function_->Emit(blockIdx, MOpcode::MOVDQA, {tmp, acc});
+            function_->Emit(blockIdx, MOpcode::PSRLDQ, {tmp, MachineOperand::Imm(shift)});
+            function_->Emit(blockIdx, opcode, {acc, tmp});
+        }
+    }
+    function_->Emit(blockIdx, avx ? MOpcode::VMOVQ : MOpcode::MOVQ, {dst, acc});
+}
+
+MachineOperand LoweringContext::EmitQwordPair(size_t blockIdx, bool avx, int64_t lo, int64_t hi) {
+    auto loReg = MachineOperand::VReg(function_->NewVReg());
+    auto hiReg = MachineOperand::VReg(function_->NewVReg());
+    auto loVec = MachineOperand::VReg(function_->NewVReg());
+    auto hiVec = MachineOperand::VReg(function_->NewVReg());
+    auto movq = avx ? MOpcode::VMOVQ : MOpcode::MOVQ;
+
+    function_->Emit(blockIdx, MOpcode::MOV, {loReg, MachineOperand::Imm(lo)});
+    function_->Emit(blockIdx, movq, {loVec, loReg});
+    function_->Emit(blockIdx, MOpcode::MOV, {hiReg, MachineOperand::Imm(hi)});
+    function_->Emit(blockIdx, movq, {hiVec, hiReg});
+    if(avx) {
+        auto pair = MachineOperand::VReg(function_->NewVReg());
+        function_->Emit(blockIdx, MOpcode::VPUNPCKLQDQ, {pair, loVec, hiVec});
+        return pair;
+    }
+    function_->Emit(blockIdx, MOpcode::PUNPCKLQDQ, {loVec, hiVec});
+    return loVec;
+}
+
+MOpcode LoweringContext::InvertCondition(MOpcode cc) {
+    switch(cc) {
+        case MOpcode::JA:
+            return MOpcode::JBE;
+        case MOpcode::JAE:
+            return MOpcode::JB;
+        case MOpcode::JE:
+            return MOpcode::JNE;
+        case MOpcode::JBE:
+            return MOpcode::JA;
+        case MOpcode::JB:
+            return MOpcode::JAE;
+        case MOpcode::JNE:
+            return MOpcode::JE;
+        default:
+            return cc;
+    }
+}
+
+MOpcode LoweringContext::GetCondition(OpType branch) {
+    switch(branch) {
+        case OpType::JA:
+            return MOpcode::JA;
+        case OpType::JAE:
+            return MOpcode::JAE;
+        default:
+            return MOpcode::JE;
+    }
+}
+
+MOpcode LoweringContext::GetMoveCondition(MOpcode cc) {
+    switch(cc) {
+        case MOpcode::JA:
+            return MOpcode::CMOVA;
+        case MOpcode::JAE:
+            return MOpcode::CMOVAE;
+        default:
+            return MOpcode::CMOVE;
+    }
+}
+
+size_t LoweringContext::AddDeoptStub(Instruction* instr) {
+    size_t stub = function_->AddBlock("DEOPT_" + std::to_string(instr->GetId()));
+    function_->Emit(stub, MOpcode::DEOPT, {MachineOperand::Imm(static_cast<int64_t>(instr->GetId()))});
+    return stub;
+}
+
+size_t LoweringContext::GetEdgeTarget(BasicBlock* from, BasicBlock* to) {
+    auto *first = to->GetFirstInstr();
+    if(first == nullptr || !first->IsPhi()) {
+        return GetBlockIdx(to);
+    }
+
+    size_t edgeBlock = function_->AddBlock("BB_" + std::to_string(from->GetId()) + "_" + std::to_string(to->GetId()));
+    EmitPhiMoves(edgeBlock, from, to);
+    function_->Emit(edgeBlock, MOpcode::JMP, {MachineOperand::Label(GetBlockIdx(to))});
+    return edgeBlock;
+}
+
+void LoweringContext::EmitPhiMoves(size_t blockIdx, BasicBlock* from, BasicBlock* to) {
+    // Register classes never overlap, so every move kind is sequenced on its own.
+    for(auto move: {MOpcode::MOV, MOpcode::MOVDQA, MOpcode::VMOVDQA}) {
+        std::vector<std::pair<uint64_t, MachineOperand>> moves;
+        for(auto *instr = to->GetFirstInstr(); instr != nullptr && instr->IsPhi(); instr = instr->GetNext()) {
+            auto *input = static_cast<PhiInstr*>(instr)->GetPhiInput(from);
+            if(input != nullptr && GetMoveOpcode(instr->GetResultType()) == move) {
+                moves.emplace_back(instr->GetId(), GetValue(input));
+            }
+        }
+        EmitParallelMoves(blockIdx, move, std::move(moves));
+    }
+}
+
+void LoweringContext::EmitParallelMoves(size_t blockIdx, MOpcode move,
+                                        std::vector<std::pair<uint64_t, MachineOperand>> moves) {
+    auto isSource = [&moves](uint64_t reg) {
+        return std::any_of(moves.begin(), moves.end(), [reg](auto &move) {
+            return move.second.kind == MOperandKind::VREG && move.second.reg == reg;
+        });
+    };
+
+    moves.erase(std::remove_if(moves.begin(), moves.end(), [](auto &move) {
+        return move.second.kind == MOperandKind::VREG && move.second.reg == move.first;
+    }), moves.end());
+
+    while(!moves.empty()) {
+        auto ready = std::find_if(moves.begin(), moves.end(), [&isSource](auto &move) {
+            return !isSource(move.first);
+        });
+
+        if(ready == moves.end()) {
+            // Only cycles are left: save one destination and read it from the copy.
+            uint64_t saved = moves.front().first;
+            uint64_t tmp = function_->NewVReg();
+            function_->Emit(blockIdx, move, {MachineOperand::VReg(tmp), MachineOperand::VReg(saved)});
+            for(auto &move: moves) {
+                if(move.second.kind == MOperandKind::VREG && move.second.reg == saved) {
+                    move.second = MachineOperand::VReg(tmp);
+                }
+            }
+            continue;
+        }
+
+        function_->Emit(blockIdx, move, {MachineOperand::VReg(ready->first), ready->second});
+        moves.erase(ready);
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef IR_LOWERING_CONTEXT_HPP
+#define IR_LOWERING_CONTEXT_HPP
+
+#include "Codegen/machineinstr.hpp"
+#include "Graph/graph.hpp"
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Lowering state shared by the naive lowering and the instruction selector:
+// machine blocks laid out in graph order, phi moves on control flow edges,
+// branches with fall-through and deopt stubs. Value of an IR instruction lives
+// in the virtual register with the instruction id.
+class LoweringContext final {
+public:
+    LoweringContext(Graph* graph, MachineFunction* function, bool constantsInRegisters);
+
+    size_t GetBlockIdx(BasicBlock* block) const;
+
+    MachineOperand GetValue(Instruction* value) const;
+    MachineOperand GetParameterLocation(uint32_t argNum) const;
+    // Fields are 8 bytes each, laid out from the start of the object.
+    static MachineOperand GetFieldAddress(MachineOperand object, uint32_t field);
+    static MachineOperand GetAddress(MachineOperand base, int64_t offset);
+
+    void EmitJmp(size_t blockIdx, BasicBlock* from, BasicBlock* to);
+    void EmitCondBranch(size_t blockIdx, BasicBlock* from, MOpcode cc,
+                        BasicBlock* ifTrue, BasicBlock* ifFalse);
+    void EmitGuard(size_t blockIdx, GuardInstr* guard, MOpcode cc);
+    void EmitBoundsCheck(size_t blockIdx, BoundsCheckInstr* check, MachineOperand index, MachineOperand length);
+    // Operands are expected to hold values of the checked type extended to 64 bits.
+    void EmitOverflowCheck(size_t blockIdx, OverflowCheckInstr* check, MachineOperand lhs, MachineOperand rhs);
+
+    // Scalar operands are expected to hold values of `type` extended to 64 bits
+    // as well. `op` is DIV or MOD.
+    void EmitDivision(size_t blockIdx, OpType op, DataType type, MachineOperand dst,
+                      MachineOperand lhs, MachineOperand rhs);
+    void EmitMulHigh(size_t blockIdx, DataType type, MachineOperand dst, MachineOperand lhs, MachineOperand rhs);
+    void EmitShiftRight(size_t blockIdx, DataType type, MachineOperand dst, MachineOperand lhs,
+                        MachineOperand amount);
+
+    // Vector values use SSE2 forms for 128-bit types and AVX2 forms for 256-bit ones.
+    void EmitVectorBinary(size_t blockIdx, OpType op, DataType type, MachineOperand dst,
+                          MachineOperand lhs, MachineOperand rhs);
+    void EmitSplat(size_t blockIdx, DataType type, MachineOperand dst, MachineOperand scalar);
+    void EmitIota(size_t blockIdx, DataType type, MachineOperand dst);
+    void EmitReduce(size_t blockIdx, OpType op, DataType type, MachineOperand dst, MachineOperand vector);
+
+    static MOpcode InvertCondition(MOpcode cc);
+    static MOpcode GetCondition(OpType branch);
+    // Conditional move taken under the condition of jump `cc`.
+    static MOpcode GetMoveCondition(MOpcode cc);
+
+private:
+    size_t GetEdgeTarget(BasicBlock* from, BasicBlock* to);
+    size_t AddDeoptStub(Instruction* instr);
+    void EmitPhiMoves(size_t blockIdx, BasicBlock* from, BasicBlock* to);
+    void EmitParallelMoves(size_t blockIdx, MOpcode move, std::vector<std::pair<uint64_t, MachineOperand>> moves);
+    MachineOperand EmitQwordPair(size_t blockIdx, bool avx, int64_t lo, int64_t hi);
+
+private:
+    Graph* graph_ = nullptr;
+    MachineFunction* function_ = nullptr;
+    bool constantsInRegisters_ = true;
+
+    std::unordered_map<BasicBlock*, size_t> blockIdx_;
+};
+
+#endif  // IR_LOWERING_CONTEXT_HPP
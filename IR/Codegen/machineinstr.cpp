@@ -0,0 +1,171 @@
+#include "Codegen/machineinstr.hpp"
+
+namespace {
+
+const char* PhysRegToString(PhysReg preg) {
+    switch(preg) {
+        case PhysReg::RAX:
+            return "rax";
+        case PhysReg::RDX:
+            return "rdx";
+        case PhysReg::RDI:
+            return "rdi";
+        case PhysReg::RSI:
+            return "rsi";
+        case PhysReg::RCX:
+            return "rcx";
+        case PhysReg::R8:
+            return "r8";
+        case PhysReg::R9:
+            return "r9";
+    }
+    return "";
+}
+
+void DumpOperand(std::ostream &ostr, const MachineOperand &operand, const std::vector<MachineBlock> &blocks) {
+    switch(operand.kind) {
+        case MOperandKind::VREG:
+            ostr << "%" << operand.reg;
+            break;
+        case MOperandKind::PREG:
+            ostr << PhysRegToString(static_cast<PhysReg>(operand.reg));
+            break;
+        case MOperandKind::IMM:
+            ostr << operand.imm;
+            break;
+        case MOperandKind::LABEL:
+            ostr << blocks[operand.reg].name;
+            break;
+        case MOperandKind::ADDR: {
+            ostr << "[";
+            bool needPlus = false;
+            if(operand.reg != MachineOperand::NO_REG) {
+                ostr << "%" << operand.reg;
+                needPlus = true;
+            }
+            if(operand.index != MachineOperand::NO_REG) {
+                ostr << (needPlus ? " + " : "") << "%" << operand.index << "*" << static_cast<int>(operand.scale);
+                needPlus = true;
+            }
+            if(operand.imm != 0 || !needPlus) {
+                ostr << (needPlus ? (operand.imm < 0 ? " - " : " + ") : "")
+                     << (needPlus && operand.imm < 0 ? -operand.imm : operand.imm);
+            }
+            ostr << "]";
+            break;
+        }
+    }
+}
+
+}  // namespace
+
+std::string MOpcodeToString(MOpcode opcode) {
+    switch(opcode)
+    {
+        #define MINSTR_DEF(name, asm_name) \
+        case MOpcode::name:                 \
+            return asm_name;
+
+        #include "minstrdef.hpp"
+        #undef MINSTR_DEF
+    }
+
+    return "";
+}
+
+MachineOperand MachineOperand::VReg(uint64_t vreg) {
+    MachineOperand operand;
+    operand.kind = MOperandKind::VREG;
+    operand.reg = vreg;
+    return operand;
+}
+
+MachineOperand MachineOperand::PReg(PhysReg preg) {
+    MachineOperand operand;
+    operand.kind = MOperandKind::PREG;
+    operand.reg = static_cast<uint64_t>(preg);
+    return operand;
+}
+
+MachineOperand MachineOperand::Imm(int64_t value) {
+    MachineOperand operand;
+    operand.kind = MOperandKind::IMM;
+    operand.imm = value;
+    return operand;
+}
+
+MachineOperand MachineOperand::Label(uint64_t blockIdx) {
+    MachineOperand operand;
+    operand.kind = MOperandKind::LABEL;
+    operand.reg = blockIdx;
+    return operand;
+}
+
+MachineOperand MachineOperand::Address(uint64_t base, uint64_t index, uint8_t scale, int64_t disp) {
+    MachineOperand operand;
+    operand.kind = MOperandKind::ADDR;
+    operand.reg = base;
+    operand.index = index;
+    operand.scale = scale;
+    operand.imm = disp;
+    return operand;
+}
+
+size_t MachineFunction::AddBlock(std::string name) {
+    blocks_.push_back(MachineBlock {std::move(name), {}});
+    return blocks_.size() - 1;
+}
+
+MachineBlock& MachineFunction::GetBlock(size_t idx) {
+    return blocks_[idx];
+}
+
+const std::vector<MachineBlock>& MachineFunction::GetBlocks() const {
+    return blocks_;
+}
+
+void MachineFunction::Emit(size_t blockIdx, MOpcode opcode, std::vector<MachineOperand> operands) {
+    blocks_[blockIdx].instrs.push_back(MachineInstr {opcode, std::move(operands)});
+}
+
+uint64_t MachineFunction::NewVReg() {
+    return vregsCount_++;
+}
+
+void MachineFunction::ReserveVRegs(uint64_t count) {
+    if(vregsCount_ < count) {
+        vregsCount_ = count;
+    }
+}
+
+size_t MachineFunction::GetInstructionsCount() const {
+    size_t count = 0;
+    for(auto &block: blocks_) {
+        count += block.instrs.size();
+    }
+    return count;
+}
+
+size_t MachineFunction::CountOpcode(MOpcode opcode) const {
+    size_t count = 0;
+    for(auto &block: blocks_) {
+        for(auto &instr: block.instrs) {
+            count += instr.opcode == opcode;
+        }
+    }
+    return count;
+}
+
+void MachineFunction::Dump(std::ostream &ostr) const {
+    for(auto &block: blocks_) {
+        ostr << block.name << ":\n";
+        for(auto &instr: block.instrs) {
+            ostr << "    " << MOpcodeToString(instr.opcode);
+            for(size_t idx = 0; idx < instr.operands.size(); ++idx) {
+                ostr << (idx == 0 ? " " : ", ");
+                DumpOperand(ostr, instr.operands[idx], blocks_);
+            }
+            ostr << "\n";
+        }
+    }
+}
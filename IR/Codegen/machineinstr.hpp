@@ -0,0 +1,84 @@
+#ifndef IR_MACHINE_INSTR_HPP
+#define IR_MACHINE_INSTR_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+enum class MOpcode {
+    #define MINSTR_DEF(name, asm_name) name,
+
+    #include "minstrdef.hpp"
+    #undef MINSTR_DEF
+};
+
+enum class PhysReg {
+    RAX,
+    RDX,
+    RDI,
+    RSI,
+    RCX,
+    R8,
+    R9,
+};
+
+enum class MOperandKind {
+    VREG,
+    PREG,
+    IMM,
+    LABEL,
+    ADDR,
+};
+
+// Operand of a machine instruction. Registers are virtual until register
+// allocation; ADDR is a base + index * scale + disp address as used by lea.
+struct MachineOperand {
+    static constexpr uint64_t NO_REG = ~0ULL;
+
+    MOperandKind kind = MOperandKind::IMM;
+    uint64_t reg = NO_REG;
+    uint64_t index = NO_REG;
+    uint8_t scale = 1;
+    int64_t imm = 0;
+
+    static MachineOperand VReg(uint64_t vreg);
+    static MachineOperand PReg(PhysReg preg);
+    static MachineOperand Imm(int64_t value);
+    static MachineOperand Label(uint64_t blockIdx);
+    static MachineOperand Address(uint64_t base, uint64_t index, uint8_t scale, int64_t disp);
+};
+
+struct MachineInstr {
+    MOpcode opcode = MOpcode::MOV;
+    std::vector<MachineOperand> operands;
+};
+
+struct MachineBlock {
+    std::string name;
+    std::vector<MachineInstr> instrs;
+};
+
+class MachineFunction final {
+public:
+    size_t AddBlock(std::string name);
+    MachineBlock& GetBlock(size_t idx);
+    const std::vector<MachineBlock>& GetBlocks() const;
+
+    void Emit(size_t blockIdx, MOpcode opcode, std::vector<MachineOperand> operands = {});
+    uint64_t NewVReg();
+    void ReserveVRegs(uint64_t count);
+
+    size_t GetInstructionsCount() const;
+    size_t CountOpcode(MOpcode opcode) const;
+
+    void Dump(std::ostream &ostr) const;
+
+private:
+    std::vector<MachineBlock> blocks_;
+    uint64_t vregsCount_ = 0;
+};
+
+std::string MOpcodeToString(MOpcode opcode);
+
+#endif  // IR_MACHINE_INSTR_HPP
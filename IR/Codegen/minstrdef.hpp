@@ -0,0 +1,123 @@
+MINSTR_DEF(MOV, "mov")
+
+MINSTR_DEF(LEA, "lea")
+
+MINSTR_DEF(ADD, "add")
+
+MINSTR_DEF(SUB, "sub")
+
+MINSTR_DEF(IMUL, "imul")
+
+MINSTR_DEF(MUL, "mul")
+
+MINSTR_DEF(DIV, "div")
+
+MINSTR_DEF(IDIV, "idiv")
+
+MINSTR_DEF(CQO, "cqo")
+
+MINSTR_DEF(XOR, "xor")
+
+MINSTR_DEF(AND, "and")
+
+MINSTR_DEF(SHR, "shr")
+
+MINSTR_DEF(SAR, "sar")
+
+MINSTR_DEF(CMP, "cmp")
+
+MINSTR_DEF(SETA, "seta")
+
+MINSTR_DEF(SETAE, "setae")
+
+MINSTR_DEF(CMOVA, "cmova")
+
+MINSTR_DEF(CMOVAE, "cmovae")
+
+MINSTR_DEF(CMOVE, "cmove")
+
+MINSTR_DEF(JMP, "jmp")
+
+MINSTR_DEF(JA, "ja")
+
+MINSTR_DEF(JAE, "jae")
+
+MINSTR_DEF(JE, "je")
+
+MINSTR_DEF(JBE, "jbe")
+
+MINSTR_DEF(JB, "jb")
+
+MINSTR_DEF(JNE, "jne")
+
+MINSTR_DEF(JO, "jo")
+
+MINSTR_DEF(RET, "ret")
+
+MINSTR_DEF(DEOPT, "deopt")
+
+MINSTR_DEF(NEWOBJ, "newobj")
+
+MINSTR_DEF(MOVDQA, "movdqa")
+
+MINSTR_DEF(MOVQ, "movq")
+
+MINSTR_DEF(PUNPCKLQDQ, "punpcklqdq")
+
+MINSTR_DEF(PSHUFD, "pshufd")
+
+MINSTR_DEF(PSHUFLW, "pshuflw")
+
+MINSTR_DEF(PSRLDQ, "psrldq")
+
+MINSTR_DEF(PADDW, "paddw")
+
+MINSTR_DEF(PADDD, "paddd")
+
+MINSTR_DEF(PADDQ, "paddq")
+
+MINSTR_DEF(PSUBW, "psubw")
+
+MINSTR_DEF(PSUBD, "psubd")
+
+MINSTR_DEF(PSUBQ, "psubq")
+
+MINSTR_DEF(PMULLW, "pmullw")
+
+MINSTR_DEF(PAND, "pand")
+
+MINSTR_DEF(VMOVDQA, "vmovdqa")
+
+MINSTR_DEF(VMOVQ, "vmovq")
+
+MINSTR_DEF(VPUNPCKLQDQ, "vpunpcklqdq")
+
+MINSTR_DEF(VPSRLDQ, "vpsrldq")
+
+MINSTR_DEF(VPBROADCASTW, "vpbroadcastw")
+
+MINSTR_DEF(VPBROADCASTD, "vpbroadcastd")
+
+MINSTR_DEF(VPBROADCASTQ, "vpbroadcastq")
+
+MINSTR_DEF(VINSERTI128, "vinserti128")
+
+MINSTR_DEF(VEXTRACTI128, "vextracti128")
+
+MINSTR_DEF(VPADDW, "vpaddw")
+
+MINSTR_DEF(VPADDD, "vpaddd")
+
+MINSTR_DEF(VPADDQ, "vpaddq")
+
+MINSTR_DEF(VPSUBW, "vpsubw")
+
+MINSTR_DEF(VPSUBD, "vpsubd")
+
+MINSTR_DEF(VPSUBQ, "vpsubq")
+
+MINSTR_DEF(VPMULLW, "vpmullw")
+
+MINSTR_DEF(VPMULLD, "vpmulld")
+
+MINSTR_DEF(VPAND, "vpand")
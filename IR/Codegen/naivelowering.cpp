@@ -0,0 +1,153 @@
+#include "Codegen/naivelowering.hpp"
+
+#include "BasicBlock/basicblock.hpp"
+#include "Instr/datatraits.hpp"
+
+MachineFunction NaiveLowering::Run() {
+    function_ = MachineFunction();
+    LoweringContext context(graph_, &function_, true);
+
+    for(auto &block: graph_->GetBlocks()) {
+        size_t blockIdx = context.GetBlockIdx(block.get());
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            LowerInstruction(context, blockIdx, instr);
+        }
+    }
+    return std::move(function_);
+}
+
+void NaiveLowering::LowerInstruction(LoweringContext &context, size_t blockIdx, Instruction* instr) {
+    auto dst = MachineOperand::VReg(instr->GetId());
+    auto &inputs = instr->GetInputs();
+    auto input = [&context, &inputs](size_t idx) {
+        return context.GetValue(inputs[idx].GetValue());
+    };
+
+    switch(instr->GetOpType()) {
+        case OpType::PHI:
+            break;
+        case OpType::PRM:
+            function_.Emit(blockIdx, MOpcode::MOV,
+                           {dst, context.GetParameterLocation(static_cast<ParameterInstr*>(instr)->GetArgNum())});
+            break;
+        case OpType::CONST:
+            function_.Emit(blockIdx, MOpcode::MOV,
+                           {dst, MachineOperand::Imm(static_cast<ConstantInstr*>(instr)->GetAsSignedInt())});
+            break;
+        case OpType::ADD:
+        case OpType::SUB:
+        case OpType::MUL:
+        case OpType::AND: {
+            if(IsVectorType(instr->GetResultType())) {
+                context.EmitVectorBinary(blockIdx, instr->GetOpType(), instr->GetResultType(), dst, input(0), input(1));
+                break;
+            }
+            auto op = instr->GetOpType() == OpType::ADD ? MOpcode::ADD :
+                      instr->GetOpType() == OpType::SUB ? MOpcode::SUB :
+                      instr->GetOpType() == OpType::MUL ? MOpcode::IMUL : MOpcode::AND;
+            function_.Emit(blockIdx, MOpcode::MOV, {dst, input(0)});
+            function_.Emit(blockIdx, op, {dst, input(1)});
+            break;
+        }
+        case OpType::DIV:
+        case OpType::MOD:
+            context.EmitDivision(blockIdx, instr->GetOpType(), instr->GetResultType(), dst, input(0), input(1));
+            break;
+        case OpType::MULH:
+            context.EmitMulHigh(blockIdx, instr->GetResultType(), dst, input(0), input(1));
+            break;
+        case OpType::SHR:
+            context.EmitShiftRight(blockIdx, instr->GetResultType(), dst, input(0), input(1));
+            break;
+        case OpType::CMP: {
+            auto tmp = MachineOperand::VReg(function_.NewVReg());
+            function_.Emit(blockIdx, MOpcode::CMP, {input(0), input(1)});
+            function_.Emit(blockIdx, MOpcode::SETA, {tmp});
+            function_.Emit(blockIdx, MOpcode::SETAE, {dst});
+            function_.Emit(blockIdx, MOpcode::ADD, {dst, tmp});
+            break;
+        }
+        case OpType::SPLAT:
+            context.EmitSplat(blockIdx, instr->GetResultType(), dst, input(0));
+            break;
+        case OpType::IOTA:
+            context.EmitIota(blockIdx, instr->GetResultType(), dst);
+            break;
+        case OpType::REDUCE:
+            context.EmitReduce(blockIdx, static_cast<ReduceInstr*>(instr)->GetReduceOp(),
+                               inputs[0].GetValue()->GetResultType(), dst, input(0));
+            break;
+        case OpType::MOV:
+        case OpType::CAST:
+            function_.Emit(blockIdx, MOpcode::MOV, {dst, input(0)});
+            break;
+        case OpType::JMP:
+            context.EmitJmp(blockIdx, instr->GetParentBB(), static_cast<JmpInstr*>(instr)->GetBBToJmp());
+            break;
+        case OpType::JA:
+        case OpType::JAE:
+        case OpType::JE: {
+            auto *branch = static_cast<CjmpInstr*>(instr);
+            // CMP result is 0 (below), 1 (equal) or 2 (above).
+            int64_t bound = instr->GetOpType() == OpType::JA ? 2 : 1;
+            auto cc = instr->GetOpType() == OpType::JAE ? MOpcode::JAE : MOpcode::JE;
+            function_.Emit(blockIdx, MOpcode::CMP, {input(0), MachineOperand::Imm(bound)});
+            context.EmitCondBranch(blockIdx, instr->GetParentBB(), cc,
+                                   branch->GetTrueBranchBB(), branch->GetFalseBranchBB());
+            break;
+        }
+        case OpType::DEOPT: {
+            auto *guard = static_cast<GuardInstr*>(instr);
+            int64_t bound = guard->GetCondition() == OpType::JA ? 2 : 1;
+            auto cc = guard->GetCondition() == OpType::JAE ? MOpcode::JAE : MOpcode::JE;
+            function_.Emit(blockIdx, MOpcode::CMP, {input(0), MachineOperand::Imm(bound)});
+            context.EmitGuard(blockIdx, guard, cc);
+            break;
+        }
+        case OpType::SELECT: {
+            auto condition = static_cast<SelectInstr*>(instr)->GetCondition();
+            int64_t bound = condition == OpType::JA ? 2 : 1;
+            auto cc = condition == OpType::JAE ? MOpcode::JAE : MOpcode::JE;
+            function_.Emit(blockIdx, MOpcode::MOV, {dst, input(2)});
+            function_.Emit(blockIdx, MOpcode::CMP, {input(0), MachineOperand::Imm(bound)});
+            function_.Emit(blockIdx, LoweringContext::GetMoveCondition(cc), {dst, input(1)});
+            break;
+        }
+        case OpType::BOUNDS_CHECK:
+            context.EmitBoundsCheck(blockIdx, static_cast<BoundsCheckInstr*>(instr), input(0), input(1));
+            break;
+        case OpType::OVERFLOW_CHECK:
+            context.EmitOverflowCheck(blockIdx, static_cast<OverflowCheckInstr*>(instr), input(0), input(1));
+            break;
+        case OpType::NEW_OBJECT:
+            function_.Emit(blockIdx, MOpcode::NEWOBJ,
+                           {dst, MachineOperand::Imm(static_cast<NewObjectInstr*>(instr)->GetFieldsCount())});
+            break;
+        case OpType::LOAD_FIELD: {
+            auto field = static_cast<LoadFieldInstr*>(instr)->GetField();
+            function_.Emit(blockIdx, MOpcode::MOV, {dst, LoweringContext::GetFieldAddress(input(0), field)});
+            break;
+        }
+        case OpType::STORE_FIELD: {
+            auto field = static_cast<StoreFieldInstr*>(instr)->GetField();
+            function_.Emit(blockIdx, MOpcode::MOV, {LoweringContext::GetFieldAddress(input(0), field), input(1)});
+            break;
+        }
+        case OpType::LOAD: {
+            auto offset = static_cast<LoadInstr*>(instr)->GetOffset();
+            function_.Emit(blockIdx, MOpcode::MOV, {dst, LoweringContext::GetAddress(input(0), offset)});
+            break;
+        }
+        case OpType::STORE: {
+            auto offset = static_cast<StoreInstr*>(instr)->GetOffset();
+            function_.Emit(blockIdx, MOpcode::MOV, {LoweringContext::GetAddress(input(0), offset), input(1)});
+            break;
+        }
+        case OpType::RET:
+            function_.Emit(blockIdx, MOpcode::MOV, {MachineOperand::PReg(PhysReg::RAX), input(0)});
+            function_.Emit(blockIdx, MOpcode::RET);
+            break;
+        default:
+            break;
+    }
+}
@@ -0,0 +1,22 @@
+#ifndef IR_NAIVE_LOWERING_HPP
+#define IR_NAIVE_LOWERING_HPP
+
+#include "Codegen/loweringcontext.hpp"
+
+// Macro-expansion lowering: every IR instruction gets one fixed machine
+// sequence, all values live in registers. Baseline for the selector.
+class NaiveLowering final {
+public:
+    explicit NaiveLowering(Graph* graph): graph_(graph) {}
+
+    MachineFunction Run();
+
+private:
+    void LowerInstruction(LoweringContext &context, size_t blockIdx, Instruction* instr);
+
+private:
+    Graph* graph_ = nullptr;
+    MachineFunction function_;
+};
+
+#endif  // IR_NAIVE_LOWERING_HPP
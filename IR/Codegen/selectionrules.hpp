@@ -0,0 +1,122 @@
+// RULE_DEF(name, result, opcode, child0, child1, cost)
+// Opcode UNDEFINED marks a chain rule: it converts child0 into result on the same node.
+
+RULE_DEF(CONST_REG, REG, CONST, NONE, NONE, 1)
+
+RULE_DEF(CONST_IMM, IMM, CONST, NONE, NONE, 0)
+
+RULE_DEF(CONST_SCALE, SCALE, CONST, NONE, NONE, 0)
+
+RULE_DEF(PARAM_REG, REG, PRM, NONE, NONE, 1)
+
+RULE_DEF(INDEX_REG, REG, UNDEFINED, INDEX, NONE, 1)
+
+RULE_DEF(FLAGS_REG, REG, UNDEFINED, FLAGS, NONE, 3)
+
+RULE_DEF(ADD_RR, REG, ADD, REG, REG, 1)
+
+RULE_DEF(ADD_RI, REG, ADD, REG, IMM, 1)
+
+RULE_DEF(ADD_IR, REG, ADD, IMM, REG, 1)
+
+RULE_DEF(ADD_R_INDEX, REG, ADD, REG, INDEX, 1)
+
+RULE_DEF(ADD_INDEX_R, REG, ADD, INDEX, REG, 1)
+
+RULE_DEF(SUB_RR, REG, SUB, REG, REG, 2)
+
+RULE_DEF(SUB_RI, REG, SUB, REG, IMM, 1)
+
+RULE_DEF(MUL_RR, REG, MUL, REG, REG, 2)
+
+RULE_DEF(MUL_RI, REG, MUL, REG, IMM, 1)
+
+RULE_DEF(MUL_IR, REG, MUL, IMM, REG, 1)
+
+RULE_DEF(INDEX_MUL_RS, INDEX, MUL, REG, SCALE, 0)
+
+RULE_DEF(INDEX_MUL_SR, INDEX, MUL, SCALE, REG, 0)
+
+RULE_DEF(DIV_RR, REG, DIV, REG, REG, 4)
+
+RULE_DEF(MOD_RR, REG, MOD, REG, REG, 4)
+
+RULE_DEF(MULH_RR, REG, MULH, REG, REG, 3)
+
+RULE_DEF(AND_RR, REG, AND, REG, REG, 1)
+
+RULE_DEF(AND_RI, REG, AND, REG, IMM, 1)
+
+RULE_DEF(SHR_RR, REG, SHR, REG, REG, 2)
+
+RULE_DEF(SHR_RI, REG, SHR, REG, IMM, 1)
+
+RULE_DEF(VADD_VV, VREG, ADD, VREG, VREG, 1)
+
+RULE_DEF(VSUB_VV, VREG, SUB, VREG, VREG, 1)
+
+RULE_DEF(VMUL_VV, VREG, MUL, VREG, VREG, 2)
+
+RULE_DEF(VAND_VV, VREG, AND, VREG, VREG, 1)
+
+RULE_DEF(SPLAT_R, VREG, SPLAT, REG, NONE, 2)
+
+RULE_DEF(IOTA_V, VREG, IOTA, NONE, NONE, 3)
+
+RULE_DEF(REDUCE_V, REG, REDUCE, VREG, NONE, 4)
+
+RULE_DEF(CMP_RR, FLAGS, CMP, REG, REG, 1)
+
+RULE_DEF(CMP_RI, FLAGS, CMP, REG, IMM, 1)
+
+RULE_DEF(MOV_R, REG, MOV, REG, NONE, 1)
+
+RULE_DEF(CAST_R, REG, CAST, REG, NONE, 1)
+
+RULE_DEF(JMP, STMT, JMP, NONE, NONE, 1)
+
+RULE_DEF(JA_FLAGS, STMT, JA, FLAGS, NONE, 1)
+
+RULE_DEF(JAE_FLAGS, STMT, JAE, FLAGS, NONE, 1)
+
+RULE_DEF(JE_FLAGS, STMT, JE, FLAGS, NONE, 1)
+
+RULE_DEF(JA_REG, STMT, JA, REG, NONE, 2)
+
+RULE_DEF(JAE_REG, STMT, JAE, REG, NONE, 2)
+
+RULE_DEF(JE_REG, STMT, JE, REG, NONE, 2)
+
+RULE_DEF(SELECT_FLAGS, REG, SELECT, FLAGS, NONE, 2)
+
+RULE_DEF(SELECT_REG, REG, SELECT, REG, NONE, 3)
+
+RULE_DEF(GUARD_FLAGS, STMT, DEOPT, FLAGS, NONE, 1)
+
+RULE_DEF(GUARD_REG, STMT, DEOPT, REG, NONE, 2)
+
+RULE_DEF(BOUNDS_CHECK_RR, STMT, BOUNDS_CHECK, REG, REG, 2)
+
+RULE_DEF(BOUNDS_CHECK_RI, STMT, BOUNDS_CHECK, REG, IMM, 2)
+
+RULE_DEF(OVERFLOW_CHECK_RR, STMT, OVERFLOW_CHECK, REG, REG, 3)
+
+RULE_DEF(OVERFLOW_CHECK_RI, STMT, OVERFLOW_CHECK, REG, IMM, 3)
+
+RULE_DEF(NEW_OBJECT_R, REG, NEW_OBJECT, NONE, NONE, 3)
+
+RULE_DEF(LOAD_FIELD_R, REG, LOAD_FIELD, REG, NONE, 1)
+
+RULE_DEF(STORE_FIELD_RR, STMT, STORE_FIELD, REG, REG, 1)
+
+RULE_DEF(STORE_FIELD_RI, STMT, STORE_FIELD, REG, IMM, 1)
+
+RULE_DEF(LOAD_R, REG, LOAD, REG, NONE, 1)
+
+RULE_DEF(STORE_RR, STMT, STORE, REG, REG, 1)
+
+RULE_DEF(STORE_RI, STMT, STORE, REG, IMM, 1)
+
+RULE_DEF(RET_R, STMT, RET, REG, NONE, 2)
+
+RULE_DEF(RET_I, STMT, RET, IMM, NONE, 2)
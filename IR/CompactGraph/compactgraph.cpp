@@ -0,0 +1,167 @@
+#include "CompactGraph/compactgraph.hpp"
+
+namespace {
+
+// Turns per-entry counts in `offsets[0..n)` into exclusive prefix sums with a
+// trailing total, the layout of every index pool here.
+void ToOffsets(std::vector<uint32_t> &offsets) {
+    uint32_t sum = 0;
+    for(auto &offset: offsets) {
+        auto count = offset;
+        offset = sum;
+        sum += count;
+    }
+    offsets.push_back(sum);
+}
+
+}  // namespace
+
+CompactGraph::CompactGraph(const Graph* graph) {
+    auto &blocks = graph->GetBlocks();
+    indexById_.assign(graph->GetInstructions().size(), NO_INDEX);
+
+    for(auto &block: blocks) {
+        basicBlocks_.push_back(block.get());
+        blockFirstInstr_.push_back(instrs_.size());
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            indexById_[instr->GetId()] = instrs_.size();
+            instrs_.push_back(instr);
+        }
+    }
+    blockFirstInstr_.push_back(instrs_.size());
+
+    size_t count = instrs_.size();
+    opcodes_.reserve(count);
+    types_.reserve(count);
+    blocks_.reserve(count);
+    payloads_.reserve(count);
+    firstOperand_.reserve(count + 1);
+    firstUser_.assign(count, 0);
+
+    for(auto *instr: instrs_) {
+        opcodes_.push_back(static_cast<uint8_t>(instr->GetOpType()));
+        types_.push_back(static_cast<uint8_t>(instr->GetResultType()));
+        blocks_.push_back(instr->GetParentBB()->GetId());
+
+        uint64_t payload = 0;
+        if(auto *constant = instr->As<ConstantInstr>()) {
+            payload = constant->GetAsUnsignedInt();
+        } else if(auto *parameter = instr->As<ParameterInstr>()) {
+            payload = parameter->GetArgNum();
+        }
+        payloads_.push_back(payload);
+
+        firstOperand_.push_back(operands_.size());
+        for(auto &input: instr->GetInputs()) {
+            auto operand = indexById_[input.GetValue()->GetId()];
+            operands_.push_back(operand);
+            if(operand != NO_INDEX) {
+                ++firstUser_[operand];
+            }
+        }
+    }
+    firstOperand_.push_back(operands_.size());
+
+    ToOffsets(firstUser_);
+    users_.resize(firstUser_.back());
+    std::vector<uint32_t> fill(firstUser_.begin(), firstUser_.end() - 1);
+    for(uint32_t idx = 0; idx < count; ++idx) {
+        for(auto operand: GetOperands(idx)) {
+            if(operand != NO_INDEX) {
+                users_[fill[operand]++] = idx;
+            }
+        }
+    }
+
+    for(auto &block: blocks) {
+        firstSucc_.push_back(succs_.size());
+        for(auto *succ: block->GetSuccessors()) {
+            succs_.push_back(succ->GetId());
+        }
+        firstPred_.push_back(preds_.size());
+        for(auto *pred: block->GetPredecessors()) {
+            preds_.push_back(pred->GetId());
+        }
+    }
+    firstSucc_.push_back(succs_.size());
+    firstPred_.push_back(preds_.size());
+}
+
+size_t CompactGraph::GetInstrsCount() const {
+    return instrs_.size();
+}
+
+size_t CompactGraph::GetBlocksCount() const {
+    return basicBlocks_.size();
+}
+
+OpType CompactGraph::GetOpType(uint32_t idx) const {
+    return static_cast<OpType>(opcodes_[idx]);
+}
+
+DataType CompactGraph::GetType(uint32_t idx) const {
+    return static_cast<DataType>(types_[idx]);
+}
+
+uint32_t CompactGraph::GetBlock(uint32_t idx) const {
+    return blocks_[idx];
+}
+
+uint64_t CompactGraph::GetPayload(uint32_t idx) const {
+    return payloads_[idx];
+}
+
+std::span<const uint32_t> CompactGraph::GetOperands(uint32_t idx) const {
+    return {operands_.data() + firstOperand_[idx], operands_.data() + firstOperand_[idx + 1]};
+}
+
+std::span<const uint32_t> CompactGraph::GetUsers(uint32_t idx) const {
+    return {users_.data() + firstUser_[idx], users_.data() + firstUser_[idx + 1]};
+}
+
+std::span<const uint8_t> CompactGraph::GetOpTypes() const {
+    return opcodes_;
+}
+
+std::span<const uint8_t> CompactGraph::GetTypes() const {
+    return types_;
+}
+
+uint32_t CompactGraph::GetBlockBegin(uint32_t block) const {
+    return blockFirstInstr_[block];
+}
+
+uint32_t CompactGraph::GetBlockEnd(uint32_t block) const {
+    return blockFirstInstr_[block + 1];
+}
+
+std::span<const uint32_t> CompactGraph::GetSuccessors(uint32_t block) const {
+    return {succs_.data() + firstSucc_[block], succs_.data() + firstSucc_[block + 1]};
+}
+
+std::span<const uint32_t> CompactGraph::GetPredecessors(uint32_t block) const {
+    return {preds_.data() + firstPred_[block], preds_.data() + firstPred_[block + 1]};
+}
+
+std::vector<uint32_t> CompactGraph::Collect(OpType op) const {
+    std::vector<uint32_t> result;
+    auto opcode = static_cast<uint8_t>(op);
+    for(uint32_t idx = 0; idx < opcodes_.size(); ++idx) {
+        if(opcodes_[idx] == opcode) {
+            result.push_back(idx);
+        }
+    }
+    return result;
+}
+
+Instruction* CompactGraph::GetInstruction(uint32_t idx) const {
+    return instrs_[idx];
+}
+
+BasicBlock* CompactGraph::GetBasicBlock(uint32_t block) const {
+    return basicBlocks_[block];
+}
+
+uint32_t CompactGraph::GetIndex(const Instruction* instr) const {
+    return instr->GetId() < indexById_.size() ? indexById_[instr->GetId()] : NO_INDEX;
+}
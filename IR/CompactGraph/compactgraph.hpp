@@ -0,0 +1,73 @@
+#ifndef IR_COMPACT_GRAPH_HPP
+#define IR_COMPACT_GRAPH_HPP
+
+#include "Graph/graph.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Read-only structure-of-arrays snapshot of a graph for scans over many
+// instructions. Instructions are renumbered densely in block order, so block
+// `b` owns indices [GetBlockBegin(b), GetBlockEnd(b)) and a question about one
+// attribute ("which instructions are phis") reads a single byte array instead
+// of chasing list pointers. Operands and users are stored as compact indices in
+// shared pools. The snapshot does not follow later changes of the graph.
+class CompactGraph final {
+public:
+    static constexpr uint32_t NO_INDEX = ~0U;
+
+    explicit CompactGraph(const Graph* graph);
+
+    size_t GetInstrsCount() const;
+    size_t GetBlocksCount() const;
+
+    OpType GetOpType(uint32_t idx) const;
+    DataType GetType(uint32_t idx) const;
+    uint32_t GetBlock(uint32_t idx) const;
+    // Constant bits of CONST, argument number of PRM, 0 otherwise.
+    uint64_t GetPayload(uint32_t idx) const;
+    std::span<const uint32_t> GetOperands(uint32_t idx) const;
+    // One entry per operand slot referring to the instruction, in index order.
+    std::span<const uint32_t> GetUsers(uint32_t idx) const;
+
+    // Whole columns, indexed by compact index.
+    std::span<const uint8_t> GetOpTypes() const;
+    std::span<const uint8_t> GetTypes() const;
+
+    uint32_t GetBlockBegin(uint32_t block) const;
+    uint32_t GetBlockEnd(uint32_t block) const;
+    std::span<const uint32_t> GetSuccessors(uint32_t block) const;
+    std::span<const uint32_t> GetPredecessors(uint32_t block) const;
+
+    // Indices of all instructions with the given opcode, in block order.
+    std::vector<uint32_t> Collect(OpType op) const;
+
+    Instruction* GetInstruction(uint32_t idx) const;
+    BasicBlock* GetBasicBlock(uint32_t block) const;
+    // NO_INDEX for instructions detached from the graph.
+    uint32_t GetIndex(const Instruction* instr) const;
+
+private:
+    std::vector<uint8_t> opcodes_;
+    std::vector<uint8_t> types_;
+    std::vector<uint32_t> blocks_;
+    std::vector<uint64_t> payloads_;
+    std::vector<uint32_t> firstOperand_;
+    std::vector<uint32_t> operands_;
+    std::vector<uint32_t> firstUser_;
+    std::vector<uint32_t> users_;
+
+    std::vector<uint32_t> blockFirstInstr_;
+    std::vector<uint32_t> firstSucc_;
+    std::vector<uint32_t> succs_;
+    std::vector<uint32_t> firstPred_;
+    std::vector<uint32_t> preds_;
+
+    std::vector<Instruction*> instrs_;
+    std::vector<BasicBlock*> basicBlocks_;
+    // Compact index by instruction id.
+    std::vector<uint32_t> indexById_;
+};
+
+#endif  // IR_COMPACT_GRAPH_HPP
@@ -0,0 +1,177 @@
+#include "CompileService/compileservice.hpp"
+
+Graph* CompileTask::GetGraph() const {
+    return graph_;
+}
+
+uint64_t CompileTask::GetHotness() const {
+    return hotness_;
+}
+
+CompileStatus CompileTask::GetStatus() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return status_;
+}
+
+bool CompileTask::Cancel() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(status_ != CompileStatus::PENDING) {
+            return false;
+        }
+        status_ = CompileStatus::CANCELLED;
+    }
+    doneCv_.notify_all();
+    if(onDone_) {
+        onDone_(*this);
+    }
+    return true;
+}
+
+CodeCache::CodePtr CompileTask::Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    doneCv_.wait(lock, [this] {
+        return status_ == CompileStatus::DONE || status_ == CompileStatus::CANCELLED;
+    });
+    return code_;
+}
+
+bool CompileTask::TryStart() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(status_ != CompileStatus::PENDING) {
+        return false;
+    }
+    status_ = CompileStatus::RUNNING;
+    return true;
+}
+
+void CompileTask::Finish(CodeCache::CodePtr code) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        code_ = std::move(code);
+        status_ = CompileStatus::DONE;
+    }
+    doneCv_.notify_all();
+    if(onDone_) {
+        onDone_(*this);
+    }
+}
+
+CompileService::CompileService(CodeCache::CompileFn compile, size_t workersCount, size_t maxQueued):
+    compile_(std::move(compile)), maxQueued_(maxQueued) {
+    workersCount = std::max<size_t>(workersCount, 1);
+    for(size_t idx = 0; idx < workersCount; ++idx) {
+        queues_.push_back(std::make_unique<PriorityWorkQueue<CompileTaskPtr>>());
+    }
+    for(size_t idx = 0; idx < workersCount; ++idx) {
+        workers_.emplace_back(&CompileService::WorkerLoop, this, idx);
+    }
+}
+
+CompileService::~CompileService() {
+    Shutdown();
+}
+
+CompileTaskPtr CompileService::Submit(Graph* graph, uint64_t hotness, CompileTask::Callback onDone) {
+    auto task = std::make_shared<CompileTask>(graph, hotness, std::move(onDone));
+    {
+        // Pushing under the lock keeps a concurrent Shutdown() from draining
+        // the queues between the count and the push.
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(stopping_ || queued_ >= maxQueued_) {
+            return nullptr;
+        }
+        ++queued_;
+        ++inFlight_;
+        queues_[nextQueue_++ % queues_.size()]->Push(task, hotness);
+    }
+    workCv_.notify_one();
+    return task;
+}
+
+void CompileService::WaitIdle() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idleCv_.wait(lock, [this] {
+        return inFlight_ == 0;
+    });
+}
+
+void CompileService::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    workCv_.notify_all();
+    for(auto &worker: workers_) {
+        worker.join();
+    }
+    workers_.clear();
+
+    for(auto &queue: queues_) {
+        for(auto &task: queue->Drain()) {
+            task->Cancel();
+            std::lock_guard<std::mutex> lock(mutex_);
+            --queued_;
+            --inFlight_;
+        }
+    }
+    idleCv_.notify_all();
+}
+
+size_t CompileService::GetWorkersCount() const {
+    return queues_.size();
+}
+
+size_t CompileService::GetQueuedCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queued_;
+}
+
+size_t CompileService::GetStealsCount() const {
+    return stealsCount_;
+}
+
+void CompileService::WorkerLoop(size_t workerIdx) {
+    for(;;) {
+        CompileTaskPtr task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            workCv_.wait(lock, [this] {
+                return stopping_ || queued_ != 0;
+            });
+            if(stopping_) {
+                return;
+            }
+            task = TakeTask(workerIdx);
+        }
+
+        if(task->TryStart()) {
+            task->Finish(std::make_shared<const CompiledCode>(compile_(task->GetGraph())));
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(--inFlight_ == 0) {
+            idleCv_.notify_all();
+        }
+    }
+}
+
+CompileTaskPtr CompileService::TakeTask(size_t workerIdx) {
+    size_t bestIdx = workerIdx;
+    auto bestPriority = queues_[workerIdx]->PeekPriority();
+    for(size_t shift = 1; shift < queues_.size(); ++shift) {
+        size_t idx = (workerIdx + shift) % queues_.size();
+        auto priority = queues_[idx]->PeekPriority();
+        if(priority.has_value() && (!bestPriority.has_value() || *priority > *bestPriority)) {
+            bestIdx = idx;
+            bestPriority = priority;
+        }
+    }
+
+    auto task = queues_[bestIdx]->Pop();
+    if(bestIdx != workerIdx) {
+        ++stealsCount_;
+    }
+    --queued_;
+    return *task;
+}
@@ -0,0 +1,107 @@
+#ifndef IR_COMPILE_SERVICE_HPP
+#define IR_COMPILE_SERVICE_HPP
+
+#include "CodeCache/codecache.hpp"
+#include "CompileService/workqueue.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+enum class CompileStatus {
+    PENDING,
+    RUNNING,
+    DONE,
+    CANCELLED,
+};
+
+class CompileTask;
+using CompileTaskPtr = std::shared_ptr<CompileTask>;
+
+// Handle of a submitted graph. The callback runs exactly once, on the thread
+// that finished or cancelled the task.
+class CompileTask final {
+public:
+    using Callback = std::function<void(CompileTask&)>;
+
+    CompileTask(Graph* graph, uint64_t hotness, Callback onDone):
+        graph_(graph), hotness_(hotness), onDone_(std::move(onDone)) {}
+
+    Graph* GetGraph() const;
+    uint64_t GetHotness() const;
+    CompileStatus GetStatus() const;
+
+    // Succeeds only while the task is still queued.
+    bool Cancel();
+
+    // Blocks until the task is done or cancelled; cancelled tasks yield nullptr.
+    CodeCache::CodePtr Wait();
+
+private:
+    friend class CompileService;
+
+    bool TryStart();
+    void Finish(CodeCache::CodePtr code);
+
+private:
+    Graph* graph_ = nullptr;
+    uint64_t hotness_ = 0;
+    Callback onDone_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable doneCv_;
+    CompileStatus status_ = CompileStatus::PENDING;
+    CodeCache::CodePtr code_;
+};
+
+// Compiles graphs on a pool of worker threads. Submitted tasks are spread
+// over per-worker priority queues ordered by hotness. A free worker takes the
+// hottest queued task of all queues, preferring its own queue on ties, and a
+// take from another worker's queue counts as a steal. Graphs must not be
+// shared between in-flight tasks.
+class CompileService final {
+public:
+    CompileService(CodeCache::CompileFn compile, size_t workersCount, size_t maxQueued);
+    ~CompileService();
+
+    CompileService(const CompileService&) = delete;
+    CompileService& operator=(const CompileService&) = delete;
+
+    // Returns nullptr when the queue is full or the service is shut down.
+    CompileTaskPtr Submit(Graph* graph, uint64_t hotness, CompileTask::Callback onDone = nullptr);
+
+    void WaitIdle();
+    // Cancels queued tasks and joins the workers.
+    void Shutdown();
+
+    size_t GetWorkersCount() const;
+    size_t GetQueuedCount() const;
+    size_t GetStealsCount() const;
+
+private:
+    void WorkerLoop(size_t workerIdx);
+    // Called with mutex_ held, so queued_ always matches the queues.
+    CompileTaskPtr TakeTask(size_t workerIdx);
+
+private:
+    CodeCache::CompileFn compile_;
+    size_t maxQueued_ = 0;
+
+    std::vector<std::unique_ptr<PriorityWorkQueue<CompileTaskPtr>>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<size_t> nextQueue_ = 0;
+    std::atomic<size_t> stealsCount_ = 0;
+
+    mutable std::mutex mutex_;
+    std::condition_variable workCv_;
+    std::condition_variable idleCv_;
+    size_t queued_ = 0;
+    size_t inFlight_ = 0;
+    bool stopping_ = false;
+};
+
+#endif  // IR_COMPILE_SERVICE_HPP
@@ -0,0 +1,76 @@
+#ifndef IR_WORK_QUEUE_HPP
+#define IR_WORK_QUEUE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+// Per-worker task queue ordered by priority. The highest priority item comes
+// out first, equal priorities in submission order.
+template <typename T>
+class PriorityWorkQueue final {
+public:
+    void Push(T item, uint64_t priority) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        heap_.push_back(Item {std::move(item), priority, sequence_++});
+        std::push_heap(heap_.begin(), heap_.end(), Less);
+    }
+
+    std::optional<T> Pop() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(heap_.empty()) {
+            return std::nullopt;
+        }
+        std::pop_heap(heap_.begin(), heap_.end(), Less);
+        T item = std::move(heap_.back().item);
+        heap_.pop_back();
+        return item;
+    }
+
+    // Priority of the item Pop() would return.
+    std::optional<uint64_t> PeekPriority() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(heap_.empty()) {
+            return std::nullopt;
+        }
+        return heap_.front().priority;
+    }
+
+    std::vector<T> Drain() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<T> items;
+        for(auto &entry: heap_) {
+            items.push_back(std::move(entry.item));
+        }
+        heap_.clear();
+        return items;
+    }
+
+    size_t GetSize() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return heap_.size();
+    }
+
+private:
+    struct Item {
+        T item;
+        uint64_t priority = 0;
+        uint64_t sequence = 0;
+    };
+
+    static bool Less(const Item &lhs, const Item &rhs) {
+        if(lhs.priority != rhs.priority) {
+            return lhs.priority < rhs.priority;
+        }
+        return lhs.sequence > rhs.sequence;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<Item> heap_;
+    uint64_t sequence_ = 0;
+};
+
+#endif  // IR_WORK_QUEUE_HPP
@@ -53,4 +53,24 @@ void DFS::DFSImpl(std::vector<std::pair<BasicBlock*, BasicBlock*>> &analyzerResu
     }
 
     visitMap[block] = NodeColor::BLACK;
+}
+
+std::vector<BasicBlock*> DFS::RunPostOrder(BasicBlock* startBlock) {
+    std::vector<BasicBlock*> postOrder;
+    std::unordered_set<BasicBlock*> visitSet;
+    PostOrderImpl(postOrder, visitSet, startBlock == nullptr ? graph_->GetStartBlock() : startBlock);
+    return postOrder;
+}
+
+void DFS::PostOrderImpl(std::vector<BasicBlock*> &postOrder, std::unordered_set<BasicBlock*> &visitSet,
+                        BasicBlock* block) {
+    visitSet.insert(block);
+
+    for(auto succBlock: block->GetSuccessors()) {
+        if(visitSet.find(succBlock) == visitSet.end()) {
+            PostOrderImpl(postOrder, visitSet, succBlock);
+        }
+    }
+
+    postOrder.push_back(block);
 }
\ No newline at end of file
@@ -17,11 +17,14 @@ public:
     std::vector<BasicBlock*> Run();
     std::vector<BasicBlock*> Run(std::unordered_set<BasicBlock*> &visitSet);
     std::vector<std::pair<BasicBlock*, BasicBlock*>> RunLoopAnalyzer();
+    std::vector<BasicBlock*> RunPostOrder(BasicBlock* startBlock = nullptr);
 private:
     void DFSImpl(std::vector<BasicBlock*> &dfsVector, std::unordered_set<BasicBlock*> &visitSet,
                  BasicBlock* block);
     void DFSImpl(std::vector<std::pair<BasicBlock*, BasicBlock*>> &analyzerResult,
                  std::unordered_map<BasicBlock*, NodeColor> &visitMap, BasicBlock* block);
+    void PostOrderImpl(std::vector<BasicBlock*> &postOrder, std::unordered_set<BasicBlock*> &visitSet,
+                       BasicBlock* block);
 
 private:
     Graph *graph_ = nullptr;
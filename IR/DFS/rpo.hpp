@@ -4,14 +4,15 @@
 #include "DFS/dfs.hpp"
 
 #include <vector>
+#include <algorithm>
 
 class RPO final {
 public:
     RPO(Graph* graph): graph_(graph) {}
 
-    std::vector<BasicBlock*> Run() {
+    std::vector<BasicBlock*> Run(BasicBlock* startBlock = nullptr) {
         DFS dfs{graph_};
-        std::vector<BasicBlock*> rpoVector = dfs.Run();
+        std::vector<BasicBlock*> rpoVector = dfs.RunPostOrder(startBlock);
         std::reverse(rpoVector.begin(), rpoVector.end());
         return rpoVector;
     }
@@ -0,0 +1,234 @@
+#include "DivisionByConstant/divisionbyconstant.hpp"
+#include "Instr/datatraits.hpp"
+
+#include <vector>
+
+namespace {
+
+bool IsSignedType(DataType type) {
+    return type == DataType::I8 || type == DataType::I16 || type == DataType::I32 || type == DataType::I64;
+}
+
+bool IsIntegerType(DataType type) {
+    return IsSignedType(type) || type == DataType::U8 || type == DataType::U16 ||
+           type == DataType::U32 || type == DataType::U64;
+}
+
+uint64_t GetMask(uint32_t bits) {
+    return bits >= 64 ? ~0ULL : (1ULL << bits) - 1;
+}
+
+int64_t SignExtend(uint64_t value, uint32_t bits) {
+    auto shift = 64 - bits;
+    return static_cast<int64_t>(value << shift) >> shift;
+}
+
+bool IsPowerOfTwo(uint64_t value) {
+    return (value & (value - 1)) == 0;
+}
+
+uint32_t Log2(uint64_t value) {
+    return 63 - __builtin_clzll(value);
+}
+
+// Quotient of `bits`-wide values is the high half of the product with
+// `multiplier`, shifted right by `shift`. With `add` set the multiplier needs
+// one bit more than the type has, and its top bit is added back separately.
+struct Magic {
+    uint64_t multiplier = 0;
+    uint32_t shift = 0;
+    bool add = false;
+};
+
+// Hacker's Delight, figure 10-2 (magicu2), widened to any type up to 64 bits;
+// all arithmetic wraps at the width of the type.
+Magic GetUnsignedMagic(uint64_t divisor, uint32_t bits) {
+    auto mask = GetMask(bits);
+    uint64_t half = 1ULL << (bits - 1);
+    uint64_t nc = mask - ((0 - divisor) & mask) % divisor;
+    uint32_t p = bits - 1;
+    uint64_t q1 = half / nc;
+    uint64_t r1 = half - q1 * nc;
+    uint64_t q2 = (half - 1) / divisor;
+    uint64_t r2 = (half - 1) - q2 * divisor;
+
+    Magic magic;
+    uint64_t delta = 0;
+    do {
+        ++p;
+        if(r1 >= nc - r1) {
+            q1 = (2 * q1 + 1) & mask;
+            r1 = (2 * r1 - nc) & mask;
+        } else {
+            q1 = (2 * q1) & mask;
+            r1 = (2 * r1) & mask;
+        }
+        if(r2 + 1 >= divisor - r2) {
+            magic.add |= q2 >= half - 1;
+            q2 = (2 * q2 + 1) & mask;
+            r2 = (2 * r2 + 1 - divisor) & mask;
+        } else {
+            magic.add |= q2 >= half;
+            q2 = (2 * q2) & mask;
+            r2 = (2 * r2 + 1) & mask;
+        }
+        delta = divisor - 1 - r2;
+    } while(p < 2 * bits && (q1 < delta || (q1 == delta && r1 == 0)));
+
+    magic.multiplier = (q2 + 1) & mask;
+    magic.shift = p - bits;
+    return magic;
+}
+
+// Hacker's Delight, figure 10-1, for a divisor whose magnitude is at least 2.
+// The multiplier is negated for negative divisors.
+Magic GetSignedMagic(int64_t divisor, uint32_t bits) {
+    auto mask = GetMask(bits);
+    uint64_t half = 1ULL << (bits - 1);
+    uint64_t magnitude = divisor < 0 ? 0 - static_cast<uint64_t>(divisor) : divisor;
+    uint64_t t = half + (divisor < 0 ? 1 : 0);
+    uint64_t anc = t - 1 - t % magnitude;
+    uint32_t p = bits - 1;
+    uint64_t q1 = half / anc;
+    uint64_t r1 = half - q1 * anc;
+    uint64_t q2 = half / magnitude;
+    uint64_t r2 = half - q2 * magnitude;
+
+    uint64_t delta = 0;
+    do {
+        ++p;
+        q1 = (2 * q1) & mask;
+        r1 = (2 * r1) & mask;
+        if(r1 >= anc) {
+            q1 = (q1 + 1) & mask;
+            r1 -= anc;
+        }
+        q2 = (2 * q2) & mask;
+        r2 = (2 * r2) & mask;
+        if(r2 >= magnitude) {
+            q2 = (q2 + 1) & mask;
+            r2 -= magnitude;
+        }
+        delta = magnitude - r2;
+    } while(q1 < delta || (q1 == delta && r1 == 0));
+
+    Magic magic;
+    magic.multiplier = (divisor < 0 ? 0 - (q2 + 1) : q2 + 1) & mask;
+    magic.shift = p - bits;
+    return magic;
+}
+
+Instruction* CreateConstant(IrBuilder &builder, DataType type, uint64_t value) {
+    auto bits = GetElementBits(type);
+    if(IsSignedType(type)) {
+        return builder.CreateConstant(SignExtend(value, bits), type);
+    }
+    return builder.CreateConstant(value & GetMask(bits), type);
+}
+
+}  // namespace
+
+size_t DivisionByConstant::Run() {
+    std::vector<Instruction*> candidates;
+    for(auto &block: graph_->GetBlocks()) {
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            auto op = instr->GetOpType();
+            if((op == OpType::DIV || op == OpType::MOD) && IsIntegerType(instr->GetResultType()) &&
+               instr->GetInputs()[1].GetValue()->GetOpType() == OpType::CONST) {
+                candidates.push_back(instr);
+            }
+        }
+    }
+
+    IrBuilder builder(graph_);
+    size_t rewritten = 0;
+    for(auto *instr: candidates) {
+        auto type = instr->GetResultType();
+        auto bits = GetElementBits(type);
+        auto *dividend = instr->GetInputs()[0].GetValue();
+        auto *constant = instr->GetInputs()[1].GetValue();
+        uint64_t divisor = static_cast<ConstantInstr*>(constant)->GetAsUnsignedInt() & GetMask(bits);
+        if(divisor == 0) {
+            continue;
+        }
+
+        builder.SetInsertPoint(instr);
+        Instruction* value = nullptr;
+        bool isSigned = IsSignedType(type);
+        if(instr->GetOpType() == OpType::MOD && !isSigned && IsPowerOfTwo(divisor)) {
+            value = builder.CreateAnd(type, dividend, CreateConstant(builder, type, divisor - 1));
+        } else {
+            value = isSigned ? EmitSignedQuotient(builder, type, dividend, SignExtend(divisor, bits)) :
+                               EmitUnsignedQuotient(builder, type, dividend, divisor);
+            if(instr->GetOpType() == OpType::MOD) {
+                value = builder.CreateSub(type, dividend, builder.CreateMul(type, value, constant));
+            }
+        }
+
+        instr->ReplaceAllUsesWith(value);
+        graph_->RemoveInstruction(instr);
+        ++rewritten;
+    }
+    return rewritten;
+}
+
+Instruction* DivisionByConstant::EmitUnsignedQuotient(IrBuilder &builder, DataType type, Instruction* dividend,
+                                                      uint64_t divisor) {
+    if(divisor == 1) {
+        return dividend;
+    }
+    if(IsPowerOfTwo(divisor)) {
+        return builder.CreateShr(type, dividend, CreateConstant(builder, type, Log2(divisor)));
+    }
+
+    auto magic = GetUnsignedMagic(divisor, GetElementBits(type));
+    auto *high = builder.CreateMulHigh(type, dividend, CreateConstant(builder, type, magic.multiplier));
+    if(!magic.add) {
+        return magic.shift == 0 ? high : builder.CreateShr(type, high, CreateConstant(builder, type, magic.shift));
+    }
+    // (dividend + high) / 2 without overflowing the type.
+    auto *difference = builder.CreateSub(type, dividend, high);
+    auto *half = builder.CreateShr(type, difference, CreateConstant(builder, type, 1));
+    auto *sum = builder.CreateAdd(type, half, high);
+    return magic.shift == 1 ? sum : builder.CreateShr(type, sum, CreateConstant(builder, type, magic.shift - 1));
+}
+
+Instruction* DivisionByConstant::EmitSignedQuotient(IrBuilder &builder, DataType type, Instruction* dividend,
+                                                    int64_t divisor) {
+    auto bits = GetElementBits(type);
+    auto negate = [&builder, type](Instruction* value) {
+        return builder.CreateSub(type, CreateConstant(builder, type, 0), value);
+    };
+    if(divisor == 1) {
+        return dividend;
+    }
+    if(divisor == -1) {
+        return negate(dividend);
+    }
+
+    uint64_t magnitude = divisor < 0 ? 0 - static_cast<uint64_t>(divisor) : divisor;
+    if(IsPowerOfTwo(magnitude)) {
+        // Negative dividends are biased by magnitude - 1 to round towards zero.
+        auto log = Log2(magnitude);
+        auto *sign = builder.CreateShr(type, dividend, CreateConstant(builder, type, bits - 1));
+        auto *bias = builder.CreateAnd(type, sign, CreateConstant(builder, type, magnitude - 1));
+        auto *biased = builder.CreateAdd(type, dividend, bias);
+        auto *quotient = builder.CreateShr(type, biased, CreateConstant(builder, type, log));
+        return divisor < 0 ? negate(quotient) : quotient;
+    }
+
+    auto magic = GetSignedMagic(divisor, bits);
+    auto multiplier = SignExtend(magic.multiplier, bits);
+    Instruction* quotient = builder.CreateMulHigh(type, dividend, CreateConstant(builder, type, magic.multiplier));
+    if(divisor > 0 && multiplier < 0) {
+        quotient = builder.CreateAdd(type, quotient, dividend);
+    } else if(divisor < 0 && multiplier > 0) {
+        quotient = builder.CreateSub(type, quotient, dividend);
+    }
+    if(magic.shift != 0) {
+        quotient = builder.CreateShr(type, quotient, CreateConstant(builder, type, magic.shift));
+    }
+    // The shifted product rounds down; negative quotients get one added.
+    auto *sign = builder.CreateShr(type, quotient, CreateConstant(builder, type, bits - 1));
+    return builder.CreateSub(type, quotient, sign);
+}
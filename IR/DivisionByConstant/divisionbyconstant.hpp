@@ -0,0 +1,29 @@
+#ifndef IR_DIVISION_BY_CONSTANT_HPP
+#define IR_DIVISION_BY_CONSTANT_HPP
+
+#include "Graph/graph.hpp"
+#include "irbuilder.hpp"
+
+// Replaces scalar integer DIV and MOD by a constant with a multiplication by
+// a magic number, shifts and corrections (Granlund and Montgomery, "Division
+// by Invariant Integers using Multiplication"; Warren, "Hacker's Delight",
+// chapter 10). Powers of two only take shifts, the remainder is the dividend
+// minus the quotient times the divisor, or a mask for unsigned powers of two.
+// Signed division truncates towards zero like DIV, so the minimum value
+// divided by -1 wraps to itself. A zero divisor is left alone to trap.
+class DivisionByConstant final {
+public:
+    DivisionByConstant(Graph* graph): graph_(graph) {}
+
+    // Returns the number of rewritten instructions.
+    size_t Run();
+
+private:
+    Instruction* EmitUnsignedQuotient(IrBuilder &builder, DataType type, Instruction* dividend, uint64_t divisor);
+    Instruction* EmitSignedQuotient(IrBuilder &builder, DataType type, Instruction* dividend, int64_t divisor);
+
+private:
+    Graph* graph_ = nullptr;
+};
+
+#endif  // IR_DIVISION_BY_CONSTANT_HPP
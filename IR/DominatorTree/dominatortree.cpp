@@ -1,9 +1,16 @@
 #include "DominatorTree/dominatortree.hpp"
-#include "DFS/rpo.hpp"
 #include "Graph/graph.hpp"
 
 #include <algorithm>
-#include <iostream>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+namespace {
+
+constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+}  // namespace
 
 const std::vector<BasicBlock*> &DominatorTree::GetImmediateDominatedBlocks(BasicBlock* block) const {
     return immediateDominatedBlocks_.at(block);
@@ -13,90 +20,294 @@ std::vector<BasicBlock*> &DominatorTree::GetImmediateDominatedBlocks(BasicBlock*
     return immediateDominatedBlocks_.at(block);
 }
 
-bool DominatorTree::IsDominatesOver(BasicBlock* domBlock, BasicBlock* block) const {
-    if(block == domBlock) {
-        return true;
-    }
-    auto it = std::find_if(dominatedBlocks_.at(domBlock).begin(), dominatedBlocks_.at(domBlock).end(),
-                           [block](auto domBlock) { return domBlock == block; });
-    return it != dominatedBlocks_.at(domBlock).end();
-}
-
 bool DominatorTree::Dominates(BasicBlock *dominator, BasicBlock *dominated) const {
     if(dominator == dominated) {
         return true;
     }
-    
-    auto it = dominatedBlocks_.find(dominator);
-    if(it == dominatedBlocks_.end()) {
+
+    auto dominatorLevel = levels_.find(dominator);
+    auto level = levels_.find(dominated);
+    if(dominatorLevel == levels_.end() || level == levels_.end()) {
         return false;
     }
-    
-    const auto &dominatedSet = it->second;
-    return std::find(dominatedSet.begin(), dominatedSet.end(), dominated) != dominatedSet.end();
+
+    for(auto depth = level->second; depth > dominatorLevel->second; --depth) {
+        dominated = immediateDominators_.at(dominated);
+    }
+    return dominated == dominator;
+}
+
+BasicBlock* DominatorTree::GetImmediateDominator(BasicBlock* block) const {
+    auto it = immediateDominators_.find(block);
+    return it == immediateDominators_.end() ? nullptr : it->second;
+}
+
+BasicBlock* DominatorTree::FindNearestCommonDominator(BasicBlock* lhs, BasicBlock* rhs) const {
+    if(!IsReachable(lhs) || !IsReachable(rhs)) {
+        return nullptr;
+    }
+    while(levels_.at(lhs) > levels_.at(rhs)) {
+        lhs = immediateDominators_.at(lhs);
+    }
+    while(levels_.at(rhs) > levels_.at(lhs)) {
+        rhs = immediateDominators_.at(rhs);
+    }
+    while(lhs != rhs) {
+        lhs = immediateDominators_.at(lhs);
+        rhs = immediateDominators_.at(rhs);
+    }
+    return lhs;
 }
 
 void DominatorTree::Build() {
-    RPO rpo{graph_};
-    auto rpoVec = rpo.Run();
+    immediateDominatedBlocks_.clear();
+    immediateDominators_.clear();
+    levels_.clear();
+
+    BasicBlock* rootBlock = nullptr;
+    if(reversed_) {
+        exits_.clear();
+        for(auto &block: graph_->GetBlocks()) {
+            if(block->GetSuccessors().empty()) {
+                exits_.push_back(block.get());
+            }
+        }
+    } else {
+        rootBlock = graph_->GetStartBlock();
+    }
+    levels_[rootBlock] = 0;
+    Recompute(rootBlock, nullptr);
+}
+
+// An insertion whose common dominator already is the immediate dominator of
+// the target changes nothing.
+void DominatorTree::InsertEdge(BasicBlock* from, BasicBlock* to) {
+    if(reversed_) {
+        Build();
+        return;
+    }
+    if(!IsReachable(from)) {
+        return;
+    }
+    if(IsReachable(to)) {
+        auto *common = FindNearestCommonDominator(from, to);
+        if(common == to || common == GetImmediateDominator(to)) {
+            return;
+        }
+    }
+    ApplyUpdates({{UpdateKind::INSERT, from, to}});
+}
 
-    auto *rootBlock = graph_->GetStartBlock();
-    dominatedBlocks_[rootBlock] = rpoVec;
+// A remaining parallel edge keeps every path.
+void DominatorTree::DeleteEdge(BasicBlock* from, BasicBlock* to) {
+    if(reversed_) {
+        Build();
+        return;
+    }
+    auto &succs = from->GetSuccessors();
+    if(!IsReachable(from) || !IsReachable(to) || std::find(succs.begin(), succs.end(), to) != succs.end()) {
+        return;
+    }
+    ApplyUpdates({{UpdateKind::DELETE, from, to}});
+}
 
-    for(auto it = rpoVec.begin(); it < rpoVec.end(); ++it) {
-        dominatorsMap_.emplace(*it, std::vector<BasicBlock*> {rootBlock});
+// Before the updates no edge enters the subtree of a block other than at the
+// block itself, and every updated edge starts in the subtree of the common
+// dominator, so blocks outside it keep their dominators. Blocks reached for
+// the first time hang below the common dominator as well, and their edges
+// into the tree count as insertions. A deletion that may cut off its target
+// also takes away every edge leaving the target's subtree.
+void DominatorTree::ApplyUpdates(const std::vector<Update> &updates) {
+    if(reversed_) {
+        Build();
+        return;
     }
 
-    DFS dfs(graph_);
+    BasicBlock* root = nullptr;
+    auto join = [this, &root](BasicBlock* block) {
+        root = root == nullptr ? block : FindNearestCommonDominator(root, block);
+    };
+    auto deletions = std::count_if(updates.begin(), updates.end(),
+                                   [](auto &update) { return update.kind == UpdateKind::DELETE; });
 
-    for(auto blockIt = rpoVec.begin(); blockIt < rpoVec.end(); ++blockIt) {
-        std::unordered_set<BasicBlock*> visitSet;
-        visitSet.insert(*blockIt);
-        auto reachableBlocks = dfs.Run(visitSet);
+    std::unordered_set<BasicBlock*> region;
+    std::vector<BasicBlock*> worklist;
+    for(auto &update: updates) {
+        if(!IsReachable(update.from)) {
+            continue;
+        }
+        join(update.from);
+        if(IsReachable(update.to)) {
+            join(update.to);
+            if(update.kind == UpdateKind::DELETE && (deletions > 1 || !HasEntry(update.to))) {
+                std::unordered_set<BasicBlock*> subtree;
+                CollectSubtree(update.to, subtree);
+                for(auto *block: subtree) {
+                    for(auto *succ: block->GetSuccessors()) {
+                        if(subtree.count(succ) == 0 && IsReachable(succ)) {
+                            join(succ);
+                        }
+                    }
+                }
+            }
+            continue;
+        }
+        if(update.kind == UpdateKind::DELETE) {
+            continue;
+        }
 
-        CalculateDominatedBlocks(*blockIt, rpoVec, reachableBlocks);
+        worklist.push_back(update.to);
+        while(!worklist.empty()) {
+            auto *block = worklist.back();
+            worklist.pop_back();
+            if(!region.insert(block).second) {
+                continue;
+            }
+            for(auto *succ: block->GetSuccessors()) {
+                if(IsReachable(succ)) {
+                    join(succ);
+                } else if(region.count(succ) == 0) {
+                    worklist.push_back(succ);
+                }
+            }
+        }
+    }
+    if(root == nullptr) {
+        return;
     }
 
-    for(auto blockIt = rpoVec.begin(); blockIt < rpoVec.end(); ++blockIt) {
-        CalculateImmediateDominators(*blockIt);
+    CollectSubtree(root, region);
+    Recompute(root, &region);
+}
+
+bool DominatorTree::IsReachable(BasicBlock* block) const {
+    return levels_.count(block) != 0;
+}
+
+const std::vector<BasicBlock*> &DominatorTree::GetSuccessors(BasicBlock* block) const {
+    if(!reversed_) {
+        return block->GetSuccessors();
     }
+    return block == nullptr ? exits_ : block->GetPredecessors();
+}
+
+const std::vector<BasicBlock*> &DominatorTree::GetPredecessors(BasicBlock* block) const {
+    return reversed_ ? block->GetSuccessors() : block->GetPredecessors();
 }
 
-void DominatorTree::CalculateDominatedBlocks(BasicBlock* block, const std::vector<BasicBlock*> &originalVec,
-                                             const std::vector<BasicBlock*> &reachableBlocks) {
-    std::vector<BasicBlock*> dominatedBlocks;
+// A path to a predecessor the block does not dominate never passes the block,
+// so a deleted edge into the block cannot be on it.
+bool DominatorTree::HasEntry(BasicBlock* block) const {
+    auto &preds = block->GetPredecessors();
+    return std::any_of(preds.begin(), preds.end(),
+                       [this, block](auto *pred) { return IsReachable(pred) && !Dominates(block, pred); });
+}
+
+void DominatorTree::CollectSubtree(BasicBlock* root, std::unordered_set<BasicBlock*> &blocks) const {
+    std::vector<BasicBlock*> worklist {root};
+    while(!worklist.empty()) {
+        auto *block = worklist.back();
+        worklist.pop_back();
+        blocks.insert(block);
+        auto &dominated = immediateDominatedBlocks_.at(block);
+        worklist.insert(worklist.end(), dominated.begin(), dominated.end());
+    }
+}
 
-    for(auto originalVecIt = originalVec.begin(); originalVecIt < originalVec.end(); ++originalVecIt) {
-        auto dominatedBlock = std::find_if(
-             reachableBlocks.begin(), reachableBlocks.end(),
-             [&originalVecIt](auto reachableBlocksIt) -> bool { return reachableBlocksIt == *originalVecIt; });
+void DominatorTree::Recompute(BasicBlock* root, const std::unordered_set<BasicBlock*>* region) {
+    auto inRegion = [region](BasicBlock* block) { return region == nullptr || region->count(block) != 0; };
 
-        if(dominatedBlock == reachableBlocks.end() && *originalVecIt != block) {
-            dominatedBlocks.push_back(*originalVecIt);
-            auto mapIt = dominatorsMap_.find(*originalVecIt);
-            if(mapIt != dominatorsMap_.end()) {
-                mapIt->second.push_back(block);
+    // Preorder of a DFS from the root; a block is numbered when it is popped,
+    // so its parent is the block that pushed it last.
+    std::vector<BasicBlock*> vertices;
+    std::vector<size_t> parents;
+    std::unordered_map<BasicBlock*, size_t> numbers;
+    std::vector<std::pair<BasicBlock*, size_t>> stack {{root, NONE}};
+    while(!stack.empty()) {
+        auto [block, parent] = stack.back();
+        stack.pop_back();
+        if(!numbers.emplace(block, vertices.size()).second) {
+            continue;
+        }
+        vertices.push_back(block);
+        parents.push_back(parent);
+        auto &succs = GetSuccessors(block);
+        for(auto it = succs.rbegin(); it != succs.rend(); ++it) {
+            if(inRegion(*it) && numbers.count(*it) == 0) {
+                stack.emplace_back(*it, vertices.size() - 1);
             }
         }
     }
 
-    dominatedBlocks_[block] = std::move(dominatedBlocks);
-}
+    // Semidominators in reverse preorder. Eval finds the vertex with the
+    // smallest semidominator on the forest path above a vertex, compressing
+    // the path on the way.
+    auto count = vertices.size();
+    std::vector<size_t> semi(count);
+    std::vector<size_t> label(count);
+    std::vector<size_t> ancestor(count, NONE);
+    std::iota(semi.begin(), semi.end(), 0);
+    std::iota(label.begin(), label.end(), 0);
+    std::vector<size_t> path;
+    auto eval = [&semi, &label, &ancestor, &path](size_t vertex) {
+        if(ancestor[vertex] == NONE) {
+            return vertex;
+        }
+        path.clear();
+        for(auto current = vertex; ancestor[ancestor[current]] != NONE; current = ancestor[current]) {
+            path.push_back(current);
+        }
+        for(auto it = path.rbegin(); it != path.rend(); ++it) {
+            auto parent = ancestor[*it];
+            if(semi[label[parent]] < semi[label[*it]]) {
+                label[*it] = label[parent];
+            }
+            ancestor[*it] = ancestor[parent];
+        }
+        return label[vertex];
+    };
 
-void DominatorTree::CalculateImmediateDominators(BasicBlock* block) {
-    std::vector<BasicBlock*> immediateDominators;
-
-    for(auto dominatedBlockIt: dominatedBlocks_[block]) {
-        auto mapIt = dominatorsMap_.find(dominatedBlockIt);
-        if(mapIt != dominatorsMap_.end()) {
-           auto blocksDominatesOverCurrent = mapIt->second;
-           auto it = std::find_if_not(blocksDominatesOverCurrent.begin(), blocksDominatesOverCurrent.end(),
-                                      [block, this](auto domIt) { return IsDominatesOver(domIt, block); });
-            if(it == blocksDominatesOverCurrent.end()) {
-                immediateDominators.push_back(dominatedBlockIt);
+    for(size_t vertex = count; vertex-- > 1;) {
+        for(auto *pred: GetPredecessors(vertices[vertex])) {
+            auto it = numbers.find(pred);
+            if(it != numbers.end()) {
+                semi[vertex] = std::min(semi[vertex], semi[eval(it->second)]);
             }
         }
+        // Exits follow the virtual exit in the reversed CFG.
+        if(reversed_ && vertices[vertex]->GetSuccessors().empty()) {
+            semi[vertex] = 0;
+        }
+        ancestor[vertex] = parents[vertex];
+    }
+
+    std::vector<size_t> idoms(count, 0);
+    for(size_t vertex = 1; vertex < count; ++vertex) {
+        auto dominator = parents[vertex];
+        while(dominator > semi[vertex]) {
+            dominator = idoms[dominator];
+        }
+        idoms[vertex] = dominator;
     }
 
-    immediateDominatedBlocks_[block] = std::move(immediateDominators);
-}
\ No newline at end of file
+    if(region != nullptr) {
+        for(auto *block: *region) {
+            if(numbers.count(block) == 0) {
+                immediateDominatedBlocks_.erase(block);
+                immediateDominators_.erase(block);
+                levels_.erase(block);
+            }
+        }
+    }
+    for(auto *block: vertices) {
+        immediateDominatedBlocks_[block].clear();
+    }
+    // Dominators come first in preorder, so their level is already known.
+    for(size_t vertex = 1; vertex < count; ++vertex) {
+        auto *block = vertices[vertex];
+        auto *dominator = vertices[idoms[vertex]];
+        immediateDominators_[block] = dominator;
+        immediateDominatedBlocks_[dominator].push_back(block);
+        levels_[block] = levels_.at(dominator) + 1;
+    }
+}
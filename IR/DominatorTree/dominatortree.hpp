@@ -1,35 +1,80 @@
 #ifndef IR_DOMINATOR_TREE_H
 #define IR_DOMINATOR_TREE_H
 
+#include <cstddef>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 
 class Graph;
 class BasicBlock;
 
+// Dominators are computed with semi-NCA (Georgiadis et al.): semidominators
+// as in Lengauer-Tarjan, then each immediate dominator is the nearest common
+// ancestor of the DFS parent and the semidominator.
+//
+// The tree can follow CFG edits without a rebuild. The CFG is changed first,
+// then the tree is told about the edges. Inserting or deleting an edge only
+// changes the dominators of blocks below the nearest common dominator of its
+// ends, so semi-NCA runs again on that subtree alone, plus the blocks the
+// insertion made reachable.
+//
+// A reversed tree holds post-dominators instead. It runs the same algorithm on
+// the reversed CFG from a virtual exit, which stands for nullptr and precedes
+// every block without successors. Blocks that never reach an exit are left out.
+// Edits can change the set of exits, so a reversed tree rebuilds on updates.
 class DominatorTree final {
 public:
-    DominatorTree(Graph* graph): graph_(graph) {}
+    enum class UpdateKind {
+        INSERT,
+        DELETE,
+    };
+
+    struct Update {
+        UpdateKind kind = UpdateKind::INSERT;
+        BasicBlock* from = nullptr;
+        BasicBlock* to = nullptr;
+    };
+
+    DominatorTree(Graph* graph, bool reversed = false): graph_(graph), reversed_(reversed) {}
     const std::vector<BasicBlock*> &GetImmediateDominatedBlocks(BasicBlock* block) const;
     std::vector<BasicBlock*> &GetImmediateDominatedBlocks(BasicBlock* block);
     bool Dominates(BasicBlock* dominator, BasicBlock* dominated) const;
+    // nullptr for the root and unreachable blocks, and for exits in a reversed tree.
+    BasicBlock* GetImmediateDominator(BasicBlock* block) const;
+    // nullptr when either block is unreachable or, in a reversed tree, for the virtual exit.
+    BasicBlock* FindNearestCommonDominator(BasicBlock* lhs, BasicBlock* rhs) const;
 
     void Build();
 
-private:
-    bool IsDominatesOver(BasicBlock* domblock, BasicBlock* block) const;
+    void InsertEdge(BasicBlock* from, BasicBlock* to);
+    void DeleteEdge(BasicBlock* from, BasicBlock* to);
+    // The CFG already has all the updates; a single subtree covering all of
+    // them is recomputed.
+    void ApplyUpdates(const std::vector<Update> &updates);
 
-    void CalculateDominatedBlocks(BasicBlock* block, const std::vector<BasicBlock*> &originalVec,
-                                  const std::vector<BasicBlock*> &reachableBlocks);
-
-    void CalculateImmediateDominators(BasicBlock* block);
+private:
+    bool IsReachable(BasicBlock* block) const;
+    // Edges of the CFG the tree is built on; the virtual exit is nullptr.
+    const std::vector<BasicBlock*> &GetSuccessors(BasicBlock* block) const;
+    const std::vector<BasicBlock*> &GetPredecessors(BasicBlock* block) const;
+    // Whether the block stays reachable after deleting edges into it.
+    bool HasEntry(BasicBlock* block) const;
+    void CollectSubtree(BasicBlock* root, std::unordered_set<BasicBlock*> &blocks) const;
+    // Runs semi-NCA from `root` over the blocks of `region`, or over the whole
+    // graph when it is nullptr. Region blocks the root no longer reaches leave
+    // the tree.
+    void Recompute(BasicBlock* root, const std::unordered_set<BasicBlock*>* region);
 
 private:
     Graph* graph_ {nullptr};
+    bool reversed_ = false;
+    std::vector<BasicBlock*> exits_;
 
-    std::unordered_map<BasicBlock*, std::vector<BasicBlock*>> dominatorsMap_;
-    std::unordered_map<BasicBlock*, std::vector<BasicBlock*>> dominatedBlocks_;
     std::unordered_map<BasicBlock*, std::vector<BasicBlock*>> immediateDominatedBlocks_;
+    std::unordered_map<BasicBlock*, BasicBlock*> immediateDominators_;
+    // Depth in the tree. Only reachable blocks have one.
+    std::unordered_map<BasicBlock*, size_t> levels_;
 };
 
-#endif  // IR_DOMINATOR_TREE_H
\ No newline at end of file
+#endif  // IR_DOMINATOR_TREE_H
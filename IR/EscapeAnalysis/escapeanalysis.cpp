@@ -0,0 +1,76 @@
+#include "EscapeAnalysis/escapeanalysis.hpp"
+#include "AliasAnalysis/aliasanalysis.hpp"
+#include "DFS/rpo.hpp"
+
+void EscapeAnalysis::Analyze() {
+    allocations_.clear();
+    escaping_.clear();
+
+    for(auto *block: RPO(graph_).Run()) {
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            if(instr->GetOpType() == OpType::NEW_OBJECT) {
+                allocations_.push_back(instr);
+            }
+        }
+    }
+
+    // Escaping objects let everything stored to them escape, so repeat until
+    // the set stops growing.
+    for(bool changed = true; changed;) {
+        changed = false;
+        for(auto *allocation: allocations_) {
+            std::unordered_set<Instruction*> visited;
+            if(escaping_.count(allocation) == 0 && !IsContained(allocation, visited)) {
+                escaping_.insert(allocation);
+                changed = true;
+            }
+        }
+    }
+}
+
+const std::vector<Instruction*>& EscapeAnalysis::GetAllocations() const {
+    return allocations_;
+}
+
+bool EscapeAnalysis::Escapes(Instruction* allocation) const {
+    return allocation->GetOpType() != OpType::NEW_OBJECT || escaping_.count(allocation) != 0;
+}
+
+// Whether every use of `reference` keeps it inside non-escaping objects. A
+// reference met again is being checked further up, so it does not fail here.
+// Loads overlapping the bytes a reference is stored to may read it back under
+// any type, so their values must stay contained too.
+bool EscapeAnalysis::IsContained(Instruction* reference, std::unordered_set<Instruction*> &visited) const {
+    if(!visited.insert(reference).second) {
+        return true;
+    }
+
+    for(auto &use: reference->GetUses()) {
+        auto *user = use.GetUser();
+        auto location = AliasAnalysis::GetLocation(user);
+        if(location.has_value() && use.GetIndex() == 0) {
+            continue;
+        }
+        if(!location.has_value() || (user->GetOpType() != OpType::STORE && user->GetOpType() != OpType::STORE_FIELD)) {
+            return false;
+        }
+
+        auto *object = user->GetInputs()[0].GetValue();
+        if(Escapes(object)) {
+            return false;
+        }
+        for(auto &objectUse: object->GetUses()) {
+            auto *load = objectUse.GetUser();
+            if(load->GetOpType() != OpType::LOAD && load->GetOpType() != OpType::LOAD_FIELD) {
+                continue;
+            }
+            auto loadLocation = AliasAnalysis::GetLocation(load);
+            bool mayRead = !loadLocation.has_value() ||
+                           AliasAnalysis::Alias(*loadLocation, *location) != AliasResult::NO_ALIAS;
+            if(mayRead && !IsContained(load, visited)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
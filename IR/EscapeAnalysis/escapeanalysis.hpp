@@ -0,0 +1,34 @@
+#ifndef IR_ESCAPE_ANALYSIS_HPP
+#define IR_ESCAPE_ANALYSIS_HPP
+
+#include "Graph/graph.hpp"
+
+#include <unordered_set>
+#include <vector>
+
+// Finds the allocations whose references never leave the graph. A reference
+// escapes when it is returned, kept in a guard state, merged by a phi, used by
+// any instruction other than as the base of a memory access, or stored to an
+// object that is not a known allocation or escapes itself. A reference stored
+// to a non-escaping object escapes as well when a value loaded from the bytes
+// it was stored to does. The graph has no calls, so nothing else can capture a reference.
+class EscapeAnalysis final {
+public:
+    EscapeAnalysis(Graph* graph): graph_(graph) {}
+
+    void Analyze();
+
+    const std::vector<Instruction*>& GetAllocations() const;
+    bool Escapes(Instruction* allocation) const;
+
+private:
+    bool IsContained(Instruction* reference, std::unordered_set<Instruction*> &visited) const;
+
+private:
+    Graph* graph_ = nullptr;
+
+    std::vector<Instruction*> allocations_;
+    std::unordered_set<Instruction*> escaping_;
+};
+
+#endif  // IR_ESCAPE_ANALYSIS_HPP
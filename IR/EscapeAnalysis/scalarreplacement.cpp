@@ -0,0 +1,136 @@
+#include "EscapeAnalysis/scalarreplacement.hpp"
+#include "DFS/rpo.hpp"
+#include "Instr/datatraits.hpp"
+#include "irbuilder.hpp"
+
+#include <unordered_map>
+
+size_t ScalarReplacement::Run() {
+    size_t removed = 0;
+    while(true) {
+        EscapeAnalysis analysis(graph_);
+        analysis.Analyze();
+
+        std::vector<Instruction*> allocations;
+        std::vector<std::vector<DataType>> fieldTypes;
+        for(auto *allocation: analysis.GetAllocations()) {
+            if(analysis.Escapes(allocation)) {
+                continue;
+            }
+            if(auto types = GetFieldTypes(allocation)) {
+                allocations.push_back(allocation);
+                fieldTypes.push_back(std::move(*types));
+            }
+        }
+        if(allocations.empty()) {
+            return removed;
+        }
+
+        Replace(allocations, fieldTypes);
+        removed += allocations.size();
+    }
+}
+
+std::optional<std::vector<DataType>> ScalarReplacement::GetFieldTypes(Instruction* allocation) const {
+    std::vector<DataType> types(static_cast<NewObjectInstr*>(allocation)->GetFieldsCount(), DataType::VOID);
+    for(auto &use: allocation->GetUses()) {
+        if(use.GetIndex() != 0) {
+            return std::nullopt;
+        }
+
+        uint32_t field = 0;
+        auto type = DataType::VOID;
+        if(auto *load = use.GetUser()->As<LoadFieldInstr>()) {
+            field = load->GetField();
+            type = load->GetResultType();
+        } else if(auto *store = use.GetUser()->As<StoreFieldInstr>()) {
+            field = store->GetField();
+            type = store->GetInputs()[1].GetValue()->GetResultType();
+        } else {
+            return std::nullopt;
+        }
+
+        // Accesses past the last field trap and must stay.
+        if(field >= types.size() || IsVectorType(type) || (types[field] != DataType::VOID && types[field] != type)) {
+            return std::nullopt;
+        }
+        types[field] = type;
+    }
+    return types;
+}
+
+// Fields become builder variables, so the SSA form is built on the fly while
+// the blocks are walked in reverse post order. A block is sealed once all its
+// reachable predecessors are walked; loop headers wait for their latches.
+void ScalarReplacement::Replace(const std::vector<Instruction*> &allocations,
+                                const std::vector<std::vector<DataType>> &fieldTypes) {
+    std::unordered_map<Instruction*, size_t> allocationIdx;
+    std::vector<uint32_t> firstVariable;
+    uint32_t variablesCount = 0;
+    for(size_t idx = 0; idx < allocations.size(); ++idx) {
+        allocationIdx[allocations[idx]] = idx;
+        firstVariable.push_back(variablesCount);
+        variablesCount += fieldTypes[idx].size();
+    }
+    auto getVariable = [&](Instruction* object, uint32_t field) -> std::optional<uint32_t> {
+        auto it = allocationIdx.find(object);
+        if(it == allocationIdx.end()) {
+            return std::nullopt;
+        }
+        return firstVariable[it->second] + field;
+    };
+
+    auto rpo = RPO(graph_).Run();
+    std::unordered_map<BasicBlock*, size_t> pendingPreds;
+    for(auto *block: rpo) {
+        for(auto *succ: block->GetSuccessors()) {
+            ++pendingPreds[succ];
+        }
+    }
+
+    IrBuilder builder(graph_);
+    std::vector<Instruction*> accesses;
+    for(auto *block: rpo) {
+        builder.SetBasicBlockScope(block);
+        if(pendingPreds[block] == 0) {
+            builder.SealBlock(block);
+        }
+
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            auto it = allocationIdx.find(instr);
+            if(it != allocationIdx.end()) {
+                auto &types = fieldTypes[it->second];
+                builder.SetInsertPoint(instr);
+                for(uint32_t field = 0; field < types.size(); ++field) {
+                    if(types[field] != DataType::VOID) {
+                        builder.WriteVariable(*getVariable(instr, field),
+                                              builder.CreateConstant(uint64_t{0}, types[field]));
+                    }
+                }
+            } else if(auto *load = instr->As<LoadFieldInstr>()) {
+                if(auto variable = getVariable(load->GetInputs()[0].GetValue(), load->GetField())) {
+                    load->ReplaceAllUsesWith(builder.ReadVariable(*variable));
+                    accesses.push_back(load);
+                }
+            } else if(auto *store = instr->As<StoreFieldInstr>()) {
+                if(auto variable = getVariable(store->GetInputs()[0].GetValue(), store->GetField())) {
+                    builder.WriteVariable(*variable, store->GetInputs()[1].GetValue());
+                    accesses.push_back(store);
+                }
+            }
+        }
+
+        for(auto *succ: block->GetSuccessors()) {
+            if(--pendingPreds[succ] == 0) {
+                builder.SealBlock(succ);
+            }
+        }
+    }
+
+    for(auto *access: accesses) {
+        graph_->RemoveInstruction(access);
+    }
+    for(auto *allocation: allocations) {
+        graph_->RemoveInstruction(allocation);
+    }
+}
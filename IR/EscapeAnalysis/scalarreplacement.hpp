@@ -0,0 +1,31 @@
+#ifndef IR_SCALAR_REPLACEMENT_HPP
+#define IR_SCALAR_REPLACEMENT_HPP
+
+#include "EscapeAnalysis/escapeanalysis.hpp"
+
+#include <optional>
+#include <vector>
+
+// Replaces the fields of non-escaping allocations with SSA values and removes
+// the allocations with all their loads and stores. An allocation is replaced
+// once every use accesses one of its fields directly, each field with a single
+// type. A reference kept in a field of a replaced object turns into a direct
+// value, so the pass repeats until no allocation is left to replace.
+class ScalarReplacement final {
+public:
+    ScalarReplacement(Graph* graph): graph_(graph) {}
+
+    // Returns the number of removed allocations.
+    size_t Run();
+
+private:
+    // Type of every field of `allocation` that is accessed, VOID for the rest,
+    // or nothing if the allocation cannot be replaced.
+    std::optional<std::vector<DataType>> GetFieldTypes(Instruction* allocation) const;
+    void Replace(const std::vector<Instruction*> &allocations, const std::vector<std::vector<DataType>> &fieldTypes);
+
+private:
+    Graph* graph_ = nullptr;
+};
+
+#endif  // IR_SCALAR_REPLACEMENT_HPP
@@ -1,4 +1,8 @@
 #include "Graph/graph.hpp"
+#include "DFS/dfs.hpp"
+
+#include <algorithm>
+#include <utility>
 
 void Graph::AddBlock(std::unique_ptr<BasicBlock> block) {
     size_t currblockNum = basicBlocks_.size();
@@ -7,6 +11,101 @@ void Graph::AddBlock(std::unique_ptr<BasicBlock> block) {
     basicBlocks_.push_back(std::move(block));
 }
 
+void Graph::RemoveBlock(BasicBlock* block) {
+    auto succs = block->GetSuccessors();
+    for(auto *succ: succs) {
+        succ->RemovePredecessor(block);
+        block->RemoveSuccessor(succ);
+    }
+    auto preds = block->GetPredecessors();
+    for(auto *pred: preds) {
+        pred->RemoveSuccessor(block);
+        block->RemovePredecessor(pred);
+    }
+
+    for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+        instr->SetParentBB(nullptr);
+        instr->ClearInputs();
+    }
+
+    auto it = std::find_if(basicBlocks_.begin(), basicBlocks_.end(),
+                           [block](auto &bb) { return bb.get() == block; });
+    basicBlocks_.erase(it);
+
+    for(size_t idx = 0; idx < basicBlocks_.size(); ++idx) {
+        basicBlocks_[idx]->SetId(idx);
+    }
+}
+
+void Graph::RemoveUnreachableBlocks() {
+    DFS dfs(this);
+    auto reachable = dfs.Run();
+    std::unordered_set<BasicBlock*> reachableSet(reachable.begin(), reachable.end());
+
+    std::vector<BasicBlock*> unreachable;
+    for(auto &block: basicBlocks_) {
+        if(reachableSet.count(block.get()) == 0) {
+            unreachable.push_back(block.get());
+        }
+    }
+    for(auto *block: unreachable) {
+        RemoveBlock(block);
+    }
+}
+
+BasicBlock* Graph::SplitEdge(BasicBlock* from, BasicBlock* to) {
+    AddBlock(std::make_unique<BasicBlock>());
+    auto *middle = basicBlocks_.back().get();
+
+    auto jmp = std::make_unique<JmpInstr>(to);
+    jmp->SetParentBB(middle);
+    middle->PushInstruction(jmp.get());
+    AddInstruction(std::move(jmp));
+
+    auto *terminator = from->GetLastInstr();
+    if(auto *branch = terminator->As<CjmpInstr>()) {
+        branch->ReplaceTarget(to, middle);
+    } else {
+        static_cast<JmpInstr*>(terminator)->SetBBToJmp(middle);
+    }
+    from->ReplaceSuccessor(to, middle);
+    middle->AddPredecessor(from);
+    middle->AddSuccessor(to);
+    to->ReplacePredecessor(from, middle);
+    return middle;
+}
+
+size_t Graph::SplitCriticalEdges() {
+    std::vector<std::pair<BasicBlock*, BasicBlock*>> critical;
+    for(auto &block: basicBlocks_) {
+        if(block->GetSuccessors().size() < 2) {
+            continue;
+        }
+        for(auto *succ: block->GetSuccessors()) {
+            if(succ->GetPredecessors().size() > 1) {
+                critical.emplace_back(block.get(), succ);
+            }
+        }
+    }
+    // Each split takes the first remaining edge between the two blocks, so
+    // parallel edges get a block each.
+    for(auto [from, to]: critical) {
+        SplitEdge(from, to);
+    }
+    return critical.size();
+}
+
+bool Graph::RemoveInstruction(Instruction* instr) {
+    if(instr->HasUses()) {
+        return false;
+    }
+    if(instr->GetParentBB() != nullptr) {
+        instr->GetParentBB()->RemoveInstruction(instr);
+    }
+    instr->ClearInputs();
+    return true;
+}
+
 BasicBlock* Graph::GetStartBlock() const {
     return basicBlocks_.front().get();
 }
@@ -16,6 +115,14 @@ void Graph::AddInstruction(std::unique_ptr<Instruction> instr) {
     instructions_.push_back(std::move(instr));
 }
 
+const std::vector<std::unique_ptr<BasicBlock>>& Graph::GetBlocks() const {
+    return basicBlocks_;
+}
+
+const std::vector<std::unique_ptr<Instruction>>& Graph::GetInstructions() const {
+    return instructions_;
+}
+
 void Graph::Dump(std::stringstream &ss) const {
     for (auto &bb : basicBlocks_) {
         bb->Dump(ss);
@@ -10,9 +10,23 @@
 class Graph final {
 public:
     void AddBlock(std::unique_ptr<BasicBlock> block);
+    void RemoveBlock(BasicBlock* block);
+    void RemoveUnreachableBlocks();
+    // Puts a new block that only jumps to `to` on the edge from `from` and
+    // returns it. Phis in `to` take their input for the edge from it.
+    BasicBlock* SplitEdge(BasicBlock* from, BasicBlock* to);
+    // Splits every edge from a block with several successors to a block with
+    // several predecessors and returns the number of split edges.
+    size_t SplitCriticalEdges();
+    // Unlinks an unused instruction from its block and drops its inputs. The
+    // graph keeps owning it, so instruction ids stay stable.
+    bool RemoveInstruction(Instruction* instr);
     BasicBlock *GetStartBlock() const;
     void AddInstruction(std::unique_ptr<Instruction> instr);
 
+    const std::vector<std::unique_ptr<BasicBlock>>& GetBlocks() const;
+    const std::vector<std::unique_ptr<Instruction>>& GetInstructions() const;
+
     void Dump(std::stringstream &ss) const;
 
 private:
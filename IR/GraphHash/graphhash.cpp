@@ -0,0 +1,104 @@
+#include "GraphHash/graphhash.hpp"
+#include "Graph/graph.hpp"
+#include "Instr/visitor.hpp"
+
+namespace {
+
+constexpr uint64_t HASH_SEED = 0x9e3779b97f4a7c15ULL;
+constexpr uint64_t NO_INSTR = ~0ULL;
+
+uint64_t MixBits(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+}  // namespace
+
+uint64_t GraphHasher::Run() {
+    hash_ = HASH_SEED;
+    key_.clear();
+    instrNumbers_.clear();
+
+    NumberInstructions();
+
+    auto &blocks = graph_->GetBlocks();
+    Mix(blocks.size());
+
+    for(auto &block: blocks) {
+        // Phi inputs are matched to predecessors by position, so order matters.
+        Mix(block->GetPredecessors().size());
+        for(auto *pred: block->GetPredecessors()) {
+            Mix(pred->GetId());
+        }
+        Mix(block->GetSuccessors().size());
+        for(auto *succ: block->GetSuccessors()) {
+            Mix(succ->GetId());
+        }
+
+        uint64_t instrsCount = 0;
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            ++instrsCount;
+        }
+        Mix(instrsCount);
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            HashInstruction(instr);
+        }
+    }
+
+    return hash_;
+}
+
+void GraphHasher::NumberInstructions() {
+    uint64_t number = 0;
+    for(auto &block: graph_->GetBlocks()) {
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            instrNumbers_[instr] = number++;
+        }
+    }
+}
+
+void GraphHasher::Mix(uint64_t value) {
+    key_.push_back(value);
+    hash_ = MixBits(hash_ ^ (value + HASH_SEED + (hash_ << 6) + (hash_ >> 2)));
+}
+
+void GraphHasher::HashInstruction(Instruction* instr) {
+    Mix(static_cast<uint64_t>(instr->GetOpType()));
+    Mix(static_cast<uint64_t>(instr->GetResultType()));
+
+    auto &inputs = instr->GetInputs();
+    Mix(inputs.size());
+    for(auto &input: inputs) {
+        auto it = instrNumbers_.find(input.GetValue());
+        Mix(it == instrNumbers_.end() ? NO_INSTR : it->second);
+    }
+
+    VisitInstruction(instr, Overloaded{
+        [this](ConstantInstr* constant) {
+            Mix(constant->IsSignedInt());
+            Mix(constant->GetAsUnsignedInt());
+        },
+        [this](ParameterInstr* parameter) { Mix(parameter->GetArgNum()); },
+        [this](JmpInstr* jmp) { Mix(jmp->GetBBToJmp()->GetId()); },
+        [this](CjmpInstr* branch) {
+            Mix(branch->GetTrueBranchBB()->GetId());
+            Mix(branch->GetFalseBranchBB()->GetId());
+        },
+        [this](ReduceInstr* reduce) { Mix(static_cast<uint64_t>(reduce->GetReduceOp())); },
+        [this](OverflowCheckInstr* check) {
+            Mix(static_cast<uint64_t>(check->GetCheckedOp()));
+            Mix(static_cast<uint64_t>(check->GetCheckedType()));
+        },
+        [this](NewObjectInstr* object) { Mix(object->GetFieldsCount()); },
+        [this](LoadFieldInstr* load) { Mix(load->GetField()); },
+        [this](StoreFieldInstr* store) { Mix(store->GetField()); },
+        [this](LoadInstr* load) { Mix(static_cast<uint64_t>(load->GetOffset())); },
+        [this](StoreInstr* store) { Mix(static_cast<uint64_t>(store->GetOffset())); },
+        [this](SelectInstr* select) { Mix(static_cast<uint64_t>(select->GetCondition())); },
+        [](Instruction*) {},
+    });
+}
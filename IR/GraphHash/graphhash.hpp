@@ -0,0 +1,40 @@
+#ifndef IR_GRAPH_HASH_HPP
+#define IR_GRAPH_HASH_HPP
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class Graph;
+class Instruction;
+
+// Every value mixed into the hash, in order. Two graphs with equal keys have
+// the same shape, so a key comparison confirms a hash match.
+using GraphKey = std::vector<uint64_t>;
+
+// Hash of the graph shape: blocks with their ordered predecessors and
+// successors, opcodes, result types, operand topology and constant values.
+// Instruction ids and addresses do not take part, so two graphs built the
+// same way hash equally.
+class GraphHasher final {
+public:
+    GraphHasher(Graph* graph): graph_(graph) {}
+
+    uint64_t Run();
+
+    const GraphKey& GetKey() const { return key_; }
+
+private:
+    void NumberInstructions();
+    void Mix(uint64_t value);
+    void HashInstruction(Instruction* instr);
+
+private:
+    Graph* graph_ = nullptr;
+
+    uint64_t hash_ = 0;
+    GraphKey key_;
+    std::unordered_map<Instruction*, uint64_t> instrNumbers_;
+};
+
+#endif  // IR_GRAPH_HASH_HPP
@@ -0,0 +1,137 @@
+#include "IfConversion/ifconversion.hpp"
+#include "DFS/dfs.hpp"
+#include "Instr/optraits.hpp"
+#include "irbuilder.hpp"
+
+#include <algorithm>
+
+// A conversion only changes blocks of its own hammock, and every candidate is
+// checked against the current CFG, so one post-dominator tree serves a whole
+// round. Inner hammocks come first in post order; the outer ones they were
+// arms of are converted in the next round.
+size_t IfConversion::Run() {
+    size_t converted = 0;
+    for(bool changed = true; changed;) {
+        changed = false;
+        DominatorTree postDomTree(graph_, true);
+        postDomTree.Build();
+        for(auto *block: DFS(graph_).RunPostOrder()) {
+            if(Convert(block, postDomTree)) {
+                ++converted;
+                changed = true;
+            }
+        }
+        graph_->RemoveUnreachableBlocks();
+    }
+    return converted;
+}
+
+bool IfConversion::IsPredictable(Instruction* branch) const {
+    if(profile_ == nullptr) {
+        return false;
+    }
+    auto counters = profile_->GetCounters(branch);
+    auto total = counters.taken + counters.notTaken;
+    return total != 0 && std::max(counters.taken, counters.notTaken) * 100 >= total * predictablePercent_;
+}
+
+std::optional<size_t> IfConversion::GetArmSize(BasicBlock* block, BasicBlock* target, BasicBlock* join) const {
+    if(target == join) {
+        return 0;
+    }
+    auto &succs = target->GetSuccessors();
+    if(target == block || target->GetPredecessors().size() != 1 || succs.size() != 1 || succs[0] != join ||
+       target->GetLastInstr()->GetOpType() != OpType::JMP) {
+        return std::nullopt;
+    }
+
+    // Allocations would happen on both paths.
+    size_t size = 0;
+    for(auto *instr = target->GetFirstInstr(); instr != target->GetLastInstr(); instr = instr->GetNext()) {
+        if(instr->IsPhi() || HasSideEffects(instr->GetOpType()) || instr->GetOpType() == OpType::NEW_OBJECT) {
+            return std::nullopt;
+        }
+        ++size;
+    }
+    return size;
+}
+
+bool IfConversion::Convert(BasicBlock* block, const DominatorTree &postDomTree) {
+    auto *terminator = block->GetLastInstr();
+    auto *branch = terminator == nullptr ? nullptr : terminator->As<CjmpInstr>();
+    auto *join = postDomTree.GetImmediateDominator(block);
+    if(branch == nullptr || join == nullptr || join == block || join == graph_->GetStartBlock()) {
+        return false;
+    }
+    auto *ifTrue = branch->GetTrueBranchBB();
+    auto *ifFalse = branch->GetFalseBranchBB();
+    if(ifTrue == ifFalse || IsPredictable(branch)) {
+        return false;
+    }
+
+    auto trueSize = GetArmSize(block, ifTrue, join);
+    auto falseSize = GetArmSize(block, ifFalse, join);
+    if(!trueSize.has_value() || !falseSize.has_value() || *trueSize + *falseSize > maxInstructions_) {
+        return false;
+    }
+    auto *trueEdge = ifTrue == join ? block : ifTrue;
+    auto *falseEdge = ifFalse == join ? block : ifFalse;
+    auto &joinPreds = join->GetPredecessors();
+    if(joinPreds.size() != 2 || std::count(joinPreds.begin(), joinPreds.end(), trueEdge) != 1 ||
+       std::count(joinPreds.begin(), joinPreds.end(), falseEdge) != 1) {
+        return false;
+    }
+    for(auto *phi = join->GetFirstInstr(); phi != nullptr && phi->IsPhi(); phi = phi->GetNext()) {
+        if(IsVectorType(phi->GetResultType())) {
+            return false;
+        }
+    }
+
+    for(auto *arm: {ifTrue, ifFalse}) {
+        while(arm != join && arm->GetFirstInstr() != arm->GetLastInstr()) {
+            auto *instr = arm->GetFirstInstr();
+            arm->RemoveInstruction(instr);
+            block->InsertBefore(branch, instr);
+        }
+    }
+
+    IrBuilder builder(graph_);
+    builder.SetInsertPoint(branch);
+    auto *condition = branch->GetInputs()[0].GetValue();
+    while(join->GetFirstInstr() != nullptr && join->GetFirstInstr()->IsPhi()) {
+        auto *phi = static_cast<PhiInstr*>(join->GetFirstInstr());
+        auto *trueValue = phi->GetPhiInput(trueEdge);
+        auto *falseValue = phi->GetPhiInput(falseEdge);
+        auto *value = trueValue == falseValue ? trueValue :
+                      builder.CreateSelect(phi->GetResultType(), branch->GetOpType(), condition, trueValue, falseValue);
+        phi->ReplaceAllUsesWith(value);
+        graph_->RemoveInstruction(phi);
+    }
+    graph_->RemoveInstruction(branch);
+    if(!condition->HasUses() && !HasSideEffects(condition->GetOpType())) {
+        graph_->RemoveInstruction(condition);
+    }
+
+    // The arms and the join leave the CFG; successors of the join see the
+    // block in its place.
+    for(auto *target: {ifTrue, ifFalse}) {
+        block->RemoveSuccessor(target);
+        target->RemovePredecessor(block);
+        if(target != join) {
+            target->RemoveSuccessor(join);
+            join->RemovePredecessor(target);
+        }
+    }
+    while(auto *instr = join->GetFirstInstr()) {
+        join->RemoveInstruction(instr);
+        block->PushInstruction(instr);
+        instr->SetParentBB(block);
+    }
+    auto succs = join->GetSuccessors();
+    for(auto *succ: succs) {
+        block->AddSuccessor(succ);
+        succ->ReplacePredecessor(join, block);
+        join->RemoveSuccessor(succ);
+    }
+    return true;
+}
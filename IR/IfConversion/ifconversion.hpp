@@ -0,0 +1,45 @@
+#ifndef IR_IF_CONVERSION_HPP
+#define IR_IF_CONVERSION_HPP
+
+#include "DominatorTree/dominatortree.hpp"
+#include "Graph/graph.hpp"
+#include "Profile/branchprofile.hpp"
+
+#include <optional>
+
+// Replaces short hammocks with selects. A conditional jump qualifies when its
+// immediate post-dominator, the join, is one of its targets or the only
+// successor of the other ones, those arms have no other predecessor and the
+// join is entered from the hammock alone. The arms are hoisted above the jump,
+// each phi of the join becomes a select on the jump's condition and the join
+// is merged into the branching block.
+//
+// Arms must be free of side effects, and both of them together at most
+// `maxInstructions` long, since they now always run. With a profile, branches
+// that went one way in at least `predictablePercent` of their runs are left
+// alone: the predictor gets them right and the branch skips an arm.
+class IfConversion final {
+public:
+    IfConversion(Graph* graph, const BranchProfile* profile = nullptr, size_t maxInstructions = 4,
+                 size_t predictablePercent = 90):
+        graph_(graph), profile_(profile), maxInstructions_(maxInstructions),
+        predictablePercent_(predictablePercent) {}
+
+    // Returns the number of converted branches.
+    size_t Run();
+
+private:
+    bool IsPredictable(Instruction* branch) const;
+    // Instructions hoisting the arm from `block` to `target` adds; nullopt when
+    // `target` is no arm that can be hoisted.
+    std::optional<size_t> GetArmSize(BasicBlock* block, BasicBlock* target, BasicBlock* join) const;
+    bool Convert(BasicBlock* block, const DominatorTree &postDomTree);
+
+private:
+    Graph* graph_ = nullptr;
+    const BranchProfile* profile_ = nullptr;
+    size_t maxInstructions_ = 4;
+    size_t predictablePercent_ = 90;
+};
+
+#endif  // IR_IF_CONVERSION_HPP
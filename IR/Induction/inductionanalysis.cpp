@@ -0,0 +1,285 @@
+#include "Induction/inductionanalysis.hpp"
+#include "DFS/rpo.hpp"
+#include "Instr/datatraits.hpp"
+
+namespace {
+
+bool IsSignedType(DataType type) {
+    return type == DataType::I8 || type == DataType::I16 || type == DataType::I32 || type == DataType::I64;
+}
+
+bool IsUnsignedType(DataType type) {
+    return type == DataType::U8 || type == DataType::U16 || type == DataType::U32 || type == DataType::U64;
+}
+
+uint64_t GetTypeMask(DataType type) {
+    auto bits = GetElementBits(type);
+    return bits >= 64 ? ~0ULL : (1ULL << bits) - 1;
+}
+
+bool IsIntegerType(DataType type) {
+    return IsSignedType(type) || IsUnsignedType(type);
+}
+
+}  // namespace
+
+void InductionAnalysis::Analyze() {
+    loopAnalyzer_.Analyze();
+    variables_.clear();
+    byValue_.clear();
+    byLoop_.clear();
+    tripCounts_.clear();
+
+    auto rpo = RPO(graph_).Run();
+    for(auto &loop: loopAnalyzer_.GetLoops()) {
+        AnalyzeLoop(loop.get(), rpo);
+    }
+}
+
+const LoopAnalyzer& InductionAnalysis::GetLoopAnalyzer() const {
+    return loopAnalyzer_;
+}
+
+const InductionVariable* InductionAnalysis::GetInductionVariable(Instruction* instr) const {
+    auto it = byValue_.find(instr);
+    return it == byValue_.end() ? nullptr : it->second;
+}
+
+const std::vector<InductionVariable*>& InductionAnalysis::GetInductionVariables(Loop* loop) const {
+    static const std::vector<InductionVariable*> EMPTY;
+    auto it = byLoop_.find(loop);
+    return it == byLoop_.end() ? EMPTY : it->second;
+}
+
+std::optional<uint64_t> InductionAnalysis::GetTripCount(Loop* loop) const {
+    auto it = tripCounts_.find(loop);
+    return it == tripCounts_.end() ? std::nullopt : it->second;
+}
+
+BasicBlock* InductionAnalysis::GetPreheader(Loop* loop) {
+    auto &preds = loop->GetHeader()->GetPredecessors();
+    if(loop->GetBackEdges().size() != 1 || preds.size() != 2) {
+        return nullptr;
+    }
+    auto *latch = loop->GetBackEdges()[0];
+    return preds[0] == latch ? preds[1] : preds[0];
+}
+
+uint64_t InductionAnalysis::GetConstantValue(ConstantInstr* constant) {
+    auto type = constant->GetResultType();
+    auto bits = GetElementBits(type);
+    uint64_t value = constant->GetAsUnsignedInt();
+    if(bits == 0 || bits >= 64) {
+        return value;
+    }
+
+    auto mask = GetTypeMask(type);
+    value &= mask;
+    if(IsSignedType(type) && ((value >> (bits - 1)) & 1) != 0) {
+        value |= ~mask;
+    }
+    return value;
+}
+
+void InductionAnalysis::AnalyzeLoop(Loop* loop, const std::vector<BasicBlock*> &rpo) {
+    auto *preheader = GetPreheader(loop);
+    if(preheader == nullptr) {
+        return;
+    }
+
+    auto &variables = byLoop_[loop];
+    auto record = [this, &variables](InductionVariable variable) {
+        variables_.push_back(std::make_unique<InductionVariable>(variable));
+        auto *recorded = variables_.back().get();
+        byValue_[recorded->value] = recorded;
+        variables.push_back(recorded);
+    };
+
+    auto *header = loop->GetHeader();
+    for(auto *instr = header->GetFirstInstr(); instr != nullptr && instr->IsPhi(); instr = instr->GetNext()) {
+        if(auto basic = GetBasic(loop, preheader, instr)) {
+            record(*basic);
+        }
+    }
+
+    // Values of inner loops change at their own pace and are left to them.
+    auto isInSubLoop = [loop](BasicBlock* block) {
+        for(auto *subLoop: loop->GetSubLoops()) {
+            if(subLoop->Contains(block)) {
+                return true;
+            }
+        }
+        return false;
+    };
+    for(auto *block: rpo) {
+        if(!loop->Contains(block) || isInSubLoop(block)) {
+            continue;
+        }
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            if(instr->IsPhi()) {
+                continue;
+            }
+            if(auto derived = GetDerived(loop, instr)) {
+                record(*derived);
+            }
+        }
+    }
+
+    tripCounts_[loop] = ComputeTripCount(loop);
+}
+
+bool InductionAnalysis::IsInvariant(Loop* loop, Instruction* value) const {
+    return value->Is<ConstantInstr>() || (value->GetParentBB() != nullptr && !loop->Contains(value->GetParentBB()));
+}
+
+std::optional<InductionVariable> InductionAnalysis::GetBasic(Loop* loop, BasicBlock* preheader,
+                                                             Instruction* phi) const {
+    auto type = phi->GetResultType();
+    if(!IsIntegerType(type) || phi->GetInputs().size() != 2) {
+        return std::nullopt;
+    }
+
+    InductionVariable variable;
+    variable.value = variable.basic = phi;
+    variable.loop = loop;
+    variable.bits = GetElementBits(type);
+    variable.init = static_cast<PhiInstr*>(phi)->GetPhiInput(preheader);
+
+    auto *update = static_cast<PhiInstr*>(phi)->GetPhiInput(loop->GetBackEdges()[0]);
+    auto op = update->GetOpType();
+    if((op != OpType::ADD && op != OpType::SUB) || !loop->Contains(update->GetParentBB()) ||
+       GetElementBits(update->GetResultType()) < variable.bits) {
+        return std::nullopt;
+    }
+    auto &inputs = update->GetInputs();
+    bool isFirst = inputs[0].GetValue() == phi;
+    auto *step = isFirst ? inputs[1].GetValue() : inputs[0].GetValue();
+    if((!isFirst && (op == OpType::SUB || inputs[1].GetValue() != phi)) || !IsInvariant(loop, step)) {
+        return std::nullopt;
+    }
+
+    if(auto *constant = step->As<ConstantInstr>()) {
+        variable.step = GetConstantValue(constant);
+        if(op == OpType::SUB) {
+            variable.step = 0 - variable.step;
+        }
+    } else if(op == OpType::ADD) {
+        variable.stepValue = step;
+    } else {
+        return std::nullopt;
+    }
+    return variable;
+}
+
+std::optional<InductionVariable> InductionAnalysis::GetDerived(Loop* loop, Instruction* instr) const {
+    auto op = instr->GetOpType();
+    auto type = instr->GetResultType();
+    if((op != OpType::ADD && op != OpType::SUB && op != OpType::MUL) || !IsIntegerType(type)) {
+        return std::nullopt;
+    }
+
+    auto &inputs = instr->GetInputs();
+    auto *lhs = GetInductionVariable(inputs[0].GetValue());
+    auto *rhs = GetInductionVariable(inputs[1].GetValue());
+    lhs = lhs != nullptr && lhs->loop == loop ? lhs : nullptr;
+    rhs = rhs != nullptr && rhs->loop == loop ? rhs : nullptr;
+    if((lhs == nullptr) == (rhs == nullptr) || (rhs != nullptr && op == OpType::SUB)) {
+        return std::nullopt;
+    }
+    auto *source = lhs != nullptr ? lhs : rhs;
+    auto *other = lhs != nullptr ? inputs[1].GetValue() : inputs[0].GetValue();
+    // Narrowing keeps the value affine modulo the narrower type, widening does not.
+    if(!IsInvariant(loop, other) || GetElementBits(type) > source->bits) {
+        return std::nullopt;
+    }
+
+    InductionVariable variable;
+    if(!source->IsBasic()) {
+        variable = *source;
+    } else {
+        variable.basic = source->value;
+    }
+    variable.kind = InductionVariable::Kind::DERIVED;
+    variable.value = instr;
+    variable.loop = loop;
+    variable.bits = GetElementBits(type);
+
+    auto *constant = other->As<ConstantInstr>();
+    uint64_t value = constant != nullptr ? GetConstantValue(constant) : 0;
+    switch(op) {
+        case OpType::ADD:
+            if(constant != nullptr) {
+                variable.constOffset += value;
+            } else if(variable.offset == nullptr) {
+                variable.offset = other;
+            } else {
+                return std::nullopt;
+            }
+            break;
+        case OpType::SUB:
+            if(constant == nullptr) {
+                return std::nullopt;
+            }
+            variable.constOffset -= value;
+            break;
+        default:
+            if(variable.offset != nullptr) {
+                return std::nullopt;
+            }
+            if(constant != nullptr) {
+                variable.scale *= value;
+                variable.constOffset *= value;
+            } else if(variable.scaleValue == nullptr && variable.constOffset == 0) {
+                variable.scaleValue = other;
+            } else {
+                return std::nullopt;
+            }
+            break;
+    }
+    return variable;
+}
+
+std::optional<uint64_t> InductionAnalysis::ComputeTripCount(Loop* loop) const {
+    auto *header = loop->GetHeader();
+    auto *branch = header->GetLastInstr() == nullptr ? nullptr : header->GetLastInstr()->As<CjmpInstr>();
+    if(branch == nullptr || (branch->GetOpType() != OpType::JA && branch->GetOpType() != OpType::JAE) ||
+       loop->Contains(branch->GetTrueBranchBB()) || !loop->Contains(branch->GetFalseBranchBB())) {
+        return std::nullopt;
+    }
+    auto *cmp = branch->GetInputs()[0].GetValue();
+    if(cmp->GetOpType() != OpType::CMP) {
+        return std::nullopt;
+    }
+
+    // Derived variables carry no init, so only a basic one can count the loop.
+    auto *iv = GetInductionVariable(cmp->GetInputs()[0].GetValue());
+    if(iv == nullptr || !iv->IsBasic() || iv->init == nullptr) {
+        return std::nullopt;
+    }
+    auto *init = iv->init->As<ConstantInstr>();
+    auto *bound = cmp->GetInputs()[1].GetValue()->As<ConstantInstr>();
+    if(iv->loop != loop || iv->stepValue != nullptr || iv->step == 0 || init == nullptr || bound == nullptr ||
+       !IsUnsignedType(iv->value->GetResultType()) || !IsUnsignedType(bound->GetResultType())) {
+        return std::nullopt;
+    }
+
+    // The loop is counted when iv reaches the exit before wrapping around.
+    auto mask = GetTypeMask(iv->value->GetResultType());
+    uint64_t start = GetConstantValue(init) & mask;
+    uint64_t limit = GetConstantValue(bound);
+    uint64_t step = iv->step & mask;
+    bool isStrict = branch->GetOpType() == OpType::JA;
+    if(isStrict ? start > limit : start >= limit) {
+        return 0;
+    }
+
+    uint64_t distance = limit - start;
+    if(isStrict && distance / step == ~0ULL) {
+        return std::nullopt;
+    }
+    uint64_t trips = distance / step + (isStrict || distance % step != 0 ? 1 : 0);
+    if(trips > (mask - start) / step) {
+        return std::nullopt;
+    }
+    return trips;
+}
@@ -0,0 +1,87 @@
+#ifndef IR_INDUCTION_ANALYSIS_HPP
+#define IR_INDUCTION_ANALYSIS_HPP
+
+#include "Graph/graph.hpp"
+#include "LoopAnalyzer/loopanalyzer.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+// An affine function of the iteration number. A basic induction variable is a
+// header phi that starts at `init` and grows by `step` (`stepValue` when it is
+// not a constant) on every back edge. A derived one is computed in the loop as
+//     basic * scale * scaleValue + offset + constOffset
+// with everything but `basic` loop invariant; missing values count as one for
+// `scaleValue` and zero for `offset`. Arithmetic wraps in the narrowest type
+// on the way from the basic variable, which is recorded in `bits`.
+struct InductionVariable {
+    enum class Kind {
+        BASIC,
+        DERIVED,
+    };
+
+    Kind kind = Kind::BASIC;
+    Instruction* value = nullptr;
+    Loop* loop = nullptr;
+    uint32_t bits = 64;
+
+    Instruction* basic = nullptr;
+    Instruction* init = nullptr;
+    uint64_t step = 0;
+    Instruction* stepValue = nullptr;
+
+    uint64_t scale = 1;
+    Instruction* scaleValue = nullptr;
+    Instruction* offset = nullptr;
+    uint64_t constOffset = 0;
+
+    bool IsBasic() const {
+        return kind == Kind::BASIC;
+    }
+    // Whether computing the value takes a multiplication every iteration.
+    bool IsScaled() const {
+        return scale != 1 || scaleValue != nullptr;
+    }
+};
+
+// Finds the induction variables of every loop with a single back edge and a
+// preheader, and the trip counts of counted loops whose header leaves the loop
+// once `iv ja/jae bound` holds for a basic variable and constants.
+class InductionAnalysis final {
+public:
+    InductionAnalysis(Graph* graph): graph_(graph), loopAnalyzer_(graph) {}
+
+    void Analyze();
+
+    const LoopAnalyzer& GetLoopAnalyzer() const;
+    // nullptr unless `instr` is an induction variable.
+    const InductionVariable* GetInductionVariable(Instruction* instr) const;
+    // Induction variables of the loop, each after the ones it is derived from.
+    const std::vector<InductionVariable*>& GetInductionVariables(Loop* loop) const;
+    // Number of times the loop body runs, if known at compile time.
+    std::optional<uint64_t> GetTripCount(Loop* loop) const;
+
+    static BasicBlock* GetPreheader(Loop* loop);
+    // Value of a constant as the interpreter sees it, sign-extended for signed types.
+    static uint64_t GetConstantValue(ConstantInstr* constant);
+
+private:
+    void AnalyzeLoop(Loop* loop, const std::vector<BasicBlock*> &rpo);
+    bool IsInvariant(Loop* loop, Instruction* value) const;
+    std::optional<InductionVariable> GetBasic(Loop* loop, BasicBlock* preheader, Instruction* phi) const;
+    std::optional<InductionVariable> GetDerived(Loop* loop, Instruction* instr) const;
+    std::optional<uint64_t> ComputeTripCount(Loop* loop) const;
+
+private:
+    Graph* graph_ = nullptr;
+    LoopAnalyzer loopAnalyzer_;
+
+    std::vector<std::unique_ptr<InductionVariable>> variables_;
+    std::unordered_map<Instruction*, InductionVariable*> byValue_;
+    std::unordered_map<Loop*, std::vector<InductionVariable*>> byLoop_;
+    std::unordered_map<Loop*, std::optional<uint64_t>> tripCounts_;
+};
+
+#endif  // IR_INDUCTION_ANALYSIS_HPP
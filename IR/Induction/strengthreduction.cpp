@@ -0,0 +1,134 @@
+#include "Induction/strengthreduction.hpp"
+
+#include <unordered_set>
+
+size_t StrengthReduction::Run() {
+    InductionAnalysis analysis(graph_);
+    analysis.Analyze();
+    IrBuilder builder(graph_);
+
+    size_t reduced = 0;
+    for(auto &loop: analysis.GetLoopAnalyzer().GetLoops()) {
+        auto &variables = analysis.GetInductionVariables(loop.get());
+        if(variables.empty()) {
+            continue;
+        }
+        for(auto *variable: variables) {
+            if(IsWorthReducing(analysis, *variable)) {
+                Reduce(builder, analysis, *variable);
+                ++reduced;
+            }
+        }
+        RemoveDeadVariables(variables);
+    }
+    return reduced;
+}
+
+bool StrengthReduction::IsWorthReducing(const InductionAnalysis &analysis, const InductionVariable &variable) const {
+    if(variable.IsBasic() || !variable.IsScaled() || !variable.value->HasUses()) {
+        return false;
+    }
+
+    // Variables only feeding other scaled ones go away with them.
+    bool hasOtherUsers = false;
+    bool isInHeader = variable.value->GetParentBB() == variable.loop->GetHeader();
+    for(auto &use: variable.value->GetUses()) {
+        auto *user = use.GetUser();
+        if(!isInHeader && !variable.loop->Contains(user->GetParentBB())) {
+            return false;
+        }
+        auto *userVariable = analysis.GetInductionVariable(user);
+        if(userVariable == nullptr || userVariable->loop != variable.loop || !userVariable->IsScaled()) {
+            hasOtherUsers = true;
+        }
+    }
+    return hasOtherUsers;
+}
+
+void StrengthReduction::Reduce(IrBuilder &builder, const InductionAnalysis &analysis,
+                               const InductionVariable &variable) {
+    auto *loop = variable.loop;
+    auto *header = loop->GetHeader();
+    auto *preheader = InductionAnalysis::GetPreheader(loop);
+    auto *basic = analysis.GetInductionVariable(variable.basic);
+    auto type = variable.value->GetResultType();
+
+    // value = basic * scale + offset, so it starts at init * scale + offset and
+    // grows by step * scale.
+    builder.SetInsertPoint(preheader->GetLastInstr());
+    auto scale = [&builder, &variable, type](Instruction* value) {
+        if(variable.scale != 1) {
+            value = builder.CreateMul(type, value, builder.CreateConstant(variable.scale, type));
+        }
+        if(variable.scaleValue != nullptr) {
+            value = builder.CreateMul(type, value, variable.scaleValue);
+        }
+        return value;
+    };
+    auto *init = scale(basic->init);
+    if(variable.offset != nullptr) {
+        init = builder.CreateAdd(type, init, variable.offset);
+    }
+    if(variable.constOffset != 0) {
+        init = builder.CreateAdd(type, init, builder.CreateConstant(variable.constOffset, type));
+    }
+
+    Instruction* step = nullptr;
+    if(basic->stepValue != nullptr) {
+        step = scale(basic->stepValue);
+    } else {
+        step = builder.CreateConstant(basic->step * variable.scale, type);
+        if(variable.scaleValue != nullptr) {
+            step = builder.CreateMul(type, step, variable.scaleValue);
+        }
+    }
+
+    auto *firstNonPhi = header->GetFirstInstr();
+    while(firstNonPhi->IsPhi()) {
+        firstNonPhi = firstNonPhi->GetNext();
+    }
+    builder.SetInsertPoint(firstNonPhi);
+    auto *phi = builder.CreatePhi(type);
+
+    auto *latch = loop->GetBackEdges()[0];
+    builder.SetInsertPoint(latch->GetLastInstr());
+    auto *next = builder.CreateAdd(type, phi, step);
+
+    for(auto *pred: header->GetPredecessors()) {
+        phi->AddInput(pred == latch ? next : init);
+    }
+    variable.value->ReplaceAllUsesWith(phi);
+}
+
+void StrengthReduction::RemoveDeadVariables(const std::vector<InductionVariable*> &variables) {
+    // Shrinks the set to the variables that are only used inside of it.
+    std::unordered_set<Instruction*> dead;
+    for(auto *variable: variables) {
+        dead.insert(variable->value);
+    }
+    for(bool changed = true; changed;) {
+        changed = false;
+        for(auto *variable: variables) {
+            auto *value = variable->value;
+            if(dead.count(value) == 0) {
+                continue;
+            }
+            for(auto &use: value->GetUses()) {
+                if(dead.count(use.GetUser()) == 0) {
+                    dead.erase(value);
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    for(auto *value: dead) {
+        value->ClearInputs();
+    }
+    for(auto *variable: variables) {
+        if(dead.count(variable->value) != 0) {
+            graph_->RemoveInstruction(variable->value);
+        }
+    }
+}
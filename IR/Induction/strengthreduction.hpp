@@ -0,0 +1,31 @@
+#ifndef IR_STRENGTH_REDUCTION_HPP
+#define IR_STRENGTH_REDUCTION_HPP
+
+#include "Induction/inductionanalysis.hpp"
+#include "irbuilder.hpp"
+
+#include <vector>
+
+// Replaces derived induction variables that take a multiplication every
+// iteration with additive recurrences: a new header phi starts at the value of
+// the first iteration and adds the scaled basic step on the back edge. A value
+// computed in the body is only replaced when the loop is its only user, since
+// after the exit the recurrence is one step ahead of it. Induction variables
+// that are left feeding nothing but each other are removed afterwards.
+class StrengthReduction final {
+public:
+    StrengthReduction(Graph* graph): graph_(graph) {}
+
+    // Returns the number of rewritten induction variables.
+    size_t Run();
+
+private:
+    bool IsWorthReducing(const InductionAnalysis &analysis, const InductionVariable &variable) const;
+    void Reduce(IrBuilder &builder, const InductionAnalysis &analysis, const InductionVariable &variable);
+    void RemoveDeadVariables(const std::vector<InductionVariable*> &variables);
+
+private:
+    Graph* graph_ = nullptr;
+};
+
+#endif  // IR_STRENGTH_REDUCTION_HPP
@@ -1,21 +1,37 @@
-DATA_DEF(UNDEFINED, "daaaaamn")
+// DATA_DEF(name, dump_name, element, bits, lanes)
+// Vector types hold `lanes` values of the `element` scalar type, `bits` wide
+// each; scalars are their own element with one lane.
 
-DATA_DEF(VOID, "void")
+DATA_DEF(UNDEFINED, "daaaaamn", UNDEFINED, 0, 0)
 
-DATA_DEF(I8, "i8")
+DATA_DEF(VOID, "void", VOID, 0, 0)
 
-DATA_DEF(U8, "u8")
+DATA_DEF(I8, "i8", I8, 8, 1)
 
-DATA_DEF(I16, "i16")
+DATA_DEF(U8, "u8", U8, 8, 1)
 
-DATA_DEF(U16, "u16")
+DATA_DEF(I16, "i16", I16, 16, 1)
 
-DATA_DEF(I32, "i32")
+DATA_DEF(U16, "u16", U16, 16, 1)
 
-DATA_DEF(U32, "u32")
+DATA_DEF(I32, "i32", I32, 32, 1)
 
-DATA_DEF(I64, "i64")
+DATA_DEF(U32, "u32", U32, 32, 1)
 
-DATA_DEF(U64, "u64")
+DATA_DEF(I64, "i64", I64, 64, 1)
 
-DATA_DEF(REF, "ref")
\ No newline at end of file
+DATA_DEF(U64, "u64", U64, 64, 1)
+
+DATA_DEF(REF, "ref", REF, 64, 1)
+
+DATA_DEF(V8I16, "v8i16", I16, 16, 8)
+
+DATA_DEF(V4I32, "v4i32", I32, 32, 4)
+
+DATA_DEF(V2I64, "v2i64", I64, 64, 2)
+
+DATA_DEF(V16I16, "v16i16", I16, 16, 16)
+
+DATA_DEF(V8I32, "v8i32", I32, 32, 8)
+
+DATA_DEF(V4I64, "v4i64", I64, 64, 4)
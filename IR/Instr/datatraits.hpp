@@ -0,0 +1,70 @@
+#ifndef IR_DATATRAITS_HPP
+#define IR_DATATRAITS_HPP
+
+#include "Instr/enums.hpp"
+
+#include <array>
+#include <cstdint>
+
+inline constexpr size_t DATA_TYPES_COUNT = 0
+    #define DATA_DEF(name, dump_name, ...) + 1
+
+    #include "datadef.hpp"
+    #undef DATA_DEF
+    ;
+
+struct DataTraits {
+    DataType element = DataType::UNDEFINED;
+    uint32_t bits = 0;
+    uint32_t lanes = 0;
+};
+
+inline constexpr std::array<DataTraits, DATA_TYPES_COUNT> DATA_TRAITS = {{
+    #define DATA_DEF(name, dump_name, element, bits, lanes) \
+        DataTraits{DataType::element, bits, lanes},
+
+    #include "datadef.hpp"
+    #undef DATA_DEF
+}};
+
+constexpr const DataTraits& GetDataTraits(DataType type) {
+    return DATA_TRAITS[static_cast<size_t>(type)];
+}
+
+constexpr bool IsVectorType(DataType type) {
+    return GetDataTraits(type).lanes > 1;
+}
+
+constexpr uint32_t GetLanesCount(DataType type) {
+    return GetDataTraits(type).lanes;
+}
+
+constexpr DataType GetElementType(DataType type) {
+    return GetDataTraits(type).element;
+}
+
+// Width of the type, or of one lane for vectors.
+constexpr uint32_t GetElementBits(DataType type) {
+    return GetDataTraits(type).bits;
+}
+
+// Bytes a load or store of the type accesses; zero for types memory does not
+// hold.
+constexpr uint32_t GetAccessSize(DataType type) {
+    return IsVectorType(type) ? 0 : GetElementBits(type) / 8;
+}
+
+// Vector of `lanes` lanes as wide as the integer type `element`, UNDEFINED
+// when there is none. Signedness does not matter for lane-wise arithmetic, so
+// vectors only come with signed elements.
+constexpr DataType GetVectorType(DataType element, uint32_t lanes) {
+    for(size_t idx = 0; idx < DATA_TYPES_COUNT; ++idx) {
+        auto &traits = DATA_TRAITS[idx];
+        if(traits.lanes == lanes && traits.bits == GetElementBits(element) && lanes > 1) {
+            return static_cast<DataType>(idx);
+        }
+    }
+    return DataType::UNDEFINED;
+}
+
+#endif  // IR_DATATRAITS_HPP
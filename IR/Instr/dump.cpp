@@ -5,27 +5,31 @@
 std::string OpToString(OpType optype) {
     switch(optype)
     {
-        #define OPR_DEF(name, dump_name) \
+        #define OPR_DEF(name, dump_name, ...) \
         case OpType::name:                \
             return dump_name;              \
             break;                                 
 
         #include "oprdef.hpp"
-        #undef REG_DEF
+        #undef OPR_DEF
     }
+
+    return "";
 }
 
 std::string DataTypeToStr(DataType datatype) {
     switch(datatype)
     {
-        #define DATA_DEF(name, dump_name) \
+        #define DATA_DEF(name, dump_name, ...) \
         case DataType::name:               \
             return dump_name;               \
             break;                                 
 
         #include "datadef.hpp"
-        #undef REG_DEF
+        #undef DATA_DEF
     }
+
+    return "";
 }
 
 void Instruction::Dump(std::stringstream &ss) const
@@ -57,7 +61,7 @@ void PhiInstr::Dump(std::stringstream &ss) const
     auto &inputs = GetInputs();
 
     for (size_t idx = 0; idx < inputs.size(); ++idx) {
-        ss << "v" << inputs[idx].input->GetId() << ":BB_" << inputs[idx].input->GetParentBB()->GetId();
+        ss << "v" << inputs[idx].GetValue()->GetId() << ":BB_" << inputs[idx].GetValue()->GetParentBB()->GetId();
         if (idx != inputs.size() - 1) {
             ss << ", ";
         }
@@ -71,7 +75,7 @@ void ArithmeticInstr::Dump(std::stringstream &ss) const
     auto &inputs = GetInputs();
 
     for (size_t idx = 0; idx < inputs.size(); ++idx) {
-        ss << "v" << inputs[idx].input->GetId();
+        ss << "v" << inputs[idx].GetValue()->GetId();
         if (idx != inputs.size() - 1) {
             ss << ", ";
         }
@@ -89,14 +93,95 @@ void CjmpInstr::Dump(std::stringstream &ss) const
     Instruction::Dump(ss);
     auto &inputs = GetInputs();
     for (auto &i : inputs) {
-        ss << "v" << i.input->GetId() << ", ";
+        ss << "v" << i.GetValue()->GetId() << ", ";
     }
 
     ss << "BB_" << GetTrueBranchBB()->GetId() << ", BB_" << GetFalseBranchBB()->GetId();
 }
 
+void GuardInstr::Dump(std::stringstream &ss) const
+{
+    Instruction::Dump(ss);
+    auto &inputs = GetInputs();
+
+    ss << "v" << inputs[0].GetValue()->GetId() << ", " << OpToString(condition_)
+       << (expectTaken_ ? " taken" : " not taken")
+       << ", resume BB_" << resumeBlock_->GetId() << " from BB_" << resumePrevBlock_->GetId() << " [";
+    for (size_t idx = 0; idx < stateValues_.size(); ++idx) {
+        ss << "v" << stateValues_[idx]->GetId() << ":v" << inputs[idx + 1].GetValue()->GetId();
+        if (idx != stateValues_.size() - 1) {
+            ss << ", ";
+        }
+    }
+    ss << "]";
+}
+
 void RetInstr::Dump(std::stringstream &ss) const
 {
     Instruction::Dump(ss);
-    ss << "v" << retValue_->GetId();
-}
\ No newline at end of file
+    ss << "v" << GetInputs()[0].GetValue()->GetId();
+}
+
+void SplatInstr::Dump(std::stringstream &ss) const
+{
+    Instruction::Dump(ss);
+    ss << "v" << GetInputs()[0].GetValue()->GetId();
+}
+
+void ReduceInstr::Dump(std::stringstream &ss) const
+{
+    Instruction::Dump(ss);
+    ss << OpToString(op_) << " v" << GetInputs()[0].GetValue()->GetId();
+}
+
+void BoundsCheckInstr::Dump(std::stringstream &ss) const
+{
+    Instruction::Dump(ss);
+    ss << "v" << GetInputs()[0].GetValue()->GetId() << ", v" << GetInputs()[1].GetValue()->GetId();
+}
+
+void OverflowCheckInstr::Dump(std::stringstream &ss) const
+{
+    Instruction::Dump(ss);
+    ss << DataTypeToStr(checkedType_) << " " << OpToString(op_) << " v" << GetInputs()[0].GetValue()->GetId()
+       << ", v" << GetInputs()[1].GetValue()->GetId();
+}
+
+void NewObjectInstr::Dump(std::stringstream &ss) const
+{
+    Instruction::Dump(ss);
+    ss << fieldsCount_;
+}
+
+void LoadFieldInstr::Dump(std::stringstream &ss) const
+{
+    Instruction::Dump(ss);
+    ss << "v" << GetInputs()[0].GetValue()->GetId() << "." << field_;
+}
+
+void StoreFieldInstr::Dump(std::stringstream &ss) const
+{
+    Instruction::Dump(ss);
+    ss << "v" << GetInputs()[0].GetValue()->GetId() << "." << field_ << ", v" << GetInputs()[1].GetValue()->GetId();
+}
+
+void LoadInstr::Dump(std::stringstream &ss) const
+{
+    Instruction::Dump(ss);
+    ss << "[v" << GetInputs()[0].GetValue()->GetId() << " + " << offset_ << "]";
+}
+
+void StoreInstr::Dump(std::stringstream &ss) const
+{
+    Instruction::Dump(ss);
+    ss << "[v" << GetInputs()[0].GetValue()->GetId() << " + " << offset_ << "], v"
+       << GetInputs()[1].GetValue()->GetId();
+}
+
+void SelectInstr::Dump(std::stringstream &ss) const
+{
+    Instruction::Dump(ss);
+    auto &inputs = GetInputs();
+    ss << "v" << inputs[0].GetValue()->GetId() << ", " << OpToString(condition_) << " ? v"
+       << inputs[1].GetValue()->GetId() << " : v" << inputs[2].GetValue()->GetId();
+}
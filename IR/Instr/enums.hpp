@@ -4,14 +4,21 @@
 #include <cstddef>
 
 enum class OpType: size_t{
-    #define OPR_DEF(name, dump_name) name,
+    #define OPR_DEF(name, dump_name, ...) name,
 
     #include "oprdef.hpp"
     #undef OPR_DEF
 };
 
+inline constexpr size_t OPCODES_COUNT = 0
+    #define OPR_DEF(name, dump_name, ...) + 1
+
+    #include "oprdef.hpp"
+    #undef OPR_DEF
+    ;
+
 enum class DataType {
-    #define DATA_DEF(name, dump_name) name,
+    #define DATA_DEF(name, dump_name, ...) name,
 
     #include "datadef.hpp"
     #undef DATA_DEF
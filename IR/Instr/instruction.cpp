@@ -1,4 +1,5 @@
 #include "Instr/instruction.hpp"
+#include "BasicBlock/basicblock.hpp"
 
 void Instruction::SetParentBB(BasicBlock* bb) {
     parentBB_ = bb;
@@ -24,34 +25,171 @@ Instruction* Instruction::GetPrev() const {
     return prev_;
 }
 
+Use::Use(Instruction* user, Instruction* value): user_(user), value_(value) {
+    Link();
+}
+
+Use::Use(Use &&other) noexcept: user_(other.user_), value_(other.value_) {
+    TakeLinks(other);
+}
+
+Use& Use::operator=(Use &&other) noexcept {
+    if(this != &other) {
+        Unlink();
+        user_ = other.user_;
+        value_ = other.value_;
+        TakeLinks(other);
+    }
+    return *this;
+}
+
+Use::~Use() {
+    Unlink();
+}
+
+Instruction* Use::GetUser() const {
+    return user_;
+}
+
+Instruction* Use::GetValue() const {
+    return value_;
+}
+
+size_t Use::GetIndex() const {
+    return static_cast<size_t>(this - user_->inputs_.data());
+}
+
+Use* Use::GetNextUse() const {
+    return next_;
+}
+
+void Use::Set(Instruction* value) {
+    if(value == value_) {
+        return;
+    }
+    Unlink();
+    value_ = value;
+    Link();
+}
+
+void Use::Link() {
+    if(value_ == nullptr) {
+        return;
+    }
+    prev_ = nullptr;
+    next_ = value_->firstUse_;
+    if(next_ != nullptr) {
+        next_->prev_ = this;
+    }
+    value_->firstUse_ = this;
+}
+
+void Use::Unlink() {
+    if(value_ == nullptr) {
+        return;
+    }
+    if(prev_ == nullptr) {
+        value_->firstUse_ = next_;
+    } else {
+        prev_->next_ = next_;
+    }
+    if(next_ != nullptr) {
+        next_->prev_ = prev_;
+    }
+    prev_ = nullptr;
+    next_ = nullptr;
+}
+
+void Use::TakeLinks(Use &other) {
+    prev_ = other.prev_;
+    next_ = other.next_;
+    if(value_ != nullptr) {
+        if(prev_ == nullptr) {
+            value_->firstUse_ = this;
+        } else {
+            prev_->next_ = this;
+        }
+        if(next_ != nullptr) {
+            next_->prev_ = this;
+        }
+    }
+    other.value_ = nullptr;
+    other.prev_ = nullptr;
+    other.next_ = nullptr;
+}
+
+Instruction::~Instruction() {
+    // Remaining uses forget the value instead of pointing to freed memory.
+    for(auto *use = firstUse_; use != nullptr;) {
+        auto *next = use->next_;
+        use->value_ = nullptr;
+        use->prev_ = nullptr;
+        use->next_ = nullptr;
+        use = next;
+    }
+    firstUse_ = nullptr;
+}
+
 void Instruction::AddInput(Instruction* input) {
-    inputs_.push_back(Input {input});
+    inputs_.emplace_back(this, input);
+}
+
+void Instruction::SetInput(size_t idx, Instruction* input) {
+    inputs_[idx].Set(input);
 }
 
-void Instruction::AddUser(Instruction* user) {
-    users_.push_back(User {user});
+void Instruction::RemoveInput(size_t idx) {
+    inputs_.erase(inputs_.begin() + idx);
 }
 
-void Instruction::SetInputs(std::vector<Input> inputs) {
-    inputs_ = std::move(inputs);
+void Instruction::ClearInputs() {
+    inputs_.clear();
 }
 
-const std::vector<Instruction::Input>& Instruction::GetInputs() const {
+const std::vector<Use>& Instruction::GetInputs() const {
     return inputs_;
 }
 
+UsesRange Instruction::GetUses() const {
+    return UsesRange {firstUse_};
+}
+
+bool Instruction::HasUses() const {
+    return firstUse_ != nullptr;
+}
+
+size_t Instruction::GetUsesCount() const {
+    size_t count = 0;
+    for(auto *use = firstUse_; use != nullptr; use = use->next_) {
+        ++count;
+    }
+    return count;
+}
+
+void Instruction::ReplaceAllUsesWith(Instruction* value) {
+    while(firstUse_ != nullptr && value != this) {
+        firstUse_->Set(value);
+    }
+}
+
 bool Instruction::IsPhi() const {
     return optype_ == OpType::PHI;
 }
 
 bool Instruction::IsJmp() const {
-    return optype_ == OpType::JMP;
+    return Is<JmpInstr>();
 }
 
 bool Instruction::IsBranch() const {
-    return (optype_ == OpType::JA)  ||
-           (optype_ == OpType::JAE) ||
-           (optype_ == OpType::JE);
+    return Is<CjmpInstr>();
+}
+
+OpType Instruction::GetOpType() const {
+    return optype_;
+}
+
+DataType Instruction::GetResultType() const {
+    return resultType_;
 }
 
 void Instruction::SetResultType(DataType type) {
@@ -90,10 +228,30 @@ uint64_t ConstantInstr::GetAsUnsignedInt() const {
 }
 
 
+BasicBlock* PhiInstr::GetPhiInputBB(size_t idx) {
+    return GetParentBB()->GetPredecessors().at(idx);
+}
+
+Instruction* PhiInstr::GetPhiInput(BasicBlock* bb) {
+    auto &preds = GetParentBB()->GetPredecessors();
+    auto &inputs = GetInputs();
+    for (size_t idx = 0; idx < preds.size() && idx < inputs.size(); ++idx) {
+        if (preds[idx] == bb) {
+            return inputs[idx].GetValue();
+        }
+    }
+    return nullptr;
+}
+
+
 BasicBlock* JmpInstr::GetBBToJmp() const {
     return bbToJmp_;
 }
 
+void JmpInstr::SetBBToJmp(BasicBlock* block) {
+    bbToJmp_ = block;
+}
+
 
 BasicBlock* CjmpInstr::GetTrueBranchBB() const {
     return ifTrueBB_;
@@ -101,4 +259,74 @@ BasicBlock* CjmpInstr::GetTrueBranchBB() const {
 
 BasicBlock* CjmpInstr::GetFalseBranchBB() const {
     return ifFalseBB_;
-}
\ No newline at end of file
+}
+
+void CjmpInstr::ReplaceTarget(BasicBlock* from, BasicBlock* to) {
+    if(ifTrueBB_ == from) {
+        ifTrueBB_ = to;
+    } else if(ifFalseBB_ == from) {
+        ifFalseBB_ = to;
+    }
+}
+
+
+void GuardInstr::AddStateValue(Instruction* baselineValue, Instruction* value) {
+    stateValues_.push_back(baselineValue);
+    AddInput(value);
+}
+
+OpType GuardInstr::GetCondition() const {
+    return condition_;
+}
+
+bool GuardInstr::IsTakenExpected() const {
+    return expectTaken_;
+}
+
+BasicBlock* GuardInstr::GetResumeBlock() const {
+    return resumeBlock_;
+}
+
+BasicBlock* GuardInstr::GetResumePrevBlock() const {
+    return resumePrevBlock_;
+}
+
+const std::vector<Instruction*>& GuardInstr::GetStateValues() const {
+    return stateValues_;
+}
+
+OpType ReduceInstr::GetReduceOp() const {
+    return op_;
+}
+
+OpType OverflowCheckInstr::GetCheckedOp() const {
+    return op_;
+}
+
+DataType OverflowCheckInstr::GetCheckedType() const {
+    return checkedType_;
+}
+
+uint32_t NewObjectInstr::GetFieldsCount() const {
+    return fieldsCount_;
+}
+
+uint32_t LoadFieldInstr::GetField() const {
+    return field_;
+}
+
+uint32_t StoreFieldInstr::GetField() const {
+    return field_;
+}
+
+int64_t LoadInstr::GetOffset() const {
+    return offset_;
+}
+
+int64_t StoreInstr::GetOffset() const {
+    return offset_;
+}
+
+OpType SelectInstr::GetCondition() const {
+    return condition_;
+}
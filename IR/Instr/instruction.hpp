@@ -1,27 +1,92 @@
 #ifndef IR_INSTRUCTION_HPP
 #define IR_INSTRUCTION_HPP
 
+#include "Instr/datatraits.hpp"
 #include "Instr/enums.hpp"
+#include "Instr/optraits.hpp"
 
-#include <vector>
 #include <sstream>
+#include <type_traits>
+#include <vector>
 
 class Instruction;
 class BasicBlock;
 
+// Operand slot of an instruction. Every slot is linked into the use list of
+// the value it refers to, so users and inputs always agree and retargeting a
+// slot is O(1). Slots live in the user's input vector; moving one relinks its
+// neighbours.
+class Use final {
+public:
+    Use(Instruction* user, Instruction* value);
+    Use(Use &&other) noexcept;
+    Use& operator=(Use &&other) noexcept;
+    ~Use();
+
+    Use(const Use&) = delete;
+    Use& operator=(const Use&) = delete;
+
+    Instruction* GetUser() const;
+    Instruction* GetValue() const;
+    // Position of the slot among the user's inputs.
+    size_t GetIndex() const;
+    Use* GetNextUse() const;
+
+    void Set(Instruction* value);
+
+private:
+    friend class Instruction;
+
+    void Link();
+    void Unlink();
+    void TakeLinks(Use &other);
+
+private:
+    Instruction* user_ = nullptr;
+    Instruction* value_ = nullptr;
+    Use* prev_ = nullptr;
+    Use* next_ = nullptr;
+};
+
+class UseIterator final {
+public:
+    explicit UseIterator(Use* use): use_(use) {}
+
+    Use& operator*() const {
+        return *use_;
+    }
+    UseIterator& operator++() {
+        use_ = use_->GetNextUse();
+        return *this;
+    }
+    bool operator!=(const UseIterator &other) const {
+        return use_ != other.use_;
+    }
+
+private:
+    Use* use_ = nullptr;
+};
+
+struct UsesRange {
+    Use* first = nullptr;
+
+    UseIterator begin() const {
+        return UseIterator(first);
+    }
+    UseIterator end() const {
+        return UseIterator(nullptr);
+    }
+};
+
 class Instruction {
 public:
     Instruction(OpType optype, DataType resultType = DataType::UNDEFINED):
         optype_(optype), resultType_(resultType) {}
 
-    virtual ~Instruction() = default;
+    virtual ~Instruction();
 
-    struct Input {
-        Instruction* input = nullptr;
-    };
-    struct User {
-        Instruction* user = nullptr;
-    };
+    Instruction(const Instruction&) = delete;
+    Instruction& operator=(const Instruction&) = delete;
 
     void SetParentBB(BasicBlock* bb);
     BasicBlock* GetParentBB() const;
@@ -33,15 +98,32 @@ public:
     Instruction* GetPrev() const;
 
     void AddInput(Instruction* input);
-    void AddUser(Instruction* user);
+    void SetInput(size_t idx, Instruction* input);
+    void RemoveInput(size_t idx);
+    void ClearInputs();
+    const std::vector<Use>& GetInputs() const;
 
-    void SetInputs(std::vector<Input> inputs);
-    const std::vector<Input>& GetInputs() const;
+    UsesRange GetUses() const;
+    bool HasUses() const;
+    size_t GetUsesCount() const;
+    // Retargets every use of this instruction to `value`.
+    void ReplaceAllUsesWith(Instruction* value);
 
     bool IsPhi() const;
     bool IsJmp() const;
     bool IsBranch() const;
 
+    // Checked casts driven by the opcode: As<T>() is nullptr unless the
+    // instruction's class is T or derives from it.
+    template <typename T>
+    bool Is() const;
+    template <typename T>
+    T* As();
+    template <typename T>
+    const T* As() const;
+
+    OpType GetOpType() const;
+    DataType GetResultType() const;
     void SetResultType(DataType type);
     void SetId(size_t id);
     size_t GetId() const;
@@ -49,6 +131,8 @@ public:
     virtual void Dump(std::stringstream &ss) const;
 
 private:
+    friend class Use;
+
     Instruction* prev_ = nullptr;
     Instruction* next_ = nullptr;
 
@@ -58,8 +142,8 @@ private:
     OpType optype_ = OpType::UNDEFINED;
     DataType resultType_;
 
-    std::vector<Input> inputs_;
-    std::vector<User> users_;
+    std::vector<Use> inputs_;
+    Use* firstUse_ = nullptr;
 };
 
 // ------------------------------------------------------------------------------------------------------
@@ -119,8 +203,6 @@ public:
         Instruction(opcode, resultType) {
         AddInput(input1);
         AddInput(input2);
-        input1->AddUser(this);
-        input2->AddUser(this);
     }
 
     void Dump(std::stringstream &ss) const override;
@@ -144,16 +226,37 @@ public:
         ArithmeticInstr(OpType::MUL, resultType, input1, input2) {}
 };
 
+// Upper half of the double-width product, signed or unsigned as the type.
+class MulHighInstr final: public ArithmeticInstr {
+public:
+    MulHighInstr(DataType resultType, Instruction* input1, Instruction* input2):
+        ArithmeticInstr(OpType::MULH, resultType, input1, input2) {}
+};
+
 class DivInstr final: public ArithmeticInstr {
 public:
     DivInstr(DataType resultType, Instruction* input1, Instruction* input2):
         ArithmeticInstr(OpType::DIV, resultType, input1, input2) {}
 };
 
+class ModInstr final: public ArithmeticInstr {
+public:
+    ModInstr(DataType resultType, Instruction* input1, Instruction* input2):
+        ArithmeticInstr(OpType::MOD, resultType, input1, input2) {}
+};
+
 class AndInstr final: public ArithmeticInstr {
 public:
     AndInstr(DataType resultType, Instruction* input1, Instruction* input2):
-        ArithmeticInstr(OpType::ADD, resultType, input1, input2) {}
+        ArithmeticInstr(OpType::AND, resultType, input1, input2) {}
+};
+
+// Arithmetic shift for signed types, logical for unsigned ones. The amount is
+// below the width of the type.
+class ShrInstr final: public ArithmeticInstr {
+public:
+    ShrInstr(DataType resultType, Instruction* input1, Instruction* input2):
+        ArithmeticInstr(OpType::SHR, resultType, input1, input2) {}
 };
 
 class JmpInstr final: public Instruction {
@@ -161,6 +264,7 @@ public:
     JmpInstr(BasicBlock* bbToJmp): Instruction(OpType::JMP, DataType::VOID), bbToJmp_(bbToJmp) {}
 
     BasicBlock* GetBBToJmp() const;
+    void SetBBToJmp(BasicBlock* block);
 
     void Dump(std::stringstream &ss) const override;
 
@@ -179,11 +283,12 @@ public:
     CjmpInstr(OpType optype, Instruction* input, BasicBlock* ifTrueBB, BasicBlock* ifFalseBB):
         Instruction(optype, DataType::VOID), ifTrueBB_(ifTrueBB), ifFalseBB_(ifFalseBB) {
         AddInput(input);
-        input->AddUser(this);
     }
 
     BasicBlock* GetTrueBranchBB() const;
     BasicBlock* GetFalseBranchBB() const;
+    // Retargets the true branch if it goes to `from`, the false one otherwise.
+    void ReplaceTarget(BasicBlock* from, BasicBlock* to);
 
     void Dump(std::stringstream &ss) const override;
 
@@ -210,19 +315,249 @@ public:
         CjmpInstr(OpType::JE, input, ifTrueBB, ifFalseBB) {}
 };
 
+// Guard on a comparison result: as long as the condition of `condition` jump
+// evaluates to `expectTaken` execution goes on, otherwise the frame is
+// deoptimized. Inputs past the first are the values of the frame state; each of
+// them stands for the baseline graph value at the same index of GetStateValues(),
+// and the interpreter resumes the baseline graph at the start of the resume
+// block as if it was entered from the resume predecessor.
+class GuardInstr final: public Instruction {
+public:
+    GuardInstr(Instruction* input, OpType condition, bool expectTaken,
+               BasicBlock* resumeBlock, BasicBlock* resumePrevBlock):
+        Instruction(OpType::DEOPT, DataType::VOID), condition_(condition), expectTaken_(expectTaken),
+        resumeBlock_(resumeBlock), resumePrevBlock_(resumePrevBlock) {
+        AddInput(input);
+    }
+
+    void AddStateValue(Instruction* baselineValue, Instruction* value);
+
+    OpType GetCondition() const;
+    bool IsTakenExpected() const;
+    BasicBlock* GetResumeBlock() const;
+    BasicBlock* GetResumePrevBlock() const;
+    const std::vector<Instruction*>& GetStateValues() const;
+
+    void Dump(std::stringstream &ss) const override;
+
+private:
+    OpType condition_ = OpType::JE;
+    bool expectTaken_ = false;
+
+    BasicBlock* resumeBlock_ = nullptr;
+    BasicBlock* resumePrevBlock_ = nullptr;
+    std::vector<Instruction*> stateValues_;
+};
+
 class RetInstr final: public Instruction {
 public:
     RetInstr(DataType retType, Instruction* input):
-        Instruction(OpType::RET, retType), retValue_(input) {
+        Instruction(OpType::RET, retType) {
         AddInput(input);
-        input->AddUser(this);
     }
 
+    void Dump(std::stringstream &ss) const override;
+};
+
+// Vector with every lane set to the scalar input.
+class SplatInstr final: public Instruction {
+public:
+    SplatInstr(DataType vectorType, Instruction* input):
+        Instruction(OpType::SPLAT, vectorType) {
+        AddInput(input);
+    }
+
+    void Dump(std::stringstream &ss) const override;
+};
+
+// Vector of lane numbers: 0, 1, ..., lanes - 1.
+class IotaInstr final: public Instruction {
+public:
+    IotaInstr(DataType vectorType): Instruction(OpType::IOTA, vectorType) {}
+};
+
+// Folds the lanes of a vector with `op` (ADD, MUL or AND) into a scalar.
+class ReduceInstr final: public Instruction {
+public:
+    ReduceInstr(OpType op, DataType resultType, Instruction* input):
+        Instruction(OpType::REDUCE, resultType), op_(op) {
+        AddInput(input);
+    }
+
+    OpType GetReduceOp() const;
+
     void Dump(std::stringstream &ss) const override;
 
 private:
-    Instruction* retValue_ = nullptr;
+    OpType op_ = OpType::ADD;
 };
 
+// Traps unless `index` is below `length`, compared as unsigned values.
+class BoundsCheckInstr final: public Instruction {
+public:
+    BoundsCheckInstr(Instruction* index, Instruction* length):
+        Instruction(OpType::BOUNDS_CHECK, DataType::VOID) {
+        AddInput(index);
+        AddInput(length);
+    }
+
+    void Dump(std::stringstream &ss) const override;
+};
+
+// Traps unless `lhs op rhs` (ADD, SUB or MUL) fits the checked type, with both
+// operands taken as values of that type.
+class OverflowCheckInstr final: public Instruction {
+public:
+    OverflowCheckInstr(OpType op, DataType checkedType, Instruction* lhs, Instruction* rhs):
+        Instruction(OpType::OVERFLOW_CHECK, DataType::VOID), op_(op), checkedType_(checkedType) {
+        AddInput(lhs);
+        AddInput(rhs);
+    }
+
+    OpType GetCheckedOp() const;
+    DataType GetCheckedType() const;
+
+    void Dump(std::stringstream &ss) const override;
+
+private:
+    OpType op_ = OpType::ADD;
+    DataType checkedType_ = DataType::I32;
+};
+
+// Allocates an object with `fieldsCount` 64-bit fields, all zero. Objects are
+// never freed explicitly.
+class NewObjectInstr final: public Instruction {
+public:
+    NewObjectInstr(uint32_t fieldsCount):
+        Instruction(OpType::NEW_OBJECT, DataType::REF), fieldsCount_(fieldsCount) {}
+
+    uint32_t GetFieldsCount() const;
+
+    void Dump(std::stringstream &ss) const override;
+
+private:
+    uint32_t fieldsCount_ = 0;
+};
+
+// Reads a field of `object` as a value of the result type. Traps on a null
+// reference or a field the object does not have.
+class LoadFieldInstr final: public Instruction {
+public:
+    LoadFieldInstr(DataType resultType, Instruction* object, uint32_t field):
+        Instruction(OpType::LOAD_FIELD, resultType), field_(field) {
+        AddInput(object);
+    }
+
+    uint32_t GetField() const;
+
+    void Dump(std::stringstream &ss) const override;
+
+private:
+    uint32_t field_ = 0;
+};
+
+// Writes `value` to a field of `object`, trapping like LoadFieldInstr.
+class StoreFieldInstr final: public Instruction {
+public:
+    StoreFieldInstr(Instruction* object, uint32_t field, Instruction* value):
+        Instruction(OpType::STORE_FIELD, DataType::VOID), field_(field) {
+        AddInput(object);
+        AddInput(value);
+    }
+
+    uint32_t GetField() const;
+
+    void Dump(std::stringstream &ss) const override;
+
+private:
+    uint32_t field_ = 0;
+};
+
+// Reads a value of the result type at `offset` bytes into the object `base`
+// refers to. Objects are little-endian byte arrays, 8 bytes per field, so a
+// 64-bit access at offset 8 * n is an access to field n. Traps like
+// LoadFieldInstr when the bytes are not all inside the object.
+class LoadInstr final: public Instruction {
+public:
+    LoadInstr(DataType resultType, Instruction* base, int64_t offset):
+        Instruction(OpType::LOAD, resultType), offset_(offset) {
+        AddInput(base);
+    }
+
+    int64_t GetOffset() const;
+
+    void Dump(std::stringstream &ss) const override;
+
+private:
+    int64_t offset_ = 0;
+};
+
+// Writes `value` at `offset` bytes into the object `base` refers to, as many
+// bytes as the type of `value` is wide. Traps like LoadInstr.
+class StoreInstr final: public Instruction {
+public:
+    StoreInstr(Instruction* base, int64_t offset, Instruction* value):
+        Instruction(OpType::STORE, DataType::VOID), offset_(offset) {
+        AddInput(base);
+        AddInput(value);
+    }
+
+    int64_t GetOffset() const;
+
+    void Dump(std::stringstream &ss) const override;
+
+private:
+    int64_t offset_ = 0;
+};
+
+// Branch-free choice between two values: `ifTrue` when a `condition` jump
+// (JA, JAE or JE) on the comparison result `input` would be taken, `ifFalse`
+// otherwise. Both values are computed before the select.
+class SelectInstr final: public Instruction {
+public:
+    SelectInstr(DataType resultType, OpType condition, Instruction* input, Instruction* ifTrue, Instruction* ifFalse):
+        Instruction(OpType::SELECT, resultType), condition_(condition) {
+        AddInput(input);
+        AddInput(ifTrue);
+        AddInput(ifFalse);
+    }
+
+    OpType GetCondition() const;
+
+    void Dump(std::stringstream &ss) const override;
+
+private:
+    OpType condition_ = OpType::JE;
+};
+
+// True when instructions with opcode `op` are of class T or of a class derived from it.
+template <typename T>
+constexpr bool IsInstanceOf(OpType op) {
+    switch(op) {
+        #define OPR_DEF(name, dump_name, class_name, ...) \
+        case OpType::name:                                 \
+            return std::is_base_of_v<T, class_name>;
+
+        #include "oprdef.hpp"
+        #undef OPR_DEF
+    }
+
+    return false;
+}
+
+template <typename T>
+bool Instruction::Is() const {
+    return IsInstanceOf<T>(optype_);
+}
+
+template <typename T>
+T* Instruction::As() {
+    return Is<T>() ? static_cast<T*>(this) : nullptr;
+}
+
+template <typename T>
+const T* Instruction::As() const {
+    return Is<T>() ? static_cast<const T*>(this) : nullptr;
+}
 
 #endif  // IR_INSTRUCTION_HPP
\ No newline at end of file
@@ -1,31 +1,67 @@
-OPR_DEF(UNDEFINED, "daaaaamn")
+// OPR_DEF(name, dump_name, class_name, operands, flags)
+// `operands` is the number of value inputs, -1 when it varies per instruction.
+// `flags` names an OpFlags value.
 
-OPR_DEF(ADD, "add")
+OPR_DEF(UNDEFINED, "daaaaamn", Instruction, 0, NONE)
 
-OPR_DEF(SUB, "sub")
+OPR_DEF(ADD, "add", AddInstr, 2, COMMUTATIVE)
 
-OPR_DEF(MUL, "mul")
+OPR_DEF(SUB, "sub", SubInstr, 2, NONE)
 
-OPR_DEF(DIV, "div")
+OPR_DEF(MUL, "mul", MulInstr, 2, COMMUTATIVE)
 
-OPR_DEF(CMP, "cmp")
+OPR_DEF(DIV, "div", DivInstr, 2, SIDE_EFFECTS)
 
-OPR_DEF(JMP, "jmp")
+OPR_DEF(CMP, "cmp", CmpInstr, 2, NONE)
 
-OPR_DEF(JA, "ja")
+OPR_DEF(JMP, "jmp", JmpInstr, 0, TERMINATOR)
 
-OPR_DEF(JAE, "jae")
+OPR_DEF(JA, "ja", JaInstr, 1, TERMINATOR)
 
-OPR_DEF(JE, "je")
+OPR_DEF(JAE, "jae", JaeInstr, 1, TERMINATOR)
 
-OPR_DEF(RET, "ret")
+OPR_DEF(JE, "je", JeInstr, 1, TERMINATOR)
 
-OPR_DEF(PHI, "phi")
+OPR_DEF(RET, "ret", RetInstr, 1, TERMINATOR)
 
-OPR_DEF(PRM, "param")
+OPR_DEF(PHI, "phi", PhiInstr, -1, NONE)
 
-OPR_DEF(MOV, "mov")
+OPR_DEF(PRM, "param", ParameterInstr, 0, NONE)
 
-OPR_DEF(CONST, "const")
+OPR_DEF(MOV, "mov", Instruction, 1, NONE)
 
-OPR_DEF(CAST, "cast")
\ No newline at end of file
+OPR_DEF(CONST, "const", ConstantInstr, 0, NONE)
+
+OPR_DEF(CAST, "cast", Instruction, 1, NONE)
+
+OPR_DEF(DEOPT, "deopt", GuardInstr, -1, SIDE_EFFECTS)
+
+OPR_DEF(AND, "and", AndInstr, 2, COMMUTATIVE)
+
+OPR_DEF(SPLAT, "splat", SplatInstr, 1, NONE)
+
+OPR_DEF(IOTA, "iota", IotaInstr, 0, NONE)
+
+OPR_DEF(REDUCE, "reduce", ReduceInstr, 1, NONE)
+
+OPR_DEF(BOUNDS_CHECK, "boundscheck", BoundsCheckInstr, 2, SIDE_EFFECTS)
+
+OPR_DEF(OVERFLOW_CHECK, "ovfcheck", OverflowCheckInstr, 2, SIDE_EFFECTS)
+
+OPR_DEF(NEW_OBJECT, "newobj", NewObjectInstr, 0, NONE)
+
+OPR_DEF(LOAD_FIELD, "ldfield", LoadFieldInstr, 1, SIDE_EFFECTS)
+
+OPR_DEF(STORE_FIELD, "stfield", StoreFieldInstr, 2, SIDE_EFFECTS)
+
+OPR_DEF(LOAD, "load", LoadInstr, 1, SIDE_EFFECTS)
+
+OPR_DEF(STORE, "store", StoreInstr, 2, SIDE_EFFECTS)
+
+OPR_DEF(SELECT, "select", SelectInstr, 3, NONE)
+
+OPR_DEF(MOD, "mod", ModInstr, 2, SIDE_EFFECTS)
+
+OPR_DEF(MULH, "mulh", MulHighInstr, 2, COMMUTATIVE)
+
+OPR_DEF(SHR, "shr", ShrInstr, 2, NONE)
@@ -0,0 +1,66 @@
+#ifndef IR_OPTRAITS_HPP
+#define IR_OPTRAITS_HPP
+
+#include "Instr/enums.hpp"
+
+#include <array>
+#include <cstdint>
+
+enum class OpFlags: uint8_t {
+    NONE         = 0,
+    COMMUTATIVE  = 1 << 0,
+    // May leave the compiled code (trap or deoptimize) or touches memory, so
+    // it is neither removed when unused nor reordered with other such
+    // instructions.
+    SIDE_EFFECTS = 1 << 1,
+    TERMINATOR   = 1 << 2,
+};
+
+constexpr OpFlags operator|(OpFlags lhs, OpFlags rhs) {
+    return static_cast<OpFlags>(static_cast<uint8_t>(lhs) | static_cast<uint8_t>(rhs));
+}
+
+constexpr bool HasFlag(OpFlags flags, OpFlags flag) {
+    return (static_cast<uint8_t>(flags) & static_cast<uint8_t>(flag)) != 0;
+}
+
+struct OpTraits {
+    const char* name = "";
+    // Number of value inputs, -1 when it varies.
+    int operandsCount = 0;
+    OpFlags flags = OpFlags::NONE;
+};
+
+inline constexpr std::array<OpTraits, OPCODES_COUNT> OP_TRAITS = {{
+    #define OPR_DEF(name, dump_name, class_name, operands, flags) \
+        OpTraits{dump_name, operands, OpFlags::flags},
+
+    #include "oprdef.hpp"
+    #undef OPR_DEF
+}};
+
+constexpr const OpTraits& GetOpTraits(OpType op) {
+    return OP_TRAITS[static_cast<size_t>(op)];
+}
+
+constexpr const char* GetOpName(OpType op) {
+    return GetOpTraits(op).name;
+}
+
+constexpr int GetOperandsCount(OpType op) {
+    return GetOpTraits(op).operandsCount;
+}
+
+constexpr bool IsCommutative(OpType op) {
+    return HasFlag(GetOpTraits(op).flags, OpFlags::COMMUTATIVE);
+}
+
+constexpr bool HasSideEffects(OpType op) {
+    return HasFlag(GetOpTraits(op).flags, OpFlags::SIDE_EFFECTS);
+}
+
+constexpr bool IsTerminator(OpType op) {
+    return HasFlag(GetOpTraits(op).flags, OpFlags::TERMINATOR);
+}
+
+#endif  // IR_OPTRAITS_HPP
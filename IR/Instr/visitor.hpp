@@ -0,0 +1,36 @@
+#ifndef IR_VISITOR_HPP
+#define IR_VISITOR_HPP
+
+#include "Instr/instruction.hpp"
+
+#include <utility>
+
+// Static dispatch on the opcode: the visitor is called with the instruction
+// cast to the class registered for its opcode in oprdef.hpp, so overload
+// resolution picks the most specific handler, e.g. a CjmpInstr* overload
+// serves JA, JAE and JE while an Instruction* overload catches the rest.
+// All handlers must return the same type.
+template <typename Visitor>
+decltype(auto) VisitInstruction(Instruction* instr, Visitor &&visitor) {
+    switch(instr->GetOpType()) {
+        #define OPR_DEF(name, dump_name, class_name, ...) \
+        case OpType::name:                                 \
+            return std::forward<Visitor>(visitor)(static_cast<class_name*>(instr));
+
+        #include "oprdef.hpp"
+        #undef OPR_DEF
+    }
+
+    __builtin_unreachable();
+}
+
+// Builds a visitor out of lambdas: VisitInstruction(instr, Overloaded{...}).
+template <typename... Handlers>
+struct Overloaded: Handlers... {
+    using Handlers::operator()...;
+};
+
+template <typename... Handlers>
+Overloaded(Handlers...) -> Overloaded<Handlers...>;
+
+#endif  // IR_VISITOR_HPP
@@ -0,0 +1,523 @@
+#include "Interpreter/interpreter.hpp"
+#include "OSR/osr.hpp"
+
+#include <limits>
+
+uint64_t NormalizeValue(DataType type, uint64_t value) {
+    switch(type) {
+        case DataType::I8:
+            return static_cast<uint64_t>(static_cast<int64_t>(static_cast<int8_t>(value)));
+        case DataType::U8:
+            return static_cast<uint8_t>(value);
+        case DataType::I16:
+            return static_cast<uint64_t>(static_cast<int64_t>(static_cast<int16_t>(value)));
+        case DataType::U16:
+            return static_cast<uint16_t>(value);
+        case DataType::I32:
+            return static_cast<uint64_t>(static_cast<int64_t>(static_cast<int32_t>(value)));
+        case DataType::U32:
+            return static_cast<uint32_t>(value);
+        case DataType::VOID:
+            return 0;
+        default:
+            return value;
+    }
+}
+
+bool IsConditionTaken(OpType condition, uint64_t cmpResult) {
+    auto cmp = static_cast<CmpResult>(cmpResult);
+    switch(condition) {
+        case OpType::JA:
+            return cmp == CmpResult::ABOVE;
+        case OpType::JAE:
+            return cmp != CmpResult::BELOW;
+        case OpType::JE:
+            return cmp == CmpResult::EQUAL;
+        default:
+            return false;
+    }
+}
+
+namespace {
+
+bool IsSignedType(DataType type) {
+    return type == DataType::I8  || type == DataType::I16 ||
+           type == DataType::I32 || type == DataType::I64;
+}
+
+// The remainder takes the sign of the dividend.
+std::optional<uint64_t> Divide(OpType op, DataType type, uint64_t lhs, uint64_t rhs) {
+    if(NormalizeValue(type, rhs) == 0) {
+        return std::nullopt;
+    }
+
+    if(IsSignedType(type)) {
+        auto dividend = static_cast<int64_t>(NormalizeValue(type, lhs));
+        auto divisor = static_cast<int64_t>(NormalizeValue(type, rhs));
+        if(dividend == std::numeric_limits<int64_t>::min() && divisor == -1) {
+            return op == OpType::MOD ? 0 : NormalizeValue(type, lhs);
+        }
+        auto value = op == OpType::MOD ? dividend % divisor : dividend / divisor;
+        return NormalizeValue(type, static_cast<uint64_t>(value));
+    }
+
+    auto dividend = NormalizeValue(type, lhs);
+    auto divisor = NormalizeValue(type, rhs);
+    return op == OpType::MOD ? dividend % divisor : dividend / divisor;
+}
+
+// Narrower products fit 64 bits; the 64-bit one is put together from 32-bit
+// halves, and the signed high half corrects the unsigned one for negative
+// factors.
+uint64_t MultiplyHigh(DataType type, uint64_t lhs, uint64_t rhs) {
+    auto bits = GetElementBits(type);
+    lhs = NormalizeValue(type, lhs);
+    rhs = NormalizeValue(type, rhs);
+    bool isSigned = IsSignedType(type);
+    if(bits < 64) {
+        auto product = isSigned ? static_cast<uint64_t>(static_cast<int64_t>(lhs) * static_cast<int64_t>(rhs)) :
+                                  lhs * rhs;
+        return NormalizeValue(type, isSigned ? static_cast<uint64_t>(static_cast<int64_t>(product) >> bits) :
+                                               product >> bits);
+    }
+
+    constexpr uint64_t LOW_HALF = 0xffffffffULL;
+    uint64_t low = (lhs & LOW_HALF) * (rhs & LOW_HALF);
+    uint64_t middle = (lhs >> 32) * (rhs & LOW_HALF) + (low >> 32);
+    uint64_t other = (lhs & LOW_HALF) * (rhs >> 32) + (middle & LOW_HALF);
+    uint64_t high = (lhs >> 32) * (rhs >> 32) + (middle >> 32) + (other >> 32);
+    if(isSigned) {
+        high -= static_cast<int64_t>(lhs) < 0 ? rhs : 0;
+        high -= static_cast<int64_t>(rhs) < 0 ? lhs : 0;
+    }
+    return high;
+}
+
+// Signed values are kept sign-extended, so shifting all 64 bits is exact.
+uint64_t ShiftRight(DataType type, uint64_t lhs, uint64_t rhs) {
+    auto amount = NormalizeValue(type, rhs) & 63;
+    lhs = NormalizeValue(type, lhs);
+    if(IsSignedType(type)) {
+        return NormalizeValue(type, static_cast<uint64_t>(static_cast<int64_t>(lhs) >> amount));
+    }
+    return lhs >> amount;
+}
+
+template <typename T, typename V>
+bool Overflows(OpType op, V lhs, V rhs) {
+    T result;
+    switch(op) {
+        case OpType::ADD:
+            return __builtin_add_overflow(lhs, rhs, &result);
+        case OpType::SUB:
+            return __builtin_sub_overflow(lhs, rhs, &result);
+        default:
+            return __builtin_mul_overflow(lhs, rhs, &result);
+    }
+}
+
+bool Overflows(OpType op, DataType type, uint64_t lhs, uint64_t rhs) {
+    lhs = NormalizeValue(type, lhs);
+    rhs = NormalizeValue(type, rhs);
+    auto signedLhs = static_cast<int64_t>(lhs);
+    auto signedRhs = static_cast<int64_t>(rhs);
+    switch(type) {
+        case DataType::I8:
+            return Overflows<int8_t>(op, signedLhs, signedRhs);
+        case DataType::I16:
+            return Overflows<int16_t>(op, signedLhs, signedRhs);
+        case DataType::I32:
+            return Overflows<int32_t>(op, signedLhs, signedRhs);
+        case DataType::I64:
+            return Overflows<int64_t>(op, signedLhs, signedRhs);
+        case DataType::U8:
+            return Overflows<uint8_t>(op, lhs, rhs);
+        case DataType::U16:
+            return Overflows<uint16_t>(op, lhs, rhs);
+        case DataType::U32:
+            return Overflows<uint32_t>(op, lhs, rhs);
+        default:
+            return Overflows<uint64_t>(op, lhs, rhs);
+    }
+}
+
+uint64_t* GetField(InterpreterFrame &frame, uint64_t object, uint32_t field) {
+    if(object == 0 || object > frame.objects.size() || field >= frame.objects[object - 1].size()) {
+        return nullptr;
+    }
+    return &frame.objects[object - 1][field];
+}
+
+// Fields of the object if `size` bytes at `offset` are all inside it.
+std::vector<uint64_t>* GetBytes(InterpreterFrame &frame, uint64_t object, int64_t offset, uint32_t size) {
+    if(object == 0 || object > frame.objects.size() || size == 0 || offset < 0) {
+        return nullptr;
+    }
+    auto &fields = frame.objects[object - 1];
+    if(static_cast<uint64_t>(offset) + size > fields.size() * sizeof(uint64_t)) {
+        return nullptr;
+    }
+    return &fields;
+}
+
+uint64_t ReadBytes(const std::vector<uint64_t> &fields, uint64_t offset, uint32_t size) {
+    uint64_t value = 0;
+    for(uint32_t idx = 0; idx < size; ++idx) {
+        auto pos = offset + idx;
+        value |= ((fields[pos / 8] >> (8 * (pos % 8))) & 0xff) << (8 * idx);
+    }
+    return value;
+}
+
+void WriteBytes(std::vector<uint64_t> &fields, uint64_t offset, uint32_t size, uint64_t value) {
+    for(uint32_t idx = 0; idx < size; ++idx) {
+        auto pos = offset + idx;
+        auto shift = 8 * (pos % 8);
+        fields[pos / 8] = (fields[pos / 8] & ~(0xffULL << shift)) | (((value >> (8 * idx)) & 0xff) << shift);
+    }
+}
+
+}  // namespace
+
+std::optional<uint64_t> Interpreter::Run(const std::vector<uint64_t> &args) {
+    InterpreterFrame frame;
+    frame.block = graph_->GetStartBlock();
+    frame.values.assign(graph_->GetInstructions().size(), 0);
+
+    return Resume(std::move(frame), args);
+}
+
+std::optional<uint64_t> Interpreter::Resume(InterpreterFrame frame, const std::vector<uint64_t> &args) {
+    frame.values.resize(graph_->GetInstructions().size(), 0);
+    frame.vectors.resize(graph_->GetInstructions().size());
+
+    while(frame.block != nullptr) {
+        if(!EvaluatePhis(frame)) {
+            return std::nullopt;
+        }
+
+        if(osrCompiler_ != nullptr && frame.prevBlock != nullptr) {
+            auto it = backEdges_.find(frame.block);
+            if(it != backEdges_.end() && it->second.count(frame.prevBlock) != 0) {
+                if(++backEdgeCounters_[frame.block] >= osrThreshold_) {
+                    if(auto *entry = osrCompiler_->GetEntry(frame.block)) {
+                        std::vector<uint64_t> liveInValues;
+                        for(auto *liveIn: entry->GetLiveIns()) {
+                            liveInValues.push_back(frame.values[liveIn->GetId()]);
+                        }
+                        ++osrTransitions_;
+                        return entry->Run(liveInValues);
+                    }
+                }
+            }
+        }
+
+        nextBlock_ = nullptr;
+        retValue_.reset();
+
+        for(auto *instr = frame.block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            if(instr->IsPhi()) {
+                continue;
+            }
+            if(!Execute(instr, frame, args)) {
+                return std::nullopt;
+            }
+            if(retValue_.has_value()) {
+                return retValue_;
+            }
+            if(nextBlock_ != nullptr) {
+                break;
+            }
+        }
+
+        frame.prevBlock = frame.block;
+        frame.block = nextBlock_;
+    }
+
+    return std::nullopt;
+}
+
+void Interpreter::EnableOsr(OsrCompiler* compiler, size_t threshold) {
+    osrCompiler_ = compiler;
+    osrThreshold_ = threshold;
+    backEdges_.clear();
+    backEdgeCounters_.clear();
+
+    if(compiler == nullptr) {
+        return;
+    }
+
+    for(auto &loop: compiler->GetLoopAnalyzer().GetLoops()) {
+        auto &latches = backEdges_[loop->GetHeader()];
+        latches.insert(loop->GetBackEdges().begin(), loop->GetBackEdges().end());
+    }
+}
+
+size_t Interpreter::GetBackEdgeCount(BasicBlock* header) const {
+    auto it = backEdgeCounters_.find(header);
+    return it == backEdgeCounters_.end() ? 0 : it->second;
+}
+
+size_t Interpreter::GetOsrTransitionsCount() const {
+    return osrTransitions_;
+}
+
+void Interpreter::SetBranchProfile(BranchProfile* profile) {
+    branchProfile_ = profile;
+}
+
+size_t Interpreter::GetDeoptsCount() const {
+    return deopts_;
+}
+
+bool Interpreter::Deoptimize(GuardInstr* guard, const InterpreterFrame &frame, const std::vector<uint64_t> &args) {
+    ++deopts_;
+
+    auto *baseline = guard->GetResumeBlock()->GetGraph();
+
+    InterpreterFrame baselineFrame;
+    baselineFrame.block = guard->GetResumeBlock();
+    baselineFrame.prevBlock = guard->GetResumePrevBlock();
+    baselineFrame.values.assign(baseline->GetInstructions().size(), 0);
+    baselineFrame.objects = frame.objects;
+
+    auto &stateValues = guard->GetStateValues();
+    auto &inputs = guard->GetInputs();
+    for(size_t idx = 0; idx < stateValues.size(); ++idx) {
+        baselineFrame.values[stateValues[idx]->GetId()] = frame.values[inputs[idx + 1].GetValue()->GetId()];
+    }
+
+    Interpreter baselineInterpreter(baseline);
+    baselineInterpreter.SetBranchProfile(branchProfile_);
+    retValue_ = baselineInterpreter.Resume(std::move(baselineFrame), args);
+    return retValue_.has_value();
+}
+
+bool Interpreter::EvaluatePhis(InterpreterFrame &frame) {
+    std::vector<std::pair<Instruction*, uint64_t>> phiValues;
+    std::vector<std::pair<Instruction*, std::vector<uint64_t>>> phiVectors;
+
+    for(auto *instr = frame.block->GetFirstInstr(); instr != nullptr && instr->IsPhi(); instr = instr->GetNext()) {
+        auto *input = static_cast<PhiInstr*>(instr)->GetPhiInput(frame.prevBlock);
+        if(input == nullptr) {
+            return false;
+        }
+        if(IsVectorType(instr->GetResultType())) {
+            phiVectors.emplace_back(instr, frame.vectors[input->GetId()]);
+        } else {
+            phiValues.emplace_back(instr, NormalizeValue(instr->GetResultType(), frame.values[input->GetId()]));
+        }
+    }
+
+    for(auto &[phi, value]: phiValues) {
+        frame.values[phi->GetId()] = value;
+    }
+    for(auto &[phi, lanes]: phiVectors) {
+        frame.vectors[phi->GetId()] = std::move(lanes);
+    }
+    return true;
+}
+
+bool Interpreter::ExecuteVector(Instruction* instr, InterpreterFrame &frame) {
+    auto &inputs = instr->GetInputs();
+    auto type = instr->GetResultType();
+    auto element = GetElementType(type);
+    std::vector<uint64_t> lanes(GetLanesCount(type), 0);
+
+    switch(instr->GetOpType()) {
+        case OpType::SPLAT:
+            lanes.assign(lanes.size(), NormalizeValue(element, frame.values[inputs[0].GetValue()->GetId()]));
+            break;
+        case OpType::IOTA:
+            for(size_t lane = 0; lane < lanes.size(); ++lane) {
+                lanes[lane] = lane;
+            }
+            break;
+        case OpType::ADD:
+        case OpType::SUB:
+        case OpType::MUL:
+        case OpType::AND: {
+            auto &lhs = frame.vectors[inputs[0].GetValue()->GetId()];
+            auto &rhs = frame.vectors[inputs[1].GetValue()->GetId()];
+            if(lhs.size() != lanes.size() || rhs.size() != lanes.size()) {
+                return false;
+            }
+            for(size_t lane = 0; lane < lanes.size(); ++lane) {
+                uint64_t value = 0;
+                switch(instr->GetOpType()) {
+                    case OpType::ADD:
+                        value = lhs[lane] + rhs[lane];
+                        break;
+                    case OpType::SUB:
+                        value = lhs[lane] - rhs[lane];
+                        break;
+                    case OpType::MUL:
+                        value = lhs[lane] * rhs[lane];
+                        break;
+                    default:
+                        value = lhs[lane] & rhs[lane];
+                        break;
+                }
+                lanes[lane] = NormalizeValue(element, value);
+            }
+            break;
+        }
+        default:
+            return false;
+    }
+
+    frame.vectors[instr->GetId()] = std::move(lanes);
+    return true;
+}
+
+bool Interpreter::Execute(Instruction* instr, InterpreterFrame &frame, const std::vector<uint64_t> &args) {
+    auto &inputs = instr->GetInputs();
+    auto input = [&frame, &inputs](size_t idx) { return frame.values[inputs[idx].GetValue()->GetId()]; };
+    auto type = instr->GetResultType();
+    auto &result = frame.values[instr->GetId()];
+
+    if(IsVectorType(type)) {
+        return ExecuteVector(instr, frame);
+    }
+
+    switch(instr->GetOpType()) {
+        case OpType::PRM: {
+            auto argNum = static_cast<ParameterInstr*>(instr)->GetArgNum();
+            if(argNum >= args.size()) {
+                return false;
+            }
+            result = NormalizeValue(type, args[argNum]);
+            return true;
+        }
+        case OpType::CONST:
+            result = NormalizeValue(type, static_cast<ConstantInstr*>(instr)->GetAsUnsignedInt());
+            return true;
+        case OpType::ADD:
+            result = NormalizeValue(type, input(0) + input(1));
+            return true;
+        case OpType::SUB:
+            result = NormalizeValue(type, input(0) - input(1));
+            return true;
+        case OpType::MUL:
+            result = NormalizeValue(type, input(0) * input(1));
+            return true;
+        case OpType::AND:
+            result = NormalizeValue(type, input(0) & input(1));
+            return true;
+        case OpType::DIV:
+        case OpType::MOD: {
+            auto quotient = Divide(instr->GetOpType(), type, input(0), input(1));
+            if(!quotient.has_value()) {
+                return false;
+            }
+            result = *quotient;
+            return true;
+        }
+        case OpType::MULH:
+            result = MultiplyHigh(type, input(0), input(1));
+            return true;
+        case OpType::SHR:
+            result = ShiftRight(type, input(0), input(1));
+            return true;
+        case OpType::CMP: {
+            auto lhs = input(0);
+            auto rhs = input(1);
+            auto cmp = lhs == rhs ? CmpResult::EQUAL : (lhs > rhs ? CmpResult::ABOVE : CmpResult::BELOW);
+            result = static_cast<uint64_t>(cmp);
+            return true;
+        }
+        case OpType::MOV:
+        case OpType::CAST:
+            result = NormalizeValue(type, input(0));
+            return true;
+        case OpType::SELECT:
+            result = IsConditionTaken(static_cast<SelectInstr*>(instr)->GetCondition(), input(0)) ? input(1) : input(2);
+            return true;
+        case OpType::JMP:
+            nextBlock_ = static_cast<JmpInstr*>(instr)->GetBBToJmp();
+            return true;
+        case OpType::JA:
+        case OpType::JAE:
+        case OpType::JE: {
+            bool taken = IsConditionTaken(instr->GetOpType(), input(0));
+            if(branchProfile_ != nullptr) {
+                branchProfile_->Record(instr, taken);
+            }
+            auto *branch = static_cast<CjmpInstr*>(instr);
+            nextBlock_ = taken ? branch->GetTrueBranchBB() : branch->GetFalseBranchBB();
+            return true;
+        }
+        case OpType::DEOPT: {
+            auto *guard = static_cast<GuardInstr*>(instr);
+            if(IsConditionTaken(guard->GetCondition(), input(0)) == guard->IsTakenExpected()) {
+                return true;
+            }
+            return Deoptimize(guard, frame, args);
+        }
+        case OpType::RET:
+            retValue_ = NormalizeValue(type, input(0));
+            return true;
+        case OpType::REDUCE: {
+            auto op = static_cast<ReduceInstr*>(instr)->GetReduceOp();
+            auto &lanes = frame.vectors[inputs[0].GetValue()->GetId()];
+            if(lanes.empty()) {
+                return false;
+            }
+            uint64_t value = lanes[0];
+            for(size_t lane = 1; lane < lanes.size(); ++lane) {
+                value = op == OpType::ADD ? value + lanes[lane] :
+                        op == OpType::MUL ? value * lanes[lane] : value & lanes[lane];
+            }
+            result = NormalizeValue(type, value);
+            return true;
+        }
+        case OpType::BOUNDS_CHECK:
+            return input(0) < input(1);
+        case OpType::OVERFLOW_CHECK: {
+            auto *check = static_cast<OverflowCheckInstr*>(instr);
+            return !Overflows(check->GetCheckedOp(), check->GetCheckedType(), input(0), input(1));
+        }
+        case OpType::NEW_OBJECT:
+            frame.objects.emplace_back(static_cast<NewObjectInstr*>(instr)->GetFieldsCount(), 0);
+            result = frame.objects.size();
+            return true;
+        case OpType::LOAD_FIELD: {
+            auto *field = GetField(frame, input(0), static_cast<LoadFieldInstr*>(instr)->GetField());
+            if(field == nullptr) {
+                return false;
+            }
+            result = NormalizeValue(type, *field);
+            return true;
+        }
+        case OpType::STORE_FIELD: {
+            auto *field = GetField(frame, input(0), static_cast<StoreFieldInstr*>(instr)->GetField());
+            if(field == nullptr) {
+                return false;
+            }
+            *field = input(1);
+            return true;
+        }
+        case OpType::LOAD: {
+            auto offset = static_cast<LoadInstr*>(instr)->GetOffset();
+            auto size = GetAccessSize(type);
+            auto *fields = GetBytes(frame, input(0), offset, size);
+            if(fields == nullptr) {
+                return false;
+            }
+            result = NormalizeValue(type, ReadBytes(*fields, offset, size));
+            return true;
+        }
+        case OpType::STORE: {
+            auto offset = static_cast<StoreInstr*>(instr)->GetOffset();
+            auto size = GetAccessSize(inputs[1].GetValue()->GetResultType());
+            auto *fields = GetBytes(frame, input(0), offset, size);
+            if(fields == nullptr) {
+                return false;
+            }
+            WriteBytes(*fields, offset, size, input(1));
+            return true;
+        }
+        default:
+            return false;
+    }
+}
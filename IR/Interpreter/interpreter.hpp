@@ -0,0 +1,82 @@
+#ifndef IR_INTERPRETER_HPP
+#define IR_INTERPRETER_HPP
+
+#include "Graph/graph.hpp"
+#include "Profile/branchprofile.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class OsrCompiler;
+
+enum class CmpResult: uint64_t {
+    BELOW = 0,
+    EQUAL = 1,
+    ABOVE = 2,
+};
+
+uint64_t NormalizeValue(DataType type, uint64_t value);
+bool IsConditionTaken(OpType condition, uint64_t cmpResult);
+
+// Interpreter state at a block boundary: the block about to run, the block it
+// was entered from and the value of every instruction, indexed by its id.
+// Vector values keep their lanes in `vectors` under the same index. Allocated
+// objects keep their fields in `objects`; a reference is the index of its
+// object plus one, so zero is the null reference. Loads and stores see the
+// fields as little-endian bytes.
+struct InterpreterFrame {
+    BasicBlock* block = nullptr;
+    BasicBlock* prevBlock = nullptr;
+    std::vector<uint64_t> values;
+    std::vector<std::vector<uint64_t>> vectors;
+    std::vector<std::vector<uint64_t>> objects;
+};
+
+// Reference executor of the IR. Comparisons are unsigned, arithmetic wraps to
+// the width of the result type. With OSR enabled the interpreter counts loop
+// back edges and, once a header gets hot, hands the frame over to the code
+// compiled by the OsrCompiler for that header. A failing guard rebuilds the
+// frame of the baseline graph from the guard state and resumes there. Failing
+// bounds and overflow checks trap like a division by zero: there is no result,
+// and so do field accesses through null references or past the last field,
+// and loads and stores not fully inside an object.
+class Interpreter final {
+public:
+    Interpreter(Graph* graph): graph_(graph) {}
+
+    std::optional<uint64_t> Run(const std::vector<uint64_t> &args);
+    std::optional<uint64_t> Resume(InterpreterFrame frame, const std::vector<uint64_t> &args);
+
+    void EnableOsr(OsrCompiler* compiler, size_t threshold);
+    size_t GetBackEdgeCount(BasicBlock* header) const;
+    size_t GetOsrTransitionsCount() const;
+
+    void SetBranchProfile(BranchProfile* profile);
+    size_t GetDeoptsCount() const;
+
+private:
+    bool EvaluatePhis(InterpreterFrame &frame);
+    bool Execute(Instruction* instr, InterpreterFrame &frame, const std::vector<uint64_t> &args);
+    bool ExecuteVector(Instruction* instr, InterpreterFrame &frame);
+    bool Deoptimize(GuardInstr* guard, const InterpreterFrame &frame, const std::vector<uint64_t> &args);
+
+private:
+    Graph* graph_ = nullptr;
+
+    OsrCompiler* osrCompiler_ = nullptr;
+    size_t osrThreshold_ = 0;
+    size_t osrTransitions_ = 0;
+    std::unordered_map<BasicBlock*, std::unordered_set<BasicBlock*>> backEdges_;
+    std::unordered_map<BasicBlock*, size_t> backEdgeCounters_;
+
+    BranchProfile* branchProfile_ = nullptr;
+    size_t deopts_ = 0;
+
+    BasicBlock* nextBlock_ = nullptr;
+    std::optional<uint64_t> retValue_;
+};
+
+#endif  // IR_INTERPRETER_HPP
@@ -0,0 +1,146 @@
+#include "JumpThreading/blockduplicator.hpp"
+#include "Cloner/cloner.hpp"
+#include "DFS/rpo.hpp"
+#include "Instr/optraits.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+// Parameters and moves are not cloned, and guards keep a resume state that
+// points into the original block.
+bool IsClonable(Instruction* instr) {
+    switch(instr->GetOpType()) {
+        case OpType::UNDEFINED:
+        case OpType::MOV:
+        case OpType::CAST:
+        case OpType::DEOPT:
+        case OpType::PRM:
+            return false;
+        default:
+            return true;
+    }
+}
+
+}  // namespace
+
+void BlockDuplicator::CollectLoopHeaders() {
+    loopHeaders_.clear();
+    auto rpo = RPO(graph_).Run();
+    std::unordered_map<BasicBlock*, size_t> order;
+    for(size_t idx = 0; idx < rpo.size(); ++idx) {
+        order[rpo[idx]] = idx;
+    }
+    for(auto *block: rpo) {
+        for(auto *pred: block->GetPredecessors()) {
+            auto it = order.find(pred);
+            if(it != order.end() && it->second >= order[block]) {
+                loopHeaders_.insert(block);
+            }
+        }
+    }
+}
+
+bool BlockDuplicator::CanDuplicate(BasicBlock* pred, BasicBlock* block, size_t maxInstructions) const {
+    if(block == graph_->GetStartBlock() || loopHeaders_.count(block) != 0) {
+        return false;
+    }
+    auto &preds = block->GetPredecessors();
+    if(std::count(preds.begin(), preds.end(), pred) != 1 || pred->GetLastInstr() == nullptr) {
+        return false;
+    }
+    auto predOp = pred->GetLastInstr()->GetOpType();
+    if(predOp != OpType::JMP && predOp != OpType::JA && predOp != OpType::JAE && predOp != OpType::JE) {
+        return false;
+    }
+
+    size_t size = 0;
+    for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+        if(instr->IsPhi()) {
+            continue;
+        }
+        if(!IsClonable(instr) || ++size > maxInstructions) {
+            return false;
+        }
+    }
+    return size != 0;
+}
+
+BasicBlock* BlockDuplicator::Duplicate(BasicBlock* pred, BasicBlock* block, BasicBlock* target) {
+    IrBuilder builder(graph_);
+    InstructionCloner cloner(&builder);
+    auto *copy = builder.CreateBB();
+    builder.SetBasicBlockScope(copy);
+
+    std::vector<Instruction*> clones;
+    for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+        if(instr->IsPhi()) {
+            cloner.MapValue(instr, static_cast<PhiInstr*>(instr)->GetPhiInput(pred));
+        } else if(target != nullptr && instr == block->GetLastInstr()) {
+            builder.CreateJmp(target);
+        } else {
+            clones.push_back(cloner.Clone(instr));
+        }
+    }
+
+    // The phi inputs of the block are read above, before the edge leaves it.
+    auto *terminator = pred->GetLastInstr();
+    if(auto *branch = terminator->As<CjmpInstr>()) {
+        branch->ReplaceTarget(block, copy);
+    } else {
+        static_cast<JmpInstr*>(terminator)->SetBBToJmp(copy);
+    }
+    pred->ReplaceSuccessor(block, copy);
+    copy->AddPredecessor(pred);
+    block->RemovePredecessor(pred);
+
+    // The copy is the last predecessor of its successors, so its phi inputs go
+    // last as well.
+    for(auto *succ: copy->GetSuccessors()) {
+        for(auto *phi = succ->GetFirstInstr(); phi != nullptr && phi->IsPhi(); phi = phi->GetNext()) {
+            phi->AddInput(cloner.GetMappedValue(static_cast<PhiInstr*>(phi)->GetPhiInput(block)));
+        }
+    }
+
+    // Every block reached from the copy used to be reached through the block,
+    // so reading a value below it always ends at one of the two definitions.
+    IrBuilder ssa(graph_);
+    for(auto &bb: graph_->GetBlocks()) {
+        ssa.SealBlock(bb.get());
+    }
+    uint32_t variable = 0;
+    for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+        std::vector<std::pair<Instruction*, size_t>> outside;
+        for(auto &use: instr->GetUses()) {
+            auto *userBlock = use.GetUser()->GetParentBB();
+            if(userBlock != block && userBlock != copy) {
+                outside.emplace_back(use.GetUser(), use.GetIndex());
+            }
+        }
+        if(outside.empty()) {
+            continue;
+        }
+
+        ssa.SetBasicBlockScope(block);
+        ssa.WriteVariable(variable, instr);
+        ssa.SetBasicBlockScope(copy);
+        ssa.WriteVariable(variable, cloner.GetMappedValue(instr));
+        for(auto [user, idx]: outside) {
+            auto *userBlock = user->GetParentBB();
+            ssa.SetBasicBlockScope(user->IsPhi() ? userBlock->GetPredecessors()[idx] : userBlock);
+            user->SetInput(idx, ssa.ReadVariable(variable));
+        }
+        ++variable;
+    }
+
+    // A threaded branch leaves its condition unused in the copy.
+    for(auto it = clones.rbegin(); it != clones.rend(); ++it) {
+        auto op = (*it)->GetOpType();
+        if(!(*it)->HasUses() && !HasSideEffects(op) && !IsTerminator(op)) {
+            graph_->RemoveInstruction(*it);
+        }
+    }
+    return copy;
+}
@@ -0,0 +1,31 @@
+#ifndef IR_BLOCK_DUPLICATOR_HPP
+#define IR_BLOCK_DUPLICATOR_HPP
+
+#include "Graph/graph.hpp"
+
+#include <unordered_set>
+
+// Gives one incoming edge of a block its own copy of the block, which is what
+// jump threading and tail duplication both do. Phis of the block resolve to
+// the value coming along the edge, successors get phi inputs for the copy and
+// values used below the block are merged with their copies through builder
+// variables, so the graph stays in SSA form.
+class BlockDuplicator final {
+public:
+    BlockDuplicator(Graph* graph): graph_(graph) {}
+
+    // Blocks entered by a retreating edge are never duplicated, so every loop
+    // keeps its single header.
+    void CollectLoopHeaders();
+
+    bool CanDuplicate(BasicBlock* pred, BasicBlock* block, size_t maxInstructions) const;
+    // A non-null target replaces the terminator of the copy by a jump there.
+    BasicBlock* Duplicate(BasicBlock* pred, BasicBlock* block, BasicBlock* target = nullptr);
+
+private:
+    Graph* graph_ = nullptr;
+
+    std::unordered_set<BasicBlock*> loopHeaders_;
+};
+
+#endif  // IR_BLOCK_DUPLICATOR_HPP
@@ -0,0 +1,66 @@
+#include "JumpThreading/jumpthreading.hpp"
+#include "JumpThreading/blockduplicator.hpp"
+#include "DFS/rpo.hpp"
+#include "Interpreter/interpreter.hpp"
+
+// A block left without predecessors is removed right away so that fixing the
+// SSA form never reads through dead code. That frees blocks, so the walk
+// starts over after every threaded edge.
+size_t JumpThreading::Run() {
+    size_t threaded = 0;
+    BlockDuplicator duplicator(graph_);
+    for(bool changed = true; changed;) {
+        changed = false;
+        graph_->RemoveUnreachableBlocks();
+        duplicator.CollectLoopHeaders();
+        for(auto *block: RPO(graph_).Run()) {
+            for(auto *pred: block->GetPredecessors()) {
+                auto *target = FindKnownTarget(pred, block);
+                if(target != nullptr && duplicator.CanDuplicate(pred, block, maxInstructions_)) {
+                    duplicator.Duplicate(pred, block, target);
+                    changed = true;
+                    break;
+                }
+            }
+            if(changed) {
+                ++threaded;
+                break;
+            }
+        }
+    }
+    return threaded;
+}
+
+BasicBlock* JumpThreading::FindKnownTarget(BasicBlock* pred, BasicBlock* block) const {
+    auto *branch = block->GetLastInstr() == nullptr ? nullptr : block->GetLastInstr()->As<CjmpInstr>();
+    if(branch == nullptr) {
+        return nullptr;
+    }
+    auto *cmp = branch->GetInputs()[0].GetValue();
+    if(cmp->GetOpType() != OpType::CMP || cmp->GetParentBB() != block) {
+        return nullptr;
+    }
+
+    uint64_t values[2] = {};
+    bool hasPhi = false;
+    for(size_t idx = 0; idx < 2; ++idx) {
+        auto *value = cmp->GetInputs()[idx].GetValue();
+        if(value->IsPhi() && value->GetParentBB() == block) {
+            value = static_cast<PhiInstr*>(value)->GetPhiInput(pred);
+            hasPhi = true;
+        }
+        auto *constant = value == nullptr ? nullptr : value->As<ConstantInstr>();
+        if(constant == nullptr) {
+            return nullptr;
+        }
+        values[idx] = NormalizeValue(constant->GetResultType(), constant->GetAsUnsignedInt());
+    }
+    if(!hasPhi) {
+        return nullptr;
+    }
+
+    auto cmpResult = values[0] == values[1] ? CmpResult::EQUAL :
+                     (values[0] > values[1] ? CmpResult::ABOVE : CmpResult::BELOW);
+    bool taken = IsConditionTaken(branch->GetOpType(), static_cast<uint64_t>(cmpResult));
+    return taken ? branch->GetTrueBranchBB() : branch->GetFalseBranchBB();
+}
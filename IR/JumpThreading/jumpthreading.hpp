@@ -0,0 +1,28 @@
+#ifndef IR_JUMP_THREADING_HPP
+#define IR_JUMP_THREADING_HPP
+
+#include "Graph/graph.hpp"
+
+// Threads incoming edges along which a branch is known:
+//     block: phis; ...; c = cmp x, y; je/ja/jae c, ifTrue, ifFalse
+// where x and y are constants or phis of the block and at least one is a phi.
+// When both resolve to constants on the edge from a predecessor, that edge
+// gets its own copy of the block ending with a jump to the taken successor.
+// The original block keeps its other predecessors and is removed once none
+// is left. Loop headers are not threaded.
+class JumpThreading final {
+public:
+    JumpThreading(Graph* graph, size_t maxInstructions = 8): graph_(graph), maxInstructions_(maxInstructions) {}
+
+    // Returns the number of threaded edges.
+    size_t Run();
+
+private:
+    BasicBlock* FindKnownTarget(BasicBlock* pred, BasicBlock* block) const;
+
+private:
+    Graph* graph_ = nullptr;
+    size_t maxInstructions_ = 0;
+};
+
+#endif  // IR_JUMP_THREADING_HPP
@@ -0,0 +1,36 @@
+#include "JumpThreading/tailduplication.hpp"
+#include "JumpThreading/blockduplicator.hpp"
+#include "DFS/rpo.hpp"
+
+// Copies only take predecessors away from a block that still has one left, so
+// no block dies and a single walk over the original blocks is enough. Blocks
+// reached from the copies may gain predecessors and are duplicated later in
+// the walk.
+size_t TailDuplication::Run() {
+    graph_->RemoveUnreachableBlocks();
+    BlockDuplicator duplicator(graph_);
+    duplicator.CollectLoopHeaders();
+
+    size_t copies = 0;
+    for(auto *block: RPO(graph_).Run()) {
+        auto preds = block->GetPredecessors();
+        if(preds.size() < 2) {
+            continue;
+        }
+        std::vector<BasicBlock*> jumping;
+        for(auto *pred: preds) {
+            if(duplicator.CanDuplicate(pred, block, maxInstructions_) &&
+               pred->GetLastInstr()->GetOpType() == OpType::JMP) {
+                jumping.push_back(pred);
+            }
+        }
+        if(jumping.size() == preds.size()) {
+            jumping.pop_back();
+        }
+        for(auto *pred: jumping) {
+            duplicator.Duplicate(pred, block);
+            ++copies;
+        }
+    }
+    return copies;
+}
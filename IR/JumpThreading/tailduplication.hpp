@@ -0,0 +1,26 @@
+#ifndef IR_TAIL_DUPLICATION_HPP
+#define IR_TAIL_DUPLICATION_HPP
+
+#include "Graph/graph.hpp"
+
+// Copies small merge blocks into the predecessors that jump to them
+// unconditionally, so each path runs its own tail:
+//     pred0: ...; jmp merge          pred0: ...; jmp merge0
+//     pred1: ...; jmp merge    ->    pred1: ...; jmp merge1
+//     merge: phis; code              merge0, merge1: code with the phi inputs of their edge
+// When every predecessor jumps, the last one keeps the original block. Loop
+// headers and blocks with more than `maxInstructions` non-phi instructions are
+// left alone.
+class TailDuplication final {
+public:
+    TailDuplication(Graph* graph, size_t maxInstructions = 4): graph_(graph), maxInstructions_(maxInstructions) {}
+
+    // Returns the number of created copies.
+    size_t Run();
+
+private:
+    Graph* graph_ = nullptr;
+    size_t maxInstructions_ = 0;
+};
+
+#endif  // IR_TAIL_DUPLICATION_HPP
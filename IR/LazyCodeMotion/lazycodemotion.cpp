@@ -0,0 +1,297 @@
+#include "LazyCodeMotion/lazycodemotion.hpp"
+#include "DFS/rpo.hpp"
+#include "Instr/optraits.hpp"
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <unordered_set>
+
+namespace {
+
+bool IsCandidate(Instruction* instr) {
+    switch(instr->GetOpType()) {
+        case OpType::ADD:
+        case OpType::SUB:
+        case OpType::MUL:
+        case OpType::AND:
+            return !IsVectorType(instr->GetResultType());
+        default:
+            return false;
+    }
+}
+
+}  // namespace
+
+size_t LazyCodeMotion::Run() {
+    inserted_ = 0;
+    expressions_.clear();
+    expressionIdx_.clear();
+    edges_.clear();
+
+    auto rpo = RPO(graph_).Run();
+    CollectExpressions(rpo);
+    if(expressions_.empty()) {
+        return 0;
+    }
+
+    ComputeLocalSets(rpo);
+    ComputeAvailability(rpo);
+    ComputeAnticipability(rpo);
+    ComputeLater(rpo);
+
+    IrBuilder builder(graph_);
+    Insert(builder);
+    return ReplaceRedundant(builder);
+}
+
+size_t LazyCodeMotion::GetInsertedCount() const {
+    return inserted_;
+}
+
+// Only expressions computed more than once can be redundant.
+void LazyCodeMotion::CollectExpressions(const std::vector<BasicBlock*> &rpo) {
+    std::map<std::tuple<OpType, DataType, size_t, size_t>, std::vector<Instruction*>> occurrences;
+    for(auto *block: rpo) {
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            if(!IsCandidate(instr)) {
+                continue;
+            }
+            auto lhs = instr->GetInputs()[0].GetValue()->GetId();
+            auto rhs = instr->GetInputs()[1].GetValue()->GetId();
+            if(IsCommutative(instr->GetOpType()) && lhs > rhs) {
+                std::swap(lhs, rhs);
+            }
+            occurrences[{instr->GetOpType(), instr->GetResultType(), lhs, rhs}].push_back(instr);
+        }
+    }
+
+    for(auto &[key, instrs]: occurrences) {
+        if(instrs.size() < 2) {
+            continue;
+        }
+        auto &inputs = instrs[0]->GetInputs();
+        for(auto *instr: instrs) {
+            expressionIdx_[instr] = expressions_.size();
+        }
+        expressions_.push_back({std::get<0>(key), std::get<1>(key), inputs[0].GetValue(), inputs[1].GetValue()});
+    }
+}
+
+void LazyCodeMotion::ComputeLocalSets(const std::vector<BasicBlock*> &rpo) {
+    auto blocksCount = graph_->GetBlocks().size();
+    ExpressionSet none(expressions_.size(), false);
+    computed_.assign(blocksCount, none);
+    exposed_.assign(blocksCount, none);
+    killed_.assign(blocksCount, none);
+    reachable_.assign(blocksCount, false);
+
+    for(auto *block: rpo) {
+        reachable_[block->GetId()] = true;
+    }
+    for(auto [instr, idx]: expressionIdx_) {
+        computed_[instr->GetParentBB()->GetId()][idx] = true;
+    }
+    for(size_t idx = 0; idx < expressions_.size(); ++idx) {
+        killed_[expressions_[idx].lhs->GetParentBB()->GetId()][idx] = true;
+        killed_[expressions_[idx].rhs->GetParentBB()->GetId()][idx] = true;
+    }
+    // Inputs are defined before their uses, so a computation in a block that
+    // kills the expression always follows the kill.
+    for(size_t id = 0; id < blocksCount; ++id) {
+        for(size_t idx = 0; idx < expressions_.size(); ++idx) {
+            exposed_[id][idx] = computed_[id][idx] && !killed_[id][idx];
+        }
+    }
+}
+
+void LazyCodeMotion::ComputeAvailability(const std::vector<BasicBlock*> &rpo) {
+    availOut_.assign(graph_->GetBlocks().size(), ExpressionSet(expressions_.size(), true));
+    for(bool changed = true; changed;) {
+        changed = false;
+        for(auto *block: rpo) {
+            auto id = block->GetId();
+            ExpressionSet availIn(expressions_.size(), block != graph_->GetStartBlock());
+            for(auto *pred: block->GetPredecessors()) {
+                if(reachable_[pred->GetId()]) {
+                    for(size_t idx = 0; idx < expressions_.size(); ++idx) {
+                        availIn[idx] = availIn[idx] && availOut_[pred->GetId()][idx];
+                    }
+                }
+            }
+            for(size_t idx = 0; idx < expressions_.size(); ++idx) {
+                bool avail = computed_[id][idx] || (availIn[idx] && !killed_[id][idx]);
+                changed |= avail != availOut_[id][idx];
+                availOut_[id][idx] = avail;
+            }
+        }
+    }
+}
+
+void LazyCodeMotion::ComputeAnticipability(const std::vector<BasicBlock*> &rpo) {
+    antIn_.assign(graph_->GetBlocks().size(), ExpressionSet(expressions_.size(), true));
+    antOut_.assign(graph_->GetBlocks().size(), ExpressionSet(expressions_.size(), false));
+    for(bool changed = true; changed;) {
+        changed = false;
+        for(auto it = rpo.rbegin(); it != rpo.rend(); ++it) {
+            auto *block = *it;
+            auto id = block->GetId();
+            auto &antOut = antOut_[id];
+            antOut.assign(expressions_.size(), !block->GetSuccessors().empty());
+            for(auto *succ: block->GetSuccessors()) {
+                for(size_t idx = 0; idx < expressions_.size(); ++idx) {
+                    antOut[idx] = antOut[idx] && antIn_[succ->GetId()][idx];
+                }
+            }
+            for(size_t idx = 0; idx < expressions_.size(); ++idx) {
+                bool ant = exposed_[id][idx] || (antOut[idx] && !killed_[id][idx]);
+                changed |= ant != antIn_[id][idx];
+                antIn_[id][idx] = ant;
+            }
+        }
+    }
+}
+
+// An expression is placed earliest on an edge where it becomes anticipated
+// and is not available yet, and stays later while it can be delayed without
+// passing a computation of it.
+void LazyCodeMotion::ComputeLater(const std::vector<BasicBlock*> &rpo) {
+    std::unordered_map<BasicBlock*, std::vector<size_t>> inEdges;
+    for(auto *block: rpo) {
+        std::unordered_set<BasicBlock*> targets;
+        for(auto *succ: block->GetSuccessors()) {
+            if(targets.insert(succ).second) {
+                inEdges[succ].push_back(edges_.size());
+                edges_.push_back({block, succ, ExpressionSet(expressions_.size(), false)});
+            }
+        }
+    }
+
+    laterIn_.assign(graph_->GetBlocks().size(), ExpressionSet(expressions_.size(), true));
+    laterIn_[graph_->GetStartBlock()->GetId()].assign(expressions_.size(), false);
+    for(bool changed = true; changed;) {
+        changed = false;
+        for(auto *block: rpo) {
+            auto id = block->GetId();
+            if(block == graph_->GetStartBlock()) {
+                continue;
+            }
+            ExpressionSet laterIn(expressions_.size(), true);
+            for(auto edgeIdx: inEdges[block]) {
+                auto &edge = edges_[edgeIdx];
+                auto from = edge.from->GetId();
+                for(size_t idx = 0; idx < expressions_.size(); ++idx) {
+                    bool earliest = antIn_[id][idx] && !availOut_[from][idx] &&
+                                    (killed_[from][idx] || !antOut_[from][idx]);
+                    edge.later[idx] = earliest || (laterIn_[from][idx] && !exposed_[from][idx]);
+                    laterIn[idx] = laterIn[idx] && edge.later[idx];
+                }
+            }
+            changed |= laterIn != laterIn_[id];
+            laterIn_[id] = std::move(laterIn);
+        }
+    }
+}
+
+// An expression goes on an edge that is the last one it can be delayed to:
+// at the end of the source when that only leads to the target, at the start
+// of the target when only the source leads there, or in a new block between
+// them otherwise.
+void LazyCodeMotion::Insert(IrBuilder &builder) {
+    for(auto &edge: edges_) {
+        auto &laterIn = laterIn_[edge.to->GetId()];
+        Instruction* position = nullptr;
+        for(size_t idx = 0; idx < expressions_.size(); ++idx) {
+            if(!edge.later[idx] || laterIn[idx]) {
+                continue;
+            }
+
+            if(position == nullptr) {
+                auto &succs = edge.from->GetSuccessors();
+                auto &preds = edge.to->GetPredecessors();
+                auto isTarget = [&edge](BasicBlock* block) { return block == edge.to; };
+                auto isSource = [&edge](BasicBlock* block) { return block == edge.from; };
+                if(std::all_of(succs.begin(), succs.end(), isTarget)) {
+                    position = edge.from->GetLastInstr();
+                } else if(std::all_of(preds.begin(), preds.end(), isSource)) {
+                    position = edge.to->GetFirstInstr();
+                    while(position->IsPhi()) {
+                        position = position->GetNext();
+                    }
+                } else {
+                    position = graph_->SplitEdge(edge.from, edge.to)->GetLastInstr();
+                }
+            }
+
+            builder.SetInsertPoint(position);
+            expressionIdx_[CreateExpression(builder, expressions_[idx])] = idx;
+            ++inserted_;
+        }
+    }
+}
+
+// Expressions become builder variables, as fields do in the scalar
+// replacement: every computation writes its variable and a redundant one is
+// replaced by a read. Blocks are walked in reverse post order and sealed once
+// all their reachable predecessors are walked.
+size_t LazyCodeMotion::ReplaceRedundant(IrBuilder &builder) {
+    auto rpo = RPO(graph_).Run();
+    std::unordered_map<BasicBlock*, size_t> pendingPreds;
+    for(auto *block: rpo) {
+        for(auto *succ: block->GetSuccessors()) {
+            ++pendingPreds[succ];
+        }
+    }
+
+    std::vector<Instruction*> redundant;
+    for(auto *block: rpo) {
+        builder.SetBasicBlockScope(block);
+        if(pendingPreds[block] == 0) {
+            builder.SealBlock(block);
+        }
+
+        // Blocks made by splitting edges have no sets and delete nothing.
+        auto id = block->GetId();
+        auto *deleted = id < exposed_.size() ? &exposed_[id] : nullptr;
+        std::unordered_set<size_t> written;
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            auto it = expressionIdx_.find(instr);
+            if(it == expressionIdx_.end()) {
+                continue;
+            }
+            auto idx = it->second;
+            bool isDeleted = deleted != nullptr && (*deleted)[idx] && !laterIn_[id][idx];
+            if(written.count(idx) != 0 || isDeleted) {
+                instr->ReplaceAllUsesWith(builder.ReadVariable(static_cast<uint32_t>(idx)));
+                redundant.push_back(instr);
+            } else {
+                builder.WriteVariable(static_cast<uint32_t>(idx), instr);
+            }
+            written.insert(idx);
+        }
+
+        for(auto *succ: block->GetSuccessors()) {
+            if(--pendingPreds[succ] == 0) {
+                builder.SealBlock(succ);
+            }
+        }
+    }
+
+    for(auto *instr: redundant) {
+        graph_->RemoveInstruction(instr);
+    }
+    return redundant.size();
+}
+
+Instruction* LazyCodeMotion::CreateExpression(IrBuilder &builder, const Expression &expression) const {
+    switch(expression.op) {
+        case OpType::ADD:
+            return builder.CreateAdd(expression.type, expression.lhs, expression.rhs);
+        case OpType::SUB:
+            return builder.CreateSub(expression.type, expression.lhs, expression.rhs);
+        case OpType::MUL:
+            return builder.CreateMul(expression.type, expression.lhs, expression.rhs);
+        default:
+            return builder.CreateAnd(expression.type, expression.lhs, expression.rhs);
+    }
+}
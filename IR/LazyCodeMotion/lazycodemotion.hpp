@@ -0,0 +1,73 @@
+#ifndef IR_LAZY_CODE_MOTION_HPP
+#define IR_LAZY_CODE_MOTION_HPP
+
+#include "Graph/graph.hpp"
+#include "irbuilder.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+// Partial redundancy elimination by lazy code motion (Knoop, Ruthing and
+// Steffen), in the edge-based form of Drechsler and Stadel. An expression is a
+// scalar ADD, SUB, MUL or AND of two values, so each one is computed by every
+// instruction with the same opcode, type and inputs. A block defining an input
+// kills the expression: in SSA form this keeps new computations below the
+// definitions they need. Availability and anticipability are solved over the
+// CFG with a set of expressions per block id; computations then go on the
+// edges where they are needed as late as possible, splitting critical edges,
+// and the computations made redundant read the value through phis.
+class LazyCodeMotion final {
+public:
+    LazyCodeMotion(Graph* graph): graph_(graph) {}
+
+    // Returns the number of removed computations.
+    size_t Run();
+    size_t GetInsertedCount() const;
+
+private:
+    using ExpressionSet = std::vector<bool>;
+
+    struct Expression {
+        OpType op = OpType::UNDEFINED;
+        DataType type = DataType::UNDEFINED;
+        Instruction* lhs = nullptr;
+        Instruction* rhs = nullptr;
+    };
+
+    struct Edge {
+        BasicBlock* from = nullptr;
+        BasicBlock* to = nullptr;
+        ExpressionSet later;
+    };
+
+    void CollectExpressions(const std::vector<BasicBlock*> &rpo);
+    void ComputeLocalSets(const std::vector<BasicBlock*> &rpo);
+    void ComputeAvailability(const std::vector<BasicBlock*> &rpo);
+    void ComputeAnticipability(const std::vector<BasicBlock*> &rpo);
+    void ComputeLater(const std::vector<BasicBlock*> &rpo);
+    void Insert(IrBuilder &builder);
+    size_t ReplaceRedundant(IrBuilder &builder);
+    Instruction* CreateExpression(IrBuilder &builder, const Expression &expression) const;
+
+private:
+    Graph* graph_ = nullptr;
+    size_t inserted_ = 0;
+
+    std::vector<Expression> expressions_;
+    // Expression computed by each candidate instruction.
+    std::unordered_map<Instruction*, size_t> expressionIdx_;
+
+    // Indexed by block id.
+    std::vector<ExpressionSet> computed_;
+    std::vector<ExpressionSet> exposed_;
+    std::vector<ExpressionSet> killed_;
+    std::vector<ExpressionSet> availOut_;
+    std::vector<ExpressionSet> antIn_;
+    std::vector<ExpressionSet> antOut_;
+    std::vector<ExpressionSet> laterIn_;
+    std::vector<bool> reachable_;
+
+    std::vector<Edge> edges_;
+};
+
+#endif  // IR_LAZY_CODE_MOTION_HPP
@@ -0,0 +1,87 @@
+#include "Liveness/liveness.hpp"
+#include "DFS/dfs.hpp"
+#include "Graph/graph.hpp"
+
+#include <algorithm>
+
+void LivenessAnalyzer::Analyze() {
+    liveIn_.clear();
+    liveOut_.clear();
+
+    DFS dfs(graph_);
+    auto postOrder = dfs.RunPostOrder();
+    for(auto *block: postOrder) {
+        liveIn_[block];
+        liveOut_[block];
+    }
+
+    bool changed = true;
+    while(changed) {
+        changed = false;
+
+        for(auto *block: postOrder) {
+            std::unordered_set<Instruction*> live;
+            for(auto *succ: block->GetSuccessors()) {
+                AddEdgeLiveValues(block, succ, live);
+            }
+
+            auto &liveOut = liveOut_[block];
+            if(live.size() != liveOut.size()) {
+                liveOut = live;
+                changed = true;
+            }
+
+            for(auto *instr = block->GetLastInstr(); instr != nullptr; instr = instr->GetPrev()) {
+                live.erase(instr);
+                if(instr->IsPhi()) {
+                    live.insert(instr);
+                    continue;
+                }
+                for(auto &input: instr->GetInputs()) {
+                    live.insert(input.GetValue());
+                }
+            }
+
+            auto &liveIn = liveIn_[block];
+            if(live.size() != liveIn.size()) {
+                liveIn = std::move(live);
+                changed = true;
+            }
+        }
+    }
+}
+
+const std::unordered_set<Instruction*>& LivenessAnalyzer::GetLiveIn(BasicBlock* block) const {
+    return liveIn_.at(block);
+}
+
+const std::unordered_set<Instruction*>& LivenessAnalyzer::GetLiveOut(BasicBlock* block) const {
+    return liveOut_.at(block);
+}
+
+std::vector<Instruction*> LivenessAnalyzer::GetLiveOnEdge(BasicBlock* from, BasicBlock* to) const {
+    std::unordered_set<Instruction*> live;
+    AddEdgeLiveValues(from, to, live);
+
+    std::vector<Instruction*> result(live.begin(), live.end());
+    std::sort(result.begin(), result.end(), [](auto *lhs, auto *rhs) { return lhs->GetId() < rhs->GetId(); });
+    return result;
+}
+
+void LivenessAnalyzer::AddEdgeLiveValues(BasicBlock* from, BasicBlock* to,
+                                         std::unordered_set<Instruction*> &live) const {
+    auto it = liveIn_.find(to);
+    if(it != liveIn_.end()) {
+        for(auto *value: it->second) {
+            if(!(value->IsPhi() && value->GetParentBB() == to)) {
+                live.insert(value);
+            }
+        }
+    }
+
+    for(auto *instr = to->GetFirstInstr(); instr != nullptr && instr->IsPhi(); instr = instr->GetNext()) {
+        if(auto *input = static_cast<PhiInstr*>(instr)->GetPhiInput(from)) {
+            live.insert(input);
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef IR_LIVENESS_HPP
+#define IR_LIVENESS_HPP
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class Graph;
+class BasicBlock;
+class Instruction;
+
+// SSA liveness at block boundaries. A phi is live-in at its own block, and its
+// inputs are live-out only at the matching predecessor.
+class LivenessAnalyzer final {
+public:
+    LivenessAnalyzer(Graph* graph): graph_(graph) {}
+
+    void Analyze();
+
+    const std::unordered_set<Instruction*>& GetLiveIn(BasicBlock* block) const;
+    const std::unordered_set<Instruction*>& GetLiveOut(BasicBlock* block) const;
+
+    // Values needed to start executing `to` when entering it from `from`,
+    // ordered by instruction id.
+    std::vector<Instruction*> GetLiveOnEdge(BasicBlock* from, BasicBlock* to) const;
+
+private:
+    void AddEdgeLiveValues(BasicBlock* from, BasicBlock* to, std::unordered_set<Instruction*> &live) const;
+
+private:
+    Graph* graph_ = nullptr;
+
+    std::unordered_map<BasicBlock*, std::unordered_set<Instruction*>> liveIn_;
+    std::unordered_map<BasicBlock*, std::unordered_set<Instruction*>> liveOut_;
+};
+
+#endif  // IR_LIVENESS_HPP
@@ -7,7 +7,10 @@
 
 void LoopAnalyzer::Analyze() {
     domTree_.Build();
+    AnalyzeLoops();
+}
 
+void LoopAnalyzer::AnalyzeLoops() {
     loops_.clear();
     headerToLoop_.clear();
 
@@ -19,6 +22,19 @@ const std::vector<std::unique_ptr<Loop>>& LoopAnalyzer::GetLoops() const {
     return loops_;
 }
 
+Loop *LoopAnalyzer::GetLoop(BasicBlock *header) const {
+    auto it = headerToLoop_.find(header);
+    return it == headerToLoop_.end() ? nullptr : it->second;
+}
+
+const DominatorTree& LoopAnalyzer::GetDominatorTree() const {
+    return domTree_;
+}
+
+DominatorTree& LoopAnalyzer::GetDominatorTree() {
+    return domTree_;
+}
+
 void LoopAnalyzer::FindNaturalLoops() {
     DFS dfs(graph_);
     auto backEdges = dfs.RunLoopAnalyzer();
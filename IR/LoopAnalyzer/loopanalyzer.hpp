@@ -17,7 +17,13 @@ public:
     LoopAnalyzer(Graph* graph): graph_(graph), domTree_(graph) {}
 
     void Analyze();
+    // Finds the loops again over the current dominator tree, for passes that
+    // keep it up to date through its update API instead of rebuilding it.
+    void AnalyzeLoops();
     const std::vector<std::unique_ptr<Loop>>& GetLoops() const;
+    Loop *GetLoop(BasicBlock *header) const;
+    const DominatorTree& GetDominatorTree() const;
+    DominatorTree& GetDominatorTree();
     void DumpLoops(std::ostream &ostr = std::cout) const;
 
 private:
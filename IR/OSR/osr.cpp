@@ -0,0 +1,275 @@
+#include "OSR/osr.hpp"
+#include "Cloner/cloner.hpp"
+#include "DFS/rpo.hpp"
+#include "Interpreter/interpreter.hpp"
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace {
+
+void ReachableAvoiding(BasicBlock* start, BasicBlock* avoid, std::unordered_set<BasicBlock*> &reachable) {
+    std::vector<BasicBlock*> worklist {start};
+    reachable.insert(start);
+
+    while(!worklist.empty()) {
+        auto *block = worklist.back();
+        worklist.pop_back();
+        for(auto *succ: block->GetSuccessors()) {
+            if(succ != avoid && reachable.insert(succ).second) {
+                worklist.push_back(succ);
+            }
+        }
+    }
+}
+
+BasicBlock* UseBlock(Instruction* user, size_t inputIdx) {
+    if(user->IsPhi()) {
+        return static_cast<PhiInstr*>(user)->GetPhiInputBB(inputIdx);
+    }
+    return user->GetParentBB();
+}
+
+bool HasUseIn(Instruction* value, const std::vector<BasicBlock*> &blocks,
+              const std::unordered_set<BasicBlock*> &useBlocks) {
+    for(auto *block: blocks) {
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            auto &inputs = instr->GetInputs();
+            for(size_t idx = 0; idx < inputs.size(); ++idx) {
+                if(inputs[idx].GetValue() == value && useBlocks.count(UseBlock(instr, idx)) != 0) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+Graph* OsrEntry::GetGraph() const {
+    return graph_.get();
+}
+
+const std::vector<Instruction*>& OsrEntry::GetLiveIns() const {
+    return liveIns_;
+}
+
+void OsrEntry::SetCode(OsrCode code) {
+    code_ = std::move(code);
+}
+
+std::optional<uint64_t> OsrEntry::Run(const std::vector<uint64_t> &liveInValues) const {
+    if(code_) {
+        return code_(liveInValues);
+    }
+
+    Interpreter interpreter(graph_.get());
+    return interpreter.Run(liveInValues);
+}
+
+//--------------------------------------------------------------------
+
+OsrCompiler::OsrCompiler(Graph* graph, OsrCodeGenerator generator):
+    graph_(graph), generator_(std::move(generator)), loopAnalyzer_(graph) {
+    loopAnalyzer_.Analyze();
+}
+
+const LoopAnalyzer& OsrCompiler::GetLoopAnalyzer() const {
+    return loopAnalyzer_;
+}
+
+OsrEntry* OsrCompiler::GetEntry(BasicBlock* header) {
+    auto it = entries_.find(header);
+    if(it != entries_.end()) {
+        return it->second.get();
+    }
+
+    Loop* loop = loopAnalyzer_.GetLoop(header);
+    if(loop == nullptr) {
+        return nullptr;
+    }
+
+    auto entry = Compile(loop);
+    if(entry != nullptr && generator_) {
+        entry->SetCode(generator_(entry->GetGraph()));
+    }
+
+    auto *entryPtr = entry.get();
+    entries_[header] = std::move(entry);
+    return entryPtr;
+}
+
+std::unique_ptr<OsrEntry> OsrCompiler::Compile(Loop* loop) {
+    auto *header = loop->GetHeader();
+    auto &domTree = loopAnalyzer_.GetDominatorTree();
+
+    for(auto *pred: header->GetPredecessors()) {
+        if(loop->Contains(pred) && !domTree.Dominates(header, pred)) {
+            return nullptr;
+        }
+    }
+
+    RPO rpo(graph_);
+    auto order = rpo.Run(header);
+    std::unordered_set<BasicBlock*> region(order.begin(), order.end());
+
+    // Header phis, then values defined before the header and used in the region,
+    // then values of outer-loop blocks which will be redefined in the region.
+    std::vector<Instruction*> liveIns;
+    std::unordered_set<Instruction*> liveInSet;
+    std::vector<Instruction*> redefinedLiveIns;
+
+    auto addLiveIn = [&liveIns, &liveInSet](Instruction* value) {
+        if(liveInSet.insert(value).second) {
+            liveIns.push_back(value);
+        }
+    };
+
+    for(auto *instr = header->GetFirstInstr(); instr != nullptr && instr->IsPhi(); instr = instr->GetNext()) {
+        addLiveIn(instr);
+    }
+
+    std::vector<Instruction*> outsideConstants;
+    for(auto *block: order) {
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            auto &inputs = instr->GetInputs();
+            for(size_t idx = 0; idx < inputs.size(); ++idx) {
+                auto *value = inputs[idx].GetValue();
+                if(instr->IsPhi() && region.count(UseBlock(instr, idx)) == 0) {
+                    continue;
+                }
+                if(region.count(value->GetParentBB()) != 0) {
+                    continue;
+                }
+                if(value->GetOpType() == OpType::CONST) {
+                    if(std::find(outsideConstants.begin(), outsideConstants.end(), value) == outsideConstants.end()) {
+                        outsideConstants.push_back(value);
+                    }
+                } else {
+                    addLiveIn(value);
+                }
+            }
+        }
+    }
+
+    // A value of a block strictly dominating the header needs merging only if
+    // some use can be reached from the header without passing its definition.
+    std::unordered_map<BasicBlock*, std::unordered_set<BasicBlock*>> bypassingBlocks;
+    for(auto *block: order) {
+        if(block == header || !domTree.Dominates(block, header)) {
+            continue;
+        }
+        auto &bypassing = bypassingBlocks[block];
+        ReachableAvoiding(header, block, bypassing);
+
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            if(instr->GetResultType() == DataType::VOID || instr->GetOpType() == OpType::CONST) {
+                continue;
+            }
+            if(HasUseIn(instr, order, bypassing)) {
+                addLiveIn(instr);
+                redefinedLiveIns.push_back(instr);
+            }
+        }
+    }
+
+    auto graph = std::make_unique<Graph>();
+    IrBuilder builder(graph.get());
+    InstructionCloner cloner(&builder);
+
+    auto *entryBB = builder.CreateBB();
+    for(auto *block: order) {
+        cloner.MapBlock(block, builder.CreateBB());
+    }
+
+    builder.SetBasicBlockScope(entryBB);
+    std::vector<Instruction*> params;
+    for(size_t idx = 0; idx < liveIns.size(); ++idx) {
+        auto *param = builder.CreateParameter(idx);
+        param->SetResultType(liveIns[idx]->GetResultType());
+        params.push_back(param);
+        cloner.MapValue(liveIns[idx], param);
+    }
+    for(auto *constant: outsideConstants) {
+        cloner.Clone(constant);
+    }
+    auto *headerCopy = cloner.GetMappedBlock(header);
+    builder.CreateJmp(headerCopy);
+
+    auto paramOf = [&liveIns, &params](Instruction* liveIn) {
+        return params[std::find(liveIns.begin(), liveIns.end(), liveIn) - liveIns.begin()];
+    };
+
+    std::vector<std::pair<Instruction*, Instruction*>> phis;
+    std::unordered_map<Instruction*, Instruction*> mergePhis;
+
+    for(auto *block: order) {
+        builder.SetBasicBlockScope(cloner.GetMappedBlock(block));
+
+        auto *instr = block->GetFirstInstr();
+        for(; instr != nullptr && instr->IsPhi(); instr = instr->GetNext()) {
+            phis.emplace_back(instr, cloner.Clone(instr));
+        }
+        if(block == header) {
+            for(auto *value: redefinedLiveIns) {
+                mergePhis[value] = builder.CreatePhi(value->GetResultType());
+            }
+        }
+        for(; instr != nullptr; instr = instr->GetNext()) {
+            if(cloner.Clone(instr) == nullptr) {
+                return nullptr;
+            }
+        }
+    }
+
+    std::unordered_map<BasicBlock*, BasicBlock*> originalBlocks;
+    for(auto *block: order) {
+        originalBlocks[cloner.GetMappedBlock(block)] = block;
+    }
+
+    for(auto &[phi, phiCopy]: phis) {
+        auto *phiInstr = static_cast<PhiInstr*>(phi);
+        for(auto *pred: phiCopy->GetParentBB()->GetPredecessors()) {
+            if(pred == entryBB) {
+                phiCopy->AddInput(paramOf(phi));
+            } else {
+                phiCopy->AddInput(cloner.GetMappedValue(phiInstr->GetPhiInput(originalBlocks[pred])));
+            }
+        }
+    }
+
+    for(auto *value: redefinedLiveIns) {
+        auto &bypassing = bypassingBlocks[value->GetParentBB()];
+        auto *redefinition = cloner.GetMappedValue(value);
+        auto *mergePhi = mergePhis[value];
+        auto *param = paramOf(value);
+
+        for(auto *pred: headerCopy->GetPredecessors()) {
+            if(pred == entryBB) {
+                mergePhi->AddInput(param);
+            } else if(bypassing.count(originalBlocks[pred]) == 0) {
+                mergePhi->AddInput(redefinition);
+            } else {
+                mergePhi->AddInput(mergePhi);
+            }
+        }
+
+        for(auto &user: graph->GetInstructions()) {
+            if(user.get() == mergePhi || user->GetParentBB() == entryBB) {
+                continue;
+            }
+            auto &inputs = user->GetInputs();
+            for(size_t idx = 0; idx < inputs.size(); ++idx) {
+                if(inputs[idx].GetValue() != redefinition && inputs[idx].GetValue() != param) {
+                    continue;
+                }
+                if(bypassing.count(originalBlocks[UseBlock(user.get(), idx)]) != 0) {
+                    user->SetInput(idx, mergePhi);
+                }
+            }
+        }
+    }
+
+    return std::make_unique<OsrEntry>(std::move(graph), std::move(liveIns));
+}
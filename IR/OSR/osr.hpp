@@ -0,0 +1,61 @@
+#ifndef IR_OSR_HPP
+#define IR_OSR_HPP
+
+#include "Graph/graph.hpp"
+#include "LoopAnalyzer/loopanalyzer.hpp"
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+using OsrCode = std::function<std::optional<uint64_t>(const std::vector<uint64_t>&)>;
+using OsrCodeGenerator = std::function<OsrCode(Graph*)>;
+
+// Compiled entry into the middle of a function at a loop header. The entry
+// graph takes the live values of the interpreted frame as parameters, in the
+// order of GetLiveIns(), and runs from the header to the function exit.
+class OsrEntry final {
+public:
+    OsrEntry(std::unique_ptr<Graph> graph, std::vector<Instruction*> liveIns):
+        graph_(std::move(graph)), liveIns_(std::move(liveIns)) {}
+
+    Graph* GetGraph() const;
+    const std::vector<Instruction*>& GetLiveIns() const;
+
+    void SetCode(OsrCode code);
+    std::optional<uint64_t> Run(const std::vector<uint64_t> &liveInValues) const;
+
+private:
+    std::unique_ptr<Graph> graph_;
+    std::vector<Instruction*> liveIns_;
+
+    OsrCode code_;
+};
+
+// Builds OSR entries for loop headers of a graph. Live-ins are the header phis,
+// values defined outside the blocks reachable from the header, and values of
+// outer-loop blocks dominating the header, which get merged with their
+// redefinitions by a phi at the header. Entries are compiled once per header
+// and turned into code by the generator; without one the entry graph is
+// interpreted.
+class OsrCompiler final {
+public:
+    OsrCompiler(Graph* graph, OsrCodeGenerator generator = nullptr);
+
+    const LoopAnalyzer& GetLoopAnalyzer() const;
+    OsrEntry* GetEntry(BasicBlock* header);
+
+private:
+    std::unique_ptr<OsrEntry> Compile(Loop* loop);
+
+private:
+    Graph* graph_ = nullptr;
+    OsrCodeGenerator generator_;
+
+    LoopAnalyzer loopAnalyzer_;
+    std::unordered_map<BasicBlock*, std::unique_ptr<OsrEntry>> entries_;
+};
+
+#endif  // IR_OSR_HPP
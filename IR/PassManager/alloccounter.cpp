@@ -0,0 +1,25 @@
+#include "PassManager/alloccounter.hpp"
+
+namespace {
+
+thread_local AllocationCounters counters;
+bool enabled = false;
+
+}  // namespace
+
+AllocationCounters GetAllocationCounters() {
+    return counters;
+}
+
+bool AreAllocationCountersEnabled() {
+    return enabled;
+}
+
+void CountAllocation(size_t size) {
+    counters.bytes += size;
+    ++counters.count;
+}
+
+void EnableAllocationCounters() {
+    enabled = true;
+}
@@ -0,0 +1,22 @@
+#ifndef IR_ALLOC_COUNTER_HPP
+#define IR_ALLOC_COUNTER_HPP
+
+#include <cstddef>
+
+// Per-thread totals of global operator new calls. They stay zero unless the
+// program links the IR_alloc_counters object library, which replaces the
+// global operator new. Tests and benchmarks link it; other users of IR_lib
+// only get it with IR_ALLOC_COUNTERS.
+struct AllocationCounters {
+    size_t bytes = 0;
+    size_t count = 0;
+};
+
+AllocationCounters GetAllocationCounters();
+bool AreAllocationCountersEnabled();
+
+// Called by the operator new replacement.
+void CountAllocation(size_t size);
+void EnableAllocationCounters();
+
+#endif  // IR_ALLOC_COUNTER_HPP
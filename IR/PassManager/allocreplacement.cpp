@@ -0,0 +1,49 @@
+#include "PassManager/alloccounter.hpp"
+
+#include <cstdlib>
+#include <new>
+
+// Replaces the global operator new for the whole program, so this file lives
+// in its own object library instead of IR_lib.
+
+namespace {
+
+[[maybe_unused]] const bool registered = (EnableAllocationCounters(), true);
+
+// Retries through the new-handler like the standard operator new. Without
+// exceptions a missing handler cannot throw bad_alloc, so it aborts instead.
+void* Allocate(size_t size, bool mayFail) {
+    CountAllocation(size);
+    for(;;) {
+        void* ptr = std::malloc(size == 0 ? 1 : size);
+        if(ptr != nullptr) {
+            return ptr;
+        }
+        auto handler = std::get_new_handler();
+        if(handler == nullptr) {
+            if(mayFail) {
+                return nullptr;
+            }
+            std::abort();
+        }
+        handler();
+    }
+}
+
+}  // namespace
+
+void* operator new(size_t size) {
+    return Allocate(size, false);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return Allocate(size, true);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
@@ -0,0 +1,157 @@
+#include "PassManager/passmanager.hpp"
+
+#include "PassManager/alloccounter.hpp"
+
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+
+namespace {
+
+size_t CountInstructions(Graph* graph) {
+    size_t count = 0;
+    for(auto &block: graph->GetBlocks()) {
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+void DumpString(std::ostream &ostr, const std::string &str) {
+    ostr << '"';
+    for(char ch: str) {
+        if(ch == '"' || ch == '\\') {
+            ostr << '\\' << ch;
+        } else if(static_cast<unsigned char>(ch) < 0x20) {
+            ostr << ' ';
+        } else {
+            ostr << ch;
+        }
+    }
+    ostr << '"';
+}
+
+void DumpCounters(std::ostream &ostr, const PassStats &stats) {
+    ostr << "\"instructions_before\": " << stats.instrsBefore
+         << ", \"instructions_after\": " << stats.instrsAfter
+         << ", \"blocks_before\": " << stats.blocksBefore
+         << ", \"blocks_after\": " << stats.blocksAfter
+         << ", \"bytes_allocated\": " << stats.bytesAllocated
+         << ", \"allocations\": " << stats.allocationsCount
+         << ", \"succeeded\": " << (stats.succeeded ? "true" : "false");
+}
+
+// Exact microseconds with a nanosecond fraction. The default stream format
+// keeps 6 significant digits and switches to exponents past one second.
+void DumpMicroseconds(std::ostream &ostr, uint64_t ns) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%" PRIu64 ".%03" PRIu64, ns / 1000, ns % 1000);
+    ostr << buffer;
+}
+
+template <typename DumpFn>
+bool WriteFile(const std::string &path, DumpFn dump) {
+    std::ofstream file(path);
+    if(!file.is_open()) {
+        return false;
+    }
+    dump(file);
+    return static_cast<bool>(file);
+}
+
+}  // namespace
+
+const char* FunctionPass::GetName() const {
+    return name_.c_str();
+}
+
+bool FunctionPass::Run(Graph* graph) {
+    return fn_(graph);
+}
+
+void PassManager::AddPass(std::unique_ptr<Pass> pass) {
+    passes_.push_back(std::move(pass));
+}
+
+void PassManager::AddPass(std::string name, FunctionPass::PassFn fn) {
+    passes_.push_back(std::make_unique<FunctionPass>(std::move(name), std::move(fn)));
+}
+
+bool PassManager::Run(Graph* graph) {
+    for(auto &pass: passes_) {
+        PassStats stats;
+        stats.name = pass->GetName();
+        stats.instrsBefore = CountInstructions(graph);
+        stats.blocksBefore = graph->GetBlocks().size();
+
+        auto allocsBefore = GetAllocationCounters();
+        auto start = std::chrono::steady_clock::now();
+        stats.succeeded = pass->Run(graph);
+        auto finish = std::chrono::steady_clock::now();
+        auto allocsAfter = GetAllocationCounters();
+
+        stats.startNs = std::chrono::duration_cast<std::chrono::nanoseconds>(start - epoch_).count();
+        stats.durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(finish - start).count();
+        stats.bytesAllocated = allocsAfter.bytes - allocsBefore.bytes;
+        stats.allocationsCount = allocsAfter.count - allocsBefore.count;
+        stats.instrsAfter = CountInstructions(graph);
+        stats.blocksAfter = graph->GetBlocks().size();
+        stats_.push_back(std::move(stats));
+
+        if(!stats_.back().succeeded) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const std::vector<PassStats>& PassManager::GetStats() const {
+    return stats_;
+}
+
+void PassManager::ClearStats() {
+    stats_.clear();
+}
+
+void PassManager::DumpJson(std::ostream &ostr) const {
+    uint64_t totalNs = 0;
+    ostr << "{\n  \"passes\": [";
+    for(size_t idx = 0; idx < stats_.size(); ++idx) {
+        auto &stats = stats_[idx];
+        totalNs += stats.durationNs;
+        ostr << (idx == 0 ? "\n" : ",\n") << "    {\"name\": ";
+        DumpString(ostr, stats.name);
+        ostr << ", \"start_ns\": " << stats.startNs << ", \"duration_ns\": " << stats.durationNs << ", ";
+        DumpCounters(ostr, stats);
+        ostr << "}";
+    }
+    ostr << "\n  ],\n  \"total_ns\": " << totalNs
+         << ",\n  \"alloc_counters\": " << (AreAllocationCountersEnabled() ? "true" : "false") << "\n}\n";
+}
+
+void PassManager::DumpChromeTrace(std::ostream &ostr) const {
+    ostr << "{\"traceEvents\": [";
+    for(size_t idx = 0; idx < stats_.size(); ++idx) {
+        auto &stats = stats_[idx];
+        // Timestamps are in microseconds.
+        ostr << (idx == 0 ? "\n" : ",\n") << "  {\"name\": ";
+        DumpString(ostr, stats.name);
+        ostr << ", \"cat\": \"pass\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1, \"ts\": ";
+        DumpMicroseconds(ostr, stats.startNs);
+        ostr << ", \"dur\": ";
+        DumpMicroseconds(ostr, stats.durationNs);
+        ostr << ", \"args\": {";
+        DumpCounters(ostr, stats);
+        ostr << "}}";
+    }
+    ostr << "\n], \"displayTimeUnit\": \"ns\"}\n";
+}
+
+bool PassManager::WriteJson(const std::string &path) const {
+    return WriteFile(path, [this](std::ostream &ostr) { DumpJson(ostr); });
+}
+
+bool PassManager::WriteChromeTrace(const std::string &path) const {
+    return WriteFile(path, [this](std::ostream &ostr) { DumpChromeTrace(ostr); });
+}
@@ -0,0 +1,79 @@
+#ifndef IR_PASS_MANAGER_HPP
+#define IR_PASS_MANAGER_HPP
+
+#include "Graph/graph.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class Pass {
+public:
+    virtual ~Pass() = default;
+
+    virtual const char* GetName() const = 0;
+    // Returns false if the pass failed and the pipeline must stop.
+    virtual bool Run(Graph* graph) = 0;
+};
+
+class FunctionPass final: public Pass {
+public:
+    using PassFn = std::function<bool(Graph*)>;
+
+    FunctionPass(std::string name, PassFn fn): name_(std::move(name)), fn_(std::move(fn)) {}
+
+    const char* GetName() const override;
+    bool Run(Graph* graph) override;
+
+private:
+    std::string name_;
+    PassFn fn_;
+};
+
+struct PassStats {
+    std::string name;
+    uint64_t startNs = 0;
+    uint64_t durationNs = 0;
+    size_t instrsBefore = 0;
+    size_t instrsAfter = 0;
+    size_t blocksBefore = 0;
+    size_t blocksAfter = 0;
+    size_t bytesAllocated = 0;
+    size_t allocationsCount = 0;
+    bool succeeded = true;
+};
+
+// Runs a pipeline of passes and records one PassStats entry per executed
+// pass. Start times are relative to the creation of the manager, or to the
+// given epoch.
+class PassManager final {
+public:
+    PassManager(): epoch_(std::chrono::steady_clock::now()) {}
+    explicit PassManager(std::chrono::steady_clock::time_point epoch): epoch_(epoch) {}
+
+    void AddPass(std::unique_ptr<Pass> pass);
+    void AddPass(std::string name, FunctionPass::PassFn fn);
+
+    bool Run(Graph* graph);
+
+    const std::vector<PassStats>& GetStats() const;
+    void ClearStats();
+
+    void DumpJson(std::ostream &ostr) const;
+    // Trace-event format, loadable by chrome://tracing and Perfetto.
+    void DumpChromeTrace(std::ostream &ostr) const;
+
+    bool WriteJson(const std::string &path) const;
+    bool WriteChromeTrace(const std::string &path) const;
+
+private:
+    std::chrono::steady_clock::time_point epoch_;
+    std::vector<std::unique_ptr<Pass>> passes_;
+    std::vector<PassStats> stats_;
+};
+
+#endif  // IR_PASS_MANAGER_HPP
@@ -0,0 +1,19 @@
+#include "Profile/branchprofile.hpp"
+
+void BranchProfile::Record(Instruction* branch, bool taken) {
+    auto &counters = counters_[branch];
+    if(taken) {
+        ++counters.taken;
+    } else {
+        ++counters.notTaken;
+    }
+}
+
+BranchCounters BranchProfile::GetCounters(Instruction* branch) const {
+    auto it = counters_.find(branch);
+    return it == counters_.end() ? BranchCounters {} : it->second;
+}
+
+void BranchProfile::Clear() {
+    counters_.clear();
+}
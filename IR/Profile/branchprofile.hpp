@@ -0,0 +1,24 @@
+#ifndef IR_BRANCH_PROFILE_HPP
+#define IR_BRANCH_PROFILE_HPP
+
+#include <cstddef>
+#include <unordered_map>
+
+class Instruction;
+
+struct BranchCounters {
+    size_t taken = 0;
+    size_t notTaken = 0;
+};
+
+class BranchProfile final {
+public:
+    void Record(Instruction* branch, bool taken);
+    BranchCounters GetCounters(Instruction* branch) const;
+    void Clear();
+
+private:
+    std::unordered_map<Instruction*, BranchCounters> counters_;
+};
+
+#endif  // IR_BRANCH_PROFILE_HPP
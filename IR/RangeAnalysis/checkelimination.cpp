@@ -0,0 +1,317 @@
+#include "RangeAnalysis/checkelimination.hpp"
+#include "DFS/rpo.hpp"
+#include "Instr/datatraits.hpp"
+
+#include <utility>
+
+namespace {
+
+bool IsCheck(Instruction* instr) {
+    return instr->GetOpType() == OpType::BOUNDS_CHECK || instr->GetOpType() == OpType::OVERFLOW_CHECK;
+}
+
+bool IsUnsignedType(DataType type) {
+    return type == DataType::U8 || type == DataType::U16 || type == DataType::U32 || type == DataType::U64;
+}
+
+// Constants may live in the loop, everything else is defined before it.
+Instruction* Rematerialize(IrBuilder &builder, Loop* loop, Instruction* value) {
+    auto *constant = value->As<ConstantInstr>();
+    if(constant == nullptr || !loop->Contains(value->GetParentBB())) {
+        return value;
+    }
+    if(constant->IsSignedInt()) {
+        return builder.CreateConstant(constant->GetAsSignedInt(), value->GetResultType());
+    }
+    return builder.CreateConstant(constant->GetAsUnsignedInt(), value->GetResultType());
+}
+
+Instruction* CreateCheck(IrBuilder &builder, Instruction* check, Instruction* lhs, Instruction* rhs) {
+    if(auto *overflow = check->As<OverflowCheckInstr>()) {
+        return builder.CreateOverflowCheck(overflow->GetCheckedOp(), overflow->GetCheckedType(), lhs, rhs);
+    }
+    return builder.CreateBoundsCheck(lhs, rhs);
+}
+
+}  // namespace
+
+size_t CheckElimination::Run() {
+    RangeAnalysis analysis(graph_);
+    analysis.Analyze();
+    auto rpo = RPO(graph_).Run();
+
+    std::vector<Instruction*> checks;
+    for(auto *block: rpo) {
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            if(IsCheck(instr)) {
+                checks.push_back(instr);
+            }
+        }
+    }
+
+    size_t removed = 0;
+    std::vector<Instruction*> kept;
+    for(auto *check: checks) {
+        if(IsRedundant(analysis, check, kept)) {
+            graph_->RemoveInstruction(check);
+            ++removed;
+        } else {
+            kept.push_back(check);
+        }
+    }
+
+    hoisted_ = 0;
+    for(auto &loop: analysis.GetInductionAnalysis().GetLoopAnalyzer().GetLoops()) {
+        HoistChecks(analysis, rpo, loop.get());
+    }
+    return removed;
+}
+
+size_t CheckElimination::GetHoistedCount() const {
+    return hoisted_;
+}
+
+bool CheckElimination::IsRedundant(const RangeAnalysis &analysis, Instruction* check,
+                                   const std::vector<Instruction*> &kept) const {
+    auto *lhs = check->GetInputs()[0].GetValue();
+    auto *rhs = check->GetInputs()[1].GetValue();
+    auto *overflow = check->As<OverflowCheckInstr>();
+    if(overflow == nullptr) {
+        return analysis.IsKnownBelow(lhs, rhs, check);
+    }
+
+    auto op = overflow->GetCheckedOp();
+    auto type = overflow->GetCheckedType();
+    auto lhsRange = RangeAnalysis::CastRange(analysis.GetRange(lhs, check), type);
+    auto rhsRange = RangeAnalysis::CastRange(analysis.GetRange(rhs, check), type);
+    if(RangeAnalysis::GetExactRange(op, type, lhsRange, rhsRange).has_value()) {
+        return true;
+    }
+
+    for(auto *other: kept) {
+        auto *prior = other->As<OverflowCheckInstr>();
+        if(prior == nullptr || prior->GetCheckedOp() != op || prior->GetCheckedType() != type) {
+            continue;
+        }
+        auto *priorLhs = prior->GetInputs()[0].GetValue();
+        auto *priorRhs = prior->GetInputs()[1].GetValue();
+        bool isSame = (priorLhs == lhs && priorRhs == rhs) ||
+                      (IsCommutative(op) && priorLhs == rhs && priorRhs == lhs);
+        if(isSame && analysis.Dominates(prior, check)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void CheckElimination::HoistChecks(const RangeAnalysis &analysis, const std::vector<BasicBlock*> &rpo, Loop* loop) {
+    auto *preheader = InductionAnalysis::GetPreheader(loop);
+    if(preheader == nullptr || preheader->GetLastInstr() == nullptr || !preheader->GetLastInstr()->IsJmp() ||
+       !HasSingleExit(loop)) {
+        return;
+    }
+    auto *header = loop->GetHeader();
+    auto *latch = loop->GetBackEdges()[0];
+    auto &domTree = analysis.GetDominatorTree();
+    auto isInvariant = [loop](Instruction* value) {
+        return value->Is<ConstantInstr>() || !loop->Contains(value->GetParentBB());
+    };
+
+    // A guard repeats the first exit test, which takes header phis at their
+    // initial values and invariants.
+    auto *branch = header->GetLastInstr() == nullptr ? nullptr : header->GetLastInstr()->As<CjmpInstr>();
+    auto *cmp = branch == nullptr ? nullptr : branch->GetInputs()[0].GetValue();
+    bool canGuard = cmp != nullptr && cmp->GetOpType() == OpType::CMP && loop->GetSubLoops().empty() &&
+                    loop->Contains(branch->GetTrueBranchBB()) != loop->Contains(branch->GetFalseBranchBB());
+    for(size_t idx = 0; canGuard && idx < 2; ++idx) {
+        auto *operand = cmp->GetInputs()[idx].GetValue();
+        canGuard = isInvariant(operand) || (operand->IsPhi() && operand->GetParentBB() == header);
+    }
+
+    std::vector<Instruction*> headerChecks;
+    std::vector<HoistedCheck> bodyChecks;
+    for(auto *block: rpo) {
+        if(!loop->Contains(block)) {
+            continue;
+        }
+        bool isHeader = block == header;
+        bool runsEveryIteration = isHeader || (canGuard && domTree.Dominates(block, latch));
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            // Deoptimization resumes in the middle of the loop.
+            if(instr->GetOpType() == OpType::DEOPT) {
+                return;
+            }
+            if(!IsCheck(instr) || !runsEveryIteration) {
+                continue;
+            }
+            auto &inputs = instr->GetInputs();
+            if(isInvariant(inputs[0].GetValue()) && isInvariant(inputs[1].GetValue())) {
+                if(isHeader) {
+                    headerChecks.push_back(instr);
+                } else {
+                    bodyChecks.push_back(HoistedCheck{instr, std::nullopt});
+                }
+            } else if(auto offset = isHeader ? std::nullopt : GetIndexOffset(analysis, loop, instr)) {
+                bodyChecks.push_back(HoistedCheck{instr, offset});
+            }
+        }
+    }
+
+    // The header runs at least once whenever the preheader does.
+    IrBuilder builder(graph_);
+    for(auto *check: headerChecks) {
+        builder.SetInsertPoint(preheader->GetLastInstr());
+        auto &inputs = check->GetInputs();
+        CreateCheck(builder, check, Rematerialize(builder, loop, inputs[0].GetValue()),
+                    Rematerialize(builder, loop, inputs[1].GetValue()));
+        graph_->RemoveInstruction(check);
+        ++hoisted_;
+    }
+    if(!bodyChecks.empty()) {
+        HoistIntoGuard(loop, bodyChecks);
+    }
+}
+
+std::optional<uint64_t> CheckElimination::GetIndexOffset(const RangeAnalysis &analysis, Loop* loop,
+                                                         Instruction* check) const {
+    auto *header = loop->GetHeader();
+    auto *branch = header->GetLastInstr()->As<CjmpInstr>();
+    if(check->GetOpType() != OpType::BOUNDS_CHECK ||
+       (branch->GetOpType() != OpType::JA && branch->GetOpType() != OpType::JAE) ||
+       loop->Contains(branch->GetTrueBranchBB())) {
+        return std::nullopt;
+    }
+    auto *length = check->GetInputs()[1].GetValue();
+    if(!length->Is<ConstantInstr>() && loop->Contains(length->GetParentBB())) {
+        return std::nullopt;
+    }
+
+    // The counter goes up by one from its initial value to the last one
+    // before the exit.
+    auto &induction = analysis.GetInductionAnalysis();
+    auto *cmp = branch->GetInputs()[0].GetValue();
+    auto *counter = cmp->GetInputs()[0].GetValue();
+    auto *bound = cmp->GetInputs()[1].GetValue();
+    auto *basic = induction.GetInductionVariable(counter);
+    auto type = counter->GetResultType();
+    auto mask = ValueRange::OfType(type).max;
+    if(basic == nullptr || !basic->IsBasic() || basic->loop != loop || basic->stepValue != nullptr ||
+       (basic->step & mask) != 1 || !IsUnsignedType(type) ||
+       (!bound->Is<ConstantInstr>() && loop->Contains(bound->GetParentBB()))) {
+        return std::nullopt;
+    }
+
+    uint64_t offset = 0;
+    auto *index = check->GetInputs()[0].GetValue();
+    if(index != counter) {
+        auto *derived = induction.GetInductionVariable(index);
+        if(derived == nullptr || derived->IsBasic() || derived->loop != loop || derived->basic != counter ||
+           derived->scale != 1 || derived->scaleValue != nullptr || derived->offset != nullptr ||
+           index->GetResultType() != type) {
+            return std::nullopt;
+        }
+        offset = derived->constOffset & mask;
+    }
+
+    // No index on the way to the last one wraps around.
+    auto limit = analysis.GetRange(bound, InductionAnalysis::GetPreheader(loop)->GetLastInstr());
+    bool isStrict = branch->GetOpType() == OpType::JA;
+    uint64_t last = 0;
+    if(limit.IsEmpty() || (!isStrict && limit.max == 0) ||
+       __builtin_add_overflow(isStrict ? limit.max : limit.max - 1, offset, &last) || last > mask) {
+        return std::nullopt;
+    }
+    return offset;
+}
+
+void CheckElimination::HoistIntoGuard(Loop* loop, const std::vector<HoistedCheck> &checks) {
+    auto *header = loop->GetHeader();
+    auto *preheader = InductionAnalysis::GetPreheader(loop);
+    auto *branch = static_cast<CjmpInstr*>(header->GetLastInstr());
+    auto *cmp = branch->GetInputs()[0].GetValue();
+
+    IrBuilder builder(graph_);
+    auto *guard = builder.CreateBB();
+    auto *hoisted = builder.CreateBB();
+    auto *join = builder.CreateBB();
+
+    std::vector<std::pair<Instruction*, Instruction*>> initValues;
+    for(auto *instr = header->GetFirstInstr(); instr != nullptr && instr->IsPhi(); instr = instr->GetNext()) {
+        initValues.emplace_back(instr, static_cast<PhiInstr*>(instr)->GetPhiInput(preheader));
+    }
+    graph_->RemoveInstruction(preheader->GetLastInstr());
+    preheader->RemoveSuccessor(header);
+    header->RemovePredecessor(preheader);
+    builder.SetBasicBlockScope(preheader);
+    builder.CreateJmp(guard);
+
+    // Values of the first iteration.
+    auto getEntryValue = [&builder, &initValues, loop](Instruction* value) {
+        for(auto &[phi, init]: initValues) {
+            if(phi == value) {
+                return init;
+            }
+        }
+        return Rematerialize(builder, loop, value);
+    };
+
+    builder.SetBasicBlockScope(guard);
+    auto *test = builder.CreateCmp(getEntryValue(cmp->GetInputs()[0].GetValue()),
+                                   getEntryValue(cmp->GetInputs()[1].GetValue()));
+    bool entersOnTrue = loop->Contains(branch->GetTrueBranchBB());
+    auto *ifTrue = entersOnTrue ? hoisted : join;
+    auto *ifFalse = entersOnTrue ? join : hoisted;
+    if(branch->GetOpType() == OpType::JA) {
+        builder.CreateJa(test, ifTrue, ifFalse);
+    } else if(branch->GetOpType() == OpType::JAE) {
+        builder.CreateJae(test, ifTrue, ifFalse);
+    } else {
+        builder.CreateJe(test, ifTrue, ifFalse);
+    }
+
+    builder.SetBasicBlockScope(hoisted);
+    for(auto &[check, indexOffset]: checks) {
+        auto *lhs = check->GetInputs()[0].GetValue();
+        auto *rhs = getEntryValue(check->GetInputs()[1].GetValue());
+        if(indexOffset.has_value()) {
+            auto type = cmp->GetInputs()[0].GetValue()->GetResultType();
+            lhs = getEntryValue(cmp->GetInputs()[1].GetValue());
+            if(branch->GetOpType() == OpType::JAE) {
+                lhs = builder.CreateSub(type, lhs, builder.CreateConstant(uint64_t{1}, type));
+            }
+            if(*indexOffset != 0) {
+                lhs = builder.CreateAdd(type, lhs, builder.CreateConstant(*indexOffset, type));
+            }
+        } else {
+            lhs = getEntryValue(lhs);
+        }
+        CreateCheck(builder, check, lhs, rhs);
+        graph_->RemoveInstruction(check);
+        ++hoisted_;
+    }
+    builder.CreateJmp(join);
+
+    builder.SetBasicBlockScope(join);
+    builder.CreateJmp(header);
+    for(auto &[phi, init]: initValues) {
+        phi->AddInput(init);
+    }
+}
+
+bool CheckElimination::HasSingleExit(Loop* loop) const {
+    for(auto *block: loop->GetBlocks()) {
+        if(block == loop->GetHeader()) {
+            continue;
+        }
+        auto &succs = block->GetSuccessors();
+        if(succs.empty()) {
+            return false;
+        }
+        for(auto *succ: succs) {
+            if(!loop->Contains(succ)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,48 @@
+#ifndef IR_CHECK_ELIMINATION_HPP
+#define IR_CHECK_ELIMINATION_HPP
+
+#include "RangeAnalysis/rangeanalysis.hpp"
+#include "irbuilder.hpp"
+
+#include <vector>
+
+// Removes bounds and overflow checks that the range analysis proves to pass,
+// and overflow checks repeating a dominating one. Checks left in a loop whose
+// only exit is the header are hoisted when a single check before the loop
+// fails exactly when one of theirs would:
+//  - a check on invariant values in the header goes to the preheader;
+//  - in a loop without inner loops, a check in a block that runs on every
+//    iteration goes to a block that only runs when the loop is entered. Its
+//    operands are invariant, or it is a bounds check of `iv + c` against an
+//    invariant length where iv counts by one up to an invariant bound; the
+//    hoisted check then tests the index of the last iteration.
+// Every failing check traps the same way, so their order does not matter.
+class CheckElimination final {
+public:
+    CheckElimination(Graph* graph): graph_(graph) {}
+
+    // Returns the number of removed checks, hoisted ones excluded.
+    size_t Run();
+    size_t GetHoistedCount() const;
+
+private:
+    struct HoistedCheck {
+        Instruction* check = nullptr;
+        // Constant added to the last value of the counter to get the index;
+        // unset for checks on invariant operands.
+        std::optional<uint64_t> indexOffset;
+    };
+
+    bool IsRedundant(const RangeAnalysis &analysis, Instruction* check,
+                     const std::vector<Instruction*> &kept) const;
+    void HoistChecks(const RangeAnalysis &analysis, const std::vector<BasicBlock*> &rpo, Loop* loop);
+    std::optional<uint64_t> GetIndexOffset(const RangeAnalysis &analysis, Loop* loop, Instruction* check) const;
+    void HoistIntoGuard(Loop* loop, const std::vector<HoistedCheck> &checks);
+    bool HasSingleExit(Loop* loop) const;
+
+private:
+    Graph* graph_ = nullptr;
+    size_t hoisted_ = 0;
+};
+
+#endif  // IR_CHECK_ELIMINATION_HPP
@@ -0,0 +1,421 @@
+#include "RangeAnalysis/rangeanalysis.hpp"
+#include "DFS/rpo.hpp"
+#include "Instr/datatraits.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+bool IsSignedType(DataType type) {
+    return type == DataType::I8 || type == DataType::I16 || type == DataType::I32 || type == DataType::I64;
+}
+
+bool IsUnsignedType(DataType type) {
+    return type == DataType::U8 || type == DataType::U16 || type == DataType::U32 || type == DataType::U64;
+}
+
+bool IsIntegerType(DataType type) {
+    return IsSignedType(type) || IsUnsignedType(type);
+}
+
+uint64_t GetTypeMask(DataType type) {
+    auto bits = GetElementBits(type);
+    return bits >= 64 ? ~0ULL : (1ULL << bits) - 1;
+}
+
+// Signed bounds of a range that does not cross from non-negative to negative values.
+std::optional<std::pair<int64_t, int64_t>> GetSignedBounds(const ValueRange &range) {
+    auto min = static_cast<int64_t>(range.min);
+    auto max = static_cast<int64_t>(range.max);
+    if(min > max) {
+        return std::nullopt;
+    }
+    return std::make_pair(min, max);
+}
+
+template <typename T>
+bool Apply(OpType op, T lhs, T rhs, T* result) {
+    switch(op) {
+        case OpType::ADD:
+            return !__builtin_add_overflow(lhs, rhs, result);
+        case OpType::SUB:
+            return !__builtin_sub_overflow(lhs, rhs, result);
+        default:
+            return !__builtin_mul_overflow(lhs, rhs, result);
+    }
+}
+
+}  // namespace
+
+ValueRange ValueRange::OfType(DataType type) {
+    return IsUnsignedType(type) ? ValueRange{0, GetTypeMask(type)} : ValueRange{};
+}
+
+ValueRange ValueRange::Intersect(const ValueRange &other) const {
+    return ValueRange{std::max(min, other.min), std::min(max, other.max)};
+}
+
+ValueRange ValueRange::Union(const ValueRange &other) const {
+    if(IsEmpty()) {
+        return other;
+    }
+    if(other.IsEmpty()) {
+        return *this;
+    }
+    return ValueRange{std::min(min, other.min), std::max(max, other.max)};
+}
+
+template <typename Callback>
+void RangeAnalysis::ForEachFact(Instruction* at, Callback callback) const {
+    auto *block = at->GetParentBB();
+    auto &domTree = GetDominatorTree();
+    for(auto *current = block; current != nullptr; current = domTree.GetImmediateDominator(current)) {
+        auto it = facts_.find(current);
+        if(it == facts_.end()) {
+            continue;
+        }
+        for(auto &fact: it->second) {
+            if(fact.after == nullptr || current != block || IsBefore(fact.after, at)) {
+                callback(fact);
+            }
+        }
+    }
+}
+
+void RangeAnalysis::Analyze() {
+    induction_.Analyze();
+    ranges_.clear();
+    facts_.clear();
+    order_.clear();
+    visited_.clear();
+
+    auto rpo = RPO(graph_).Run();
+    for(auto *block: rpo) {
+        size_t position = 0;
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            order_[instr] = position++;
+        }
+    }
+
+    for(auto *block: rpo) {
+        AddEdgeFacts(block);
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            if(IsIntegerType(instr->GetResultType())) {
+                ranges_[instr] = ComputeRange(instr);
+            }
+            if(instr->GetOpType() == OpType::BOUNDS_CHECK) {
+                auto &inputs = instr->GetInputs();
+                AddOrderFacts(block, inputs[0].GetValue(), inputs[1].GetValue(), true, instr, instr);
+            }
+        }
+        visited_.insert(block);
+    }
+}
+
+const InductionAnalysis& RangeAnalysis::GetInductionAnalysis() const {
+    return induction_;
+}
+
+const DominatorTree& RangeAnalysis::GetDominatorTree() const {
+    return induction_.GetLoopAnalyzer().GetDominatorTree();
+}
+
+ValueRange RangeAnalysis::GetRange(Instruction* value) const {
+    if(auto *constant = value->As<ConstantInstr>()) {
+        return ValueRange::Constant(InductionAnalysis::GetConstantValue(constant));
+    }
+    auto it = ranges_.find(value);
+    return it == ranges_.end() ? ValueRange::OfType(value->GetResultType()) : it->second;
+}
+
+ValueRange RangeAnalysis::GetRange(Instruction* value, Instruction* at) const {
+    auto range = GetRange(value);
+    ForEachFact(at, [&range, value](const Fact &fact) {
+        if(fact.value == value && fact.bound == nullptr) {
+            range = range.Intersect(fact.range);
+        }
+    });
+    return range;
+}
+
+bool RangeAnalysis::IsKnownBelow(Instruction* lhs, Instruction* rhs, Instruction* at) const {
+    auto lhsRange = GetRange(lhs, at);
+    auto rhsRange = GetRange(rhs, at);
+    if(lhsRange.IsEmpty() || rhsRange.IsEmpty() || lhsRange.max < rhsRange.min) {
+        return true;
+    }
+
+    bool isKnown = false;
+    ForEachFact(at, [&isKnown, lhs, rhs](const Fact &fact) {
+        isKnown = isKnown || (fact.value == lhs && fact.bound == rhs);
+    });
+    return isKnown;
+}
+
+bool RangeAnalysis::Dominates(Instruction* dominator, Instruction* dominated) const {
+    auto *block = dominator->GetParentBB();
+    if(block == dominated->GetParentBB()) {
+        return IsBefore(dominator, dominated);
+    }
+    return GetDominatorTree().Dominates(block, dominated->GetParentBB());
+}
+
+ValueRange RangeAnalysis::CastRange(const ValueRange &range, DataType type) {
+    if(range.IsEmpty() || !IsIntegerType(type)) {
+        return range;
+    }
+    auto mask = GetTypeMask(type);
+    bool isSigned = IsSignedType(type);
+    // Values that the type can hold stay the same.
+    if(range.max <= (isSigned ? mask >> 1 : mask) || (isSigned && range.min >= ~(mask >> 1))) {
+        return range;
+    }
+    return ValueRange::OfType(type);
+}
+
+std::optional<ValueRange> RangeAnalysis::GetExactRange(OpType op, DataType type, const ValueRange &lhs,
+                                                       const ValueRange &rhs) {
+    if(lhs.IsEmpty() || rhs.IsEmpty()) {
+        return ValueRange::Empty();
+    }
+
+    if(IsUnsignedType(type)) {
+        uint64_t min = 0;
+        uint64_t max = 0;
+        bool fits = op == OpType::SUB ? Apply(op, lhs.min, rhs.max, &min) && Apply(op, lhs.max, rhs.min, &max) :
+                                        Apply(op, lhs.min, rhs.min, &min) && Apply(op, lhs.max, rhs.max, &max);
+        if(!fits || max > GetTypeMask(type)) {
+            return std::nullopt;
+        }
+        return ValueRange{min, max};
+    }
+
+    auto lhsBounds = GetSignedBounds(lhs);
+    auto rhsBounds = GetSignedBounds(rhs);
+    if(!IsSignedType(type) || !lhsBounds || !rhsBounds) {
+        return std::nullopt;
+    }
+    auto [lhsMin, lhsMax] = *lhsBounds;
+    auto [rhsMin, rhsMax] = *rhsBounds;
+    std::vector<std::pair<int64_t, int64_t>> corners;
+    if(op == OpType::ADD) {
+        corners = {{lhsMin, rhsMin}, {lhsMax, rhsMax}};
+    } else if(op == OpType::SUB) {
+        corners = {{lhsMin, rhsMax}, {lhsMax, rhsMin}};
+    } else {
+        corners = {{lhsMin, rhsMin}, {lhsMin, rhsMax}, {lhsMax, rhsMin}, {lhsMax, rhsMax}};
+    }
+
+    auto typeMax = static_cast<int64_t>(GetTypeMask(type) >> 1);
+    int64_t min = typeMax;
+    int64_t max = -typeMax - 1;
+    for(auto [first, second]: corners) {
+        int64_t value = 0;
+        if(!Apply(op, first, second, &value) || value > typeMax || value < -typeMax - 1) {
+            return std::nullopt;
+        }
+        min = std::min(min, value);
+        max = std::max(max, value);
+    }
+    if(min < 0 && max >= 0) {
+        return ValueRange{};
+    }
+    return ValueRange{static_cast<uint64_t>(min), static_cast<uint64_t>(max)};
+}
+
+void RangeAnalysis::AddEdgeFacts(BasicBlock* block) {
+    auto &preds = block->GetPredecessors();
+    if(preds.size() != 1 || visited_.count(preds[0]) == 0 || preds[0]->GetLastInstr() == nullptr) {
+        return;
+    }
+    auto *branch = preds[0]->GetLastInstr()->As<CjmpInstr>();
+    if(branch == nullptr || branch->GetTrueBranchBB() == branch->GetFalseBranchBB()) {
+        return;
+    }
+    auto *cmp = branch->GetInputs()[0].GetValue();
+    if(cmp->GetOpType() != OpType::CMP) {
+        return;
+    }
+
+    auto *lhs = cmp->GetInputs()[0].GetValue();
+    auto *rhs = cmp->GetInputs()[1].GetValue();
+    bool isTaken = branch->GetTrueBranchBB() == block;
+    switch(branch->GetOpType()) {
+        case OpType::JA:
+            if(isTaken) {
+                AddOrderFacts(block, rhs, lhs, true, branch, nullptr);
+            } else {
+                AddOrderFacts(block, lhs, rhs, false, branch, nullptr);
+            }
+            break;
+        case OpType::JAE:
+            if(isTaken) {
+                AddOrderFacts(block, rhs, lhs, false, branch, nullptr);
+            } else {
+                AddOrderFacts(block, lhs, rhs, true, branch, nullptr);
+            }
+            break;
+        case OpType::JE:
+            if(isTaken) {
+                auto lhsRange = GetRange(lhs, branch);
+                auto rhsRange = GetRange(rhs, branch);
+                facts_[block].push_back(Fact{lhs, rhsRange, nullptr, nullptr});
+                facts_[block].push_back(Fact{rhs, lhsRange, nullptr, nullptr});
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void RangeAnalysis::AddOrderFacts(BasicBlock* block, Instruction* lhs, Instruction* rhs, bool isStrict,
+                                  Instruction* at, Instruction* after) {
+    auto lhsRange = GetRange(lhs, at);
+    auto rhsRange = GetRange(rhs, at);
+    ValueRange below{0, rhsRange.max};
+    ValueRange above{lhsRange.min, ~0ULL};
+    auto &facts = facts_[block];
+    if(isStrict) {
+        below = rhsRange.max == 0 ? ValueRange::Empty() : ValueRange{0, rhsRange.max - 1};
+        above = lhsRange.min == ~0ULL ? ValueRange::Empty() : ValueRange{lhsRange.min + 1, ~0ULL};
+        facts.push_back(Fact{lhs, ValueRange{}, rhs, after});
+    }
+    facts.push_back(Fact{lhs, below, nullptr, after});
+    facts.push_back(Fact{rhs, above, nullptr, after});
+}
+
+ValueRange RangeAnalysis::ComputeRange(Instruction* instr) const {
+    auto type = instr->GetResultType();
+    auto &inputs = instr->GetInputs();
+    auto input = [this, instr, &inputs, type](size_t idx) {
+        return CastRange(GetRange(inputs[idx].GetValue(), instr), type);
+    };
+
+    switch(instr->GetOpType()) {
+        case OpType::CONST:
+            return GetRange(instr);
+        case OpType::CMP:
+            return ValueRange{0, 2};
+        case OpType::ADD:
+        case OpType::SUB:
+        case OpType::MUL:
+            return GetExactRange(instr->GetOpType(), type, input(0), input(1)).value_or(ValueRange::OfType(type));
+        case OpType::AND: {
+            // Both operands are normalized, and so is their conjunction.
+            auto lhs = input(0);
+            auto rhs = input(1);
+            if(lhs.IsEmpty() || rhs.IsEmpty()) {
+                return ValueRange::Empty();
+            }
+            return ValueRange{0, std::min(lhs.max, rhs.max)};
+        }
+        case OpType::DIV: {
+            if(!IsUnsignedType(type)) {
+                return ValueRange::OfType(type);
+            }
+            auto lhs = input(0);
+            auto rhs = input(1);
+            if(lhs.IsEmpty() || rhs.IsEmpty() || rhs.max == 0) {
+                return ValueRange::Empty();
+            }
+            return ValueRange{lhs.min / rhs.max, lhs.max / std::max<uint64_t>(rhs.min, 1)};
+        }
+        case OpType::MOD: {
+            if(!IsUnsignedType(type)) {
+                return ValueRange::OfType(type);
+            }
+            auto lhs = input(0);
+            auto rhs = input(1);
+            if(lhs.IsEmpty() || rhs.IsEmpty() || rhs.max == 0) {
+                return ValueRange::Empty();
+            }
+            return ValueRange{0, std::min(lhs.max, rhs.max - 1)};
+        }
+        case OpType::MOV:
+        case OpType::CAST:
+            return input(0);
+        case OpType::PHI:
+            return ComputePhiRange(static_cast<PhiInstr*>(instr));
+        default:
+            return ValueRange::OfType(type);
+    }
+}
+
+ValueRange RangeAnalysis::ComputePhiRange(PhiInstr* phi) const {
+    if(auto range = GetInductionRange(phi)) {
+        return *range;
+    }
+
+    auto type = phi->GetResultType();
+    auto &inputs = phi->GetInputs();
+    auto range = ValueRange::Empty();
+    for(size_t idx = 0; idx < inputs.size(); ++idx) {
+        // Values coming around a back edge are not known yet.
+        auto *pred = phi->GetPhiInputBB(idx);
+        if(visited_.count(pred) == 0) {
+            return ValueRange::OfType(type);
+        }
+        auto *value = inputs[idx].GetValue();
+        auto *end = pred->GetLastInstr();
+        range = range.Union(CastRange(end == nullptr ? GetRange(value) : GetRange(value, end), type));
+    }
+    return inputs.empty() ? ValueRange::OfType(type) : range;
+}
+
+std::optional<ValueRange> RangeAnalysis::GetInductionRange(Instruction* phi) const {
+    auto *iv = induction_.GetInductionVariable(phi);
+    auto type = phi->GetResultType();
+    if(iv == nullptr || !iv->IsBasic() || iv->stepValue != nullptr || !IsUnsignedType(type)) {
+        return std::nullopt;
+    }
+
+    auto *loop = iv->loop;
+    auto *last = loop->GetHeader()->GetLastInstr();
+    auto *branch = last == nullptr ? nullptr : last->As<CjmpInstr>();
+    if(branch == nullptr || (branch->GetOpType() != OpType::JA && branch->GetOpType() != OpType::JAE) ||
+       loop->Contains(branch->GetTrueBranchBB()) || !loop->Contains(branch->GetFalseBranchBB())) {
+        return std::nullopt;
+    }
+    auto *cmp = branch->GetInputs()[0].GetValue();
+    if(cmp->GetOpType() != OpType::CMP || cmp->GetInputs()[0].GetValue() != phi) {
+        return std::nullopt;
+    }
+    auto *bound = cmp->GetInputs()[1].GetValue();
+    if(!bound->Is<ConstantInstr>() && loop->Contains(bound->GetParentBB())) {
+        return std::nullopt;
+    }
+
+    auto *preheaderEnd = InductionAnalysis::GetPreheader(loop)->GetLastInstr();
+    if(preheaderEnd == nullptr) {
+        return std::nullopt;
+    }
+    auto init = CastRange(GetRange(iv->init, preheaderEnd), type);
+    auto limit = GetRange(bound, preheaderEnd);
+    auto mask = GetTypeMask(type);
+    uint64_t step = iv->step & mask;
+    if(init.IsEmpty() || limit.IsEmpty() || step == 0) {
+        return std::nullopt;
+    }
+
+    // The body only runs for values up to the last one below the exit, so
+    // the back edge brings at most that plus the step.
+    bool isStrict = branch->GetOpType() == OpType::JA;
+    if(!isStrict && limit.max == 0) {
+        return init;
+    }
+    uint64_t next = 0;
+    if(__builtin_add_overflow(isStrict ? limit.max : limit.max - 1, step, &next) || next > mask) {
+        return std::nullopt;
+    }
+    return ValueRange{init.min, std::max(init.max, next)};
+}
+
+bool RangeAnalysis::IsBefore(Instruction* first, Instruction* second) const {
+    auto firstIt = order_.find(first);
+    auto secondIt = order_.find(second);
+    if(firstIt == order_.end() || secondIt == order_.end()) {
+        return false;
+    }
+    return firstIt->second < secondIt->second;
+}
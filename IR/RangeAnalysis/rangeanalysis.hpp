@@ -0,0 +1,101 @@
+#ifndef IR_RANGE_ANALYSIS_HPP
+#define IR_RANGE_ANALYSIS_HPP
+
+#include "Induction/inductionanalysis.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Interval of the values an instruction may take, as the interpreter keeps
+// them: 64-bit unsigned numbers with signed types sign-extended. Intervals do
+// not wrap around, so a signed value that may or may not be negative spans all
+// 64-bit numbers. An empty interval marks code that cannot run.
+struct ValueRange {
+    uint64_t min = 0;
+    uint64_t max = ~0ULL;
+
+    static ValueRange Empty() {
+        return ValueRange{1, 0};
+    }
+    static ValueRange Constant(uint64_t value) {
+        return ValueRange{value, value};
+    }
+    // Every value of the type.
+    static ValueRange OfType(DataType type);
+
+    bool IsEmpty() const {
+        return min > max;
+    }
+    ValueRange Intersect(const ValueRange &other) const;
+    ValueRange Union(const ValueRange &other) const;
+
+    bool operator==(const ValueRange &other) const = default;
+};
+
+// Value ranges over SSA. Each value gets a range where it is defined, computed
+// from the ranges of its inputs at that point; header phis of counted loops
+// take theirs from the induction variable, other phis on back edges fall back
+// to their type. Uses can be refined further: a block entered only through a
+// conditional jump on `cmp a, b` knows how a and b compare, and so does every
+// block it dominates, and the code after a bounds check knows the index is
+// below the length.
+class RangeAnalysis final {
+public:
+    RangeAnalysis(Graph* graph): graph_(graph), induction_(graph) {}
+
+    void Analyze();
+
+    const InductionAnalysis& GetInductionAnalysis() const;
+    const DominatorTree& GetDominatorTree() const;
+
+    ValueRange GetRange(Instruction* value) const;
+    // Range of `value` as seen right before `at`.
+    ValueRange GetRange(Instruction* value, Instruction* at) const;
+    // Whether `lhs` < `rhs` as unsigned values holds right before `at`.
+    bool IsKnownBelow(Instruction* lhs, Instruction* rhs, Instruction* at) const;
+    bool Dominates(Instruction* dominator, Instruction* dominated) const;
+
+    // Values of the range converted to `type`.
+    static ValueRange CastRange(const ValueRange &range, DataType type);
+    // Range of `lhs op rhs` (ADD, SUB or MUL) for operands of `type`, or
+    // nullopt if the exact result may not fit the type.
+    static std::optional<ValueRange> GetExactRange(OpType op, DataType type, const ValueRange &lhs,
+                                                   const ValueRange &rhs);
+
+private:
+    // `value` is within `range`, or below `bound` when it is set. Facts come
+    // from the edge into the block, or hold after `after` when it is set.
+    struct Fact {
+        Instruction* value = nullptr;
+        ValueRange range;
+        Instruction* bound = nullptr;
+        Instruction* after = nullptr;
+    };
+
+    void AddEdgeFacts(BasicBlock* block);
+    // `lhs` < `rhs`, or `lhs` <= `rhs` unless strict, with the ranges taken at `at`.
+    void AddOrderFacts(BasicBlock* block, Instruction* lhs, Instruction* rhs, bool isStrict,
+                       Instruction* at, Instruction* after);
+    ValueRange ComputeRange(Instruction* instr) const;
+    ValueRange ComputePhiRange(PhiInstr* phi) const;
+    std::optional<ValueRange> GetInductionRange(Instruction* phi) const;
+    // Visits the facts that hold right before `at`.
+    template <typename Callback>
+    void ForEachFact(Instruction* at, Callback callback) const;
+    bool IsBefore(Instruction* first, Instruction* second) const;
+
+private:
+    Graph* graph_ = nullptr;
+    InductionAnalysis induction_;
+
+    std::unordered_map<Instruction*, ValueRange> ranges_;
+    std::unordered_map<BasicBlock*, std::vector<Fact>> facts_;
+    std::unordered_set<BasicBlock*> visited_;
+    // Position of every instruction in its block.
+    std::unordered_map<Instruction*, size_t> order_;
+};
+
+#endif  // IR_RANGE_ANALYSIS_HPP
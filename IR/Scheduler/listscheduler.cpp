@@ -0,0 +1,257 @@
+#include "Scheduler/listscheduler.hpp"
+
+#include "BasicBlock/basicblock.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+
+namespace {
+
+bool IsTerminator(Instruction* instr) {
+    return ::IsTerminator(instr->GetOpType());
+}
+
+// Instructions with side effects are never reordered with each other: guards
+// deoptimize, DIV and MOD trap on zero, bounds and overflow checks trap, and
+// loads and stores of fields and raw memory keep their order. Every LOAD is
+// kept in order this way, even where AliasAnalysis proves NO_ALIAS with the
+// neighbouring stores.
+bool IsBarrier(Instruction* instr) {
+    return HasSideEffects(instr->GetOpType());
+}
+
+}  // namespace
+
+LatencyModel::LatencyModel() {
+    latencies_.fill(1);
+    SetLatency(OpType::MUL, 3);
+    SetLatency(OpType::MULH, 3);
+    SetLatency(OpType::DIV, 26);
+    SetLatency(OpType::MOD, 26);
+    SetLatency(OpType::PHI, 0);
+    SetLatency(OpType::PRM, 0);
+    SetLatency(OpType::CONST, 0);
+}
+
+void LatencyModel::SetLatency(OpType op, uint32_t cycles) {
+    latencies_[static_cast<size_t>(op)] = cycles;
+}
+
+uint32_t LatencyModel::GetLatency(OpType op) const {
+    return latencies_[static_cast<size_t>(op)];
+}
+
+uint32_t EstimateBlockCycles(BasicBlock* block, const LatencyModel &model) {
+    std::unordered_map<Instruction*, uint32_t> readyCycle;
+    uint32_t cycle = 0;
+    uint32_t finish = 0;
+
+    for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+        if(instr->IsPhi()) {
+            continue;
+        }
+        for(auto &input: instr->GetInputs()) {
+            auto it = readyCycle.find(input.GetValue());
+            if(it != readyCycle.end()) {
+                cycle = std::max(cycle, it->second);
+            }
+        }
+        uint32_t ready = cycle + model.GetLatency(instr->GetOpType());
+        readyCycle[instr] = ready;
+        finish = std::max(finish, ready);
+        ++cycle;
+    }
+    return std::max(finish, cycle);
+}
+
+void ListScheduler::Run() {
+    for(auto &block: graph_->GetBlocks()) {
+        ScheduleBlock(block.get());
+    }
+}
+
+std::vector<ListScheduler::Node> ListScheduler::BuildDag(BasicBlock* block, Instruction* terminator) const {
+    std::vector<Node> dag;
+    std::unordered_map<Instruction*, size_t> nodeIdx;
+
+    for(auto *instr = block->GetFirstInstr(); instr != terminator; instr = instr->GetNext()) {
+        if(!instr->IsPhi()) {
+            nodeIdx[instr] = dag.size();
+            dag.push_back(Node {instr, {}, 0, 0, 0});
+        }
+    }
+
+    auto addEdge = [&dag](size_t from, size_t to) {
+        auto &succs = dag[from].succs;
+        if(std::find(succs.begin(), succs.end(), to) == succs.end()) {
+            succs.push_back(to);
+            ++dag[to].predsLeft;
+        }
+    };
+
+    size_t lastBarrier = dag.size();
+    for(size_t idx = 0; idx < dag.size(); ++idx) {
+        for(auto &input: dag[idx].instr->GetInputs()) {
+            auto it = nodeIdx.find(input.GetValue());
+            if(it != nodeIdx.end()) {
+                addEdge(it->second, idx);
+            }
+        }
+        if(IsBarrier(dag[idx].instr)) {
+            if(lastBarrier != dag.size()) {
+                addEdge(lastBarrier, idx);
+            }
+            lastBarrier = idx;
+        }
+    }
+
+    // Successors always come later in the original order, so a backward walk
+    // sees them first.
+    for(size_t idx = dag.size(); idx-- > 0;) {
+        uint32_t succHeight = 0;
+        for(auto succ: dag[idx].succs) {
+            succHeight = std::max(succHeight, dag[succ].height);
+        }
+        dag[idx].height = model_.GetLatency(dag[idx].instr->GetOpType()) + succHeight;
+    }
+    return dag;
+}
+
+int ListScheduler::GetPressureDelta(Instruction* instr, BasicBlock* block,
+                                    const std::unordered_map<Instruction*, size_t> &usesLeft) const {
+    auto &liveOut = liveness_.GetLiveOut(block);
+    int delta = 0;
+
+    auto defUses = usesLeft.find(instr);
+    if((defUses != usesLeft.end() && defUses->second != 0) || liveOut.count(instr) != 0) {
+        ++delta;
+    }
+
+    auto &inputs = instr->GetInputs();
+    for(size_t idx = 0; idx < inputs.size(); ++idx) {
+        auto *input = inputs[idx].GetValue();
+        bool seen = std::any_of(inputs.begin(), inputs.begin() + idx, [input](auto &prev) {
+            return prev.GetValue() == input;
+        });
+        if(seen || input->GetOpType() == OpType::CONST || liveOut.count(input) != 0) {
+            continue;
+        }
+        size_t occurrences = std::count_if(inputs.begin(), inputs.end(), [input](auto &other) {
+            return other.GetValue() == input;
+        });
+        if(usesLeft.at(input) == occurrences) {
+            --delta;
+        }
+    }
+    return delta;
+}
+
+void ListScheduler::ScheduleBlock(BasicBlock* block) {
+    if(!livenessReady_) {
+        liveness_.Analyze();
+        livenessReady_ = true;
+    }
+
+    auto *terminator = block->GetLastInstr();
+    if(terminator != nullptr && !IsTerminator(terminator)) {
+        terminator = nullptr;
+    }
+
+    auto dag = BuildDag(block, terminator);
+    if(dag.size() < 2) {
+        return;
+    }
+
+    std::unordered_map<Instruction*, size_t> usesLeft;
+    for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+        if(instr->IsPhi()) {
+            continue;
+        }
+        for(auto &input: instr->GetInputs()) {
+            ++usesLeft[input.GetValue()];
+        }
+    }
+
+    std::vector<size_t> ready;
+    for(size_t idx = 0; idx < dag.size(); ++idx) {
+        if(dag[idx].predsLeft == 0) {
+            ready.push_back(idx);
+        }
+    }
+
+    std::vector<Instruction*> order;
+    order.reserve(dag.size());
+    size_t pressure = liveness_.GetLiveIn(block).size();
+    uint32_t cycle = 0;
+
+    while(!ready.empty()) {
+        uint32_t firstReady = std::numeric_limits<uint32_t>::max();
+        for(auto idx: ready) {
+            firstReady = std::min(firstReady, dag[idx].earliestCycle);
+        }
+        cycle = std::max(cycle, firstReady);
+
+        bool relievePressure = pressure >= registersCount_;
+        auto best = ready.end();
+        int bestDelta = 0;
+        for(auto it = ready.begin(); it != ready.end(); ++it) {
+            auto &node = dag[*it];
+            if(node.earliestCycle > cycle) {
+                continue;
+            }
+            int delta = GetPressureDelta(node.instr, block, usesLeft);
+            if(best == ready.end()) {
+                best = it;
+                bestDelta = delta;
+                continue;
+            }
+
+            auto &bestNode = dag[*best];
+            bool better = false;
+            if(relievePressure && delta != bestDelta) {
+                better = delta < bestDelta;
+            } else if(node.height != bestNode.height) {
+                better = node.height > bestNode.height;
+            } else if(delta != bestDelta) {
+                better = delta < bestDelta;
+            } else {
+                better = *it < *best;
+            }
+
+            if(better) {
+                best = it;
+                bestDelta = delta;
+            }
+        }
+
+        size_t idx = *best;
+        ready.erase(best);
+
+        auto *instr = dag[idx].instr;
+        order.push_back(instr);
+        pressure = static_cast<size_t>(std::max<int64_t>(0, static_cast<int64_t>(pressure) + bestDelta));
+        for(auto &input: instr->GetInputs()) {
+            --usesLeft[input.GetValue()];
+        }
+
+        uint32_t doneCycle = cycle + model_.GetLatency(instr->GetOpType());
+        for(auto succ: dag[idx].succs) {
+            dag[succ].earliestCycle = std::max(dag[succ].earliestCycle, doneCycle);
+            if(--dag[succ].predsLeft == 0) {
+                ready.push_back(succ);
+            }
+        }
+        ++cycle;
+    }
+
+    for(auto *instr: order) {
+        block->RemoveInstruction(instr);
+        if(terminator != nullptr) {
+            block->InsertBefore(terminator, instr);
+        } else {
+            block->PushInstruction(instr);
+            instr->SetParentBB(block);
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef IR_LIST_SCHEDULER_HPP
+#define IR_LIST_SCHEDULER_HPP
+
+#include "Graph/graph.hpp"
+#include "Liveness/liveness.hpp"
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Result latency of every opcode in cycles.
+class LatencyModel final {
+public:
+    LatencyModel();
+
+    void SetLatency(OpType op, uint32_t cycles);
+    uint32_t GetLatency(OpType op) const;
+
+private:
+    std::array<uint32_t, OPCODES_COUNT> latencies_ {};
+};
+
+// Cycles an in-order single-issue machine spends on the block when every
+// instruction waits for its inputs.
+uint32_t EstimateBlockCycles(BasicBlock* block, const LatencyModel &model);
+
+// Top-down list scheduler. Phis stay at the top of the block, the terminator
+// stays at the bottom, guards and divisions keep their relative order. Ready
+// instructions are picked by critical path height; once the number of live
+// values reaches the register limit, instructions that free registers win.
+class ListScheduler final {
+public:
+    ListScheduler(Graph* graph, LatencyModel model = LatencyModel(), size_t registersCount = 16):
+        graph_(graph), model_(model), registersCount_(registersCount), liveness_(graph) {}
+
+    void Run();
+    void ScheduleBlock(BasicBlock* block);
+
+private:
+    struct Node {
+        Instruction* instr = nullptr;
+        std::vector<size_t> succs;
+        size_t predsLeft = 0;
+        uint32_t height = 0;
+        uint32_t earliestCycle = 0;
+    };
+
+    std::vector<Node> BuildDag(BasicBlock* block, Instruction* terminator) const;
+    int GetPressureDelta(Instruction* instr, BasicBlock* block,
+                         const std::unordered_map<Instruction*, size_t> &usesLeft) const;
+
+private:
+    Graph* graph_ = nullptr;
+    LatencyModel model_;
+    size_t registersCount_ = 0;
+
+    LivenessAnalyzer liveness_;
+    bool livenessReady_ = false;
+};
+
+#endif  // IR_LIST_SCHEDULER_HPP
@@ -0,0 +1,583 @@
+#include "Serialization/graphserializer.hpp"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char GRAPH_MAGIC[8] = "IRGRAPH";
+constexpr uint32_t NO_ID = ~0U;
+
+// Number of value operands an opcode must have, -1 for any, or -2 when the
+// opcode cannot be stored: guards carry block state that the format does not
+// describe, MOV and CAST only exist after lowering, vector nodes only after
+// vectorization.
+int GetExpectedOperandsCount(OpType op) {
+    switch(op) {
+        case OpType::UNDEFINED:
+        case OpType::MOV:
+        case OpType::CAST:
+        case OpType::DEOPT:
+        case OpType::SPLAT:
+        case OpType::IOTA:
+        case OpType::REDUCE:
+            return -2;
+        default:
+            return GetOperandsCount(op);
+    }
+}
+
+bool HasPayload(OpType op) {
+    switch(op) {
+        case OpType::CONST:
+        case OpType::PRM:
+        case OpType::JMP:
+        case OpType::JA:
+        case OpType::JAE:
+        case OpType::JE:
+        case OpType::OVERFLOW_CHECK:
+        case OpType::NEW_OBJECT:
+        case OpType::LOAD_FIELD:
+        case OpType::STORE_FIELD:
+        case OpType::LOAD:
+        case OpType::STORE:
+        case OpType::SELECT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+template <typename T>
+void Append(std::vector<uint8_t> &buffer, const T* data, size_t count) {
+    auto *bytes = reinterpret_cast<const uint8_t*>(data);
+    buffer.insert(buffer.end(), bytes, bytes + count * sizeof(T));
+}
+
+uint64_t GetBlockId(BasicBlock* block) {
+    return block->GetId();
+}
+
+}  // namespace
+
+std::optional<std::vector<uint8_t>> GraphSerializer::Run() {
+    auto &blocks = graph_->GetBlocks();
+    auto &instructions = graph_->GetInstructions();
+
+    std::vector<BlockRecord> blockRecords;
+    std::vector<InstrRecord> instrRecords;
+    std::vector<uint32_t> words;
+    std::vector<uint32_t> edges;
+    std::vector<uint32_t> order;
+
+    // Removed instructions stay in the graph without a block or inputs. They
+    // are left out and the live ones renumbered densely in creation order.
+    std::vector<uint32_t> denseIds(instructions.size(), NO_ID);
+    uint32_t liveCount = 0;
+    for(auto &instr: instructions) {
+        if(instr->GetParentBB() != nullptr) {
+            denseIds[instr->GetId()] = liveCount++;
+        }
+    }
+
+    for(auto &block: blocks) {
+        BlockRecord record;
+        record.firstSucc = edges.size();
+        for(auto *succ: block->GetSuccessors()) {
+            edges.push_back(succ->GetId());
+        }
+        record.succsCount = edges.size() - record.firstSucc;
+        record.firstPred = edges.size();
+        for(auto *pred: block->GetPredecessors()) {
+            edges.push_back(pred->GetId());
+        }
+        record.predsCount = edges.size() - record.firstPred;
+        record.firstInstr = order.size();
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            order.push_back(denseIds[instr->GetId()]);
+        }
+        record.instrsCount = order.size() - record.firstInstr;
+        blockRecords.push_back(record);
+    }
+
+    for(auto &instr: instructions) {
+        if(instr->GetParentBB() == nullptr) {
+            continue;
+        }
+        auto op = instr->GetOpType();
+        if(GetExpectedOperandsCount(op) == -2) {
+            return std::nullopt;
+        }
+
+        InstrRecord record;
+        record.opcode = static_cast<uint8_t>(op);
+        record.type = static_cast<uint8_t>(instr->GetResultType());
+        record.firstWord = words.size();
+        for(auto &input: instr->GetInputs()) {
+            auto operand = denseIds[input.GetValue()->GetId()];
+            if(operand == NO_ID) {
+                return std::nullopt;
+            }
+            words.push_back(operand);
+        }
+        record.operandsCount = words.size() - record.firstWord;
+
+        uint64_t payload = 0;
+
+        switch(op) {
+            case OpType::CONST: {
+                auto *constant = static_cast<ConstantInstr*>(instr.get());
+                payload = constant->GetAsUnsignedInt();
+                record.flags = constant->IsSignedInt() ? InstrRecord::SIGNED_CONSTANT : 0;
+                break;
+            }
+            case OpType::PRM:
+                payload = static_cast<ParameterInstr*>(instr.get())->GetArgNum();
+                break;
+            case OpType::JMP:
+                payload = GetBlockId(static_cast<JmpInstr*>(instr.get())->GetBBToJmp());
+                break;
+            case OpType::JA:
+            case OpType::JAE:
+            case OpType::JE: {
+                auto *branch = static_cast<CjmpInstr*>(instr.get());
+                payload = GetBlockId(branch->GetTrueBranchBB()) | (GetBlockId(branch->GetFalseBranchBB()) << 32);
+                break;
+            }
+            case OpType::OVERFLOW_CHECK: {
+                auto *check = static_cast<OverflowCheckInstr*>(instr.get());
+                payload = static_cast<uint64_t>(check->GetCheckedOp()) |
+                          (static_cast<uint64_t>(check->GetCheckedType()) << 32);
+                break;
+            }
+            case OpType::NEW_OBJECT:
+                payload = static_cast<NewObjectInstr*>(instr.get())->GetFieldsCount();
+                break;
+            case OpType::LOAD_FIELD:
+                payload = static_cast<LoadFieldInstr*>(instr.get())->GetField();
+                break;
+            case OpType::STORE_FIELD:
+                payload = static_cast<StoreFieldInstr*>(instr.get())->GetField();
+                break;
+            case OpType::LOAD:
+                payload = static_cast<uint64_t>(static_cast<LoadInstr*>(instr.get())->GetOffset());
+                break;
+            case OpType::STORE:
+                payload = static_cast<uint64_t>(static_cast<StoreInstr*>(instr.get())->GetOffset());
+                break;
+            case OpType::SELECT:
+                payload = static_cast<uint64_t>(static_cast<SelectInstr*>(instr.get())->GetCondition());
+                break;
+            default:
+                break;
+        }
+        if(HasPayload(op)) {
+            words.push_back(static_cast<uint32_t>(payload));
+            words.push_back(static_cast<uint32_t>(payload >> 32));
+        }
+        instrRecords.push_back(record);
+    }
+
+    GraphFileHeader header;
+    std::memcpy(header.magic, GRAPH_MAGIC, sizeof(header.magic));
+    header.version = GRAPH_FORMAT_VERSION;
+    header.blocksCount = blockRecords.size();
+    header.instrsCount = instrRecords.size();
+    header.wordsCount = words.size();
+    header.edgesCount = edges.size();
+    header.orderCount = order.size();
+
+    std::vector<uint8_t> image;
+    image.reserve(sizeof(header) + blockRecords.size() * sizeof(BlockRecord) +
+                  instrRecords.size() * sizeof(InstrRecord) +
+                  (words.size() + edges.size() + order.size()) * sizeof(uint32_t));
+    Append(image, &header, 1);
+    Append(image, blockRecords.data(), blockRecords.size());
+    Append(image, instrRecords.data(), instrRecords.size());
+    Append(image, words.data(), words.size());
+    Append(image, edges.data(), edges.size());
+    Append(image, order.data(), order.size());
+    return image;
+}
+
+bool GraphSerializer::WriteFile(const std::string &path) {
+    auto image = Run();
+    if(!image.has_value()) {
+        return false;
+    }
+
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0) {
+        return false;
+    }
+
+    size_t written = 0;
+    while(written < image->size()) {
+        ssize_t res = write(fd, image->data() + written, image->size() - written);
+        if(res <= 0) {
+            close(fd);
+            return false;
+        }
+        written += static_cast<size_t>(res);
+    }
+    return close(fd) == 0;
+}
+
+std::optional<GraphImageView> GraphImageView::Create(const uint8_t* data, size_t size) {
+    if(size < sizeof(GraphFileHeader) || reinterpret_cast<uintptr_t>(data) % alignof(uint64_t) != 0) {
+        return std::nullopt;
+    }
+
+    GraphImageView view;
+    view.header_ = reinterpret_cast<const GraphFileHeader*>(data);
+    auto &header = *view.header_;
+    if(std::memcmp(header.magic, GRAPH_MAGIC, sizeof(header.magic)) != 0 || header.version != GRAPH_FORMAT_VERSION) {
+        return std::nullopt;
+    }
+
+    uint64_t expectedSize = sizeof(GraphFileHeader) +
+                            static_cast<uint64_t>(header.blocksCount) * sizeof(BlockRecord) +
+                            static_cast<uint64_t>(header.instrsCount) * sizeof(InstrRecord) +
+                            (static_cast<uint64_t>(header.wordsCount) + header.edgesCount + header.orderCount) *
+                            sizeof(uint32_t);
+    if(expectedSize != size) {
+        return std::nullopt;
+    }
+
+    auto *cursor = data + sizeof(GraphFileHeader);
+    view.blocks_ = reinterpret_cast<const BlockRecord*>(cursor);
+    cursor += header.blocksCount * sizeof(BlockRecord);
+    view.instrs_ = reinterpret_cast<const InstrRecord*>(cursor);
+    cursor += header.instrsCount * sizeof(InstrRecord);
+    view.words_ = reinterpret_cast<const uint32_t*>(cursor);
+    view.edges_ = view.words_ + header.wordsCount;
+    view.order_ = view.edges_ + header.edgesCount;
+
+    if(!view.Validate()) {
+        return std::nullopt;
+    }
+    return view;
+}
+
+bool GraphImageView::Validate() const {
+    auto inRange = [](uint64_t first, uint64_t count, uint64_t limit) {
+        return first + count <= limit;
+    };
+    auto &header = *header_;
+
+    for(size_t idx = 0; idx < header.blocksCount; ++idx) {
+        auto &block = blocks_[idx];
+        if(!inRange(block.firstSucc, block.succsCount, header.edgesCount) ||
+           !inRange(block.firstPred, block.predsCount, header.edgesCount) ||
+           !inRange(block.firstInstr, block.instrsCount, header.orderCount)) {
+            return false;
+        }
+    }
+    for(size_t idx = 0; idx < header.edgesCount; ++idx) {
+        if(edges_[idx] >= header.blocksCount) {
+            return false;
+        }
+    }
+    std::vector<bool> placed(header.instrsCount, false);
+    for(size_t idx = 0; idx < header.blocksCount; ++idx) {
+        for(auto id: GetBlockInstructions(blocks_[idx])) {
+            if(id >= header.instrsCount || placed[id]) {
+                return false;
+            }
+            placed[id] = true;
+        }
+    }
+
+    for(size_t id = 0; id < header.instrsCount; ++id) {
+        auto &instr = instrs_[id];
+        if(instr.opcode >= OPCODES_COUNT || instr.type >= DATA_TYPES_COUNT) {
+            return false;
+        }
+
+        auto op = static_cast<OpType>(instr.opcode);
+        int expected = GetExpectedOperandsCount(op);
+        if(expected == -2 || (expected >= 0 && instr.operandsCount != static_cast<uint32_t>(expected)) ||
+           !inRange(instr.firstWord, instr.operandsCount + (HasPayload(op) ? 2 : 0), header.wordsCount)) {
+            return false;
+        }
+        for(auto operand: GetOperands(instr)) {
+            if(operand >= header.instrsCount) {
+                return false;
+            }
+        }
+
+        uint64_t payload = HasPayload(op) ? GetPayload(instr) : 0;
+        if(op == OpType::JMP && payload >= header.blocksCount) {
+            return false;
+        }
+        if((op == OpType::JA || op == OpType::JAE || op == OpType::JE) &&
+           ((payload & 0xffffffffULL) >= header.blocksCount || (payload >> 32) >= header.blocksCount)) {
+            return false;
+        }
+        if((op == OpType::NEW_OBJECT || op == OpType::LOAD_FIELD || op == OpType::STORE_FIELD) &&
+           (payload >> 32) != 0) {
+            return false;
+        }
+        if(op == OpType::SELECT) {
+            auto condition = static_cast<OpType>(payload);
+            if(condition != OpType::JA && condition != OpType::JAE && condition != OpType::JE) {
+                return false;
+            }
+        }
+        if(op == OpType::OVERFLOW_CHECK) {
+            auto checkedOp = static_cast<OpType>(payload & 0xffffffffULL);
+            if((checkedOp != OpType::ADD && checkedOp != OpType::SUB && checkedOp != OpType::MUL) ||
+               (payload >> 32) >= DATA_TYPES_COUNT) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+size_t GraphImageView::GetBlocksCount() const {
+    return header_->blocksCount;
+}
+
+size_t GraphImageView::GetInstructionsCount() const {
+    return header_->instrsCount;
+}
+
+const BlockRecord& GraphImageView::GetBlock(size_t idx) const {
+    return blocks_[idx];
+}
+
+const InstrRecord& GraphImageView::GetInstruction(size_t id) const {
+    return instrs_[id];
+}
+
+std::span<const uint32_t> GraphImageView::GetOperands(const InstrRecord &instr) const {
+    return {words_ + instr.firstWord, instr.operandsCount};
+}
+
+uint64_t GraphImageView::GetPayload(const InstrRecord &instr) const {
+    auto *payload = words_ + instr.firstWord + instr.operandsCount;
+    return static_cast<uint64_t>(payload[0]) | (static_cast<uint64_t>(payload[1]) << 32);
+}
+
+std::span<const uint32_t> GraphImageView::GetSuccessors(const BlockRecord &block) const {
+    return {edges_ + block.firstSucc, block.succsCount};
+}
+
+std::span<const uint32_t> GraphImageView::GetPredecessors(const BlockRecord &block) const {
+    return {edges_ + block.firstPred, block.predsCount};
+}
+
+std::span<const uint32_t> GraphImageView::GetBlockInstructions(const BlockRecord &block) const {
+    return {order_ + block.firstInstr, block.instrsCount};
+}
+
+MappedGraphFile::~MappedGraphFile() {
+    Close();
+}
+
+bool MappedGraphFile::Open(const std::string &path) {
+    Close();
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(mapping == MAP_FAILED) {
+        return false;
+    }
+
+    mapping_ = static_cast<const uint8_t*>(mapping);
+    mappingSize_ = static_cast<size_t>(st.st_size);
+    view_ = GraphImageView::Create(mapping_, mappingSize_);
+    if(!view_.has_value()) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void MappedGraphFile::Close() {
+    view_.reset();
+    if(mapping_ != nullptr) {
+        munmap(const_cast<uint8_t*>(mapping_), mappingSize_);
+        mapping_ = nullptr;
+        mappingSize_ = 0;
+    }
+}
+
+const std::optional<GraphImageView>& MappedGraphFile::GetView() const {
+    return view_;
+}
+
+std::unique_ptr<Graph> GraphDeserializer::Run() {
+    auto graph = std::make_unique<Graph>();
+
+    std::vector<BasicBlock*> blocks;
+    blocks.reserve(view_.GetBlocksCount());
+    for(size_t idx = 0; idx < view_.GetBlocksCount(); ++idx) {
+        auto block = std::make_unique<BasicBlock>();
+        blocks.push_back(block.get());
+        graph->AddBlock(std::move(block));
+    }
+    for(size_t idx = 0; idx < view_.GetBlocksCount(); ++idx) {
+        auto &record = view_.GetBlock(idx);
+        for(auto succ: view_.GetSuccessors(record)) {
+            blocks[idx]->AddSuccessor(blocks[succ]);
+        }
+        for(auto pred: view_.GetPredecessors(record)) {
+            blocks[idx]->AddPredecessor(blocks[pred]);
+        }
+    }
+
+    // Operands defined later than their user (phi inputs, values reordered by
+    // passes) are bound to a placeholder first and patched at the end.
+    struct Fixup {
+        Instruction* user = nullptr;
+        size_t inputIdx = 0;
+        uint32_t inputId = 0;
+    };
+    std::vector<Fixup> fixups;
+    std::vector<Instruction*> instrs;
+    instrs.reserve(view_.GetInstructionsCount());
+    Instruction placeholder(OpType::UNDEFINED);
+
+    for(size_t id = 0; id < view_.GetInstructionsCount(); ++id) {
+        auto &record = view_.GetInstruction(id);
+        auto operands = view_.GetOperands(record);
+        auto type = static_cast<DataType>(record.type);
+        uint64_t payload = HasPayload(static_cast<OpType>(record.opcode)) ? view_.GetPayload(record) : 0;
+
+        std::unique_ptr<Instruction> instr;
+        Instruction* inputs[3] = {&placeholder, &placeholder, &placeholder};
+        for(size_t idx = 0; idx < operands.size() && idx < 3; ++idx) {
+            if(operands[idx] < id) {
+                inputs[idx] = instrs[operands[idx]];
+            }
+        }
+
+        switch(static_cast<OpType>(record.opcode)) {
+            case OpType::ADD:
+                instr = std::make_unique<AddInstr>(type, inputs[0], inputs[1]);
+                break;
+            case OpType::SUB:
+                instr = std::make_unique<SubInstr>(type, inputs[0], inputs[1]);
+                break;
+            case OpType::MUL:
+                instr = std::make_unique<MulInstr>(type, inputs[0], inputs[1]);
+                break;
+            case OpType::DIV:
+                instr = std::make_unique<DivInstr>(type, inputs[0], inputs[1]);
+                break;
+            case OpType::MOD:
+                instr = std::make_unique<ModInstr>(type, inputs[0], inputs[1]);
+                break;
+            case OpType::MULH:
+                instr = std::make_unique<MulHighInstr>(type, inputs[0], inputs[1]);
+                break;
+            case OpType::AND:
+                instr = std::make_unique<AndInstr>(type, inputs[0], inputs[1]);
+                break;
+            case OpType::SHR:
+                instr = std::make_unique<ShrInstr>(type, inputs[0], inputs[1]);
+                break;
+            case OpType::CMP:
+                instr = std::make_unique<CmpInstr>(inputs[0], inputs[1]);
+                break;
+            case OpType::JMP:
+                instr = std::make_unique<JmpInstr>(blocks[payload]);
+                break;
+            case OpType::JA:
+                instr = std::make_unique<JaInstr>(inputs[0], blocks[payload & 0xffffffffULL], blocks[payload >> 32]);
+                break;
+            case OpType::JAE:
+                instr = std::make_unique<JaeInstr>(inputs[0], blocks[payload & 0xffffffffULL], blocks[payload >> 32]);
+                break;
+            case OpType::JE:
+                instr = std::make_unique<JeInstr>(inputs[0], blocks[payload & 0xffffffffULL], blocks[payload >> 32]);
+                break;
+            case OpType::RET:
+                instr = std::make_unique<RetInstr>(type, inputs[0]);
+                break;
+            case OpType::BOUNDS_CHECK:
+                instr = std::make_unique<BoundsCheckInstr>(inputs[0], inputs[1]);
+                break;
+            case OpType::OVERFLOW_CHECK:
+                instr = std::make_unique<OverflowCheckInstr>(static_cast<OpType>(payload & 0xffffffffULL),
+                                                             static_cast<DataType>(payload >> 32),
+                                                             inputs[0], inputs[1]);
+                break;
+            case OpType::NEW_OBJECT:
+                instr = std::make_unique<NewObjectInstr>(static_cast<uint32_t>(payload));
+                break;
+            case OpType::LOAD_FIELD:
+                instr = std::make_unique<LoadFieldInstr>(type, inputs[0], static_cast<uint32_t>(payload));
+                break;
+            case OpType::STORE_FIELD:
+                instr = std::make_unique<StoreFieldInstr>(inputs[0], static_cast<uint32_t>(payload), inputs[1]);
+                break;
+            case OpType::LOAD:
+                instr = std::make_unique<LoadInstr>(type, inputs[0], static_cast<int64_t>(payload));
+                break;
+            case OpType::STORE:
+                instr = std::make_unique<StoreInstr>(inputs[0], static_cast<int64_t>(payload), inputs[1]);
+                break;
+            case OpType::SELECT:
+                instr = std::make_unique<SelectInstr>(type, static_cast<OpType>(payload),
+                                                      inputs[0], inputs[1], inputs[2]);
+                break;
+            case OpType::PHI: {
+                instr = std::make_unique<PhiInstr>(type);
+                for(size_t idx = 0; idx < operands.size(); ++idx) {
+                    instr->AddInput(&placeholder);
+                }
+                break;
+            }
+            case OpType::PRM:
+                instr = std::make_unique<ParameterInstr>(static_cast<uint32_t>(payload));
+                break;
+            case OpType::CONST:
+                if(record.flags & InstrRecord::SIGNED_CONSTANT) {
+                    instr = std::make_unique<ConstantInstr>(static_cast<int64_t>(payload));
+                } else {
+                    instr = std::make_unique<ConstantInstr>(payload);
+                }
+                break;
+            default:
+                return nullptr;
+        }
+        instr->SetResultType(type);
+
+        for(size_t idx = 0; idx < operands.size(); ++idx) {
+            if(instr->GetInputs()[idx].GetValue() == &placeholder) {
+                fixups.push_back(Fixup {instr.get(), idx, operands[idx]});
+            }
+        }
+        instrs.push_back(instr.get());
+        graph->AddInstruction(std::move(instr));
+    }
+
+    for(auto &fixup: fixups) {
+        fixup.user->SetInput(fixup.inputIdx, instrs[fixup.inputId]);
+    }
+
+    for(size_t idx = 0; idx < view_.GetBlocksCount(); ++idx) {
+        for(auto id: view_.GetBlockInstructions(view_.GetBlock(idx))) {
+            blocks[idx]->PushInstruction(instrs[id]);
+            instrs[id]->SetParentBB(blocks[idx]);
+        }
+    }
+    return graph;
+}
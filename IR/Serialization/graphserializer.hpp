@@ -0,0 +1,136 @@
+#ifndef IR_GRAPH_SERIALIZER_HPP
+#define IR_GRAPH_SERIALIZER_HPP
+
+#include "Graph/graph.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+// Binary graph image. All sections are arrays of fixed-size records, so a
+// mapped file can be walked in place:
+//     GraphFileHeader
+//     BlockRecord[blocksCount]
+//     InstrRecord[instrsCount]      indexed by instruction id
+//     uint32_t words[wordsCount]    operand ids, each followed by the payload of its instruction
+//     uint32_t edges[edgesCount]    successors and predecessors of blocks
+//     uint32_t order[orderCount]    instruction ids of every block in list order
+struct GraphFileHeader {
+    char magic[8] = {};
+    uint32_t version = 0;
+    uint32_t blocksCount = 0;
+    uint32_t instrsCount = 0;
+    uint32_t wordsCount = 0;
+    uint32_t edgesCount = 0;
+    uint32_t orderCount = 0;
+};
+
+struct BlockRecord {
+    uint32_t firstSucc = 0;
+    uint32_t succsCount = 0;
+    uint32_t firstPred = 0;
+    uint32_t predsCount = 0;
+    uint32_t firstInstr = 0;
+    uint32_t instrsCount = 0;
+};
+
+// Constants, parameters, jumps, overflow checks, object instructions and
+// selects carry a 64-bit payload in the two words after their operands:
+// constant bits, parameter number, jump target, true (low half) and false (high
+// half) targets of a conditional jump, checked operation (low half) and type
+// (high half) of an overflow check, fields count of an allocation, the accessed
+// field, the byte offset of a load or store or the condition of a select.
+struct InstrRecord {
+    static constexpr uint16_t SIGNED_CONSTANT = 1;
+
+    uint8_t opcode = 0;
+    uint8_t type = 0;
+    uint16_t flags = 0;
+    uint32_t firstWord = 0;
+    uint32_t operandsCount = 0;
+};
+
+static_assert(sizeof(GraphFileHeader) % 8 == 0 && sizeof(BlockRecord) % 4 == 0 && sizeof(InstrRecord) % 4 == 0);
+
+inline constexpr uint32_t GRAPH_FORMAT_VERSION = 1;
+
+// Writes the image of a graph. Guards refer to another graph and MOV/CAST
+// have no instruction classes yet, so graphs with them are rejected.
+// Removed instructions are dropped and the rest numbered densely.
+class GraphSerializer final {
+public:
+    explicit GraphSerializer(Graph* graph): graph_(graph) {}
+
+    std::optional<std::vector<uint8_t>> Run();
+    bool WriteFile(const std::string &path);
+
+private:
+    Graph* graph_ = nullptr;
+};
+
+// Validated zero-copy view of an image in memory.
+class GraphImageView final {
+public:
+    static std::optional<GraphImageView> Create(const uint8_t* data, size_t size);
+
+    size_t GetBlocksCount() const;
+    size_t GetInstructionsCount() const;
+    const BlockRecord& GetBlock(size_t idx) const;
+    const InstrRecord& GetInstruction(size_t id) const;
+
+    std::span<const uint32_t> GetOperands(const InstrRecord &instr) const;
+    uint64_t GetPayload(const InstrRecord &instr) const;
+    std::span<const uint32_t> GetSuccessors(const BlockRecord &block) const;
+    std::span<const uint32_t> GetPredecessors(const BlockRecord &block) const;
+    std::span<const uint32_t> GetBlockInstructions(const BlockRecord &block) const;
+
+private:
+    GraphImageView() = default;
+
+    bool Validate() const;
+
+private:
+    const GraphFileHeader* header_ = nullptr;
+    const BlockRecord* blocks_ = nullptr;
+    const InstrRecord* instrs_ = nullptr;
+    const uint32_t* words_ = nullptr;
+    const uint32_t* edges_ = nullptr;
+    const uint32_t* order_ = nullptr;
+};
+
+// Read-only mapping of an image file.
+class MappedGraphFile final {
+public:
+    MappedGraphFile() = default;
+    ~MappedGraphFile();
+
+    MappedGraphFile(const MappedGraphFile&) = delete;
+    MappedGraphFile& operator=(const MappedGraphFile&) = delete;
+
+    bool Open(const std::string &path);
+    void Close();
+
+    const std::optional<GraphImageView>& GetView() const;
+
+private:
+    const uint8_t* mapping_ = nullptr;
+    size_t mappingSize_ = 0;
+    std::optional<GraphImageView> view_;
+};
+
+// Rebuilds a graph from an image in one pass over the instruction table.
+// Block ids and the ids written by the serializer are preserved.
+class GraphDeserializer final {
+public:
+    explicit GraphDeserializer(const GraphImageView &view): view_(view) {}
+
+    std::unique_ptr<Graph> Run();
+
+private:
+    const GraphImageView &view_;
+};
+
+#endif  // IR_GRAPH_SERIALIZER_HPP
@@ -0,0 +1,65 @@
+#include "Speculation/branchspeculation.hpp"
+#include "Cloner/cloner.hpp"
+#include "Liveness/liveness.hpp"
+
+std::unique_ptr<Graph> BranchSpeculation::Run() {
+    guardsCount_ = 0;
+
+    GraphCloner cloner(baseline_);
+    auto optimized = cloner.Run();
+    if(optimized == nullptr) {
+        return nullptr;
+    }
+
+    LivenessAnalyzer liveness(baseline_);
+    liveness.Analyze();
+
+    for(auto &block: baseline_->GetBlocks()) {
+        auto *branch = block->GetLastInstr();
+        auto *cjmp = branch == nullptr ? nullptr : branch->As<CjmpInstr>();
+        if(cjmp == nullptr) {
+            continue;
+        }
+
+        auto counters = profile_->GetCounters(branch);
+        if(counters.taken + counters.notTaken < minSamples_ || (counters.taken != 0 && counters.notTaken != 0)) {
+            continue;
+        }
+
+        bool hotTaken = counters.taken != 0;
+        auto *hotBB = hotTaken ? cjmp->GetTrueBranchBB() : cjmp->GetFalseBranchBB();
+        auto *coldBB = hotTaken ? cjmp->GetFalseBranchBB() : cjmp->GetTrueBranchBB();
+        if(hotBB == coldBB) {
+            continue;
+        }
+
+        auto *branchCopy = cloner.GetClonedValue(branch);
+        auto *blockCopy = branchCopy->GetParentBB();
+        auto *coldCopy = cloner.GetClonedBlock(coldBB);
+
+        auto guard = std::make_unique<GuardInstr>(cloner.GetClonedValue(branch->GetInputs()[0].GetValue()),
+                                                  branch->GetOpType(), hotTaken, coldBB, block.get());
+        for(auto *value: liveness.GetLiveOnEdge(block.get(), coldBB)) {
+            guard->AddStateValue(value, cloner.GetClonedValue(value));
+        }
+        auto jmp = std::make_unique<JmpInstr>(cloner.GetClonedBlock(hotBB));
+
+        blockCopy->InsertBefore(branchCopy, guard.get());
+        blockCopy->InsertBefore(branchCopy, jmp.get());
+        optimized->RemoveInstruction(branchCopy);
+        optimized->AddInstruction(std::move(guard));
+        optimized->AddInstruction(std::move(jmp));
+
+        blockCopy->RemoveSuccessor(coldCopy);
+        coldCopy->RemovePredecessor(blockCopy);
+
+        ++guardsCount_;
+    }
+
+    optimized->RemoveUnreachableBlocks();
+    return optimized;
+}
+
+size_t BranchSpeculation::GetGuardsCount() const {
+    return guardsCount_;
+}
@@ -0,0 +1,30 @@
+#ifndef IR_BRANCH_SPECULATION_HPP
+#define IR_BRANCH_SPECULATION_HPP
+
+#include "Graph/graph.hpp"
+#include "Profile/branchprofile.hpp"
+
+#include <memory>
+
+// Builds a speculatively optimized copy of the baseline graph: every branch
+// that went only one way in at least `minSamples` profiled executions becomes
+// a guard plus a jump to the hot successor. The guard state holds the values
+// live on the cold edge, so a failing guard resumes the baseline graph at the
+// cold successor. Blocks reachable only through cold edges are dropped.
+class BranchSpeculation final {
+public:
+    BranchSpeculation(Graph* baseline, const BranchProfile* profile, size_t minSamples = 1):
+        baseline_(baseline), profile_(profile), minSamples_(minSamples) {}
+
+    std::unique_ptr<Graph> Run();
+    size_t GetGuardsCount() const;
+
+private:
+    Graph* baseline_ = nullptr;
+    const BranchProfile* profile_ = nullptr;
+    size_t minSamples_ = 1;
+
+    size_t guardsCount_ = 0;
+};
+
+#endif  // IR_BRANCH_SPECULATION_HPP
@@ -0,0 +1,345 @@
+#include "Unroller/loopunroller.hpp"
+#include "DFS/rpo.hpp"
+#include "Instr/datatraits.hpp"
+
+#include <algorithm>
+
+namespace {
+
+bool IsUnsignedType(DataType type) {
+    return type == DataType::U8 || type == DataType::U16 || type == DataType::U32 || type == DataType::U64;
+}
+
+uint64_t GetTypeMask(DataType type) {
+    auto bits = GetElementBits(type);
+    return bits >= 64 ? ~0ULL : (1ULL << bits) - 1;
+}
+
+bool IsExitTaken(OpType condition, uint64_t iv, uint64_t bound) {
+    return condition == OpType::JA ? iv > bound : iv >= bound;
+}
+
+// Opcodes InstructionCloner can copy and that are safe to run more than once
+// per original iteration position. Guards are left alone since their resume
+// state points into the loop.
+bool IsClonable(Instruction* instr) {
+    switch(instr->GetOpType()) {
+        case OpType::UNDEFINED:
+        case OpType::MOV:
+        case OpType::CAST:
+        case OpType::DEOPT:
+        case OpType::RET:
+        case OpType::PRM:
+            return false;
+        default:
+            return true;
+    }
+}
+
+}  // namespace
+
+size_t LoopUnroller::Run() {
+    fullyUnrolledCount_ = 0;
+
+    LoopAnalyzer analyzer(graph_);
+    analyzer.Analyze();
+    auto rpo = RPO(graph_).Run();
+
+    std::vector<Candidate> candidates;
+    for(auto &loop: analyzer.GetLoops()) {
+        if(auto candidate = Analyze(loop.get(), rpo)) {
+            candidates.push_back(std::move(*candidate));
+        }
+    }
+
+    size_t unrolled = 0;
+    for(auto &candidate: candidates) {
+        if(candidate.tripCount.has_value() && *candidate.tripCount <= maxFullUnrollTrips_ &&
+           *candidate.tripCount * candidate.size <= maxUnrolledInstrs_) {
+            UnrollFully(candidate);
+            ++fullyUnrolledCount_;
+            ++unrolled;
+        } else if(factor_ > 1 && factor_ * candidate.size <= maxUnrolledInstrs_) {
+            UnrollWithRemainder(candidate);
+            ++unrolled;
+        }
+    }
+    if(fullyUnrolledCount_ != 0) {
+        graph_->RemoveUnreachableBlocks();
+    }
+    return unrolled;
+}
+
+size_t LoopUnroller::GetFullyUnrolledCount() const {
+    return fullyUnrolledCount_;
+}
+
+std::optional<LoopUnroller::Candidate> LoopUnroller::Analyze(Loop* loop, const std::vector<BasicBlock*> &rpo) const {
+    if(!loop->GetSubLoops().empty() || loop->GetBackEdges().size() != 1) {
+        return std::nullopt;
+    }
+
+    Candidate candidate;
+    auto *header = candidate.header = loop->GetHeader();
+    auto *latch = candidate.latch = loop->GetBackEdges()[0];
+    auto &headerPreds = header->GetPredecessors();
+    if(latch == header || headerPreds.size() != 2) {
+        return std::nullopt;
+    }
+    auto *preheader = candidate.preheader = headerPreds[0] == latch ? headerPreds[1] : headerPreds[0];
+    if(preheader->GetLastInstr() == nullptr || !preheader->GetLastInstr()->IsJmp()) {
+        return std::nullopt;
+    }
+
+    // Only the header leaves the loop, and it does so on the true branch.
+    auto *branch = header->GetLastInstr() == nullptr ? nullptr : header->GetLastInstr()->As<CjmpInstr>();
+    if(branch == nullptr || (branch->GetOpType() != OpType::JA && branch->GetOpType() != OpType::JAE) ||
+       loop->Contains(branch->GetTrueBranchBB()) || !loop->Contains(branch->GetFalseBranchBB())) {
+        return std::nullopt;
+    }
+    candidate.exitCondition = branch->GetOpType();
+    candidate.bodyEntry = branch->GetFalseBranchBB();
+
+    for(auto *block: rpo) {
+        if(block == header || !loop->Contains(block)) {
+            continue;
+        }
+        for(auto *succ: block->GetSuccessors()) {
+            if(!loop->Contains(succ)) {
+                return std::nullopt;
+            }
+        }
+        candidate.body.push_back(block);
+    }
+    for(auto *block: loop->GetBlocks()) {
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            if(!IsClonable(instr)) {
+                return std::nullopt;
+            }
+            ++candidate.size;
+        }
+    }
+
+    auto *cmp = candidate.cmp = branch->GetInputs()[0].GetValue();
+    if(cmp->GetOpType() != OpType::CMP || cmp->GetParentBB() != header || cmp->GetUsesCount() != 1) {
+        return std::nullopt;
+    }
+    auto *iv = candidate.iv = cmp->GetInputs()[0].GetValue();
+    auto *bound = candidate.bound = cmp->GetInputs()[1].GetValue();
+    if(iv->GetParentBB() != header || !iv->IsPhi() ||
+       (loop->Contains(bound->GetParentBB()) && !bound->Is<ConstantInstr>())) {
+        return std::nullopt;
+    }
+
+    auto *ivUpdate = static_cast<PhiInstr*>(iv)->GetPhiInput(latch);
+    if(ivUpdate->GetOpType() != OpType::ADD || !loop->Contains(ivUpdate->GetParentBB())) {
+        return std::nullopt;
+    }
+    auto &stepInputs = ivUpdate->GetInputs();
+    auto *stepValue = stepInputs[0].GetValue() == iv ? stepInputs[1].GetValue() : stepInputs[0].GetValue();
+    auto *step = stepValue->As<ConstantInstr>();
+    if((stepInputs[0].GetValue() != iv && stepInputs[1].GetValue() != iv) || step == nullptr) {
+        return std::nullopt;
+    }
+
+    // The offset of the last copy has to stay far from wrapping around.
+    auto stepMask = GetTypeMask(iv->GetResultType()) >> 1;
+    candidate.step = step->GetAsUnsignedInt() & GetTypeMask(iv->GetResultType());
+    if(candidate.step == 0 || candidate.step > stepMask / std::max<size_t>(factor_, 1)) {
+        return std::nullopt;
+    }
+
+    candidate.tripCount = GetTripCount(candidate);
+    return candidate;
+}
+
+std::optional<uint64_t> LoopUnroller::GetTripCount(const Candidate &candidate) const {
+    auto *init = static_cast<PhiInstr*>(candidate.iv)->GetPhiInput(candidate.preheader)->As<ConstantInstr>();
+    auto *bound = candidate.bound->As<ConstantInstr>();
+    auto ivType = candidate.iv->GetResultType();
+    if(init == nullptr || bound == nullptr || !IsUnsignedType(ivType) || !IsUnsignedType(bound->GetResultType())) {
+        return std::nullopt;
+    }
+
+    // Counts the iterations the way the loop runs them, wrap-arounds included.
+    auto mask = GetTypeMask(ivType);
+    uint64_t iv = init->GetAsUnsignedInt() & mask;
+    uint64_t limit = bound->GetAsUnsignedInt() & GetTypeMask(bound->GetResultType());
+    for(uint64_t trips = 0; trips <= maxFullUnrollTrips_; ++trips) {
+        if(IsExitTaken(candidate.exitCondition, iv, limit)) {
+            return trips;
+        }
+        iv = (iv + candidate.step) & mask;
+    }
+    return std::nullopt;
+}
+
+void LoopUnroller::UnrollFully(const Candidate &candidate) {
+    IrBuilder builder(graph_);
+    auto *header = candidate.header;
+    auto *preheader = candidate.preheader;
+    auto *exit = static_cast<CjmpInstr*>(header->GetLastInstr())->GetTrueBranchBB();
+
+    ValueMap phiValues;
+    for(auto *instr = header->GetFirstInstr(); instr != nullptr && instr->IsPhi(); instr = instr->GetNext()) {
+        phiValues[instr] = static_cast<PhiInstr*>(instr)->GetPhiInput(preheader);
+    }
+
+    // The header code runs once more before the loop exits.
+    auto *last = builder.CreateBB();
+    auto *entry = CloneIterations(candidate, *candidate.tripCount, phiValues, last);
+
+    graph_->RemoveInstruction(preheader->GetLastInstr());
+    preheader->RemoveSuccessor(header);
+    header->RemovePredecessor(preheader);
+    builder.SetBasicBlockScope(preheader);
+    builder.CreateJmp(entry);
+
+    builder.SetBasicBlockScope(last);
+    InstructionCloner cloner(&builder);
+    for(auto &[phi, value]: phiValues) {
+        cloner.MapValue(phi, value);
+    }
+    CloneHeaderCode(candidate, cloner);
+    builder.CreateJmp(exit);
+
+    // The header is about to become unreachable: its values are taken from
+    // the last copy from now on, and the exit phis get an input for it.
+    for(auto *instr = exit->GetFirstInstr(); instr != nullptr && instr->IsPhi(); instr = instr->GetNext()) {
+        instr->AddInput(cloner.GetMappedValue(static_cast<PhiInstr*>(instr)->GetPhiInput(header)));
+    }
+    for(auto *instr = header->GetFirstInstr(); instr != header->GetLastInstr(); instr = instr->GetNext()) {
+        if(instr != candidate.cmp) {
+            instr->ReplaceAllUsesWith(cloner.GetMappedValue(instr));
+        }
+    }
+}
+
+void LoopUnroller::UnrollWithRemainder(const Candidate &candidate) {
+    IrBuilder builder(graph_);
+    auto *header = candidate.header;
+    auto *preheader = candidate.preheader;
+    auto ivType = candidate.iv->GetResultType();
+
+    auto *unrolledHeader = builder.CreateBB();
+    auto *check = builder.CreateBB();
+    auto *remainder = builder.CreateBB();
+
+    graph_->RemoveInstruction(preheader->GetLastInstr());
+    preheader->RemoveSuccessor(header);
+    builder.SetBasicBlockScope(preheader);
+    // A constant bound may live inside the loop.
+    auto *bound = candidate.bound;
+    if(auto *constant = bound->As<ConstantInstr>()) {
+        bound = builder.CreateConstant(constant->GetAsUnsignedInt(), bound->GetResultType());
+    }
+    auto *lastOffset = builder.CreateConstant(candidate.step * (factor_ - 1), ivType);
+    builder.CreateJmp(unrolledHeader);
+
+    builder.SetBasicBlockScope(unrolledHeader);
+    ValueMap phiValues;
+    std::vector<std::pair<Instruction*, Instruction*>> phis;
+    for(auto *instr = header->GetFirstInstr(); instr != nullptr && instr->IsPhi(); instr = instr->GetNext()) {
+        auto *phi = builder.CreatePhi(instr->GetResultType());
+        phiValues[instr] = phi;
+        phis.emplace_back(instr, phi);
+    }
+    auto *iv = phiValues.at(candidate.iv);
+    auto *last = builder.CreateAdd(ivType, iv, lastOffset);
+
+    ValueMap nextValues = phiValues;
+    auto *entry = CloneIterations(candidate, factor_, nextValues, unrolledHeader);
+
+    builder.SetBasicBlockScope(unrolledHeader);
+    auto *exitTest = builder.CreateCmp(last, bound);
+    if(candidate.exitCondition == OpType::JA) {
+        builder.CreateJa(exitTest, remainder, check);
+    } else {
+        builder.CreateJae(exitTest, remainder, check);
+    }
+
+    builder.SetBasicBlockScope(check);
+    builder.CreateJae(builder.CreateCmp(last, iv), entry, remainder);
+
+    for(auto &[original, phi]: phis) {
+        phi->AddInput(static_cast<PhiInstr*>(original)->GetPhiInput(preheader));
+        phi->AddInput(nextValues.at(original));
+    }
+
+    // The original loop now runs the remaining iterations.
+    header->RemovePredecessor(preheader);
+    builder.SetBasicBlockScope(remainder);
+    builder.CreateJmp(header);
+    for(auto &[original, phi]: phis) {
+        original->AddInput(phi);
+    }
+}
+
+BasicBlock* LoopUnroller::CloneIterations(const Candidate &candidate, size_t count, ValueMap &phiValues,
+                                          BasicBlock* next) {
+    IrBuilder builder(graph_);
+
+    // Blocks are laid out in execution order, so the jumps between the copies
+    // fall through.
+    std::vector<BasicBlock*> steps;
+    std::vector<std::unordered_map<BasicBlock*, BasicBlock*>> copies(count);
+    for(size_t idx = 0; idx < count; ++idx) {
+        steps.push_back(builder.CreateBB());
+        for(auto *block: candidate.body) {
+            copies[idx][block] = builder.CreateBB();
+        }
+    }
+
+    for(size_t idx = 0; idx < count; ++idx) {
+        InstructionCloner cloner(&builder);
+        std::unordered_map<BasicBlock*, BasicBlock*> originals;
+        for(auto &[phi, value]: phiValues) {
+            cloner.MapValue(phi, value);
+        }
+        for(auto &[block, copy]: copies[idx]) {
+            cloner.MapBlock(block, copy);
+            originals[copy] = block;
+        }
+        cloner.MapBlock(candidate.header, idx + 1 < count ? steps[idx + 1] : next);
+        originals[steps[idx]] = candidate.header;
+
+        builder.SetBasicBlockScope(steps[idx]);
+        CloneHeaderCode(candidate, cloner);
+        builder.CreateJmp(copies[idx].at(candidate.bodyEntry));
+
+        for(auto *block: candidate.body) {
+            builder.SetBasicBlockScope(copies[idx].at(block));
+            for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+                cloner.Clone(instr);
+            }
+        }
+
+        // Phis of the body are filled once all edges of the copy exist.
+        for(auto *block: candidate.body) {
+            auto *copy = copies[idx].at(block);
+            for(auto *instr = block->GetFirstInstr(); instr != nullptr && instr->IsPhi(); instr = instr->GetNext()) {
+                auto *phi = static_cast<PhiInstr*>(instr);
+                auto *phiCopy = cloner.GetMappedValue(instr);
+                for(auto *pred: copy->GetPredecessors()) {
+                    phiCopy->AddInput(cloner.GetMappedValue(phi->GetPhiInput(originals.at(pred))));
+                }
+            }
+        }
+
+        ValueMap nextValues;
+        for(auto &[phi, value]: phiValues) {
+            nextValues[phi] = cloner.GetMappedValue(static_cast<PhiInstr*>(phi)->GetPhiInput(candidate.latch));
+        }
+        phiValues = std::move(nextValues);
+    }
+    return count == 0 ? next : steps.front();
+}
+
+void LoopUnroller::CloneHeaderCode(const Candidate &candidate, InstructionCloner &cloner) {
+    for(auto *instr = candidate.header->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+        if(instr->IsPhi() || instr == candidate.cmp || instr == candidate.header->GetLastInstr()) {
+            continue;
+        }
+        cloner.Clone(instr);
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef IR_LOOP_UNROLLER_HPP
+#define IR_LOOP_UNROLLER_HPP
+
+#include "Cloner/cloner.hpp"
+#include "Graph/graph.hpp"
+#include "LoopAnalyzer/loopanalyzer.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+// Unrolls innermost counted loops that only exit from the header:
+//     header: phis; header code; cmp iv, bound; ja/jae exit, body
+//     body:   any blocks, a single latch jumping back to the header
+// where iv steps by a positive constant and bound is loop invariant.
+//
+// A loop with a small constant trip count is replaced by that many copies of
+// its iteration. Any other loop gets a copy unrolled `factor` times put in
+// front of it, and the original loop is kept for the remaining iterations:
+//     preheader -> unrolled header -> check -> factor iterations -> unrolled header
+//                         \-----------> \---> original header
+// An unrolled iteration only starts if the iv of its last copy still passes
+// the exit test and does not wrap around. The exit test is monotonic in iv,
+// so the copies in between need no test of their own.
+class LoopUnroller final {
+public:
+    LoopUnroller(Graph* graph, size_t factor = 4, size_t maxFullUnrollTrips = 8, size_t maxUnrolledInstrs = 256):
+        graph_(graph), factor_(factor), maxFullUnrollTrips_(maxFullUnrollTrips),
+        maxUnrolledInstrs_(maxUnrolledInstrs) {}
+
+    // Returns the number of unrolled loops.
+    size_t Run();
+    // Number of loops the last Run() unrolled completely.
+    size_t GetFullyUnrolledCount() const;
+
+private:
+    using ValueMap = std::unordered_map<Instruction*, Instruction*>;
+
+    struct Candidate {
+        BasicBlock* preheader = nullptr;
+        BasicBlock* header = nullptr;
+        BasicBlock* latch = nullptr;
+        BasicBlock* bodyEntry = nullptr;
+        // Loop blocks except the header in reverse post-order.
+        std::vector<BasicBlock*> body;
+        OpType exitCondition = OpType::JA;
+        Instruction* iv = nullptr;
+        Instruction* bound = nullptr;
+        Instruction* cmp = nullptr;
+        uint64_t step = 0;
+        size_t size = 0;
+        std::optional<uint64_t> tripCount;
+    };
+
+    std::optional<Candidate> Analyze(Loop* loop, const std::vector<BasicBlock*> &rpo) const;
+    std::optional<uint64_t> GetTripCount(const Candidate &candidate) const;
+
+    void UnrollFully(const Candidate &candidate);
+    void UnrollWithRemainder(const Candidate &candidate);
+
+    // Clones `count` iterations that run one after another, the first one
+    // reading the header phis from `phiValues`. The last latch jumps to `next`.
+    // Returns the first block of the copies and updates `phiValues` to the
+    // values the header phis would get after the last iteration.
+    BasicBlock* CloneIterations(const Candidate &candidate, size_t count, ValueMap &phiValues, BasicBlock* next);
+    // Clones the header code without the exit test into the builder's block.
+    void CloneHeaderCode(const Candidate &candidate, InstructionCloner &cloner);
+
+private:
+    Graph* graph_ = nullptr;
+    size_t factor_ = 4;
+    size_t maxFullUnrollTrips_ = 8;
+    size_t maxUnrolledInstrs_ = 256;
+
+    size_t fullyUnrolledCount_ = 0;
+};
+
+#endif  // IR_LOOP_UNROLLER_HPP
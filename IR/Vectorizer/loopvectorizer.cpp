@@ -0,0 +1,311 @@
+#include "Vectorizer/loopvectorizer.hpp"
+#include "irbuilder.hpp"
+
+#include <unordered_map>
+
+namespace {
+
+bool IsVectorizableOp(OpType op) {
+    return op == OpType::ADD || op == OpType::SUB || op == OpType::MUL || op == OpType::AND;
+}
+
+bool IsReductionOp(OpType op) {
+    return op == OpType::ADD || op == OpType::MUL || op == OpType::AND;
+}
+
+uint64_t GetIdentity(OpType op) {
+    switch(op) {
+        case OpType::MUL:
+            return 1;
+        case OpType::AND:
+            return ~0ULL;
+        default:
+            return 0;
+    }
+}
+
+bool IsConstantOne(Instruction* value) {
+    auto *constant = value->As<ConstantInstr>();
+    return constant != nullptr && constant->GetAsUnsignedInt() == 1;
+}
+
+Instruction* CreateBinary(IrBuilder &builder, OpType op, DataType type, Instruction* lhs, Instruction* rhs) {
+    switch(op) {
+        case OpType::ADD:
+            return builder.CreateAdd(type, lhs, rhs);
+        case OpType::SUB:
+            return builder.CreateSub(type, lhs, rhs);
+        case OpType::MUL:
+            return builder.CreateMul(type, lhs, rhs);
+        default:
+            return builder.CreateAnd(type, lhs, rhs);
+    }
+}
+
+}  // namespace
+
+uint32_t GetVectorBits(VectorIsa isa) {
+    return isa == VectorIsa::AVX2 ? 256 : 128;
+}
+
+bool IsLegalVectorOp(VectorIsa isa, OpType op, uint32_t elementBits) {
+    if(elementBits != 16 && elementBits != 32 && elementBits != 64) {
+        return false;
+    }
+    if(op == OpType::MUL) {
+        return elementBits == 16 || (elementBits == 32 && isa == VectorIsa::AVX2);
+    }
+    return IsVectorizableOp(op);
+}
+
+size_t LoopVectorizer::Run() {
+    LoopAnalyzer analyzer(graph_);
+    analyzer.Analyze();
+
+    std::vector<Candidate> candidates;
+    for(auto &loop: analyzer.GetLoops()) {
+        if(auto candidate = Analyze(loop.get())) {
+            candidates.push_back(std::move(*candidate));
+        }
+    }
+    for(auto &candidate: candidates) {
+        Vectorize(candidate);
+    }
+    return candidates.size();
+}
+
+std::optional<LoopVectorizer::Candidate> LoopVectorizer::Analyze(Loop* loop) const {
+    if(!loop->GetSubLoops().empty() || loop->GetBlocks().size() != 2 || loop->GetBackEdges().size() != 1) {
+        return std::nullopt;
+    }
+
+    Candidate candidate;
+    auto *header = candidate.header = loop->GetHeader();
+    auto *body = candidate.body = loop->GetBackEdges()[0];
+    auto &headerPreds = header->GetPredecessors();
+    if(body == header || headerPreds.size() != 2 || body->GetPredecessors().size() != 1) {
+        return std::nullopt;
+    }
+    auto *preheader = candidate.preheader = headerPreds[0] == body ? headerPreds[1] : headerPreds[0];
+    if(preheader->GetLastInstr() == nullptr || !preheader->GetLastInstr()->IsJmp()) {
+        return std::nullopt;
+    }
+    if(body->GetLastInstr() == nullptr || !body->GetLastInstr()->IsJmp()) {
+        return std::nullopt;
+    }
+
+    // The header holds the phis and the exit test only.
+    auto *branch = header->GetLastInstr() == nullptr ? nullptr : header->GetLastInstr()->As<CjmpInstr>();
+    if(branch == nullptr || (branch->GetOpType() != OpType::JA && branch->GetOpType() != OpType::JAE) ||
+       branch->GetFalseBranchBB() != body || loop->Contains(branch->GetTrueBranchBB())) {
+        return std::nullopt;
+    }
+    auto *cmp = branch->GetPrev();
+    if(cmp == nullptr || cmp->GetOpType() != OpType::CMP || branch->GetInputs()[0].GetValue() != cmp ||
+       cmp->GetUsesCount() != 1 || (cmp->GetPrev() != nullptr && !cmp->GetPrev()->IsPhi())) {
+        return std::nullopt;
+    }
+    candidate.exit = branch->GetTrueBranchBB();
+    candidate.exitCondition = branch->GetOpType();
+
+    auto *iv = candidate.iv = cmp->GetInputs()[0].GetValue();
+    auto *bound = candidate.bound = cmp->GetInputs()[1].GetValue();
+    if(iv->GetParentBB() != header || !iv->IsPhi() || bound->GetParentBB() == nullptr ||
+       loop->Contains(bound->GetParentBB())) {
+        return std::nullopt;
+    }
+    candidate.ivInit = static_cast<PhiInstr*>(iv)->GetPhiInput(preheader);
+    auto *ivUpdate = candidate.ivUpdate = static_cast<PhiInstr*>(iv)->GetPhiInput(body);
+    if(ivUpdate->GetOpType() != OpType::ADD || ivUpdate->GetParentBB() != body) {
+        return std::nullopt;
+    }
+    auto &stepInputs = ivUpdate->GetInputs();
+    if(!(stepInputs[0].GetValue() == iv && IsConstantOne(stepInputs[1].GetValue())) &&
+       !(stepInputs[1].GetValue() == iv && IsConstantOne(stepInputs[0].GetValue()))) {
+        return std::nullopt;
+    }
+
+    // All vector values share one lane width.
+    DataType elementType = DataType::UNDEFINED;
+    auto checkType = [&elementType](DataType type) {
+        if(IsVectorType(type)) {
+            return false;
+        }
+        if(elementType == DataType::UNDEFINED) {
+            elementType = type;
+        }
+        return GetElementBits(type) == GetElementBits(elementType);
+    };
+
+    for(auto *instr = header->GetFirstInstr(); instr != nullptr && instr->IsPhi(); instr = instr->GetNext()) {
+        if(instr == iv) {
+            continue;
+        }
+        Reduction reduction;
+        reduction.phi = instr;
+        reduction.update = static_cast<PhiInstr*>(instr)->GetPhiInput(body);
+        reduction.op = reduction.update->GetOpType();
+        auto &inputs = reduction.update->GetInputs();
+        if(reduction.update->GetParentBB() != body || !IsReductionOp(reduction.op) ||
+           (inputs[0].GetValue() == instr) == (inputs[1].GetValue() == instr) ||
+           reduction.update->GetUsesCount() != 1 || !checkType(instr->GetResultType()) ||
+           !IsLegalVectorOp(isa_, reduction.op, GetElementBits(instr->GetResultType()))) {
+            return std::nullopt;
+        }
+        for(auto &use: instr->GetUses()) {
+            if(loop->Contains(use.GetUser()->GetParentBB()) && use.GetUser() != reduction.update) {
+                return std::nullopt;
+            }
+        }
+        candidate.reductions.push_back(reduction);
+    }
+    if(candidate.reductions.empty()) {
+        return std::nullopt;
+    }
+
+    bool skipIvUpdate = ivUpdate->GetUsesCount() == 1;
+    for(auto *instr = body->GetFirstInstr(); instr != body->GetLastInstr(); instr = instr->GetNext()) {
+        if((instr == ivUpdate && skipIvUpdate) || instr->GetOpType() == OpType::CONST) {
+            continue;
+        }
+        if(!IsVectorizableOp(instr->GetOpType()) || !checkType(instr->GetResultType()) ||
+           !IsLegalVectorOp(isa_, instr->GetOpType(), GetElementBits(instr->GetResultType()))) {
+            return std::nullopt;
+        }
+    }
+
+    candidate.vectorType = GetVectorType(elementType, GetVectorBits(isa_) / GetElementBits(elementType));
+    if(candidate.vectorType == DataType::UNDEFINED) {
+        return std::nullopt;
+    }
+    if(!skipIvUpdate) {
+        candidate.ivUpdate = nullptr;
+    }
+    return candidate;
+}
+
+void LoopVectorizer::Vectorize(const Candidate &candidate) {
+    IrBuilder builder(graph_);
+    auto vectorType = candidate.vectorType;
+    auto elementType = GetElementType(vectorType);
+    auto ivType = candidate.iv->GetResultType();
+    uint64_t lanes = GetLanesCount(vectorType);
+
+    auto *vectorHeader = builder.CreateBB();
+    auto *vectorCheck = builder.CreateBB();
+    auto *vectorBody = builder.CreateBB();
+    auto *vectorExit = builder.CreateBB();
+
+    auto *preheader = candidate.preheader;
+    graph_->RemoveInstruction(preheader->GetLastInstr());
+    preheader->RemoveSuccessor(candidate.header);
+    builder.SetBasicBlockScope(preheader);
+
+    // Loop invariants are broadcast once in the preheader.
+    std::unordered_map<Instruction*, Instruction*> vectorValues;
+    for(auto *instr = candidate.body->GetFirstInstr(); instr != candidate.body->GetLastInstr(); instr = instr->GetNext()) {
+        if(instr == candidate.ivUpdate) {
+            continue;
+        }
+        for(auto &input: instr->GetInputs()) {
+            auto *value = input.GetValue();
+            auto *block = value->GetParentBB();
+            if(block == candidate.header || vectorValues.count(value) != 0) {
+                continue;
+            }
+            if(block == candidate.body) {
+                auto *constant = value->As<ConstantInstr>();
+                if(constant == nullptr) {
+                    continue;
+                }
+                auto *copy = builder.CreateConstant(constant->GetAsUnsignedInt(), value->GetResultType());
+                vectorValues[value] = builder.CreateSplat(vectorType, copy);
+            } else {
+                vectorValues[value] = builder.CreateSplat(vectorType, value);
+            }
+        }
+    }
+
+    auto *iota = builder.CreateIota(vectorType);
+    auto *vectorIvInit = builder.CreateAdd(vectorType, builder.CreateSplat(vectorType, candidate.ivInit), iota);
+    auto *vectorStep = builder.CreateSplat(vectorType, builder.CreateConstant(lanes, elementType));
+    auto *lanesCount = builder.CreateConstant(lanes, ivType);
+    auto *lastLane = builder.CreateConstant(lanes - 1, ivType);
+    std::vector<Instruction*> accumulatorInits;
+    for(auto &reduction: candidate.reductions) {
+        auto *identity = builder.CreateConstant(GetIdentity(reduction.op), elementType);
+        accumulatorInits.push_back(builder.CreateSplat(vectorType, identity));
+    }
+    builder.CreateJmp(vectorHeader);
+
+    // Runs a vector iteration while its last lane passes the original test and
+    // the lanes do not wrap around, so every lane passes it.
+    builder.SetBasicBlockScope(vectorHeader);
+    auto *iv = builder.CreatePhi(ivType);
+    auto *vectorIv = builder.CreatePhi(vectorType);
+    std::vector<Instruction*> accumulators;
+    for(size_t idx = 0; idx < candidate.reductions.size(); ++idx) {
+        accumulators.push_back(builder.CreatePhi(vectorType));
+    }
+    auto *last = builder.CreateAdd(ivType, iv, lastLane);
+    auto *exitTest = builder.CreateCmp(last, candidate.bound);
+    if(candidate.exitCondition == OpType::JA) {
+        builder.CreateJa(exitTest, vectorExit, vectorCheck);
+    } else {
+        builder.CreateJae(exitTest, vectorExit, vectorCheck);
+    }
+
+    builder.SetBasicBlockScope(vectorCheck);
+    builder.CreateJae(builder.CreateCmp(last, iv), vectorBody, vectorExit);
+
+    builder.SetBasicBlockScope(vectorBody);
+    vectorValues[candidate.iv] = vectorIv;
+    for(size_t idx = 0; idx < candidate.reductions.size(); ++idx) {
+        vectorValues[candidate.reductions[idx].phi] = accumulators[idx];
+    }
+    for(auto *instr = candidate.body->GetFirstInstr(); instr != candidate.body->GetLastInstr(); instr = instr->GetNext()) {
+        if(instr == candidate.ivUpdate || instr->GetOpType() == OpType::CONST) {
+            continue;
+        }
+        auto &inputs = instr->GetInputs();
+        vectorValues[instr] = CreateBinary(builder, instr->GetOpType(), vectorType,
+                                           vectorValues.at(inputs[0].GetValue()),
+                                           vectorValues.at(inputs[1].GetValue()));
+    }
+    auto *vectorIvNext = builder.CreateAdd(vectorType, vectorIv, vectorStep);
+    auto *ivNext = builder.CreateAdd(ivType, iv, lanesCount);
+    builder.CreateJmp(vectorHeader);
+
+    iv->AddInput(candidate.ivInit);
+    iv->AddInput(ivNext);
+    vectorIv->AddInput(vectorIvInit);
+    vectorIv->AddInput(vectorIvNext);
+    for(size_t idx = 0; idx < candidate.reductions.size(); ++idx) {
+        accumulators[idx]->AddInput(accumulatorInits[idx]);
+        accumulators[idx]->AddInput(vectorValues.at(candidate.reductions[idx].update));
+    }
+
+    // Folds the accumulators into the start values of the scalar epilogue.
+    builder.SetBasicBlockScope(vectorExit);
+    std::vector<Instruction*> epilogueInits;
+    for(size_t idx = 0; idx < candidate.reductions.size(); ++idx) {
+        auto &reduction = candidate.reductions[idx];
+        auto type = reduction.phi->GetResultType();
+        auto *init = static_cast<PhiInstr*>(reduction.phi)->GetPhiInput(preheader);
+        auto *folded = builder.CreateReduce(reduction.op, type, accumulators[idx]);
+        epilogueInits.push_back(CreateBinary(builder, reduction.op, type, init, folded));
+    }
+    builder.CreateJmp(candidate.header);
+
+    // The header keeps its phis and now gets entered from the vector exit
+    // instead of the preheader.
+    std::vector<std::pair<Instruction*, Instruction*>> headerInputs;
+    headerInputs.emplace_back(candidate.iv, iv);
+    for(size_t idx = 0; idx < candidate.reductions.size(); ++idx) {
+        headerInputs.emplace_back(candidate.reductions[idx].phi, epilogueInits[idx]);
+    }
+    candidate.header->RemovePredecessor(preheader);
+    for(auto &[phi, value]: headerInputs) {
+        phi->AddInput(value);
+    }
+}
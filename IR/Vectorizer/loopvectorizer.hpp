@@ -0,0 +1,68 @@
+#ifndef IR_LOOP_VECTORIZER_HPP
+#define IR_LOOP_VECTORIZER_HPP
+
+#include "Graph/graph.hpp"
+#include "LoopAnalyzer/loopanalyzer.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+enum class VectorIsa {
+    SSE2,
+    AVX2,
+};
+
+uint32_t GetVectorBits(VectorIsa isa);
+// Whether `op` on lanes `elementBits` wide has a single-instruction form.
+// SSE2 has no 32-bit lane multiplication and neither ISA multiplies 64-bit lanes.
+bool IsLegalVectorOp(VectorIsa isa, OpType op, uint32_t elementBits);
+
+// Vectorizes innermost countable loops of the shape IrBuilder front-ends emit:
+//     header: phis; cmp iv, bound; ja/jae exit, body
+//     body:   arithmetic; jmp header
+// where iv steps by one and every other header phi is a reduction (add, mul
+// or and of itself and a body value, used nowhere else in the loop). Such loops
+// carry no other dependences between iterations, so their bodies can run
+// `lanes` iterations at once. The vector loop goes in front of the original
+// one, which is kept as the scalar epilogue for the remaining iterations:
+//     preheader -> vector header <-> vector body
+//               -> vector exit (horizontal reductions) -> original header
+class LoopVectorizer final {
+public:
+    LoopVectorizer(Graph* graph, VectorIsa isa = VectorIsa::SSE2): graph_(graph), isa_(isa) {}
+
+    // Returns the number of vectorized loops.
+    size_t Run();
+
+private:
+    struct Reduction {
+        Instruction* phi = nullptr;
+        Instruction* update = nullptr;
+        OpType op = OpType::ADD;
+    };
+
+    struct Candidate {
+        BasicBlock* preheader = nullptr;
+        BasicBlock* header = nullptr;
+        BasicBlock* body = nullptr;
+        BasicBlock* exit = nullptr;
+        OpType exitCondition = OpType::JA;
+        Instruction* iv = nullptr;
+        Instruction* ivInit = nullptr;
+        // Left out of the vector body when the phi is its only user.
+        Instruction* ivUpdate = nullptr;
+        Instruction* bound = nullptr;
+        std::vector<Reduction> reductions;
+        DataType vectorType = DataType::UNDEFINED;
+    };
+
+    std::optional<Candidate> Analyze(Loop* loop) const;
+    void Vectorize(const Candidate &candidate);
+
+private:
+    Graph* graph_ = nullptr;
+    VectorIsa isa_ = VectorIsa::SSE2;
+};
+
+#endif  // IR_LOOP_VECTORIZER_HPP
@@ -32,6 +32,22 @@ Instruction* IrBuilder::CreateDiv(DataType resultType, Instruction* input1, Inst
     return CreateInstruction<DivInstr>(resultType, input1, input2);
 }
 
+Instruction* IrBuilder::CreateMod(DataType resultType, Instruction* input1, Instruction* input2) {
+    return CreateInstruction<ModInstr>(resultType, input1, input2);
+}
+
+Instruction* IrBuilder::CreateMulHigh(DataType resultType, Instruction* input1, Instruction* input2) {
+    return CreateInstruction<MulHighInstr>(resultType, input1, input2);
+}
+
+Instruction* IrBuilder::CreateAnd(DataType resultType, Instruction* input1, Instruction* input2) {
+    return CreateInstruction<AndInstr>(resultType, input1, input2);
+}
+
+Instruction* IrBuilder::CreateShr(DataType resultType, Instruction* input1, Instruction* input2) {
+    return CreateInstruction<ShrInstr>(resultType, input1, input2);
+}
+
 Instruction* IrBuilder::CreateJmp(BasicBlock* bbToJmp) {
     return CreateInstruction<JmpInstr>(bbToJmp);
 }
@@ -52,6 +68,203 @@ Instruction* IrBuilder::CreateJe(Instruction* input, BasicBlock* bb1, BasicBlock
     return CreateInstruction<JeInstr>(input, bb1, bb2);
 }
 
+Instruction* IrBuilder::CreateSelect(DataType resultType, OpType condition, Instruction* input,
+                                     Instruction* ifTrue, Instruction* ifFalse) {
+    return CreateInstruction<SelectInstr>(resultType, condition, input, ifTrue, ifFalse);
+}
+
 Instruction* IrBuilder::CreateRet(DataType retType, Instruction* input) {
     return CreateInstruction<RetInstr>(retType, input);
-}
\ No newline at end of file
+}
+
+Instruction* IrBuilder::CreateSplat(DataType vectorType, Instruction* input) {
+    return CreateInstruction<SplatInstr>(vectorType, input);
+}
+
+Instruction* IrBuilder::CreateIota(DataType vectorType) {
+    return CreateInstruction<IotaInstr>(vectorType);
+}
+
+Instruction* IrBuilder::CreateReduce(OpType op, DataType resultType, Instruction* input) {
+    return CreateInstruction<ReduceInstr>(op, resultType, input);
+}
+
+Instruction* IrBuilder::CreateBoundsCheck(Instruction* index, Instruction* length) {
+    return CreateInstruction<BoundsCheckInstr>(index, length);
+}
+
+Instruction* IrBuilder::CreateOverflowCheck(OpType op, DataType checkedType, Instruction* lhs, Instruction* rhs) {
+    return CreateInstruction<OverflowCheckInstr>(op, checkedType, lhs, rhs);
+}
+
+Instruction* IrBuilder::CreateNewObject(uint32_t fieldsCount) {
+    return CreateInstruction<NewObjectInstr>(fieldsCount);
+}
+
+Instruction* IrBuilder::CreateLoadField(DataType resultType, Instruction* object, uint32_t field) {
+    return CreateInstruction<LoadFieldInstr>(resultType, object, field);
+}
+
+Instruction* IrBuilder::CreateStoreField(Instruction* object, uint32_t field, Instruction* value) {
+    return CreateInstruction<StoreFieldInstr>(object, field, value);
+}
+
+Instruction* IrBuilder::CreateLoad(DataType resultType, Instruction* base, int64_t offset) {
+    return CreateInstruction<LoadInstr>(resultType, base, offset);
+}
+
+Instruction* IrBuilder::CreateStore(Instruction* base, int64_t offset, Instruction* value) {
+    return CreateInstruction<StoreInstr>(base, offset, value);
+}
+
+void IrBuilder::WriteVariable(uint32_t variable, Instruction* value) {
+    WriteVariable(variable, currentBB_, value);
+}
+
+Instruction* IrBuilder::ReadVariable(uint32_t variable) {
+    return ReadVariable(variable, currentBB_);
+}
+
+void IrBuilder::SealBlock(BasicBlock* block) {
+    sealedBlocks_.insert(block);
+
+    auto it = incompletePhis_.find(block);
+    if(it == incompletePhis_.end()) {
+        return;
+    }
+    auto phis = std::move(it->second);
+    incompletePhis_.erase(it);
+    for(auto &[variable, phi]: phis) {
+        AddPhiOperands(variable, phi);
+    }
+}
+
+void IrBuilder::WriteVariable(uint32_t variable, BasicBlock* block, Instruction* value) {
+    currentDefs_[variable][block] = value;
+    variableTypes_.try_emplace(variable, value->GetResultType());
+}
+
+Instruction* IrBuilder::ReadVariable(uint32_t variable, BasicBlock* block) {
+    auto &defs = currentDefs_[variable];
+    auto it = defs.find(block);
+    if(it != defs.end()) {
+        it->second = Resolve(it->second);
+        return it->second;
+    }
+    return ReadVariableRecursive(variable, block);
+}
+
+Instruction* IrBuilder::ReadVariableRecursive(uint32_t variable, BasicBlock* block) {
+    auto typeIt = variableTypes_.find(variable);
+    auto type = typeIt == variableTypes_.end() ? DataType::U64 : typeIt->second;
+    auto &preds = block->GetPredecessors();
+
+    Instruction* value = nullptr;
+    if(sealedBlocks_.count(block) == 0) {
+        value = InsertPhi(block, type);
+        pendingPhis_.insert(value);
+        incompletePhis_[block].emplace_back(variable, value);
+    } else if(preds.size() == 1) {
+        value = ReadVariable(variable, preds[0]);
+    } else if(preds.empty()) {
+        value = GetUndefinedValue(type);
+    } else {
+        // The phi is recorded before its operands are read to break cycles.
+        auto *phi = InsertPhi(block, type);
+        pendingPhis_.insert(phi);
+        WriteVariable(variable, block, phi);
+        value = AddPhiOperands(variable, phi);
+    }
+    WriteVariable(variable, block, value);
+    return value;
+}
+
+Instruction* IrBuilder::AddPhiOperands(uint32_t variable, Instruction* phi) {
+    for(auto *pred: phi->GetParentBB()->GetPredecessors()) {
+        phi->AddInput(ReadVariable(variable, pred));
+    }
+    pendingPhis_.erase(phi);
+    return TryRemoveTrivialPhi(phi);
+}
+
+Instruction* IrBuilder::TryRemoveTrivialPhi(Instruction* phi) {
+    Instruction* same = nullptr;
+    for(auto &input: phi->GetInputs()) {
+        auto *value = input.GetValue();
+        if(value == same || value == phi) {
+            continue;
+        }
+        if(same != nullptr) {
+            return phi;
+        }
+        same = value;
+    }
+    if(same == nullptr) {
+        same = GetUndefinedValue(phi->GetResultType());
+    }
+
+    std::vector<Instruction*> phiUsers;
+    for(auto &use: phi->GetUses()) {
+        if(use.GetUser() != phi && use.GetUser()->IsPhi()) {
+            phiUsers.push_back(use.GetUser());
+        }
+    }
+
+    phi->ReplaceAllUsesWith(same);
+    graph_->RemoveInstruction(phi);
+    replacements_[phi] = same;
+
+    // Removing this phi may have made phis that used it trivial as well.
+    for(auto *user: phiUsers) {
+        if(user->GetParentBB() != nullptr && pendingPhis_.count(user) == 0) {
+            TryRemoveTrivialPhi(user);
+        }
+    }
+    return Resolve(same);
+}
+
+Instruction* IrBuilder::InsertPhi(BasicBlock* block, DataType type) {
+    auto phi = std::make_unique<PhiInstr>(type);
+    Instruction* phiPtr = phi.get();
+    graph_->AddInstruction(std::move(phi));
+    InsertAfterPhis(block, phiPtr);
+    return phiPtr;
+}
+
+// Reads of a variable that is not written on some path see zero, created once
+// per type at the start of the entry block so that it dominates every read.
+Instruction* IrBuilder::GetUndefinedValue(DataType type) {
+    auto it = undefinedValues_.find(type);
+    if(it != undefinedValues_.end()) {
+        return it->second;
+    }
+
+    auto constant = std::make_unique<ConstantInstr>(uint64_t{0});
+    constant->SetResultType(type);
+    Instruction* constantPtr = constant.get();
+    graph_->AddInstruction(std::move(constant));
+    InsertAfterPhis(graph_->GetStartBlock(), constantPtr);
+
+    undefinedValues_.emplace(type, constantPtr);
+    return constantPtr;
+}
+
+void IrBuilder::InsertAfterPhis(BasicBlock* block, Instruction* instr) {
+    auto *pos = block->GetFirstInstr();
+    while(pos != nullptr && pos->IsPhi()) {
+        pos = pos->GetNext();
+    }
+    if(pos == nullptr) {
+        block->PushInstruction(instr);
+        instr->SetParentBB(block);
+    } else {
+        block->InsertBefore(pos, instr);
+    }
+}
+
+Instruction* IrBuilder::Resolve(Instruction* value) const {
+    for(auto it = replacements_.find(value); it != replacements_.end(); it = replacements_.find(value)) {
+        value = it->second;
+    }
+    return value;
+}
@@ -8,6 +8,8 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <unordered_map>
+#include <unordered_set>
 
 class IrBuilder final {
 public:
@@ -22,6 +24,13 @@ public:
 
     void SetBasicBlockScope(BasicBlock* currentBB) {
         currentBB_ = currentBB;
+        insertPoint_ = nullptr;
+    }
+
+    // New instructions go in front of `pos` until the scope changes.
+    void SetInsertPoint(Instruction* pos) {
+        currentBB_ = pos->GetParentBB();
+        insertPoint_ = pos;
     }
 
     template <typename InstT, typename... ArgsT>
@@ -40,19 +49,70 @@ public:
     Instruction* CreateSub(DataType resultType, Instruction* input1, Instruction* input2);
     Instruction* CreateMul(DataType resultType, Instruction* input1, Instruction* input2);
     Instruction* CreateDiv(DataType resultType, Instruction* input1, Instruction* input2);
+    Instruction* CreateMod(DataType resultType, Instruction* input1, Instruction* input2);
+    Instruction* CreateMulHigh(DataType resultType, Instruction* input1, Instruction* input2);
+    Instruction* CreateAnd(DataType resultType, Instruction* input1, Instruction* input2);
+    Instruction* CreateShr(DataType resultType, Instruction* input1, Instruction* input2);
 
     Instruction* CreateJmp(BasicBlock* bbToJmp);
     Instruction* CreateCmp(Instruction* input1, Instruction* input2);
     Instruction* CreateJa(Instruction* input, BasicBlock* bb1, BasicBlock* bb2);
     Instruction* CreateJae(Instruction* input, BasicBlock* bb1, BasicBlock* bb2);
     Instruction* CreateJe(Instruction* input, BasicBlock* bb1, BasicBlock* bb2);
+    Instruction* CreateSelect(DataType resultType, OpType condition, Instruction* input,
+                              Instruction* ifTrue, Instruction* ifFalse);
 
     Instruction* CreateRet(DataType retType, Instruction* input);
 
+    Instruction* CreateSplat(DataType vectorType, Instruction* input);
+    Instruction* CreateIota(DataType vectorType);
+    Instruction* CreateReduce(OpType op, DataType resultType, Instruction* input);
+
+    Instruction* CreateBoundsCheck(Instruction* index, Instruction* length);
+    Instruction* CreateOverflowCheck(OpType op, DataType checkedType, Instruction* lhs, Instruction* rhs);
+
+    Instruction* CreateNewObject(uint32_t fieldsCount);
+    Instruction* CreateLoadField(DataType resultType, Instruction* object, uint32_t field);
+    Instruction* CreateStoreField(Instruction* object, uint32_t field, Instruction* value);
+    Instruction* CreateLoad(DataType resultType, Instruction* base, int64_t offset);
+    Instruction* CreateStore(Instruction* base, int64_t offset, Instruction* value);
+
+    // Variable-based building with on-the-fly SSA construction (Braun et al.,
+    // "Simple and Efficient Construction of Static Single Assignment Form").
+    // Reads place phis only where definitions really merge. A block must be
+    // sealed once all its predecessors are known, i.e. all jumps into it are
+    // built. Reads may return phis that are replaced when a block gets
+    // sealed, so read the variable again instead of keeping the result.
+    void WriteVariable(uint32_t variable, Instruction* value);
+    Instruction* ReadVariable(uint32_t variable);
+    void SealBlock(BasicBlock* block);
+
+private:
+    void WriteVariable(uint32_t variable, BasicBlock* block, Instruction* value);
+    Instruction* ReadVariable(uint32_t variable, BasicBlock* block);
+    Instruction* ReadVariableRecursive(uint32_t variable, BasicBlock* block);
+    Instruction* AddPhiOperands(uint32_t variable, Instruction* phi);
+    Instruction* TryRemoveTrivialPhi(Instruction* phi);
+    Instruction* InsertPhi(BasicBlock* block, DataType type);
+    Instruction* GetUndefinedValue(DataType type);
+    void InsertAfterPhis(BasicBlock* block, Instruction* instr);
+    Instruction* Resolve(Instruction* value) const;
+
 private:
     Graph* graph_ = nullptr;
 
     BasicBlock* currentBB_ = nullptr;
+    Instruction* insertPoint_ = nullptr;
+
+    std::unordered_map<uint32_t, std::unordered_map<BasicBlock*, Instruction*>> currentDefs_;
+    std::unordered_map<uint32_t, DataType> variableTypes_;
+    std::unordered_set<BasicBlock*> sealedBlocks_;
+    std::unordered_map<BasicBlock*, std::vector<std::pair<uint32_t, Instruction*>>> incompletePhis_;
+    // Phis that are still missing operands and must not be judged trivial.
+    std::unordered_set<Instruction*> pendingPhis_;
+    // Removed trivial phis and the values that replaced them.
+    std::unordered_map<Instruction*, Instruction*> replacements_;
+    std::unordered_map<DataType, Instruction*> undefinedValues_;
 };
 
 
@@ -63,10 +123,13 @@ Instruction* IrBuilder::CreateInstruction(ArgsT &&...args) {
     graph_->AddInstruction(std::move(instr));
 
     instrPtr->SetParentBB(currentBB_);
-    currentBB_->PushInstruction(instrPtr);
+    if(insertPoint_ != nullptr) {
+        currentBB_->InsertBefore(insertPoint_, instrPtr);
+    } else {
+        currentBB_->PushInstruction(instrPtr);
+    }
 
-    if (instrPtr->IsBranch()) {
-        auto* branchInst = static_cast<CjmpInstr* >(instrPtr);
+    if (auto* branchInst = instrPtr->As<CjmpInstr>()) {
         auto* ifTrueBB = branchInst->GetTrueBranchBB();
         auto* ifFalseBB = branchInst->GetFalseBranchBB();
 
@@ -77,8 +140,7 @@ Instruction* IrBuilder::CreateInstruction(ArgsT &&...args) {
         ifFalseBB->AddPredecessor(currentBB_);
     }
 
-    if (instrPtr->IsJmp()) {
-        auto* jmpInst = static_cast<JmpInstr* >(instrPtr);
+    if (auto* jmpInst = instrPtr->As<JmpInstr>()) {
         auto* bbToJmp = jmpInst->GetBBToJmp();
 
         currentBB_->AddSuccessor(bbToJmp);
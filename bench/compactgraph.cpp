@@ -0,0 +1,113 @@
+#include "CompactGraph/compactgraph.hpp"
+#include "irbuilder.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+// `blocksCount` blocks in a chain, each starting with a phi of the previous
+// block's value and followed by `blockSize` multiply-add pairs.
+std::unique_ptr<Graph> BuildGraph(size_t blocksCount, size_t blockSize) {
+    auto graph = std::make_unique<Graph>();
+    IrBuilder builder(graph.get());
+
+    std::vector<BasicBlock*> blocks;
+    for(size_t idx = 0; idx < blocksCount; ++idx) {
+        blocks.push_back(builder.CreateBB());
+    }
+
+    builder.SetBasicBlockScope(blocks[0]);
+    Instruction* value = builder.CreateParameter(0);
+    auto *seven = builder.CreateInt64Constant(7);
+    for(size_t idx = 0; idx < blocksCount; ++idx) {
+        builder.SetBasicBlockScope(blocks[idx]);
+        if(idx != 0) {
+            auto *phi = builder.CreatePhi(DataType::U64);
+            phi->AddInput(value);
+            value = phi;
+        }
+        for(size_t instr = 0; instr < blockSize; ++instr) {
+            value = builder.CreateAdd(DataType::U64, builder.CreateMul(DataType::U64, value, seven), seven);
+        }
+        if(idx + 1 < blocksCount) {
+            builder.CreateJmp(blocks[idx + 1]);
+        }
+    }
+    builder.CreateRet(DataType::U64, value);
+    return graph;
+}
+
+template <typename Fn>
+double MeasureMs(size_t iterations, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    for(size_t idx = 0; idx < iterations; ++idx) {
+        fn();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+// Same scan twice: count phis, and count uses of every multiplication.
+struct ScanResult {
+    size_t phis = 0;
+    size_t mulUses = 0;
+};
+
+// The block-by-block list walk BasicBlock::Dump does.
+ScanResult ScanList(Graph* graph) {
+    ScanResult result;
+    for(auto &block: graph->GetBlocks()) {
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            if(instr->IsPhi()) {
+                ++result.phis;
+            } else if(instr->GetOpType() == OpType::MUL) {
+                result.mulUses += instr->GetUsesCount();
+            }
+        }
+    }
+    return result;
+}
+
+ScanResult ScanCompact(const CompactGraph &compact) {
+    ScanResult result;
+    auto opcodes = compact.GetOpTypes();
+    for(uint32_t idx = 0; idx < opcodes.size(); ++idx) {
+        if(opcodes[idx] == static_cast<uint8_t>(OpType::PHI)) {
+            ++result.phis;
+        } else if(opcodes[idx] == static_cast<uint8_t>(OpType::MUL)) {
+            result.mulUses += compact.GetUsers(idx).size();
+        }
+    }
+    return result;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t blocksCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+    size_t iterations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 20;
+
+    auto graph = BuildGraph(blocksCount, 16);
+    std::cout << "instructions: " << graph->GetInstructions().size() << std::endl;
+
+    ScanResult listResult;
+    double listMs = MeasureMs(iterations, [&graph, &listResult] { listResult = ScanList(graph.get()); });
+
+    double buildMs = MeasureMs(iterations, [&graph] { CompactGraph compact(graph.get()); });
+
+    CompactGraph compact(graph.get());
+    ScanResult compactResult;
+    double compactMs = MeasureMs(iterations, [&compact, &compactResult] { compactResult = ScanCompact(compact); });
+
+    if(listResult.phis != compactResult.phis || listResult.mulUses != compactResult.mulUses) {
+        std::cerr << "scan results differ" << std::endl;
+        return 1;
+    }
+
+    std::cout << "list walk:     " << listMs << " ms (" << listResult.phis << " phis, "
+              << listResult.mulUses << " mul uses)" << std::endl;
+    std::cout << "compact build: " << buildMs << " ms" << std::endl;
+    std::cout << "compact scan:  " << compactMs << " ms" << std::endl;
+    return 0;
+}
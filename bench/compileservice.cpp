@@ -0,0 +1,116 @@
+#include "Codegen/instrselector.hpp"
+#include "CompileService/compileservice.hpp"
+#include "GraphHash/graphhash.hpp"
+#include "Liveness/liveness.hpp"
+#include "LoopAnalyzer/loopanalyzer.hpp"
+#include "Scheduler/listscheduler.hpp"
+#include "irbuilder.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+// A chain of `loopsCount` counted loops, each body doing some arithmetic on
+// the accumulator.
+std::unique_ptr<Graph> BuildGraph(size_t loopsCount, size_t bodySize) {
+    auto graph = std::make_unique<Graph>();
+    IrBuilder builder(graph.get());
+
+    auto *entryBB = builder.CreateBB();
+    builder.SetBasicBlockScope(entryBB);
+    auto *n = builder.CreateParameter(0);
+    auto *zero = builder.CreateInt64Constant(0);
+    auto *one = builder.CreateInt64Constant(1);
+    auto *three = builder.CreateInt64Constant(3);
+    Instruction* acc = builder.CreateParameter(1);
+
+    auto *prevBB = entryBB;
+    for(size_t loop = 0; loop < loopsCount; ++loop) {
+        auto *header = builder.CreateBB();
+        auto *body = builder.CreateBB();
+        auto *exitBB = builder.CreateBB();
+
+        builder.SetBasicBlockScope(prevBB);
+        builder.CreateJmp(header);
+
+        builder.SetBasicBlockScope(header);
+        auto *i = builder.CreatePhi(DataType::U64);
+        auto *sum = builder.CreatePhi(DataType::U64);
+        builder.CreateJae(builder.CreateCmp(i, n), exitBB, body);
+
+        builder.SetBasicBlockScope(body);
+        Instruction* value = sum;
+        for(size_t idx = 0; idx < bodySize; ++idx) {
+            value = builder.CreateAdd(DataType::U64, builder.CreateMul(DataType::U64, value, three), i);
+        }
+        auto *next = builder.CreateAdd(DataType::U64, i, one);
+        builder.CreateJmp(header);
+
+        i->AddInput(zero);
+        i->AddInput(next);
+        sum->AddInput(acc);
+        sum->AddInput(value);
+
+        acc = sum;
+        prevBB = exitBB;
+    }
+
+    builder.SetBasicBlockScope(prevBB);
+    builder.CreateRet(DataType::U64, acc);
+    return graph;
+}
+
+CompiledCode Compile(Graph* graph) {
+    LoopAnalyzer loops(graph);
+    loops.Analyze();
+    LivenessAnalyzer liveness(graph);
+    liveness.Analyze();
+    ListScheduler(graph).Run();
+    auto function = InstructionSelector(graph).Run();
+
+    CompiledCode code;
+    for(auto &block: function.GetBlocks()) {
+        for(auto &instr: block.instrs) {
+            code.code.push_back(static_cast<uint8_t>(instr.opcode));
+        }
+    }
+    uint64_t hash = GraphHasher(graph).Run();
+    code.relocations.push_back(Relocation {0, RelocationKind::ABS64, 0, hash});
+    return code;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t graphsCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 256;
+    size_t maxWorkers = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : std::thread::hardware_concurrency();
+    maxWorkers = std::max<size_t>(maxWorkers, 1);
+
+    std::vector<std::unique_ptr<Graph>> graphs;
+    for(size_t idx = 0; idx < graphsCount; ++idx) {
+        graphs.push_back(BuildGraph(16, 32));
+    }
+
+    std::cout << "graphs: " << graphsCount << std::endl;
+    double baseline = 0;
+    for(size_t workers = 1; workers <= maxWorkers; workers *= 2) {
+        CompileService service(Compile, workers, graphsCount);
+
+        auto start = std::chrono::steady_clock::now();
+        for(size_t idx = 0; idx < graphsCount; ++idx) {
+            service.Submit(graphs[idx].get(), idx);
+        }
+        service.WaitIdle();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        if(workers == 1) {
+            baseline = ms;
+        }
+        std::cout << "workers " << workers << ": " << ms << " ms, speedup " << baseline / ms
+                  << ", steals " << service.GetStealsCount() << std::endl;
+    }
+    return 0;
+}
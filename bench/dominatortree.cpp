@@ -0,0 +1,106 @@
+#include "DominatorTree/dominatortree.hpp"
+#include "Graph/graph.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+namespace {
+
+// The entry fans out into `armsCount` arms that meet again in an exit block.
+// Every arm is a chain of `DIAMONDS_PER_ARM` diamonds: head -> left, right -> join.
+// Returns the heads.
+constexpr size_t DIAMONDS_PER_ARM = 4;
+
+std::vector<BasicBlock*> BuildArms(Graph* graph, size_t armsCount) {
+    auto create = [graph] {
+        graph->AddBlock(std::make_unique<BasicBlock>());
+        return graph->GetBlocks().back().get();
+    };
+    auto link = [](BasicBlock* from, BasicBlock* to) {
+        from->AddSuccessor(to);
+        to->AddPredecessor(from);
+    };
+
+    auto *entry = create();
+    auto *exit = create();
+    std::vector<BasicBlock*> heads;
+    for(size_t arm = 0; arm < armsCount; ++arm) {
+        auto *head = create();
+        link(entry, head);
+        for(size_t idx = 0; idx < DIAMONDS_PER_ARM; ++idx) {
+            auto *left = create();
+            auto *right = create();
+            auto *join = create();
+            link(head, left);
+            link(head, right);
+            link(left, join);
+            link(right, join);
+            heads.push_back(head);
+            head = join;
+        }
+        link(head, exit);
+    }
+    return heads;
+}
+
+template <typename Fn>
+double MeasureMs(size_t iterations, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    for(size_t idx = 0; idx < iterations; ++idx) {
+        fn();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+}  // namespace
+
+// Every iteration deletes the edge into the left side of a random diamond, which
+// moves the diamond's join, then puts it back. The rebuild variant pays for a
+// full Build after each of the two edits.
+int main(int argc, char** argv) {
+    size_t armsCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2500;
+    size_t iterations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 200;
+
+    Graph graph;
+    auto heads = BuildArms(&graph, armsCount);
+    std::cout << "blocks: " << graph.GetBlocks().size() << std::endl;
+
+    std::mt19937 random(42);
+    auto edit = [&heads, &random](auto &&onDelete, auto &&onInsert) {
+        auto *head = heads[random() % heads.size()];
+        auto *left = head->GetSuccessors()[0];
+        head->RemoveSuccessor(left);
+        left->RemovePredecessor(head);
+        onDelete(head, left);
+        head->AddSuccessor(left);
+        left->AddPredecessor(head);
+        onInsert(head, left);
+    };
+
+    DominatorTree rebuilt(&graph);
+    double buildMs = MeasureMs(iterations, [&edit, &rebuilt] {
+        auto build = [&rebuilt](BasicBlock*, BasicBlock*) { rebuilt.Build(); };
+        edit(build, build);
+    });
+
+    DominatorTree updated(&graph);
+    updated.Build();
+    double updateMs = MeasureMs(iterations, [&edit, &updated] {
+        edit([&updated](BasicBlock* from, BasicBlock* to) { updated.DeleteEdge(from, to); },
+             [&updated](BasicBlock* from, BasicBlock* to) { updated.InsertEdge(from, to); });
+    });
+
+    rebuilt.Build();
+    for(auto &block: graph.GetBlocks()) {
+        if(updated.GetImmediateDominator(block.get()) != rebuilt.GetImmediateDominator(block.get())) {
+            std::cerr << "trees differ at block " << block->GetId() << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "rebuild: " << buildMs << " ms per edit pair" << std::endl;
+    std::cout << "update:  " << updateMs << " ms per edit pair" << std::endl;
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include "Serialization/graphserializer.hpp"
+#include "irbuilder.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+// `blocksCount` blocks in a chain, each with `blockSize` arithmetic instructions.
+std::unique_ptr<Graph> BuildGraph(size_t blocksCount, size_t blockSize) {
+    auto graph = std::make_unique<Graph>();
+    IrBuilder builder(graph.get());
+
+    std::vector<BasicBlock*> blocks;
+    for(size_t idx = 0; idx < blocksCount; ++idx) {
+        blocks.push_back(builder.CreateBB());
+    }
+
+    builder.SetBasicBlockScope(blocks[0]);
+    Instruction* value = builder.CreateParameter(0);
+    auto *seven = builder.CreateInt64Constant(7);
+    for(size_t idx = 0; idx < blocksCount; ++idx) {
+        builder.SetBasicBlockScope(blocks[idx]);
+        for(size_t instr = 0; instr < blockSize; ++instr) {
+            value = builder.CreateAdd(DataType::U64, builder.CreateMul(DataType::U64, value, seven), seven);
+        }
+        if(idx + 1 < blocksCount) {
+            builder.CreateJmp(blocks[idx + 1]);
+        }
+    }
+    builder.CreateRet(DataType::U64, value);
+    return graph;
+}
+
+template <typename Fn>
+double MeasureMs(size_t iterations, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    for(size_t idx = 0; idx < iterations; ++idx) {
+        fn();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t blocksCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+    size_t iterations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 20;
+
+    auto graph = BuildGraph(blocksCount, 16);
+    std::cout << "instructions: " << graph->GetInstructions().size() << std::endl;
+
+    size_t textSize = 0;
+    double textMs = MeasureMs(iterations, [&graph, &textSize] {
+        std::stringstream ss;
+        graph->Dump(ss);
+        textSize = ss.str().size();
+    });
+
+    std::vector<uint8_t> image;
+    double binaryMs = MeasureMs(iterations, [&graph, &image] {
+        image = *GraphSerializer(graph.get()).Run();
+    });
+
+    size_t opcodesSum = 0;
+    double viewMs = MeasureMs(iterations, [&image, &opcodesSum] {
+        auto view = GraphImageView::Create(image.data(), image.size());
+        for(size_t id = 0; id < view->GetInstructionsCount(); ++id) {
+            opcodesSum += view->GetInstruction(id).opcode;
+        }
+    });
+
+    double buildMs = MeasureMs(iterations, [&image] {
+        auto view = GraphImageView::Create(image.data(), image.size());
+        auto rebuilt = GraphDeserializer(*view).Run();
+    });
+
+    std::cout << "text dump:    " << textMs << " ms, " << textSize << " bytes" << std::endl;
+    std::cout << "binary write: " << binaryMs << " ms, " << image.size() << " bytes" << std::endl;
+    std::cout << "view + scan:  " << viewMs << " ms (checksum " << opcodesSum << ")" << std::endl;
+    std::cout << "rebuild:      " << buildMs << " ms" << std::endl;
+    return 0;
+}
@@ -2,6 +2,13 @@
 
 #include <iostream>
 
+namespace {
+
+constexpr uint32_t RESULT = 0;
+constexpr uint32_t COUNTER = 1;
+
+}  // namespace
+
 int main() {
     Graph graph;
     IrBuilder builder(&graph);
@@ -12,33 +19,34 @@ int main() {
     auto *bb3 = builder.CreateBB();
 
     builder.SetBasicBlockScope(entryBB);
+    builder.SealBlock(entryBB);
     auto *v0 = builder.CreateParameter(0);
-    auto *v1 = builder.CreateInt64Constant(1);
-    auto *v2 = builder.CreateInt64Constant(2);
+    // Header phis take the type of the first write: a U64 result, a U32 counter.
+    auto *v1 = builder.CreateConstant(uint64_t{1}, DataType::U64);
+    auto *v2 = builder.CreateConstant(uint64_t{2}, DataType::U32);
+    auto *v3 = builder.CreateConstant(uint64_t{1}, DataType::U32);
+    builder.WriteVariable(RESULT, v1);
+    builder.WriteVariable(COUNTER, v2);
     builder.CreateJmp(bb1);
 
     builder.SetBasicBlockScope(bb1);
-    auto *v4 = builder.CreatePhi(DataType::U64);
-    auto *v5 = builder.CreatePhi(DataType::U32);
-    auto *v6 = builder.CreateCmp(v5, v0);
+    auto *v6 = builder.CreateCmp(builder.ReadVariable(COUNTER), v0);
     builder.CreateJa(v6, bb3, bb2);
 
     builder.SetBasicBlockScope(bb2);
-    auto *v8 = builder.CreateMul(DataType::U64, v4, v5);
-    auto *v9 = builder.CreateAdd(DataType::U32, v5, v1);
+    builder.SealBlock(bb2);
+    auto *counter = builder.ReadVariable(COUNTER);
+    builder.WriteVariable(RESULT, builder.CreateMul(DataType::U64, builder.ReadVariable(RESULT), counter));
+    builder.WriteVariable(COUNTER, builder.CreateAdd(DataType::U32, counter, v3));
     builder.CreateJmp(bb1);
-
-    v4->AddInput(v1);
-    v4->AddInput(v8);
-
-    v5->AddInput(v2);
-    v5->AddInput(v9);
+    builder.SealBlock(bb1);
 
     builder.SetBasicBlockScope(bb3);
-    builder.CreateRet(DataType::U64, v4);
+    builder.SealBlock(bb3);
+    builder.CreateRet(DataType::U64, builder.ReadVariable(RESULT));
 
     std::stringstream ss;
     graph.Dump(ss);
     std::cout << ss.str() << std::endl;
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,303 @@
+#include <gtest/gtest.h>
+
+#include "AliasAnalysis/loadelimination.hpp"
+#include "EscapeAnalysis/scalarreplacement.hpp"
+#include "Interpreter/interpreter.hpp"
+#include "irbuilder.hpp"
+#include "testutils.hpp"
+
+#include <optional>
+
+namespace {
+
+constexpr uint32_t FIRST = 0;
+constexpr uint32_t SECOND = 1;
+constexpr uint32_t IV = 2;
+
+// object = new 2; [object + 2] = 0x11223344 as u32; [object + 6] = -2 as i16
+// ret [object + offset] as type
+std::optional<uint64_t> LoadFromPattern(DataType type, int64_t offset) {
+    Graph graph;
+    IrBuilder builder(&graph);
+    builder.SetBasicBlockScope(builder.CreateBB());
+    auto *object = builder.CreateNewObject(2);
+    builder.CreateStore(object, 2, builder.CreateInt32Constant(0x11223344));
+    builder.CreateStore(object, 6, builder.CreateConstant(static_cast<uint64_t>(-2), DataType::I16));
+    builder.CreateRet(type, builder.CreateLoad(type, object, offset));
+    return Interpreter(&graph).Run({});
+}
+
+// Ends in a new block where FIRST and SECOND hold references to two objects
+// of 2 fields, in an order chosen by the first parameter.
+BasicBlock* BuildSelectedObjects(IrBuilder &builder) {
+    auto *entry = builder.CreateBB();
+    auto *direct = builder.CreateBB();
+    auto *swapped = builder.CreateBB();
+    auto *merge = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    builder.SealBlock(entry);
+    auto *lhs = builder.CreateNewObject(2);
+    auto *rhs = builder.CreateNewObject(2);
+    builder.CreateJae(builder.CreateCmp(builder.CreateParameter(0), builder.CreateInt32Constant(10)),
+                      swapped, direct);
+
+    builder.SetBasicBlockScope(direct);
+    builder.SealBlock(direct);
+    builder.WriteVariable(FIRST, lhs);
+    builder.WriteVariable(SECOND, rhs);
+    builder.CreateJmp(merge);
+
+    builder.SetBasicBlockScope(swapped);
+    builder.SealBlock(swapped);
+    builder.WriteVariable(FIRST, rhs);
+    builder.WriteVariable(SECOND, lhs);
+    builder.CreateJmp(merge);
+
+    builder.SetBasicBlockScope(merge);
+    builder.SealBlock(merge);
+    return merge;
+}
+
+/*
+    first.0 = a; high = first.4; if(b >= 10) first.0 = b; else first.8 = first.0
+    ret first.0 + high + first.4
+*/
+void BuildDiamond(Graph* graph) {
+    IrBuilder builder(graph);
+    auto *merge = BuildSelectedObjects(builder);
+    auto *stores = builder.CreateBB();
+    auto *keeps = builder.CreateBB();
+    auto *exit = builder.CreateBB();
+
+    builder.SetBasicBlockScope(merge);
+    auto *first = builder.ReadVariable(FIRST);
+    auto *a = builder.CreateParameter(0);
+    auto *b = builder.CreateParameter(1);
+    builder.CreateStore(first, 0, a);
+    auto *high = builder.CreateLoad(DataType::U32, first, 4);
+    builder.CreateJae(builder.CreateCmp(b, builder.CreateInt32Constant(10)), stores, keeps);
+
+    builder.SetBasicBlockScope(stores);
+    builder.SealBlock(stores);
+    builder.CreateStore(first, 0, b);
+    builder.CreateJmp(exit);
+
+    builder.SetBasicBlockScope(keeps);
+    builder.SealBlock(keeps);
+    builder.CreateStore(first, 8, builder.CreateLoad(DataType::U32, first, 0));
+    builder.CreateJmp(exit);
+
+    builder.SetBasicBlockScope(exit);
+    builder.SealBlock(exit);
+    auto *sum = builder.CreateAdd(DataType::U32, builder.CreateLoad(DataType::U32, first, 0), high);
+    auto *last = builder.CreateLoad(DataType::U32, first, 4);
+    builder.CreateRet(DataType::U32, builder.CreateAdd(DataType::U32, sum, last));
+}
+
+/*
+    first.0 = a as u32; first.8 = 0
+    for(i = 0; i < n; ++i) first.8 = first.8 + first.0 * i
+    ret first.8
+*/
+void BuildAccumulatorLoop(Graph* graph) {
+    IrBuilder builder(graph);
+    auto *merge = BuildSelectedObjects(builder);
+    auto *header = builder.CreateBB();
+    auto *body = builder.CreateBB();
+    auto *exit = builder.CreateBB();
+
+    builder.SetBasicBlockScope(merge);
+    auto *first = builder.ReadVariable(FIRST);
+    auto *n = builder.CreateParameter(1);
+    builder.CreateStore(first, 0, builder.CreateParameter(0));
+    builder.CreateStore(first, 8, builder.CreateInt32Constant(0));
+    builder.WriteVariable(IV, builder.CreateInt32Constant(0));
+    builder.CreateJmp(header);
+
+    builder.SetBasicBlockScope(header);
+    auto *iv = builder.ReadVariable(IV);
+    builder.CreateJae(builder.CreateCmp(iv, n), exit, body);
+
+    builder.SetBasicBlockScope(body);
+    builder.SealBlock(body);
+    auto *product = builder.CreateMul(DataType::U32, builder.CreateLoad(DataType::U32, first, 0), iv);
+    auto *sum = builder.CreateLoad(DataType::U32, first, 8);
+    builder.CreateStore(first, 8, builder.CreateAdd(DataType::U32, sum, product));
+    builder.WriteVariable(IV, builder.CreateAdd(DataType::U32, iv, builder.CreateInt32Constant(1)));
+    builder.CreateJmp(header);
+    builder.SealBlock(header);
+
+    builder.SetBasicBlockScope(exit);
+    builder.SealBlock(exit);
+    builder.CreateRet(DataType::U32, builder.CreateLoad(DataType::U32, first, 8));
+}
+
+}  // namespace
+
+class AliasAnalysisTest: public ::testing::Test {
+protected:
+    Graph graph_;
+};
+
+TEST_F(AliasAnalysisTest, INTERPRETER_BYTE_ACCESSES) {
+    EXPECT_EQ(LoadFromPattern(DataType::U16, 3), 0x2233);
+    EXPECT_EQ(LoadFromPattern(DataType::U64, 0), 0xfffe112233440000);
+    EXPECT_EQ(LoadFromPattern(DataType::I8, 7), static_cast<uint64_t>(-1));
+    EXPECT_EQ(LoadFromPattern(DataType::U32, 12), 0);
+    EXPECT_EQ(LoadFromPattern(DataType::U32, 13), std::nullopt);
+    EXPECT_EQ(LoadFromPattern(DataType::U8, -1), std::nullopt);
+
+    // Fields are the same bytes, 8 per field.
+    IrBuilder builder(&graph_);
+    builder.SetBasicBlockScope(builder.CreateBB());
+    auto *object = builder.CreateNewObject(2);
+    builder.CreateStoreField(object, 1, builder.CreateInt64Constant(0x0102030405060708));
+    builder.CreateStore(object, 8, builder.CreateConstant(uint64_t{0xff}, DataType::U8));
+    builder.CreateRet(DataType::U64, builder.CreateLoadField(DataType::U64, object, 1));
+    EXPECT_EQ(Interpreter(&graph_).Run({}), 0x01020304050607ff);
+}
+
+TEST_F(AliasAnalysisTest, ALIAS_QUERIES) {
+    IrBuilder builder(&graph_);
+    BuildSelectedObjects(builder);
+    auto *first = builder.ReadVariable(FIRST);
+    auto *second = builder.ReadVariable(SECOND);
+    auto *a = builder.CreateParameter(1);
+    auto *local = builder.CreateNewObject(1);
+    auto *other = builder.CreateNewObject(1);
+    auto *leaked = builder.CreateNewObject(1);
+    builder.CreateStore(first, 0, leaked);
+
+    auto *store = builder.CreateStore(first, 0, a);
+    auto *same = builder.CreateLoad(DataType::U32, first, 0);
+    auto *next = builder.CreateLoad(DataType::U32, first, 4);
+    auto *straddling = builder.CreateLoad(DataType::U32, first, 2);
+    auto *narrow = builder.CreateLoad(DataType::U16, first, 0);
+    auto *throughSecond = builder.CreateLoad(DataType::U32, second, 0);
+    auto *field = builder.CreateLoadField(DataType::U64, first, 1);
+    auto *wide = builder.CreateLoad(DataType::I64, first, 8);
+    auto *localLoad = builder.CreateLoad(DataType::U32, local, 0);
+    auto *otherLoad = builder.CreateLoad(DataType::U32, other, 0);
+    auto *leakedLoad = builder.CreateLoad(DataType::U32, leaked, 0);
+    auto *sum = builder.CreateAdd(DataType::U32, same, next);
+    builder.CreateRet(DataType::U32, sum);
+
+    EXPECT_EQ(AliasAnalysis::Alias(store, same), AliasResult::MUST_ALIAS);
+    EXPECT_EQ(AliasAnalysis::Alias(store, next), AliasResult::NO_ALIAS);
+    EXPECT_EQ(AliasAnalysis::Alias(store, straddling), AliasResult::MAY_ALIAS);
+    EXPECT_EQ(AliasAnalysis::Alias(store, narrow), AliasResult::MAY_ALIAS);
+    EXPECT_EQ(AliasAnalysis::Alias(store, throughSecond), AliasResult::MAY_ALIAS);
+    EXPECT_EQ(AliasAnalysis::Alias(field, wide), AliasResult::MUST_ALIAS);
+    EXPECT_EQ(AliasAnalysis::Alias(field, next), AliasResult::NO_ALIAS);
+    EXPECT_EQ(AliasAnalysis::Alias(localLoad, same), AliasResult::NO_ALIAS);
+    EXPECT_EQ(AliasAnalysis::Alias(otherLoad, localLoad), AliasResult::NO_ALIAS);
+    EXPECT_EQ(AliasAnalysis::Alias(leakedLoad, otherLoad), AliasResult::NO_ALIAS);
+    EXPECT_EQ(AliasAnalysis::Alias(leakedLoad, same), AliasResult::MAY_ALIAS);
+
+    auto location = AliasAnalysis::GetLocation(field);
+    ASSERT_TRUE(location.has_value());
+    EXPECT_EQ(location->base, first);
+    EXPECT_EQ(location->offset, 8);
+    EXPECT_EQ(location->size, 8);
+    EXPECT_EQ(AliasAnalysis::GetLocation(sum), std::nullopt);
+    EXPECT_EQ(AliasAnalysis::Alias(sum, same), AliasResult::MAY_ALIAS);
+}
+
+TEST_F(AliasAnalysisTest, FORWARDS_VALUES_IN_BLOCK) {
+    /*
+        first.0 = a as u32; x = first.0; y = first.4; first.8 = a; z = first.4; w = first.0 as u16
+        second.0 = a; v = first.4
+        ret x + y + z + v
+    */
+    IrBuilder builder(&graph_);
+    BuildSelectedObjects(builder);
+    auto *first = builder.ReadVariable(FIRST);
+    auto *a = builder.CreateParameter(0);
+    builder.CreateStore(first, 0, a);
+    auto *x = builder.CreateLoad(DataType::U32, first, 0);
+    auto *y = builder.CreateLoad(DataType::U32, first, 4);
+    builder.CreateStore(first, 8, a);
+    auto *z = builder.CreateLoad(DataType::U32, first, 4);
+    auto *w = builder.CreateLoad(DataType::U16, first, 0);
+    builder.CreateStore(builder.ReadVariable(SECOND), 0, a);
+    auto *v = builder.CreateLoad(DataType::U32, first, 4);
+    auto *sum = builder.CreateAdd(DataType::U32, x, y);
+    sum = builder.CreateAdd(DataType::U32, sum, z);
+    builder.CreateRet(DataType::U32, builder.CreateAdd(DataType::U32, sum, v));
+
+    Interpreter interpreter(&graph_);
+    auto expected = std::vector {interpreter.Run({3}), interpreter.Run({0x10020})};
+
+    EXPECT_EQ(LoadElimination(&graph_).Run(), 2);
+    EXPECT_EQ(x->GetParentBB(), nullptr);
+    EXPECT_EQ(z->GetParentBB(), nullptr);
+    EXPECT_NE(w->GetParentBB(), nullptr);
+    EXPECT_NE(v->GetParentBB(), nullptr);
+    EXPECT_EQ(interpreter.Run({3}), expected[0]);
+    EXPECT_EQ(interpreter.Run({0x10020}), expected[1]);
+}
+
+TEST_F(AliasAnalysisTest, FORWARDS_VALUES_ACROSS_BLOCKS) {
+    BuildDiamond(&graph_);
+    Graph original;
+    BuildDiamond(&original);
+
+    // The load in the non-storing branch and the last load of first.4.
+    EXPECT_EQ(LoadElimination(&graph_).Run(), 2);
+    EXPECT_EQ(CountOpcode(&graph_, OpType::LOAD), 2);
+
+    Interpreter originalInterpreter(&original);
+    Interpreter interpreter(&graph_);
+    for(uint64_t a: {0, 5, 20}) {
+        for(uint64_t b: {1, 10, 70}) {
+            EXPECT_EQ(interpreter.Run({a, b}), originalInterpreter.Run({a, b})) << "a = " << a << ", b = " << b;
+        }
+    }
+}
+
+TEST_F(AliasAnalysisTest, STORES_IN_LOOP_KILL_VALUES) {
+    BuildAccumulatorLoop(&graph_);
+    Graph original;
+    BuildAccumulatorLoop(&original);
+
+    // Only first.0 is never stored in the loop.
+    EXPECT_EQ(LoadElimination(&graph_).Run(), 1);
+    EXPECT_EQ(CountOpcode(&graph_, OpType::LOAD), 2);
+
+    Interpreter originalInterpreter(&original);
+    Interpreter interpreter(&graph_);
+    for(uint64_t a: {0, 3, 20}) {
+        for(uint64_t n: {0, 1, 4}) {
+            EXPECT_EQ(interpreter.Run({a, n}), originalInterpreter.Run({a, n})) << "a = " << a << ", n = " << n;
+        }
+    }
+    EXPECT_EQ(interpreter.Run({3, 4}), 18);
+}
+
+TEST_F(AliasAnalysisTest, ESCAPE_ANALYSIS_SEES_OVERLAPPING_LOADS) {
+    /*
+        holder = new 2, peeked = new 1, kept = new 1
+        [holder + 0] = peeked; [holder + 8] = kept
+        [[holder + 8] as ref + 0] = 1; ret [holder + 4] as u32
+    */
+    IrBuilder builder(&graph_);
+    builder.SetBasicBlockScope(builder.CreateBB());
+    auto *holder = builder.CreateNewObject(2);
+    auto *peeked = builder.CreateNewObject(1);
+    auto *kept = builder.CreateNewObject(1);
+    builder.CreateStore(holder, 0, peeked);
+    builder.CreateStore(holder, 8, kept);
+    builder.CreateStore(builder.CreateLoad(DataType::REF, holder, 8), 0, builder.CreateInt32Constant(1));
+    builder.CreateRet(DataType::U32, builder.CreateLoad(DataType::U32, holder, 4));
+
+    EscapeAnalysis analysis(&graph_);
+    analysis.Analyze();
+    EXPECT_FALSE(analysis.Escapes(holder));
+    EXPECT_TRUE(analysis.Escapes(peeked));
+    EXPECT_FALSE(analysis.Escapes(kept));
+
+    // Byte accesses are not fields, so the objects stay.
+    EXPECT_EQ(ScalarReplacement(&graph_).Run(), 0);
+    EXPECT_EQ(CountOpcode(&graph_, OpType::NEW_OBJECT), 3);
+}
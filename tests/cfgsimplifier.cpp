@@ -0,0 +1,196 @@
+#include <gtest/gtest.h>
+
+#include "CFGSimplifier/cfgsimplifier.hpp"
+#include "Interpreter/interpreter.hpp"
+#include "irbuilder.hpp"
+#include "testutils.hpp"
+
+namespace {
+
+/*
+    x = a + b; jmp next; y = x * 2; jmp last; ret y - a
+*/
+void BuildChain(Graph* graph) {
+    IrBuilder builder(graph);
+    auto *entry = builder.CreateBB();
+    auto *next = builder.CreateBB();
+    auto *last = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    auto *a = builder.CreateParameter(0);
+    auto *b = builder.CreateParameter(1);
+    auto *x = builder.CreateAdd(DataType::U32, a, b);
+    builder.CreateJmp(next);
+
+    builder.SetBasicBlockScope(next);
+    auto *y = builder.CreateMul(DataType::U32, x, builder.CreateInt32Constant(2));
+    builder.CreateJmp(last);
+
+    builder.SetBasicBlockScope(last);
+    builder.CreateRet(DataType::U32, builder.CreateSub(DataType::U32, y, a));
+}
+
+/*
+    if(a >= 10) x = a else x = a * b
+    ret x + b
+    with the first arm an empty block
+*/
+void BuildEmptyArm(Graph* graph) {
+    IrBuilder builder(graph);
+    auto *entry = builder.CreateBB();
+    auto *empty = builder.CreateBB();
+    auto *computes = builder.CreateBB();
+    auto *merge = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    auto *a = builder.CreateParameter(0);
+    auto *b = builder.CreateParameter(1);
+    builder.CreateJae(builder.CreateCmp(a, builder.CreateInt32Constant(10)), empty, computes);
+
+    builder.SetBasicBlockScope(empty);
+    builder.CreateJmp(merge);
+
+    builder.SetBasicBlockScope(computes);
+    auto *product = builder.CreateMul(DataType::U32, a, b);
+    builder.CreateJmp(merge);
+
+    builder.SetBasicBlockScope(merge);
+    auto *x = builder.CreatePhi(DataType::U32);
+    x->AddInput(a);
+    x->AddInput(product);
+    builder.CreateRet(DataType::U32, builder.CreateAdd(DataType::U32, x, b));
+}
+
+/*
+    if(a >= 10) x = b else x = a
+    ret x
+    with the first arm an empty block and the second one the branch edge
+*/
+void BuildConflictingPhi(Graph* graph) {
+    IrBuilder builder(graph);
+    auto *entry = builder.CreateBB();
+    auto *empty = builder.CreateBB();
+    auto *merge = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    auto *a = builder.CreateParameter(0);
+    auto *b = builder.CreateParameter(1);
+    builder.CreateJae(builder.CreateCmp(a, builder.CreateInt32Constant(10)), empty, merge);
+
+    builder.SetBasicBlockScope(empty);
+    builder.CreateJmp(merge);
+
+    builder.SetBasicBlockScope(merge);
+    auto *x = builder.CreatePhi(DataType::U32);
+    x->AddInput(a);
+    x->AddInput(b);
+    builder.CreateRet(DataType::U32, x);
+}
+
+}  // namespace
+
+class CFGSimplifierTest: public ::testing::Test {
+protected:
+    Graph graph_;
+};
+
+TEST_F(CFGSimplifierTest, JUMP_CHAIN_MERGED) {
+    BuildChain(&graph_);
+    CFGSimplifier pass(&graph_);
+    EXPECT_EQ(pass.Run(), 2);
+    ASSERT_EQ(graph_.GetBlocks().size(), 1);
+    EXPECT_EQ(CountOpcode(&graph_, OpType::JMP), 0);
+    EXPECT_TRUE(graph_.GetStartBlock()->GetSuccessors().empty());
+    ExpectSameResults(BuildChain, &graph_);
+}
+
+TEST_F(CFGSimplifierTest, EMPTY_BLOCK_BYPASSED) {
+    BuildEmptyArm(&graph_);
+    auto *entry = graph_.GetStartBlock();
+    auto *computes = graph_.GetBlocks()[2].get();
+    auto *merge = graph_.GetBlocks()[3].get();
+
+    CFGSimplifier pass(&graph_);
+    EXPECT_EQ(pass.Run(), 1);
+    ASSERT_EQ(graph_.GetBlocks().size(), 3);
+    auto *branch = static_cast<CjmpInstr*>(entry->GetLastInstr());
+    EXPECT_EQ(branch->GetTrueBranchBB(), merge);
+    EXPECT_EQ(entry->GetSuccessors(), (std::vector<BasicBlock*> {merge, computes}));
+    EXPECT_EQ(merge->GetPredecessors(), (std::vector<BasicBlock*> {computes, entry}));
+    auto *phi = static_cast<PhiInstr*>(merge->GetFirstInstr());
+    ASSERT_EQ(phi->GetInputs().size(), 2);
+    EXPECT_EQ(phi->GetPhiInput(entry)->GetOpType(), OpType::PRM);
+    EXPECT_EQ(phi->GetPhiInput(computes)->GetOpType(), OpType::MUL);
+    ExpectSameResults(BuildEmptyArm, &graph_);
+}
+
+TEST_F(CFGSimplifierTest, CONFLICTING_PHI_INPUTS_KEEP_BLOCK) {
+    BuildConflictingPhi(&graph_);
+    CFGSimplifier pass(&graph_);
+    EXPECT_EQ(pass.Run(), 0);
+    EXPECT_EQ(graph_.GetBlocks().size(), 3);
+}
+
+TEST_F(CFGSimplifierTest, SAME_TARGET_BRANCH_COLLAPSED) {
+    /*
+        cmp a, 10; jae next, next; next: ret phi(a, a) + 1
+    */
+    IrBuilder builder(&graph_);
+    auto *entry = builder.CreateBB();
+    auto *next = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    auto *a = builder.CreateParameter(0);
+    builder.CreateJae(builder.CreateCmp(a, builder.CreateInt32Constant(10)), next, next);
+
+    builder.SetBasicBlockScope(next);
+    auto *phi = builder.CreatePhi(DataType::U32);
+    phi->AddInput(a);
+    phi->AddInput(a);
+    builder.CreateRet(DataType::U32, builder.CreateAdd(DataType::U32, phi, builder.CreateInt32Constant(1)));
+
+    CFGSimplifier pass(&graph_);
+    EXPECT_EQ(pass.Run(), 2);
+    ASSERT_EQ(graph_.GetBlocks().size(), 1);
+    EXPECT_EQ(CountOpcode(&graph_, OpType::CMP), 0);
+    EXPECT_EQ(CountOpcode(&graph_, OpType::PHI), 0);
+    EXPECT_EQ(Interpreter(&graph_).Run({4}), 5);
+}
+
+TEST_F(CFGSimplifierTest, UNREACHABLE_BLOCK_REMOVED) {
+    IrBuilder builder(&graph_);
+    auto *entry = builder.CreateBB();
+    auto *dead = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    builder.CreateRet(DataType::U32, builder.CreateParameter(0));
+
+    builder.SetBasicBlockScope(dead);
+    builder.CreateRet(DataType::U32, builder.CreateInt32Constant(0));
+
+    CFGSimplifier pass(&graph_);
+    EXPECT_EQ(pass.Run(), 1);
+    EXPECT_EQ(graph_.GetBlocks().size(), 1);
+}
+
+TEST_F(CFGSimplifierTest, CRITICAL_EDGES_SPLIT) {
+    BuildConflictingPhi(&graph_);
+    auto *entry = graph_.GetStartBlock();
+    auto *empty = graph_.GetBlocks()[1].get();
+    auto *merge = graph_.GetBlocks()[2].get();
+
+    // Only the branch edge to merge is critical.
+    EXPECT_EQ(graph_.SplitCriticalEdges(), 1);
+    ASSERT_EQ(graph_.GetBlocks().size(), 4);
+    auto *split = graph_.GetBlocks()[3].get();
+    EXPECT_EQ(entry->GetSuccessors(), (std::vector<BasicBlock*> {empty, split}));
+    EXPECT_EQ(merge->GetPredecessors(), (std::vector<BasicBlock*> {split, empty}));
+    EXPECT_EQ(graph_.SplitCriticalEdges(), 0);
+    ExpectSameResults(BuildConflictingPhi, &graph_);
+
+    // Once the edge is split either arm can go, but not both.
+    CFGSimplifier pass(&graph_);
+    EXPECT_EQ(pass.Run(), 1);
+    EXPECT_EQ(graph_.GetBlocks().size(), 3);
+    ExpectSameResults(BuildConflictingPhi, &graph_);
+}
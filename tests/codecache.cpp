@@ -0,0 +1,207 @@
+#include <gtest/gtest.h>
+
+#include "CodeCache/codecache.hpp"
+#include "GraphHash/graphhash.hpp"
+#include "Interpreter/interpreter.hpp"
+#include "irbuilder.hpp"
+
+class CodeCacheTest: public ::testing::Test {
+protected:
+    /*
+        BB_0: v0 = param 0, v1 = const 1, v2 = const init; jmp BB_1
+        BB_1: v4 = phi(v1, v8), v5 = phi(v2, v9), cmp v5, v0; ja BB_3, BB_2
+        BB_2: v8 = mul v4, v5, v9 = add v5, v1; jmp BB_1
+        BB_3: ret v4
+    */
+    std::unique_ptr<Graph> BuildLoopGraph(uint64_t init) {
+        auto graph = std::make_unique<Graph>();
+        IrBuilder builder(graph.get());
+
+        auto *entryBB = builder.CreateBB();
+        auto *bb1 = builder.CreateBB();
+        auto *bb2 = builder.CreateBB();
+        auto *bb3 = builder.CreateBB();
+
+        builder.SetBasicBlockScope(entryBB);
+        auto *v0 = builder.CreateParameter(0);
+        auto *v1 = builder.CreateInt64Constant(1);
+        auto *v2 = builder.CreateInt64Constant(init);
+        builder.CreateJmp(bb1);
+
+        builder.SetBasicBlockScope(bb1);
+        auto *v4 = builder.CreatePhi(DataType::U64);
+        auto *v5 = builder.CreatePhi(DataType::U32);
+        auto *v6 = builder.CreateCmp(v5, v0);
+        builder.CreateJa(v6, bb3, bb2);
+
+        builder.SetBasicBlockScope(bb2);
+        auto *v8 = builder.CreateMul(DataType::U64, v4, v5);
+        auto *v9 = builder.CreateAdd(DataType::U32, v5, v1);
+        builder.CreateJmp(bb1);
+
+        v4->AddInput(v1);
+        v4->AddInput(v8);
+        v5->AddInput(v2);
+        v5->AddInput(v9);
+
+        builder.SetBasicBlockScope(bb3);
+        builder.CreateRet(DataType::U64, v4);
+
+        return graph;
+    }
+
+    /*
+        BB_0: v0 = param 0, v1 = const 0, v2 = const 1, v3 = const 2, cmp v0, v1; je BB_1, BB_2
+        BB_1: jmp BB_3
+        BB_2: jmp BB_3
+        BB_3: v7 = phi(v2, v3); ret v7
+        BB_3 has predecessors BB_1, BB_2 or, when swapped, BB_2, BB_1.
+    */
+    std::unique_ptr<Graph> BuildDiamondGraph(bool swapPredecessors) {
+        auto graph = std::make_unique<Graph>();
+        IrBuilder builder(graph.get());
+
+        auto *entryBB = builder.CreateBB();
+        auto *bb1 = builder.CreateBB();
+        auto *bb2 = builder.CreateBB();
+        auto *bb3 = builder.CreateBB();
+
+        builder.SetBasicBlockScope(entryBB);
+        auto *v0 = builder.CreateParameter(0);
+        auto *v1 = builder.CreateInt64Constant(0);
+        auto *v2 = builder.CreateInt64Constant(1);
+        auto *v3 = builder.CreateInt64Constant(2);
+        builder.CreateJe(builder.CreateCmp(v0, v1), bb1, bb2);
+
+        for(auto *bb: swapPredecessors ? std::vector {bb2, bb1} : std::vector {bb1, bb2}) {
+            builder.SetBasicBlockScope(bb);
+            builder.CreateJmp(bb3);
+        }
+
+        builder.SetBasicBlockScope(bb3);
+        auto *v7 = builder.CreatePhi(DataType::U64);
+        v7->AddInput(v2);
+        v7->AddInput(v3);
+        builder.CreateRet(DataType::U64, v7);
+
+        return graph;
+    }
+
+    uint64_t Hash(Graph* graph) {
+        GraphHasher hasher(graph);
+        return hasher.Run();
+    }
+
+    CompiledCode MakeCode(size_t size, uint8_t fill) {
+        return CompiledCode {std::vector<uint8_t>(size, fill), {}};
+    }
+};
+
+TEST_F(CodeCacheTest, IDENTICAL_GRAPHS_HASH_EQUAL) {
+    auto graph1 = BuildLoopGraph(2);
+    auto graph2 = BuildLoopGraph(2);
+
+    EXPECT_EQ(Hash(graph1.get()), Hash(graph2.get()));
+}
+
+TEST_F(CodeCacheTest, DIFFERENT_CONSTANTS_HASH_DIFFERENT) {
+    auto graph1 = BuildLoopGraph(2);
+    auto graph2 = BuildLoopGraph(3);
+
+    EXPECT_NE(Hash(graph1.get()), Hash(graph2.get()));
+}
+
+TEST_F(CodeCacheTest, DIFFERENT_TOPOLOGY_HASH_DIFFERENT) {
+    auto graph1 = BuildLoopGraph(2);
+
+    Graph graph2;
+    IrBuilder builder(&graph2);
+    auto *bb = builder.CreateBB();
+    builder.SetBasicBlockScope(bb);
+    auto *v0 = builder.CreateParameter(0);
+    builder.CreateRet(DataType::U32, v0);
+
+    EXPECT_NE(Hash(graph1.get()), Hash(&graph2));
+}
+
+TEST_F(CodeCacheTest, PREDECESSOR_ORDER_HASH_DIFFERENT) {
+    auto graph1 = BuildDiamondGraph(false);
+    auto graph2 = BuildDiamondGraph(true);
+
+    // The same phi picks a different value once the predecessors are swapped.
+    EXPECT_NE(Interpreter(graph1.get()).Run({0}), Interpreter(graph2.get()).Run({0}));
+    EXPECT_NE(Hash(graph1.get()), Hash(graph2.get()));
+
+    CodeCache cache(1024);
+    size_t compilations = 0;
+    auto compile = [&compilations, this](Graph*) {
+        return MakeCode(16, static_cast<uint8_t>(++compilations));
+    };
+    auto code1 = cache.GetOrCompile(graph1.get(), compile);
+    auto code2 = cache.GetOrCompile(graph2.get(), compile);
+    EXPECT_EQ(compilations, 2);
+    EXPECT_NE(code1, code2);
+}
+
+TEST_F(CodeCacheTest, HASH_COLLISION_IS_A_MISS) {
+    CodeCache cache(1024);
+
+    cache.Insert(1, {1, 2}, MakeCode(16, 1));
+    EXPECT_NE(cache.Lookup(1, {1, 2}), nullptr);
+    EXPECT_EQ(cache.Lookup(1, {1, 3}), nullptr);
+    EXPECT_EQ(cache.GetStats().hits, 1);
+    EXPECT_EQ(cache.GetStats().misses, 1);
+}
+
+TEST_F(CodeCacheTest, GET_OR_COMPILE_HITS_FOR_IDENTICAL_GRAPHS) {
+    CodeCache cache(1024);
+    size_t compilations = 0;
+    auto compile = [&compilations, this](Graph*) {
+        ++compilations;
+        return MakeCode(16, 0xc3);
+    };
+
+    auto graph1 = BuildLoopGraph(2);
+    auto graph2 = BuildLoopGraph(2);
+
+    auto code1 = cache.GetOrCompile(graph1.get(), compile);
+    auto code2 = cache.GetOrCompile(graph2.get(), compile);
+
+    EXPECT_EQ(compilations, 1);
+    EXPECT_EQ(code1, code2);
+    EXPECT_EQ(cache.GetStats().hits, 1);
+    EXPECT_EQ(cache.GetStats().misses, 1);
+    EXPECT_EQ(cache.GetBytesUsed(), 16);
+}
+
+TEST_F(CodeCacheTest, LRU_EVICTION_UNDER_BUDGET) {
+    CodeCache cache(100);
+
+    cache.Insert(1, {1}, MakeCode(40, 1));
+    cache.Insert(2, {2}, MakeCode(40, 2));
+    ASSERT_NE(cache.Lookup(1, {1}), nullptr);
+
+    auto evicted = cache.Lookup(2, {2});
+    cache.Insert(3, {3}, MakeCode(40, 3));
+    cache.Lookup(1, {1});
+    cache.Insert(4, {4}, MakeCode(40, 4));
+
+    EXPECT_EQ(cache.Lookup(1, {1}), nullptr);
+    EXPECT_EQ(cache.Lookup(2, {2}), nullptr);
+    EXPECT_NE(cache.Lookup(3, {3}), nullptr);
+    EXPECT_NE(cache.Lookup(4, {4}), nullptr);
+    EXPECT_EQ(cache.GetStats().evictions, 2);
+    EXPECT_LE(cache.GetBytesUsed(), cache.GetByteBudget());
+
+    ASSERT_NE(evicted, nullptr);
+    EXPECT_EQ(evicted->code[0], 2);
+}
+
+TEST_F(CodeCacheTest, OVERSIZED_CODE_IS_NOT_CACHED) {
+    CodeCache cache(8);
+
+    auto code = cache.Insert(1, {1}, MakeCode(16, 0));
+    ASSERT_NE(code, nullptr);
+    EXPECT_EQ(cache.GetEntriesCount(), 0);
+    EXPECT_EQ(cache.Lookup(1, {1}), nullptr);
+}
@@ -0,0 +1,262 @@
+#include <gtest/gtest.h>
+
+#include "Codegen/instrselector.hpp"
+#include "Codegen/naivelowering.hpp"
+#include "irbuilder.hpp"
+
+#include <algorithm>
+
+static_assert(SELECTION_RULES[static_cast<size_t>(RuleId::ADD_R_INDEX)].children[1] == NonTerminal::INDEX);
+static_assert(RULE_TABLE.counts[static_cast<size_t>(OpType::ADD)] == 6);
+static_assert(RULE_TABLE.counts[static_cast<size_t>(OpType::UNDEFINED)] == 2);
+
+class CodegenTest: public ::testing::Test {
+protected:
+    /*
+        BB_0: v0 = param 0, v1 = const 1, v2 = const 2; jmp BB_1
+        BB_1: v4 = phi(v1, v8), v5 = phi(v2, v9), v6 = cmp v5, v0; ja v6, BB_3, BB_2
+        BB_2: v8 = mul v4, v5, v9 = add v5, v1; jmp BB_1
+        BB_3: ret v4
+    */
+    void BuildFactorial() {
+        IrBuilder builder(&graph_);
+
+        auto *entryBB = builder.CreateBB();
+        auto *bb1 = builder.CreateBB();
+        auto *bb2 = builder.CreateBB();
+        auto *bb3 = builder.CreateBB();
+
+        builder.SetBasicBlockScope(entryBB);
+        auto *v0 = builder.CreateParameter(0);
+        auto *v1 = builder.CreateInt64Constant(1);
+        auto *v2 = builder.CreateInt64Constant(2);
+        builder.CreateJmp(bb1);
+
+        builder.SetBasicBlockScope(bb1);
+        auto *v4 = builder.CreatePhi(DataType::U64);
+        auto *v5 = builder.CreatePhi(DataType::U64);
+        auto *v6 = builder.CreateCmp(v5, v0);
+        builder.CreateJa(v6, bb3, bb2);
+
+        builder.SetBasicBlockScope(bb2);
+        auto *v8 = builder.CreateMul(DataType::U64, v4, v5);
+        auto *v9 = builder.CreateAdd(DataType::U64, v5, v1);
+        builder.CreateJmp(bb1);
+
+        v4->AddInput(v1);
+        v4->AddInput(v8);
+        v5->AddInput(v2);
+        v5->AddInput(v9);
+
+        builder.SetBasicBlockScope(bb3);
+        builder.CreateRet(DataType::U64, v4);
+    }
+
+    /*
+        BB_0: a = param 0, i = param 1; ret a + i * 8 + 16
+    */
+    void BuildAddress() {
+        IrBuilder builder(&graph_);
+
+        builder.SetBasicBlockScope(builder.CreateBB());
+        auto *a = builder.CreateParameter(0);
+        auto *i = builder.CreateParameter(1);
+        auto *scaled = builder.CreateMul(DataType::U64, i, builder.CreateInt64Constant(8));
+        auto *sum = builder.CreateAdd(DataType::U64, a, scaled);
+        builder.CreateRet(DataType::U64, builder.CreateAdd(DataType::U64, sum, builder.CreateInt64Constant(16)));
+    }
+
+    /*
+        BB_0: jmp BB_1
+        BB_1: x = phi(0, y), y = phi(1, x), n = phi(param 0, n - 1); cmp n, 0; je BB_2, BB_1
+        BB_2: ret x
+    */
+    void BuildSwapLoop() {
+        IrBuilder builder(&graph_);
+
+        auto *entryBB = builder.CreateBB();
+        auto *loop = builder.CreateBB();
+        auto *exitBB = builder.CreateBB();
+
+        builder.SetBasicBlockScope(entryBB);
+        auto *n0 = builder.CreateParameter(0);
+        auto *zero = builder.CreateInt64Constant(0);
+        auto *one = builder.CreateInt64Constant(1);
+        builder.CreateJmp(loop);
+
+        builder.SetBasicBlockScope(loop);
+        auto *x = builder.CreatePhi(DataType::U64);
+        auto *y = builder.CreatePhi(DataType::U64);
+        auto *n = builder.CreatePhi(DataType::U64);
+        auto *next = builder.CreateSub(DataType::U64, n, one);
+        builder.CreateJe(builder.CreateCmp(next, zero), exitBB, loop);
+
+        builder.SetBasicBlockScope(exitBB);
+        builder.CreateRet(DataType::U64, x);
+
+        x->AddInput(zero);
+        x->AddInput(y);
+        y->AddInput(one);
+        y->AddInput(x);
+        n->AddInput(n0);
+        n->AddInput(next);
+    }
+
+    static bool HasOpcodePair(MachineFunction &function, MOpcode first, MOpcode second) {
+        for(auto &block: function.GetBlocks()) {
+            for(size_t idx = 0; idx + 1 < block.instrs.size(); ++idx) {
+                if(block.instrs[idx].opcode == first && block.instrs[idx + 1].opcode == second) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    Graph graph_;
+};
+
+TEST_F(CodegenTest, FACTORIAL_SELECTS_FEWER_INSTRUCTIONS) {
+    BuildFactorial();
+
+    auto naive = NaiveLowering(&graph_).Run();
+    auto selected = InstructionSelector(&graph_).Run();
+
+    EXPECT_LT(selected.GetInstructionsCount(), naive.GetInstructionsCount());
+    EXPECT_TRUE(HasOpcodePair(selected, MOpcode::CMP, MOpcode::JA));
+    EXPECT_EQ(selected.CountOpcode(MOpcode::SETA), 0);
+    EXPECT_EQ(naive.CountOpcode(MOpcode::SETA), 1);
+    EXPECT_EQ(selected.CountOpcode(MOpcode::RET), 1);
+}
+
+TEST_F(CodegenTest, ADDRESS_ARITHMETIC_FOLDS_INTO_LEA) {
+    BuildAddress();
+
+    auto naive = NaiveLowering(&graph_).Run();
+    auto selected = InstructionSelector(&graph_).Run();
+
+    EXPECT_EQ(selected.CountOpcode(MOpcode::LEA), 2);
+    EXPECT_EQ(selected.CountOpcode(MOpcode::IMUL), 0);
+    EXPECT_EQ(selected.CountOpcode(MOpcode::ADD), 0);
+
+    bool hasScaledIndex = false;
+    for(auto &instr: selected.GetBlocks()[0].instrs) {
+        if(instr.opcode == MOpcode::LEA && instr.operands[1].scale == 8) {
+            hasScaledIndex = true;
+        }
+    }
+    EXPECT_TRUE(hasScaledIndex);
+    EXPECT_LT(selected.GetInstructionsCount(), naive.GetInstructionsCount());
+}
+
+TEST_F(CodegenTest, PHI_CYCLE_USES_TEMPORARY) {
+    BuildSwapLoop();
+
+    auto selected = InstructionSelector(&graph_).Run();
+
+    // Back edge is split: x, y swap through a temporary and n is updated.
+    const MachineBlock* edgeBlock = nullptr;
+    for(auto &block: selected.GetBlocks()) {
+        if(block.name == "BB_1_1") {
+            edgeBlock = &block;
+        }
+    }
+    ASSERT_NE(edgeBlock, nullptr);
+    EXPECT_EQ(edgeBlock->instrs.size(), 5);
+    EXPECT_EQ(edgeBlock->instrs.back().opcode, MOpcode::JMP);
+    EXPECT_TRUE(HasOpcodePair(selected, MOpcode::CMP, MOpcode::JNE));
+}
+
+TEST_F(CodegenTest, CHECKS_BRANCH_TO_DEOPT_STUBS) {
+    IrBuilder builder(&graph_);
+    builder.SetBasicBlockScope(builder.CreateBB());
+    auto *a = builder.CreateParameter(0);
+    auto *b = builder.CreateParameter(1);
+    builder.CreateBoundsCheck(a, b);
+    builder.CreateOverflowCheck(OpType::ADD, DataType::I64, a, b);
+    builder.CreateOverflowCheck(OpType::MUL, DataType::U8, a, b);
+    builder.CreateRet(DataType::U64, builder.CreateAdd(DataType::U64, a, b));
+
+    for(auto function: {NaiveLowering(&graph_).Run(), InstructionSelector(&graph_).Run()}) {
+        EXPECT_TRUE(HasOpcodePair(function, MOpcode::CMP, MOpcode::JAE));
+        EXPECT_EQ(function.CountOpcode(MOpcode::JO), 1);
+        EXPECT_EQ(function.CountOpcode(MOpcode::JA), 1);
+        EXPECT_EQ(function.CountOpcode(MOpcode::DEOPT), 3);
+    }
+}
+
+TEST_F(CodegenTest, FIELD_ACCESSES_USE_MEMORY_OPERANDS) {
+    IrBuilder builder(&graph_);
+    builder.SetBasicBlockScope(builder.CreateBB());
+    auto *object = builder.CreateNewObject(2);
+    builder.CreateStoreField(object, 1, builder.CreateParameter(0));
+    auto *value = builder.CreateLoadField(DataType::U64, object, 1);
+    builder.CreateStoreField(object, 1, builder.CreateInt64Constant(7));
+    builder.CreateRet(DataType::U64, value);
+
+    for(auto function: {NaiveLowering(&graph_).Run(), InstructionSelector(&graph_).Run()}) {
+        EXPECT_EQ(function.CountOpcode(MOpcode::NEWOBJ), 1);
+        std::vector<bool> stores;
+        for(auto &instr: function.GetBlocks()[0].instrs) {
+            if(instr.opcode != MOpcode::MOV) {
+                continue;
+            }
+            for(size_t idx = 0; idx < instr.operands.size(); ++idx) {
+                if(instr.operands[idx].kind == MOperandKind::ADDR) {
+                    EXPECT_EQ(instr.operands[idx].imm, 8);
+                    stores.push_back(idx == 0);
+                }
+            }
+        }
+        // The load stays between the stores.
+        EXPECT_EQ(stores, (std::vector<bool> {true, false, true}));
+    }
+}
+
+TEST_F(CodegenTest, LOADS_AND_STORES_USE_BASE_AND_OFFSET) {
+    IrBuilder builder(&graph_);
+    builder.SetBasicBlockScope(builder.CreateBB());
+    auto *object = builder.CreateNewObject(2);
+    builder.CreateStore(object, 12, builder.CreateParameter(0));
+    builder.CreateRet(DataType::U16, builder.CreateLoad(DataType::U16, object, 14));
+
+    for(auto function: {NaiveLowering(&graph_).Run(), InstructionSelector(&graph_).Run()}) {
+        std::vector<int64_t> offsets;
+        for(auto &instr: function.GetBlocks()[0].instrs) {
+            for(auto &operand: instr.operands) {
+                if(operand.kind == MOperandKind::ADDR) {
+                    EXPECT_EQ(instr.opcode, MOpcode::MOV);
+                    offsets.push_back(operand.imm);
+                }
+            }
+        }
+        EXPECT_EQ(offsets, (std::vector<int64_t> {12, 14}));
+    }
+}
+
+TEST_F(CodegenTest, SELECTS_LOWER_TO_CMOV) {
+    IrBuilder builder(&graph_);
+    builder.SetBasicBlockScope(builder.CreateBB());
+    auto *a = builder.CreateParameter(0);
+    auto *b = builder.CreateParameter(1);
+    auto *sum = builder.CreateAdd(DataType::U32, a, b);
+    auto *cmp = builder.CreateCmp(a, b);
+    builder.CreateRet(DataType::U32, builder.CreateSelect(DataType::U32, OpType::JAE, cmp, sum,
+                                                          builder.CreateInt32Constant(7)));
+
+    auto naive = NaiveLowering(&graph_).Run();
+    EXPECT_EQ(naive.CountOpcode(MOpcode::CMOVAE), 1);
+    EXPECT_EQ(naive.CountOpcode(MOpcode::SETA), 1);
+
+    // The compare sets the flags the cmov reads, with no branch and no setcc.
+    auto selected = InstructionSelector(&graph_).Run();
+    EXPECT_EQ(selected.CountOpcode(MOpcode::CMOVAE), 1);
+    EXPECT_EQ(selected.CountOpcode(MOpcode::SETA), 0);
+    EXPECT_EQ(selected.CountOpcode(MOpcode::JAE) + selected.CountOpcode(MOpcode::JB), 0);
+    auto &instrs = selected.GetBlocks()[0].instrs;
+    auto cmov = std::find_if(instrs.begin(), instrs.end(), [](auto &instr) { return instr.opcode == MOpcode::CMOVAE; });
+    ASSERT_NE(cmov, instrs.end());
+    EXPECT_EQ(cmov->operands[1].reg, sum->GetId());
+    EXPECT_EQ((cmov - 1)->opcode, MOpcode::MOV);
+    EXPECT_EQ((cmov - 1)->operands[1].imm, 7);
+}
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include "CompactGraph/compactgraph.hpp"
+#include "irbuilder.hpp"
+
+class CompactGraphTest: public ::testing::Test {
+protected:
+    Graph graph_;
+};
+
+// BB_0: a = param 0; c = 3; jmp BB_1
+// BB_1: phi(a, sum); sum = phi + c; cmp sum, c; ja BB_1, BB_2
+// BB_2: ret sum
+TEST_F(CompactGraphTest, MIRRORS_LOOP) {
+    IrBuilder builder(&graph_);
+    auto *entry = builder.CreateBB();
+    auto *loop = builder.CreateBB();
+    auto *exit = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    auto *a = builder.CreateParameter(0);
+    auto *c = builder.CreateInt64Constant(3);
+    builder.CreateJmp(loop);
+
+    builder.SetBasicBlockScope(loop);
+    auto *phi = builder.CreatePhi(DataType::U64);
+    auto *sum = builder.CreateAdd(DataType::U64, phi, c);
+    phi->AddInput(a);
+    phi->AddInput(sum);
+    auto *cmp = builder.CreateCmp(sum, c);
+    builder.CreateJa(cmp, loop, exit);
+
+    builder.SetBasicBlockScope(exit);
+    builder.CreateRet(DataType::U64, sum);
+
+    CompactGraph compact(&graph_);
+    ASSERT_EQ(compact.GetInstrsCount(), 8);
+    ASSERT_EQ(compact.GetBlocksCount(), 3);
+    EXPECT_EQ(compact.GetBlockBegin(1), 3);
+    EXPECT_EQ(compact.GetBlockEnd(1), 7);
+
+    auto phiIdx = compact.GetIndex(phi);
+    auto sumIdx = compact.GetIndex(sum);
+    EXPECT_EQ(compact.GetOpType(phiIdx), OpType::PHI);
+    EXPECT_EQ(compact.GetBlock(phiIdx), 1);
+    EXPECT_EQ(compact.GetInstruction(sumIdx), sum);
+    EXPECT_EQ(compact.GetPayload(compact.GetIndex(c)), 3);
+
+    auto phiOperands = compact.GetOperands(phiIdx);
+    ASSERT_EQ(phiOperands.size(), 2);
+    EXPECT_EQ(phiOperands[0], compact.GetIndex(a));
+    EXPECT_EQ(phiOperands[1], sumIdx);
+
+    auto sumUsers = compact.GetUsers(sumIdx);
+    ASSERT_EQ(sumUsers.size(), 3);
+    EXPECT_EQ(sumUsers[0], phiIdx);
+    EXPECT_EQ(sumUsers[1], compact.GetIndex(cmp));
+    EXPECT_EQ(compact.GetOpType(sumUsers[2]), OpType::RET);
+
+    EXPECT_EQ(compact.Collect(OpType::PHI), std::vector<uint32_t>{phiIdx});
+    auto succs = compact.GetSuccessors(1);
+    ASSERT_EQ(succs.size(), 2);
+    EXPECT_EQ(succs[0], 1);
+    EXPECT_EQ(succs[1], 2);
+    EXPECT_EQ(compact.GetPredecessors(1).size(), 2);
+}
+
+TEST_F(CompactGraphTest, SKIPS_DETACHED_INSTRUCTIONS) {
+    IrBuilder builder(&graph_);
+    builder.SetBasicBlockScope(builder.CreateBB());
+    auto *a = builder.CreateParameter(0);
+    auto *dead = builder.CreateMul(DataType::U64, a, a);
+    builder.CreateRet(DataType::U64, a);
+    ASSERT_TRUE(graph_.RemoveInstruction(dead));
+
+    CompactGraph compact(&graph_);
+    EXPECT_EQ(compact.GetInstrsCount(), 2);
+    EXPECT_EQ(compact.GetIndex(dead), CompactGraph::NO_INDEX);
+    EXPECT_EQ(compact.GetUsers(compact.GetIndex(a)).size(), 1);
+    EXPECT_TRUE(compact.Collect(OpType::MUL).empty());
+}
@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+
+#include "CompileService/compileservice.hpp"
+#include "irbuilder.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+class CompileServiceTest: public ::testing::Test {
+protected:
+    /*
+        BB_0: a = param 0; ret a + value
+    */
+    std::unique_ptr<Graph> BuildGraph(int64_t value) {
+        auto graph = std::make_unique<Graph>();
+        IrBuilder builder(graph.get());
+
+        builder.SetBasicBlockScope(builder.CreateBB());
+        auto *a = builder.CreateParameter(0);
+        builder.CreateRet(DataType::U64, builder.CreateAdd(DataType::U64, a, builder.CreateInt64Constant(value)));
+        return graph;
+    }
+
+    static int64_t GetAddend(Graph* graph) {
+        auto *ret = graph->GetBlocks()[0]->GetLastInstr();
+        auto *add = ret->GetInputs()[0].GetValue();
+        return static_cast<ConstantInstr*>(add->GetInputs()[1].GetValue())->GetAsSignedInt();
+    }
+
+    // Compiles into a single byte holding the constant. The first graph
+    // blocks its worker until Release() so the queue can be inspected.
+    CodeCache::CompileFn MakeBlockingCompiler() {
+        return [this](Graph* graph) {
+            if(graph == blocker_) {
+                started_ = true;
+                while(!released_) {
+                    std::this_thread::yield();
+                }
+            }
+            return CompiledCode {{static_cast<uint8_t>(GetAddend(graph))}, {}};
+        };
+    }
+
+    void WaitStarted() {
+        while(!started_) {
+            std::this_thread::yield();
+        }
+    }
+
+    void Release() {
+        released_ = true;
+    }
+
+    Graph* blocker_ = nullptr;
+    std::atomic<bool> started_ = false;
+    std::atomic<bool> released_ = false;
+};
+
+TEST_F(CompileServiceTest, COMPILES_ALL_GRAPHS) {
+    std::vector<std::unique_ptr<Graph>> graphs;
+    for(int64_t idx = 0; idx < 64; ++idx) {
+        graphs.push_back(BuildGraph(idx));
+    }
+
+    std::atomic<size_t> callbacks = 0;
+    CompileService service(MakeBlockingCompiler(), 4, graphs.size());
+    std::vector<CompileTaskPtr> tasks;
+    for(auto &graph: graphs) {
+        tasks.push_back(service.Submit(graph.get(), 0, [&callbacks](CompileTask&) { ++callbacks; }));
+        ASSERT_NE(tasks.back(), nullptr);
+    }
+
+    for(size_t idx = 0; idx < tasks.size(); ++idx) {
+        auto code = tasks[idx]->Wait();
+        ASSERT_NE(code, nullptr);
+        EXPECT_EQ(code->code[0], idx);
+        EXPECT_EQ(tasks[idx]->GetStatus(), CompileStatus::DONE);
+    }
+    service.WaitIdle();
+    EXPECT_EQ(callbacks, graphs.size());
+    EXPECT_EQ(service.GetQueuedCount(), 0);
+}
+
+TEST_F(CompileServiceTest, HOTTEST_FIRST) {
+    auto blocker = BuildGraph(0);
+    auto cold = BuildGraph(1);
+    auto warm = BuildGraph(2);
+    auto hot = BuildGraph(3);
+    blocker_ = blocker.get();
+
+    std::vector<int64_t> order;
+    auto record = [&order](CompileTask &task) {
+        order.push_back(GetAddend(task.GetGraph()));
+    };
+
+    CompileService service(MakeBlockingCompiler(), 1, 8);
+    service.Submit(blocker.get(), 0);
+    WaitStarted();
+    service.Submit(cold.get(), 1, record);
+    service.Submit(hot.get(), 100, record);
+    service.Submit(warm.get(), 10, record);
+    Release();
+    service.WaitIdle();
+
+    EXPECT_EQ(order, (std::vector<int64_t> {3, 2, 1}));
+}
+
+TEST_F(CompileServiceTest, CANCEL_AND_BOUND) {
+    auto blocker = BuildGraph(0);
+    auto first = BuildGraph(1);
+    auto second = BuildGraph(2);
+    auto third = BuildGraph(3);
+    blocker_ = blocker.get();
+
+    CompileService service(MakeBlockingCompiler(), 1, 2);
+    auto running = service.Submit(blocker.get(), 0);
+    WaitStarted();
+    EXPECT_FALSE(running->Cancel());
+
+    size_t cancelCallbacks = 0;
+    auto queued = service.Submit(first.get(), 0, [&cancelCallbacks](CompileTask &task) {
+        cancelCallbacks += task.GetStatus() == CompileStatus::CANCELLED;
+    });
+    ASSERT_NE(service.Submit(second.get(), 0), nullptr);
+    EXPECT_EQ(service.Submit(third.get(), 0), nullptr);
+
+    EXPECT_TRUE(queued->Cancel());
+    EXPECT_FALSE(queued->Cancel());
+    EXPECT_EQ(queued->Wait(), nullptr);
+    EXPECT_EQ(cancelCallbacks, 1);
+
+    Release();
+    service.WaitIdle();
+    EXPECT_EQ(running->GetStatus(), CompileStatus::DONE);
+    EXPECT_EQ(queued->GetStatus(), CompileStatus::CANCELLED);
+}
+
+TEST_F(CompileServiceTest, SHUTDOWN_CANCELS_QUEUED) {
+    auto blocker = BuildGraph(0);
+    auto pending = BuildGraph(1);
+    blocker_ = blocker.get();
+
+    CompileService service(MakeBlockingCompiler(), 1, 4);
+    auto running = service.Submit(blocker.get(), 0);
+    WaitStarted();
+    auto queued = service.Submit(pending.get(), 0);
+
+    std::thread releaser([this] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        Release();
+    });
+    service.Shutdown();
+    releaser.join();
+
+    EXPECT_EQ(running->GetStatus(), CompileStatus::DONE);
+    EXPECT_EQ(queued->GetStatus(), CompileStatus::CANCELLED);
+    EXPECT_EQ(service.Submit(pending.get(), 0), nullptr);
+}
+
+TEST_F(CompileServiceTest, SUBMIT_RACING_SHUTDOWN_SETTLES) {
+    std::vector<std::unique_ptr<Graph>> graphs;
+    for(int64_t idx = 0; idx < 64; ++idx) {
+        graphs.push_back(BuildGraph(idx));
+    }
+
+    for(size_t round = 0; round < 50; ++round) {
+        CompileService service(MakeBlockingCompiler(), 2, 64);
+        std::vector<CompileTaskPtr> tasks;
+        std::thread submitter([&] {
+            for(size_t idx = 0; idx < graphs.size(); ++idx) {
+                if(auto task = service.Submit(graphs[idx].get(), idx)) {
+                    tasks.push_back(task);
+                }
+            }
+        });
+        service.Shutdown();
+        submitter.join();
+
+        // Every accepted task either ran or was cancelled, none is left behind.
+        service.WaitIdle();
+        for(auto &task: tasks) {
+            auto status = task->GetStatus();
+            EXPECT_TRUE(status == CompileStatus::DONE || status == CompileStatus::CANCELLED);
+        }
+        EXPECT_EQ(service.GetQueuedCount(), 0);
+    }
+}
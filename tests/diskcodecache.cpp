@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+
+#include "CodeCache/diskcodecache.hpp"
+
+#include <cstdio>
+#include <fstream>
+
+class DiskCodeCacheTest: public ::testing::Test {
+protected:
+    void SetUp() override {
+        path_ = testing::TempDir() + "ir_disk_code_cache_" +
+                testing::UnitTest::GetInstance()->current_test_info()->name() + ".bin";
+        std::remove(path_.c_str());
+    }
+
+    void TearDown() override {
+        std::remove(path_.c_str());
+    }
+
+    CompiledCode MakeCode(size_t size, uint8_t fill, size_t relocations = 0) {
+        CompiledCode code {std::vector<uint8_t>(size, fill), {}};
+        for(size_t idx = 0; idx < relocations; ++idx) {
+            code.relocations.push_back(Relocation {idx, RelocationKind::REL32, 0, fill + idx});
+        }
+        return code;
+    }
+
+    size_t FileSize() {
+        std::ifstream file(path_, std::ios::binary | std::ios::ate);
+        return static_cast<size_t>(file.tellg());
+    }
+
+    void TruncateFile(size_t size) {
+        ASSERT_EQ(truncate(path_.c_str(), static_cast<off_t>(size)), 0);
+    }
+
+    std::string path_;
+};
+
+TEST_F(DiskCodeCacheTest, ENTRIES_SURVIVE_REOPEN) {
+    {
+        DiskCodeCache cache(path_, 1);
+        ASSERT_TRUE(cache.Open());
+        ASSERT_TRUE(cache.Store(0x1234, {0x1234}, MakeCode(13, 0xaa, 2)));
+        ASSERT_TRUE(cache.Store(0x5678, {0x5678}, MakeCode(8, 0xbb)));
+    }
+
+    DiskCodeCache cache(path_, 1);
+    ASSERT_TRUE(cache.Open());
+    EXPECT_EQ(cache.GetStats().loadedRecords, 2);
+    EXPECT_EQ(cache.GetEntriesCount(), 2);
+
+    auto view = cache.Lookup(0x1234, {0x1234});
+    ASSERT_TRUE(view.has_value());
+    ASSERT_EQ(view->codeSize, 13);
+    EXPECT_EQ(view->code[12], 0xaa);
+    ASSERT_EQ(view->relocationsCount, 2);
+    EXPECT_EQ(view->relocations[1].offset, 1);
+    EXPECT_EQ(view->relocations[1].kind, RelocationKind::REL32);
+    EXPECT_EQ(view->relocations[1].target, 0xab);
+
+    EXPECT_FALSE(cache.Lookup(0x9999, {0x9999}).has_value());
+}
+
+TEST_F(DiskCodeCacheTest, OTHER_COMPILER_VERSION_IS_SKIPPED) {
+    {
+        DiskCodeCache cache(path_, 1);
+        ASSERT_TRUE(cache.Open());
+        ASSERT_TRUE(cache.Store(0x1234, {0x1234}, MakeCode(16, 0xaa)));
+    }
+
+    DiskCodeCache cache(path_, 2);
+    ASSERT_TRUE(cache.Open());
+    EXPECT_FALSE(cache.Lookup(0x1234, {0x1234}).has_value());
+    EXPECT_EQ(cache.GetStats().skippedRecords, 1);
+}
+
+TEST_F(DiskCodeCacheTest, TRUNCATED_TAIL_IS_DROPPED) {
+    size_t firstRecordEnd = 0;
+    {
+        DiskCodeCache cache(path_, 1);
+        ASSERT_TRUE(cache.Open());
+        ASSERT_TRUE(cache.Store(1, {1}, MakeCode(24, 0x11)));
+        firstRecordEnd = FileSize();
+        ASSERT_TRUE(cache.Store(2, {2}, MakeCode(24, 0x22, 1)));
+    }
+    TruncateFile(FileSize() - 5);
+
+    {
+        DiskCodeCache cache(path_, 1);
+        ASSERT_TRUE(cache.Open());
+        EXPECT_TRUE(cache.Lookup(1, {1}).has_value());
+        EXPECT_FALSE(cache.Lookup(2, {2}).has_value());
+        EXPECT_GT(cache.GetStats().corruptedBytes, 0);
+
+        ASSERT_TRUE(cache.Store(3, {3}, MakeCode(4, 0x33)));
+        EXPECT_GT(FileSize(), firstRecordEnd);
+    }
+
+    DiskCodeCache cache(path_, 1);
+    ASSERT_TRUE(cache.Open());
+    EXPECT_EQ(cache.GetStats().corruptedBytes, 0);
+    EXPECT_TRUE(cache.Lookup(1, {1}).has_value());
+    EXPECT_TRUE(cache.Lookup(3, {3}).has_value());
+}
+
+TEST_F(DiskCodeCacheTest, CORRUPTED_RECORD_FAILS_CHECKSUM) {
+    {
+        DiskCodeCache cache(path_, 1);
+        ASSERT_TRUE(cache.Open());
+        ASSERT_TRUE(cache.Store(1, {1}, MakeCode(16, 0x11)));
+    }
+
+    {
+        std::fstream file(path_, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(static_cast<std::streamoff>(FileSize() - 1));
+        file.put('\x42');
+    }
+
+    DiskCodeCache cache(path_, 1);
+    ASSERT_TRUE(cache.Open());
+    EXPECT_FALSE(cache.Lookup(1, {1}).has_value());
+}
+
+TEST_F(DiskCodeCacheTest, GARBAGE_FILE_IS_RESET) {
+    {
+        std::ofstream file(path_, std::ios::binary);
+        file << "definitely not a code cache";
+    }
+
+    DiskCodeCache cache(path_, 1);
+    ASSERT_TRUE(cache.Open());
+    EXPECT_EQ(cache.GetEntriesCount(), 0);
+    ASSERT_TRUE(cache.Store(7, {7}, MakeCode(8, 0x77)));
+    EXPECT_TRUE(cache.Lookup(7, {7}).has_value());
+}
+
+TEST_F(DiskCodeCacheTest, HASH_COLLISION_IS_A_MISS) {
+    {
+        DiskCodeCache cache(path_, 1);
+        ASSERT_TRUE(cache.Open());
+        ASSERT_TRUE(cache.Store(1, {1, 2}, MakeCode(8, 0x11)));
+        EXPECT_TRUE(cache.Lookup(1, {1, 2}).has_value());
+        EXPECT_FALSE(cache.Lookup(1, {1, 3}).has_value());
+    }
+
+    // The digest is on disk, so the collision is still caught after a restart.
+    DiskCodeCache cache(path_, 1);
+    ASSERT_TRUE(cache.Open());
+    EXPECT_TRUE(cache.Lookup(1, {1, 2}).has_value());
+    EXPECT_FALSE(cache.Lookup(1, {1, 3}).has_value());
+}
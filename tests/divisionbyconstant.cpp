@@ -0,0 +1,208 @@
+#include <gtest/gtest.h>
+
+#include "Codegen/instrselector.hpp"
+#include "DivisionByConstant/divisionbyconstant.hpp"
+#include "Interpreter/interpreter.hpp"
+#include "irbuilder.hpp"
+#include "testutils.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <type_traits>
+
+namespace {
+
+// Parameters are 32 bits wide, so the dividend is put together from two of
+// them: (args[1] << 32) + args[0] in the arithmetic of the type.
+void BuildDivision(Graph* graph, OpType op, DataType type, uint64_t divisor) {
+    IrBuilder builder(graph);
+    builder.SetBasicBlockScope(builder.CreateBB());
+    auto *low = builder.CreateParameter(0);
+    auto *high = builder.CreateParameter(1);
+    auto *shifted = builder.CreateMul(type, high, builder.CreateInt64Constant(1ULL << 32));
+    auto *dividend = builder.CreateAdd(type, shifted, low);
+    auto *constant = builder.CreateConstant(divisor, type);
+    auto *result = op == OpType::DIV ? builder.CreateDiv(type, dividend, constant) :
+                                       builder.CreateMod(type, dividend, constant);
+    builder.CreateRet(type, result);
+}
+
+// Truncating division as DIV and MOD define it, the result extended to 64
+// bits like the interpreter keeps it.
+template <typename T>
+uint64_t Reference(OpType op, uint64_t lhs, uint64_t rhs) {
+    auto dividend = static_cast<T>(lhs);
+    auto divisor = static_cast<T>(rhs);
+    T value = 0;
+    if constexpr(std::is_signed_v<T>) {
+        if(divisor == -1) {
+            using Unsigned = std::make_unsigned_t<T>;
+            value = op == OpType::DIV ? static_cast<T>(Unsigned(0) - static_cast<Unsigned>(dividend)) : 0;
+        } else {
+            value = static_cast<T>(op == OpType::DIV ? dividend / divisor : dividend % divisor);
+        }
+        return static_cast<uint64_t>(static_cast<int64_t>(value));
+    } else {
+        value = static_cast<T>(op == OpType::DIV ? dividend / divisor : dividend % divisor);
+        return static_cast<uint64_t>(value);
+    }
+}
+
+template <typename T>
+void ExpectExact(DataType type, uint64_t divisor, const std::vector<uint64_t> &dividends) {
+    for(auto op: {OpType::DIV, OpType::MOD}) {
+        Graph graph;
+        BuildDivision(&graph, op, type, divisor);
+        ASSERT_EQ(DivisionByConstant(&graph).Run(), 1);
+        ASSERT_EQ(CountOpcode(&graph, op), 0);
+
+        Interpreter interpreter(&graph);
+        for(auto dividend: dividends) {
+            auto result = interpreter.Run({dividend & 0xffffffffULL, dividend >> 32});
+            ASSERT_EQ(result, Reference<T>(op, dividend, divisor))
+                << GetOpName(op) << " " << static_cast<int64_t>(static_cast<T>(dividend)) << " by "
+                << static_cast<int64_t>(static_cast<T>(divisor));
+        }
+    }
+}
+
+template <typename T>
+std::vector<uint64_t> AllValues() {
+    std::vector<uint64_t> values;
+    for(uint64_t value = 0; value <= std::numeric_limits<std::make_unsigned_t<T>>::max(); ++value) {
+        values.push_back(static_cast<uint64_t>(static_cast<int64_t>(static_cast<T>(value))));
+    }
+    return values;
+}
+
+// Divisors of every shape the rewrite takes: small and large odd ones, even
+// ones, powers of two and their neighbours, the extremes of the type.
+template <typename T>
+std::vector<uint64_t> InterestingDivisors() {
+    using Unsigned = std::make_unsigned_t<T>;
+    std::vector<uint64_t> divisors {1, 2, 3, 5, 6, 7, 10, 12, 25, 100, 125, 641, 1000};
+    for(uint32_t bit = 1; bit < 8 * sizeof(T); bit += 5) {
+        divisors.push_back((Unsigned(1) << bit) - 1);
+        divisors.push_back(Unsigned(1) << bit);
+        divisors.push_back((Unsigned(1) << bit) + 1);
+    }
+    divisors.push_back(std::numeric_limits<Unsigned>::max());
+    divisors.push_back(std::numeric_limits<Unsigned>::max() - 6);
+    divisors.push_back(static_cast<Unsigned>(std::numeric_limits<T>::max()));
+    divisors.push_back(static_cast<Unsigned>(std::numeric_limits<T>::min()));
+    if constexpr(std::is_signed_v<T>) {
+        for(int64_t divisor: {-1, -2, -3, -5, -7, -10, -16, -100, -641}) {
+            divisors.push_back(static_cast<Unsigned>(divisor));
+        }
+    }
+
+    std::vector<uint64_t> result;
+    for(auto divisor: divisors) {
+        auto value = static_cast<Unsigned>(divisor);
+        if(value != 0 && std::find(result.begin(), result.end(), value) == result.end()) {
+            result.push_back(value);
+        }
+    }
+    return result;
+}
+
+template <typename T>
+void ExpectRandomized(DataType type, std::mt19937_64 &random) {
+    using Unsigned = std::make_unsigned_t<T>;
+    std::vector<uint64_t> dividends {0, 1, 2, 3, 7, 100};
+    for(auto value: {std::numeric_limits<T>::max(), std::numeric_limits<T>::min(), T(-1), T(-7), T(-100)}) {
+        dividends.push_back(static_cast<Unsigned>(value));
+    }
+    while(dividends.size() < 400) {
+        // Narrow values too, so small quotients and remainders come up.
+        auto value = static_cast<Unsigned>(random());
+        dividends.push_back(dividends.size() % 2 == 0 ? value : value >> (random() % (8 * sizeof(T))));
+    }
+
+    auto divisors = InterestingDivisors<T>();
+    for(size_t idx = 0; idx < 20; ++idx) {
+        auto value = static_cast<Unsigned>(random()) >> (random() % (8 * sizeof(T)));
+        divisors.push_back(value == 0 ? 1 : value);
+    }
+    for(auto divisor: divisors) {
+        ExpectExact<T>(type, divisor, dividends);
+    }
+}
+
+}  // namespace
+
+TEST(DivisionByConstantTest, REWRITES_TO_MULTIPLY) {
+    Graph graph;
+    BuildDivision(&graph, OpType::DIV, DataType::U32, 7);
+    EXPECT_EQ(DivisionByConstant(&graph).Run(), 1);
+    EXPECT_EQ(CountOpcode(&graph, OpType::DIV), 0);
+    EXPECT_EQ(CountOpcode(&graph, OpType::MULH), 1);
+
+    auto function = InstructionSelector(&graph).Run();
+    EXPECT_EQ(function.CountOpcode(MOpcode::DIV) + function.CountOpcode(MOpcode::IDIV), 0);
+}
+
+TEST(DivisionByConstantTest, POWERS_OF_TWO_SHIFT) {
+    for(auto type: {DataType::U64, DataType::I64}) {
+        for(auto op: {OpType::DIV, OpType::MOD}) {
+            Graph graph;
+            BuildDivision(&graph, op, type, 16);
+            EXPECT_EQ(DivisionByConstant(&graph).Run(), 1);
+            EXPECT_EQ(CountOpcode(&graph, OpType::MULH), 0);
+        }
+    }
+
+    // The unsigned remainder is a mask.
+    Graph graph;
+    BuildDivision(&graph, OpType::MOD, DataType::U16, 32);
+    EXPECT_EQ(DivisionByConstant(&graph).Run(), 1);
+    EXPECT_EQ(CountOpcode(&graph, OpType::AND), 1);
+    EXPECT_EQ(CountOpcode(&graph, OpType::SHR), 0);
+}
+
+TEST(DivisionByConstantTest, ZERO_AND_VARIABLE_DIVISORS_KEPT) {
+    Graph graph;
+    BuildDivision(&graph, OpType::DIV, DataType::I32, 0);
+    IrBuilder builder(&graph);
+    builder.SetInsertPoint(graph.GetStartBlock()->GetLastInstr());
+    auto *parameter = graph.GetStartBlock()->GetFirstInstr();
+    builder.CreateMod(DataType::U32, parameter, parameter);
+
+    EXPECT_EQ(DivisionByConstant(&graph).Run(), 0);
+    EXPECT_EQ(CountOpcode(&graph, OpType::DIV), 1);
+    EXPECT_EQ(CountOpcode(&graph, OpType::MOD), 1);
+    EXPECT_FALSE(Interpreter(&graph).Run({1, 0}).has_value());
+}
+
+TEST(DivisionByConstantTest, EIGHT_BIT_EXHAUSTIVE) {
+    auto signedValues = AllValues<int8_t>();
+    auto unsignedValues = AllValues<uint8_t>();
+    for(uint64_t divisor = 1; divisor < 256; ++divisor) {
+        ExpectExact<int8_t>(DataType::I8, divisor, signedValues);
+        ExpectExact<uint8_t>(DataType::U8, divisor, unsignedValues);
+    }
+}
+
+// Every dividend for divisors of each shape: 10 needs no correction, 15 and
+// -3 have a multiplier of the wrong sign, 7 and 641 one bit too wide.
+TEST(DivisionByConstantTest, SIXTEEN_BIT_EXHAUSTIVE) {
+    auto signedValues = AllValues<int16_t>();
+    for(int64_t divisor: {10, 15, -3}) {
+        ExpectExact<int16_t>(DataType::I16, static_cast<uint16_t>(divisor), signedValues);
+    }
+    auto unsignedValues = AllValues<uint16_t>();
+    for(uint64_t divisor: {10, 7, 641}) {
+        ExpectExact<uint16_t>(DataType::U16, divisor, unsignedValues);
+    }
+}
+
+TEST(DivisionByConstantTest, RANDOMIZED) {
+    std::mt19937_64 random(42);
+    ExpectRandomized<int16_t>(DataType::I16, random);
+    ExpectRandomized<uint16_t>(DataType::U16, random);
+    ExpectRandomized<int32_t>(DataType::I32, random);
+    ExpectRandomized<uint32_t>(DataType::U32, random);
+    ExpectRandomized<int64_t>(DataType::I64, random);
+    ExpectRandomized<uint64_t>(DataType::U64, random);
+}
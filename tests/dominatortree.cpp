@@ -3,6 +3,10 @@
 #include "DominatorTree/dominatortree.hpp"
 #include "irbuilder.hpp"
 
+#include <algorithm>
+#include <random>
+#include <set>
+
 class DominatorTreeTest: public ::testing::Test {
 protected:
     void SetUp() override {
@@ -25,6 +29,27 @@ protected:
         to->AddPredecessor(from);
     }
 
+    void UnlinkBlocks(BasicBlock *from, BasicBlock *to) {
+        from->RemoveSuccessor(to);
+        to->RemovePredecessor(from);
+    }
+
+    // The updated tree has to be the one a rebuild gives.
+    void ExpectMatchesRebuild() {
+        DominatorTree rebuilt(graph_.get());
+        rebuilt.Build();
+        for(auto &block: graph_->GetBlocks()) {
+            auto *dominator = rebuilt.GetImmediateDominator(block.get());
+            ASSERT_EQ(tree_->GetImmediateDominator(block.get()), dominator) << "block " << block->GetId();
+            if(dominator != nullptr || block.get() == graph_->GetStartBlock()) {
+                auto &expected = rebuilt.GetImmediateDominatedBlocks(block.get());
+                auto &actual = tree_->GetImmediateDominatedBlocks(block.get());
+                ASSERT_EQ(std::set<BasicBlock*>(actual.begin(), actual.end()),
+                          std::set<BasicBlock*>(expected.begin(), expected.end()));
+            }
+        }
+    }
+
     void BuildDominatorTree() {
         tree_ = std::make_unique<DominatorTree>(graph_.get());
         tree_->Build();
@@ -293,4 +318,156 @@ TEST_F(DominatorTreeTest, TEST_3) {
 
     auto &dImmDom = tree_->GetImmediateDominatedBlocks(d);
     ASSERT_EQ(dImmDom.size(), 0);
-}
\ No newline at end of file
+}
+
+/*
+    The TEST_1 graph with D, then A, cut off and given new edges.
+*/
+TEST_F(DominatorTreeTest, SINGLE_EDGE_UPDATES) {
+    auto *a = CreateBlock();
+    auto *b = CreateBlock();
+    auto *c = CreateBlock();
+    auto *d = CreateBlock();
+    auto *e = CreateBlock();
+    auto *f = CreateBlock();
+    auto *g = CreateBlock();
+
+    LinkBlocks(a, b);
+    LinkBlocks(b, c);
+    LinkBlocks(b, f);
+    LinkBlocks(c, d);
+    LinkBlocks(f, e);
+    LinkBlocks(f, g);
+    LinkBlocks(g, d);
+    LinkBlocks(e, d);
+
+    BuildDominatorTree();
+    EXPECT_EQ(tree_->FindNearestCommonDominator(e, g), f);
+    EXPECT_EQ(tree_->FindNearestCommonDominator(c, e), b);
+    EXPECT_EQ(tree_->FindNearestCommonDominator(d, d), d);
+
+    // Only F reaches D now.
+    UnlinkBlocks(c, d);
+    tree_->DeleteEdge(c, d);
+    EXPECT_EQ(tree_->GetImmediateDominator(d), f);
+    EXPECT_TRUE(tree_->Dominates(f, d));
+    ExpectMatchesRebuild();
+
+    LinkBlocks(a, d);
+    tree_->InsertEdge(a, d);
+    EXPECT_EQ(tree_->GetImmediateDominator(d), a);
+    EXPECT_FALSE(tree_->Dominates(b, d));
+    ExpectMatchesRebuild();
+
+    // Everything but A and D becomes unreachable, then comes back.
+    UnlinkBlocks(a, b);
+    tree_->DeleteEdge(a, b);
+    EXPECT_EQ(tree_->GetImmediateDominator(b), nullptr);
+    EXPECT_EQ(tree_->GetImmediateDominator(g), nullptr);
+    EXPECT_FALSE(tree_->Dominates(b, c));
+    ExpectMatchesRebuild();
+
+    LinkBlocks(d, b);
+    tree_->InsertEdge(d, b);
+    EXPECT_EQ(tree_->GetImmediateDominator(b), d);
+    EXPECT_EQ(tree_->GetImmediateDominator(g), f);
+    EXPECT_TRUE(tree_->Dominates(d, e));
+    ExpectMatchesRebuild();
+}
+
+TEST_F(DominatorTreeTest, RANDOM_UPDATES_MATCH_REBUILD) {
+    constexpr size_t BLOCKS_COUNT = 40;
+    std::mt19937 random(42);
+    std::vector<BasicBlock*> blocks;
+    for(size_t idx = 0; idx < BLOCKS_COUNT; ++idx) {
+        blocks.push_back(CreateBlock());
+    }
+    for(size_t idx = 0; idx < 2 * BLOCKS_COUNT; ++idx) {
+        auto *from = blocks[random() % BLOCKS_COUNT];
+        LinkBlocks(from, blocks[1 + random() % (BLOCKS_COUNT - 1)]);
+    }
+    BuildDominatorTree();
+
+    std::vector<DominatorTree::Update> batch;
+    for(size_t step = 0; step < 600; ++step) {
+        auto *from = blocks[random() % BLOCKS_COUNT];
+        auto &succs = from->GetSuccessors();
+        if(succs.empty() || random() % 2 == 0) {
+            auto *to = blocks[1 + random() % (BLOCKS_COUNT - 1)];
+            LinkBlocks(from, to);
+            batch.push_back({DominatorTree::UpdateKind::INSERT, from, to});
+        } else {
+            auto *to = succs[random() % succs.size()];
+            UnlinkBlocks(from, to);
+            batch.push_back({DominatorTree::UpdateKind::DELETE, from, to});
+        }
+
+        // The first half goes edge by edge, the second in batches of five.
+        if(step < 300) {
+            auto &update = batch.back();
+            if(update.kind == DominatorTree::UpdateKind::INSERT) {
+                tree_->InsertEdge(update.from, update.to);
+            } else {
+                tree_->DeleteEdge(update.from, update.to);
+            }
+            batch.clear();
+        } else if(batch.size() == 5) {
+            tree_->ApplyUpdates(batch);
+            batch.clear();
+        } else {
+            continue;
+        }
+        ExpectMatchesRebuild();
+        if(HasFatalFailure()) {
+            FAIL() << "step " << step;
+        }
+    }
+}
+
+/*
+    A -> B, C; B -> D; C -> D, F, G; D -> E; F -> E; G -> G
+    E is the only exit, G never reaches it.
+*/
+TEST_F(DominatorTreeTest, POST_DOMINATORS) {
+    auto *a = CreateBlock();
+    auto *b = CreateBlock();
+    auto *c = CreateBlock();
+    auto *d = CreateBlock();
+    auto *e = CreateBlock();
+    auto *f = CreateBlock();
+    auto *g = CreateBlock();
+
+    LinkBlocks(a, b);
+    LinkBlocks(a, c);
+    LinkBlocks(b, d);
+    LinkBlocks(c, d);
+    LinkBlocks(c, f);
+    LinkBlocks(c, g);
+    LinkBlocks(d, e);
+    LinkBlocks(f, e);
+    LinkBlocks(g, g);
+
+    DominatorTree postDomTree(graph_.get(), true);
+    postDomTree.Build();
+
+    EXPECT_EQ(postDomTree.GetImmediateDominatedBlocks(nullptr), (std::vector<BasicBlock*> {e}));
+    EXPECT_EQ(postDomTree.GetImmediateDominator(e), nullptr);
+    EXPECT_EQ(postDomTree.GetImmediateDominator(d), e);
+    EXPECT_EQ(postDomTree.GetImmediateDominator(b), d);
+    EXPECT_EQ(postDomTree.GetImmediateDominator(f), e);
+    EXPECT_EQ(postDomTree.GetImmediateDominator(c), e);
+    EXPECT_EQ(postDomTree.GetImmediateDominator(a), e);
+    EXPECT_EQ(postDomTree.GetImmediateDominator(g), nullptr);
+    EXPECT_TRUE(postDomTree.Dominates(e, a));
+    EXPECT_TRUE(postDomTree.Dominates(d, b));
+    EXPECT_FALSE(postDomTree.Dominates(d, a));
+    EXPECT_FALSE(postDomTree.Dominates(e, g));
+    EXPECT_EQ(postDomTree.FindNearestCommonDominator(b, f), e);
+
+    // G gets a way out; the tree follows by rebuilding.
+    LinkBlocks(g, e);
+    postDomTree.InsertEdge(g, e);
+    EXPECT_EQ(postDomTree.GetImmediateDominator(g), e);
+    EXPECT_EQ(postDomTree.GetImmediateDominator(c), e);
+    EXPECT_TRUE(postDomTree.Dominates(e, g));
+}
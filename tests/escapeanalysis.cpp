@@ -0,0 +1,248 @@
+#include <gtest/gtest.h>
+
+#include "EscapeAnalysis/scalarreplacement.hpp"
+#include "Interpreter/interpreter.hpp"
+#include "irbuilder.hpp"
+#include "testutils.hpp"
+
+#include <optional>
+
+namespace {
+
+constexpr uint32_t IV = 0;
+
+size_t CountMemoryInstructions(Graph* graph) {
+    return CountOpcode(graph, OpType::NEW_OBJECT) + CountOpcode(graph, OpType::LOAD_FIELD) +
+           CountOpcode(graph, OpType::STORE_FIELD);
+}
+
+// sum = new 1; for(i = 0; i < n; ++i) { if(i & 1) sum.0 = sum.0 + i * k else sum.0 = sum.0 + 1 }
+// return sum.0
+void BuildAccumulatorLoop(Graph* graph) {
+    IrBuilder builder(graph);
+    auto *entry = builder.CreateBB();
+    auto *header = builder.CreateBB();
+    auto *body = builder.CreateBB();
+    auto *odd = builder.CreateBB();
+    auto *even = builder.CreateBB();
+    auto *latch = builder.CreateBB();
+    auto *exit = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    builder.SealBlock(entry);
+    auto *n = builder.CreateParameter(0);
+    auto *k = builder.CreateParameter(1);
+    auto *sum = builder.CreateNewObject(1);
+    builder.WriteVariable(IV, builder.CreateConstant(uint64_t{0}, DataType::U32));
+    builder.CreateJmp(header);
+
+    builder.SetBasicBlockScope(header);
+    builder.CreateJae(builder.CreateCmp(builder.ReadVariable(IV), n), exit, body);
+
+    builder.SetBasicBlockScope(body);
+    builder.SealBlock(body);
+    auto *iv = builder.ReadVariable(IV);
+    auto *one = builder.CreateConstant(uint64_t{1}, DataType::U32);
+    builder.CreateJe(builder.CreateCmp(builder.CreateAnd(DataType::U32, iv, one), one), odd, even);
+
+    builder.SetBasicBlockScope(odd);
+    builder.SealBlock(odd);
+    auto *oddValue = builder.CreateLoadField(DataType::U32, sum, 0);
+    auto *product = builder.CreateMul(DataType::U32, iv, k);
+    builder.CreateStoreField(sum, 0, builder.CreateAdd(DataType::U32, oddValue, product));
+    builder.CreateJmp(latch);
+
+    builder.SetBasicBlockScope(even);
+    builder.SealBlock(even);
+    auto *evenValue = builder.CreateLoadField(DataType::U32, sum, 0);
+    builder.CreateStoreField(sum, 0, builder.CreateAdd(DataType::U32, evenValue, one));
+    builder.CreateJmp(latch);
+
+    builder.SetBasicBlockScope(latch);
+    builder.SealBlock(latch);
+    builder.WriteVariable(IV, builder.CreateAdd(DataType::U32, iv, one));
+    builder.CreateJmp(header);
+    builder.SealBlock(header);
+
+    builder.SetBasicBlockScope(exit);
+    builder.SealBlock(exit);
+    builder.CreateRet(DataType::U32, builder.CreateLoadField(DataType::U32, sum, 0));
+}
+
+}  // namespace
+
+class EscapeAnalysisTest: public ::testing::Test {
+protected:
+    Graph graph_;
+};
+
+TEST_F(EscapeAnalysisTest, INTERPRETER_OBJECTS) {
+    IrBuilder builder(&graph_);
+    auto *entry = builder.CreateBB();
+    auto *inRange = builder.CreateBB();
+    auto *outOfRange = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    auto *a = builder.CreateParameter(0);
+    auto *object = builder.CreateNewObject(2);
+    builder.CreateStoreField(object, 0, a);
+    auto *sum = builder.CreateAdd(DataType::U32, builder.CreateLoadField(DataType::U32, object, 0),
+                                  builder.CreateLoadField(DataType::U32, object, 1));
+    builder.CreateJae(builder.CreateCmp(a, builder.CreateConstant(uint64_t{10}, DataType::U32)), outOfRange, inRange);
+
+    builder.SetBasicBlockScope(inRange);
+    builder.CreateRet(DataType::U32, sum);
+
+    builder.SetBasicBlockScope(outOfRange);
+    builder.CreateRet(DataType::U32, builder.CreateLoadField(DataType::U32, object, 2));
+
+    Interpreter interpreter(&graph_);
+    EXPECT_EQ(interpreter.Run({7}), 7);
+    EXPECT_EQ(interpreter.Run({10}), std::nullopt);
+
+    Graph nullGraph;
+    IrBuilder nullBuilder(&nullGraph);
+    nullBuilder.SetBasicBlockScope(nullBuilder.CreateBB());
+    auto *null = nullBuilder.CreateConstant(uint64_t{0}, DataType::REF);
+    nullBuilder.CreateRet(DataType::U64, nullBuilder.CreateLoadField(DataType::U64, null, 0));
+    EXPECT_EQ(Interpreter(&nullGraph).Run({}), std::nullopt);
+}
+
+TEST_F(EscapeAnalysisTest, FINDS_ESCAPING_ALLOCATIONS) {
+    /*
+        local = new 2, inner = new 1, leaked = new 1, compared = new 1, returned = new 2
+        local.0 = param 0; local.1 = inner; (local.1).0 = 1
+        returned.0 = leaked; local.0 = compared; cmp local.0, 0
+        ret returned
+    */
+    IrBuilder builder(&graph_);
+    builder.SetBasicBlockScope(builder.CreateBB());
+    auto *a = builder.CreateParameter(0);
+    auto *local = builder.CreateNewObject(2);
+    auto *inner = builder.CreateNewObject(1);
+    auto *leaked = builder.CreateNewObject(1);
+    auto *compared = builder.CreateNewObject(1);
+    auto *returned = builder.CreateNewObject(2);
+    builder.CreateStoreField(local, 0, a);
+    builder.CreateStoreField(local, 1, inner);
+    builder.CreateStoreField(builder.CreateLoadField(DataType::REF, local, 1), 0,
+                             builder.CreateConstant(uint64_t{1}, DataType::U32));
+    builder.CreateStoreField(returned, 0, leaked);
+    builder.CreateStoreField(local, 0, compared);
+    builder.CreateCmp(builder.CreateLoadField(DataType::U64, local, 0), builder.CreateInt64Constant(0));
+    builder.CreateRet(DataType::REF, returned);
+
+    EscapeAnalysis analysis(&graph_);
+    analysis.Analyze();
+    EXPECT_EQ(analysis.GetAllocations().size(), 5);
+    EXPECT_FALSE(analysis.Escapes(local));
+    EXPECT_FALSE(analysis.Escapes(inner));
+    EXPECT_TRUE(analysis.Escapes(leaked));
+    EXPECT_TRUE(analysis.Escapes(compared));
+    EXPECT_TRUE(analysis.Escapes(returned));
+    EXPECT_TRUE(analysis.Escapes(a));
+}
+
+TEST_F(EscapeAnalysisTest, STRAIGHT_LINE_FIELDS_BECOME_VALUES) {
+    IrBuilder builder(&graph_);
+    builder.SetBasicBlockScope(builder.CreateBB());
+    auto *a = builder.CreateParameter(0);
+    auto *b = builder.CreateParameter(1);
+    auto *point = builder.CreateNewObject(3);
+    builder.CreateStoreField(point, 0, a);
+    builder.CreateStoreField(point, 1, b);
+    auto *x = builder.CreateLoadField(DataType::U32, point, 0);
+    builder.CreateStoreField(point, 0, builder.CreateMul(DataType::U32, x, x));
+    auto *sum = builder.CreateAdd(DataType::U32, builder.CreateLoadField(DataType::U32, point, 0),
+                                  builder.CreateLoadField(DataType::U32, point, 1));
+    builder.CreateRet(DataType::U32, builder.CreateAdd(DataType::U32, sum,
+                                                       builder.CreateLoadField(DataType::U32, point, 2)));
+
+    Interpreter interpreter(&graph_);
+    auto expected = interpreter.Run({5, 3});
+    EXPECT_EQ(expected, 28);
+
+    EXPECT_EQ(ScalarReplacement(&graph_).Run(), 1);
+    EXPECT_EQ(CountMemoryInstructions(&graph_), 0);
+    EXPECT_EQ(interpreter.Run({5, 3}), expected);
+}
+
+TEST_F(EscapeAnalysisTest, FIELDS_IN_LOOP_BECOME_PHIS) {
+    BuildAccumulatorLoop(&graph_);
+    Graph original;
+    BuildAccumulatorLoop(&original);
+
+    EXPECT_EQ(ScalarReplacement(&graph_).Run(), 1);
+    EXPECT_EQ(CountMemoryInstructions(&graph_), 0);
+    EXPECT_GE(CountOpcode(&graph_, OpType::PHI), 3);
+
+    Interpreter originalInterpreter(&original);
+    Interpreter interpreter(&graph_);
+    for(uint64_t n: {0, 1, 2, 5, 10}) {
+        for(uint64_t k: {0, 3}) {
+            EXPECT_EQ(interpreter.Run({n, k}), originalInterpreter.Run({n, k})) << "n = " << n << ", k = " << k;
+        }
+    }
+}
+
+TEST_F(EscapeAnalysisTest, NESTED_OBJECTS_REPLACED) {
+    IrBuilder builder(&graph_);
+    builder.SetBasicBlockScope(builder.CreateBB());
+    auto *a = builder.CreateParameter(0);
+    auto *outer = builder.CreateNewObject(1);
+    auto *inner = builder.CreateNewObject(1);
+    builder.CreateStoreField(inner, 0, a);
+    builder.CreateStoreField(outer, 0, inner);
+    auto *value = builder.CreateLoadField(DataType::U32, builder.CreateLoadField(DataType::REF, outer, 0), 0);
+    builder.CreateRet(DataType::U32, builder.CreateAdd(DataType::U32, value, builder.CreateInt32Constant(1)));
+
+    EXPECT_EQ(ScalarReplacement(&graph_).Run(), 2);
+    EXPECT_EQ(CountMemoryInstructions(&graph_), 0);
+    EXPECT_EQ(Interpreter(&graph_).Run({41}), 42);
+}
+
+TEST_F(EscapeAnalysisTest, ESCAPING_AND_TRAPPING_OBJECTS_KEPT) {
+    /*
+        returned = new 1, narrow = new 1, retyped = new 1; retyped.0 = param 0 as u32
+        a >= 300: ret returned
+        a >= 100: ret narrow.1, which traps
+        otherwise: ret retyped.0 as u8 + 1
+    */
+    IrBuilder builder(&graph_);
+    auto *entry = builder.CreateBB();
+    auto *small = builder.CreateBB();
+    auto *tiny = builder.CreateBB();
+    auto *medium = builder.CreateBB();
+    auto *large = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    auto *a = builder.CreateParameter(0);
+    auto *returned = builder.CreateNewObject(1);
+    auto *narrow = builder.CreateNewObject(1);
+    auto *retyped = builder.CreateNewObject(1);
+    builder.CreateStoreField(retyped, 0, a);
+    builder.CreateJae(builder.CreateCmp(a, builder.CreateConstant(uint64_t{300}, DataType::U32)), large, small);
+
+    builder.SetBasicBlockScope(small);
+    builder.CreateJae(builder.CreateCmp(a, builder.CreateConstant(uint64_t{100}, DataType::U32)), medium, tiny);
+
+    builder.SetBasicBlockScope(tiny);
+    builder.CreateRet(DataType::U8, builder.CreateAdd(DataType::U8, builder.CreateLoadField(DataType::U8, retyped, 0),
+                                                      builder.CreateConstant(uint64_t{1}, DataType::U8)));
+
+    builder.SetBasicBlockScope(medium);
+    builder.CreateRet(DataType::U32, builder.CreateLoadField(DataType::U32, narrow, 1));
+
+    builder.SetBasicBlockScope(large);
+    builder.CreateRet(DataType::REF, returned);
+
+    Interpreter interpreter(&graph_);
+    auto expected = std::vector {interpreter.Run({99}), interpreter.Run({150}), interpreter.Run({300})};
+    EXPECT_EQ(expected[1], std::nullopt);
+
+    EXPECT_EQ(ScalarReplacement(&graph_).Run(), 0);
+    EXPECT_EQ(CountOpcode(&graph_, OpType::NEW_OBJECT), 3);
+    EXPECT_EQ(interpreter.Run({99}), expected[0]);
+    EXPECT_EQ(interpreter.Run({150}), expected[1]);
+    EXPECT_EQ(interpreter.Run({300}), expected[2]);
+}
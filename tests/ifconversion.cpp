@@ -0,0 +1,220 @@
+#include <gtest/gtest.h>
+
+#include "Codegen/instrselector.hpp"
+#include "IfConversion/ifconversion.hpp"
+#include "Interpreter/interpreter.hpp"
+#include "irbuilder.hpp"
+#include "testutils.hpp"
+
+namespace {
+
+/*
+    if(a > b) x = a - b else x = b - a
+    ret x * 2
+*/
+void BuildDifference(Graph* graph) {
+    IrBuilder builder(graph);
+    auto *entry = builder.CreateBB();
+    auto *above = builder.CreateBB();
+    auto *below = builder.CreateBB();
+    auto *merge = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    auto *a = builder.CreateParameter(0);
+    auto *b = builder.CreateParameter(1);
+    auto *two = builder.CreateInt32Constant(2);
+    builder.CreateJa(builder.CreateCmp(a, b), above, below);
+
+    builder.SetBasicBlockScope(above);
+    auto *aMinusB = builder.CreateSub(DataType::U32, a, b);
+    builder.CreateJmp(merge);
+
+    builder.SetBasicBlockScope(below);
+    auto *bMinusA = builder.CreateSub(DataType::U32, b, a);
+    builder.CreateJmp(merge);
+
+    builder.SetBasicBlockScope(merge);
+    auto *x = builder.CreatePhi(DataType::U32);
+    x->AddInput(aMinusB);
+    x->AddInput(bMinusA);
+    builder.CreateRet(DataType::U32, builder.CreateMul(DataType::U32, x, two));
+}
+
+/*
+    y = b
+    if(a >= 10) { a = a + 5 }
+    ret a * y
+    with y a phi of the same value on both edges
+*/
+void BuildClamp(Graph* graph) {
+    IrBuilder builder(graph);
+    auto *entry = builder.CreateBB();
+    auto *large = builder.CreateBB();
+    auto *merge = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    auto *a = builder.CreateParameter(0);
+    auto *b = builder.CreateParameter(1);
+    auto *five = builder.CreateInt32Constant(5);
+    builder.CreateJae(builder.CreateCmp(a, builder.CreateInt32Constant(10)), large, merge);
+
+    builder.SetBasicBlockScope(large);
+    auto *sum = builder.CreateAdd(DataType::U32, a, five);
+    builder.CreateJmp(merge);
+
+    builder.SetBasicBlockScope(merge);
+    auto *x = builder.CreatePhi(DataType::U32);
+    x->AddInput(a);
+    x->AddInput(sum);
+    auto *y = builder.CreatePhi(DataType::U32);
+    y->AddInput(b);
+    y->AddInput(b);
+    builder.CreateRet(DataType::U32, builder.CreateMul(DataType::U32, x, y));
+}
+
+/*
+    if(a == b) {
+        x = a
+    } else {
+        x = b; if(a > b) x = a + b
+    }
+    ret x
+*/
+void BuildNested(Graph* graph) {
+    IrBuilder builder(graph);
+    auto *entry = builder.CreateBB();
+    auto *equal = builder.CreateBB();
+    auto *inner = builder.CreateBB();
+    auto *above = builder.CreateBB();
+    auto *innerMerge = builder.CreateBB();
+    auto *merge = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    auto *a = builder.CreateParameter(0);
+    auto *b = builder.CreateParameter(1);
+    auto *cmp = builder.CreateCmp(a, b);
+    builder.CreateJe(cmp, equal, inner);
+
+    builder.SetBasicBlockScope(equal);
+    builder.CreateJmp(merge);
+
+    builder.SetBasicBlockScope(inner);
+    builder.CreateJa(builder.CreateCmp(a, b), above, innerMerge);
+
+    builder.SetBasicBlockScope(above);
+    auto *sum = builder.CreateAdd(DataType::U32, a, b);
+    builder.CreateJmp(innerMerge);
+
+    builder.SetBasicBlockScope(innerMerge);
+    auto *innerX = builder.CreatePhi(DataType::U32);
+    innerX->AddInput(b);
+    innerX->AddInput(sum);
+    builder.CreateJmp(merge);
+
+    builder.SetBasicBlockScope(merge);
+    auto *x = builder.CreatePhi(DataType::U32);
+    x->AddInput(a);
+    x->AddInput(innerX);
+    builder.CreateRet(DataType::U32, x);
+}
+
+// Values of a and b around the compared constants.
+const std::vector<std::vector<uint64_t>> ARG_VALUES = {{0, 3, 9, 10, 11, 25}, {0, 3, 10, 40}};
+
+}  // namespace
+
+class IfConversionTest: public ::testing::Test {
+protected:
+    Graph graph_;
+};
+
+TEST_F(IfConversionTest, DIAMOND_BECOMES_SELECT) {
+    BuildDifference(&graph_);
+    IfConversion pass(&graph_);
+    EXPECT_EQ(pass.Run(), 1);
+    ASSERT_EQ(graph_.GetBlocks().size(), 1);
+    EXPECT_EQ(CountOpcode(&graph_, OpType::SELECT), 1);
+    EXPECT_EQ(CountOpcode(&graph_, OpType::PHI), 0);
+    EXPECT_EQ(CountOpcode(&graph_, OpType::JA), 0);
+    EXPECT_TRUE(graph_.GetStartBlock()->GetSuccessors().empty());
+    ExpectSameResults(BuildDifference, &graph_, ARG_VALUES);
+
+    auto function = InstructionSelector(&graph_).Run();
+    EXPECT_EQ(function.CountOpcode(MOpcode::CMOVA), 1);
+    EXPECT_EQ(function.CountOpcode(MOpcode::JA) + function.CountOpcode(MOpcode::JBE), 0);
+}
+
+TEST_F(IfConversionTest, TRIANGLE_BECOMES_SELECT) {
+    BuildClamp(&graph_);
+    IfConversion pass(&graph_);
+    EXPECT_EQ(pass.Run(), 1);
+    ASSERT_EQ(graph_.GetBlocks().size(), 1);
+    // The phi with the same value on both edges needs no select.
+    EXPECT_EQ(CountOpcode(&graph_, OpType::SELECT), 1);
+    EXPECT_EQ(CountOpcode(&graph_, OpType::PHI), 0);
+    ExpectSameResults(BuildClamp, &graph_, ARG_VALUES);
+}
+
+TEST_F(IfConversionTest, NESTED_HAMMOCKS) {
+    BuildNested(&graph_);
+    IfConversion pass(&graph_);
+    EXPECT_EQ(pass.Run(), 2);
+    ASSERT_EQ(graph_.GetBlocks().size(), 1);
+    EXPECT_EQ(CountOpcode(&graph_, OpType::SELECT), 2);
+    ExpectSameResults(BuildNested, &graph_, ARG_VALUES);
+}
+
+TEST_F(IfConversionTest, SIDE_EFFECTS_KEEP_BRANCH) {
+    // if(a > b) x = a / b else x = b
+    IrBuilder builder(&graph_);
+    auto *entry = builder.CreateBB();
+    auto *divide = builder.CreateBB();
+    auto *merge = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    auto *a = builder.CreateParameter(0);
+    auto *b = builder.CreateParameter(1);
+    builder.CreateJa(builder.CreateCmp(a, b), divide, merge);
+
+    builder.SetBasicBlockScope(divide);
+    auto *quotient = builder.CreateDiv(DataType::U32, a, b);
+    builder.CreateJmp(merge);
+
+    builder.SetBasicBlockScope(merge);
+    auto *x = builder.CreatePhi(DataType::U32);
+    x->AddInput(b);
+    x->AddInput(quotient);
+    builder.CreateRet(DataType::U32, x);
+
+    IfConversion pass(&graph_);
+    EXPECT_EQ(pass.Run(), 0);
+    EXPECT_EQ(graph_.GetBlocks().size(), 3);
+}
+
+TEST_F(IfConversionTest, SIZE_LIMIT) {
+    BuildDifference(&graph_);
+    IfConversion pass(&graph_, nullptr, 1);
+    EXPECT_EQ(pass.Run(), 0);
+    EXPECT_EQ(graph_.GetBlocks().size(), 4);
+}
+
+TEST_F(IfConversionTest, PREDICTABLE_BRANCH_KEPT) {
+    BuildDifference(&graph_);
+    BranchProfile profile;
+    Interpreter interpreter(&graph_);
+    interpreter.SetBranchProfile(&profile);
+    for(uint64_t a = 0; a < 20; ++a) {
+        interpreter.Run({a + 100, a});
+    }
+    IfConversion pass(&graph_, &profile);
+    EXPECT_EQ(pass.Run(), 0);
+    EXPECT_EQ(graph_.GetBlocks().size(), 4);
+
+    // A coin flip is worth the select.
+    for(uint64_t a = 0; a < 20; ++a) {
+        interpreter.Run({a, a + 100});
+    }
+    EXPECT_EQ(pass.Run(), 1);
+    EXPECT_EQ(graph_.GetBlocks().size(), 1);
+    ExpectSameResults(BuildDifference, &graph_, ARG_VALUES);
+}
@@ -0,0 +1,251 @@
+#include <gtest/gtest.h>
+
+#include "Induction/inductionanalysis.hpp"
+#include "Induction/strengthreduction.hpp"
+#include "Interpreter/interpreter.hpp"
+#include "irbuilder.hpp"
+
+#include <optional>
+
+namespace {
+
+constexpr uint32_t SUM = 0;
+constexpr uint32_t I = 1;
+constexpr uint32_t J = 2;
+
+// sum = 0; for(i = init, j = 0; !(counter exitCondition bound); i += step, ++j)
+//     sum += (i * 4 + k - 3) + i * k
+// where the counter is i or j plus counterOffset, bound defaults to parameter 0 and k is parameter 1.
+struct LoopShape {
+    DataType productType = DataType::U32;
+    OpType exitCondition = OpType::JA;
+    uint64_t init = 0;
+    uint64_t step = 2;
+    std::optional<uint64_t> bound;
+    bool separateCounter = false;
+    std::optional<uint64_t> counterOffset;
+};
+
+struct LoopValues {
+    Instruction* cmp = nullptr;
+    Instruction* k = nullptr;
+    Instruction* shifted = nullptr;
+    Instruction* product = nullptr;
+};
+
+LoopValues BuildLoop(Graph* graph, const LoopShape &shape) {
+    LoopValues values;
+    IrBuilder builder(graph);
+    auto *entry = builder.CreateBB();
+    auto *header = builder.CreateBB();
+    auto *body = builder.CreateBB();
+    auto *exit = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    builder.SealBlock(entry);
+    auto *n = builder.CreateParameter(0);
+    auto *k = values.k = builder.CreateParameter(1);
+    builder.WriteVariable(SUM, builder.CreateConstant(uint64_t{0}, DataType::U64));
+    builder.WriteVariable(I, builder.CreateConstant(shape.init, DataType::U32));
+    builder.WriteVariable(J, builder.CreateConstant(uint64_t{0}, DataType::U32));
+    auto *bound = shape.bound ? builder.CreateConstant(*shape.bound, DataType::U32) : n;
+    builder.CreateJmp(header);
+
+    builder.SetBasicBlockScope(header);
+    auto *counter = builder.ReadVariable(shape.separateCounter ? J : I);
+    if(shape.counterOffset) {
+        counter = builder.CreateAdd(DataType::U32, counter, builder.CreateConstant(*shape.counterOffset, DataType::U32));
+    }
+    auto *cmp = values.cmp = builder.CreateCmp(counter, bound);
+    if(shape.exitCondition == OpType::JA) {
+        builder.CreateJa(cmp, exit, body);
+    } else {
+        builder.CreateJae(cmp, exit, body);
+    }
+
+    builder.SetBasicBlockScope(body);
+    builder.SealBlock(body);
+    auto *i = builder.ReadVariable(I);
+    auto *four = builder.CreateConstant(uint64_t{4}, DataType::U32);
+    auto *three = builder.CreateConstant(uint64_t{3}, DataType::U32);
+    auto *scaled = builder.CreateAdd(DataType::U32, builder.CreateMul(DataType::U32, i, four), k);
+    values.shifted = builder.CreateSub(DataType::U32, scaled, three);
+    values.product = builder.CreateMul(shape.productType, i, k);
+    auto *sum = builder.CreateAdd(DataType::U64, builder.ReadVariable(SUM), values.shifted);
+    builder.WriteVariable(SUM, builder.CreateAdd(DataType::U64, sum, values.product));
+    builder.WriteVariable(I, builder.CreateAdd(DataType::U32, i, builder.CreateConstant(shape.step, DataType::U32)));
+    auto *one = builder.CreateConstant(uint64_t{1}, DataType::U32);
+    builder.WriteVariable(J, builder.CreateAdd(DataType::U32, builder.ReadVariable(J), one));
+    builder.CreateJmp(header);
+    builder.SealBlock(header);
+
+    builder.SetBasicBlockScope(exit);
+    builder.SealBlock(exit);
+    builder.CreateRet(DataType::U64, builder.ReadVariable(SUM));
+    return values;
+}
+
+size_t CountLoopOps(Graph* graph, OpType op) {
+    LoopAnalyzer analyzer(graph);
+    analyzer.Analyze();
+    size_t count = 0;
+    for(auto &loop: analyzer.GetLoops()) {
+        for(auto *block: loop->GetBlocks()) {
+            for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+                count += instr->GetOpType() == op ? 1 : 0;
+            }
+        }
+    }
+    return count;
+}
+
+std::optional<uint64_t> GetTripCount(const LoopShape &shape) {
+    Graph graph;
+    BuildLoop(&graph, shape);
+    InductionAnalysis analysis(&graph);
+    analysis.Analyze();
+    auto &loops = analysis.GetLoopAnalyzer().GetLoops();
+    return loops.size() == 1 ? analysis.GetTripCount(loops.front().get()) : std::nullopt;
+}
+
+// Runs strength reduction on a copy of the loop and checks it against the original.
+size_t ExpectSameResultsAfterReduction(const LoopShape &shape, Graph* reduced) {
+    Graph original;
+    BuildLoop(&original, shape);
+    BuildLoop(reduced, shape);
+    size_t reducedCount = StrengthReduction(reduced).Run();
+
+    Interpreter originalInterpreter(&original);
+    Interpreter reducedInterpreter(reduced);
+    for(uint64_t n: {0, 1, 2, 5, 17}) {
+        for(uint64_t k: {0ULL, 7ULL, 0xffffffffULL}) {
+            auto expected = originalInterpreter.Run({n, k});
+            EXPECT_TRUE(expected.has_value());
+            EXPECT_EQ(reducedInterpreter.Run({n, k}), expected) << "n = " << n << ", k = " << k;
+        }
+    }
+    return reducedCount;
+}
+
+}  // namespace
+
+TEST(InductionTest, CLASSIFIES_INDUCTION_VARIABLES) {
+    Graph graph;
+    auto values = BuildLoop(&graph, LoopShape{});
+    InductionAnalysis analysis(&graph);
+    analysis.Analyze();
+
+    auto *iv = values.cmp->GetInputs()[0].GetValue();
+    auto *basic = analysis.GetInductionVariable(iv);
+    ASSERT_NE(basic, nullptr);
+    EXPECT_TRUE(basic->IsBasic());
+    EXPECT_EQ(basic->step, 2);
+    EXPECT_EQ(basic->stepValue, nullptr);
+    EXPECT_EQ(basic->init->As<ConstantInstr>()->GetAsUnsignedInt(), 0);
+
+    auto *shifted = analysis.GetInductionVariable(values.shifted);
+    ASSERT_NE(shifted, nullptr);
+    EXPECT_EQ(shifted->kind, InductionVariable::Kind::DERIVED);
+    EXPECT_EQ(shifted->basic, iv);
+    EXPECT_EQ(shifted->scale, 4);
+    EXPECT_EQ(shifted->offset, values.k);
+    EXPECT_EQ(static_cast<uint32_t>(shifted->constOffset), static_cast<uint32_t>(-3));
+
+    auto *product = analysis.GetInductionVariable(values.product);
+    ASSERT_NE(product, nullptr);
+    EXPECT_EQ(product->scale, 1);
+    EXPECT_EQ(product->scaleValue, values.k);
+    EXPECT_TRUE(product->IsScaled());
+
+    // The sum is neither: it grows by a different amount every iteration.
+    auto *sumUpdate = (*values.product->GetUses().begin()).GetUser();
+    EXPECT_EQ(analysis.GetInductionVariable(sumUpdate), nullptr);
+    EXPECT_EQ(analysis.GetTripCount(analysis.GetLoopAnalyzer().GetLoops().front().get()), std::nullopt);
+}
+
+TEST(InductionTest, WIDENED_VALUE_IS_NOT_AN_INDUCTION_VARIABLE) {
+    Graph graph;
+    LoopShape shape;
+    shape.productType = DataType::U64;
+    auto values = BuildLoop(&graph, shape);
+    InductionAnalysis analysis(&graph);
+    analysis.Analyze();
+
+    EXPECT_EQ(analysis.GetInductionVariable(values.product), nullptr);
+    EXPECT_NE(analysis.GetInductionVariable(values.shifted), nullptr);
+}
+
+TEST(InductionTest, TRIP_COUNTS) {
+    LoopShape shape;
+    shape.step = 1;
+    shape.bound = 10;
+    EXPECT_EQ(GetTripCount(shape), 11);
+    shape.exitCondition = OpType::JAE;
+    EXPECT_EQ(GetTripCount(shape), 10);
+
+    shape.init = 2;
+    shape.step = 3;
+    shape.bound = 11;
+    EXPECT_EQ(GetTripCount(shape), 3);
+    shape.exitCondition = OpType::JA;
+    EXPECT_EQ(GetTripCount(shape), 4);
+
+    shape.init = 12;
+    EXPECT_EQ(GetTripCount(shape), 0);
+
+    // Exits only after wrapping around, or never.
+    shape.init = 0;
+    shape.step = 1;
+    shape.bound = 0xffffffff;
+    EXPECT_EQ(GetTripCount(shape), std::nullopt);
+    shape.step = 2;
+    shape.exitCondition = OpType::JAE;
+    EXPECT_EQ(GetTripCount(shape), std::nullopt);
+
+    shape.bound = std::nullopt;
+    EXPECT_EQ(GetTripCount(shape), std::nullopt);
+    shape.bound = 10;
+    shape.separateCounter = true;
+    EXPECT_EQ(GetTripCount(shape), 10);
+}
+
+TEST(InductionTest, STRENGTH_REDUCTION_REMOVES_MULTIPLICATIONS) {
+    Graph graph;
+    EXPECT_EQ(ExpectSameResultsAfterReduction(LoopShape{}, &graph), 2);
+    EXPECT_EQ(CountLoopOps(&graph, OpType::MUL), 0);
+}
+
+TEST(InductionTest, DEAD_INDUCTION_VARIABLE_IS_REMOVED) {
+    Graph graph;
+    LoopShape shape;
+    shape.step = 3;
+    shape.separateCounter = true;
+    EXPECT_EQ(ExpectSameResultsAfterReduction(shape, &graph), 2);
+    EXPECT_EQ(CountLoopOps(&graph, OpType::MUL), 0);
+
+    // Only the counter, the sum and the two new recurrences are left.
+    EXPECT_EQ(CountLoopOps(&graph, OpType::PHI), 4);
+}
+
+TEST(InductionTest, WIDENED_PRODUCT_IS_KEPT) {
+    Graph graph;
+    LoopShape shape;
+    shape.productType = DataType::U64;
+    EXPECT_EQ(ExpectSameResultsAfterReduction(shape, &graph), 1);
+    EXPECT_EQ(CountLoopOps(&graph, OpType::MUL), 1);
+}
+
+TEST(InductionTest, DERIVED_EXIT_COUNTER_IS_NOT_COUNTED) {
+    // while(i + 1 <= bound): the compare reads a derived variable with no init.
+    LoopShape shape;
+    shape.step = 1;
+    shape.bound = 10;
+    shape.counterOffset = 1;
+    EXPECT_EQ(GetTripCount(shape), std::nullopt);
+    shape.bound = std::nullopt;
+    EXPECT_EQ(GetTripCount(shape), std::nullopt);
+
+    Graph graph;
+    EXPECT_EQ(ExpectSameResultsAfterReduction(shape, &graph), 2);
+    EXPECT_EQ(CountLoopOps(&graph, OpType::MUL), 0);
+}
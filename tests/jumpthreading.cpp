@@ -0,0 +1,315 @@
+#include <gtest/gtest.h>
+
+#include "JumpThreading/jumpthreading.hpp"
+#include "JumpThreading/tailduplication.hpp"
+#include "Interpreter/interpreter.hpp"
+#include "irbuilder.hpp"
+#include "testutils.hpp"
+
+#include <algorithm>
+
+namespace {
+
+constexpr uint32_t IV = 0;
+
+size_t CountOpcode(BasicBlock* block, OpType op) {
+    size_t count = 0;
+    for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+        count += instr->GetOpType() == op;
+    }
+    return count;
+}
+
+// Every edge is in both lists as often as the branches take it and every phi
+// has an input per predecessor.
+void ExpectConsistent(Graph* graph) {
+    for(auto &block: graph->GetBlocks()) {
+        auto &succs = block->GetSuccessors();
+        for(auto *succ: succs) {
+            auto &preds = succ->GetPredecessors();
+            EXPECT_EQ(std::count(preds.begin(), preds.end(), block.get()),
+                      std::count(succs.begin(), succs.end(), succ));
+        }
+        for(auto *pred: block->GetPredecessors()) {
+            auto &predSuccs = pred->GetSuccessors();
+            EXPECT_NE(std::find(predSuccs.begin(), predSuccs.end(), block.get()), predSuccs.end());
+        }
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr && instr->IsPhi(); instr = instr->GetNext()) {
+            EXPECT_EQ(instr->GetInputs().size(), block->GetPredecessors().size());
+        }
+    }
+}
+
+/*
+    flag = a >= 10 ? 1 : b
+    sum = a + flag
+    if(flag == 1) ret sum else ret sum * 2
+*/
+void BuildFlagMerge(Graph* graph) {
+    IrBuilder builder(graph);
+    auto *entry = builder.CreateBB();
+    auto *left = builder.CreateBB();
+    auto *right = builder.CreateBB();
+    auto *merge = builder.CreateBB();
+    auto *yes = builder.CreateBB();
+    auto *no = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    auto *a = builder.CreateParameter(0);
+    auto *b = builder.CreateParameter(1);
+    auto *one = builder.CreateInt32Constant(1);
+    auto *two = builder.CreateInt32Constant(2);
+    builder.CreateJae(builder.CreateCmp(a, builder.CreateInt32Constant(10)), left, right);
+
+    builder.SetBasicBlockScope(left);
+    builder.CreateJmp(merge);
+
+    builder.SetBasicBlockScope(right);
+    builder.CreateJmp(merge);
+
+    builder.SetBasicBlockScope(merge);
+    auto *flag = builder.CreatePhi(DataType::U32);
+    flag->AddInput(one);
+    flag->AddInput(b);
+    auto *sum = builder.CreateAdd(DataType::U32, a, flag);
+    builder.CreateJe(builder.CreateCmp(flag, one), yes, no);
+
+    builder.SetBasicBlockScope(yes);
+    builder.CreateRet(DataType::U32, sum);
+
+    builder.SetBasicBlockScope(no);
+    builder.CreateRet(DataType::U32, builder.CreateMul(DataType::U32, sum, two));
+}
+
+/*
+    x = a >= 10 ? 0 : 5
+    if(x > 3) y = a * 3 else y = a - 1
+    ret y + x
+*/
+void BuildKnownOnBothEdges(Graph* graph) {
+    IrBuilder builder(graph);
+    auto *entry = builder.CreateBB();
+    auto *left = builder.CreateBB();
+    auto *right = builder.CreateBB();
+    auto *merge = builder.CreateBB();
+    auto *big = builder.CreateBB();
+    auto *small = builder.CreateBB();
+    auto *exit = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    auto *a = builder.CreateParameter(0);
+    auto *zero = builder.CreateInt32Constant(0);
+    auto *one = builder.CreateInt32Constant(1);
+    auto *three = builder.CreateInt32Constant(3);
+    auto *five = builder.CreateInt32Constant(5);
+    builder.CreateJae(builder.CreateCmp(a, builder.CreateInt32Constant(10)), left, right);
+
+    builder.SetBasicBlockScope(left);
+    builder.CreateJmp(merge);
+
+    builder.SetBasicBlockScope(right);
+    builder.CreateJmp(merge);
+
+    builder.SetBasicBlockScope(merge);
+    auto *x = builder.CreatePhi(DataType::U32);
+    x->AddInput(zero);
+    x->AddInput(five);
+    builder.CreateJa(builder.CreateCmp(x, three), big, small);
+
+    builder.SetBasicBlockScope(big);
+    auto *tripled = builder.CreateMul(DataType::U32, a, three);
+    builder.CreateJmp(exit);
+
+    builder.SetBasicBlockScope(small);
+    auto *decremented = builder.CreateSub(DataType::U32, a, one);
+    builder.CreateJmp(exit);
+
+    builder.SetBasicBlockScope(exit);
+    auto *y = builder.CreatePhi(DataType::U32);
+    y->AddInput(tripled);
+    y->AddInput(decremented);
+    builder.CreateRet(DataType::U32, builder.CreateAdd(DataType::U32, y, x));
+}
+
+/*
+    if(a >= 10) x = a - b else x = b
+    s = x + a; t = s * b
+    ret t + s
+*/
+void BuildSmallMerge(Graph* graph) {
+    IrBuilder builder(graph);
+    auto *entry = builder.CreateBB();
+    auto *left = builder.CreateBB();
+    auto *right = builder.CreateBB();
+    auto *merge = builder.CreateBB();
+    auto *exit = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    auto *a = builder.CreateParameter(0);
+    auto *b = builder.CreateParameter(1);
+    builder.CreateJae(builder.CreateCmp(a, builder.CreateInt32Constant(10)), left, right);
+
+    builder.SetBasicBlockScope(left);
+    auto *diff = builder.CreateSub(DataType::U32, a, b);
+    builder.CreateJmp(merge);
+
+    builder.SetBasicBlockScope(right);
+    builder.CreateJmp(merge);
+
+    builder.SetBasicBlockScope(merge);
+    auto *x = builder.CreatePhi(DataType::U32);
+    x->AddInput(diff);
+    x->AddInput(b);
+    auto *s = builder.CreateAdd(DataType::U32, x, a);
+    auto *t = builder.CreateMul(DataType::U32, s, b);
+    builder.CreateJmp(exit);
+
+    builder.SetBasicBlockScope(exit);
+    builder.CreateRet(DataType::U32, builder.CreateAdd(DataType::U32, t, s));
+}
+
+}  // namespace
+
+class JumpThreadingTest: public ::testing::Test {
+protected:
+    Graph graph_;
+};
+
+TEST_F(JumpThreadingTest, CONSTANT_PHI_INPUT_THREADED) {
+    BuildFlagMerge(&graph_);
+    auto *left = graph_.GetBlocks()[1].get();
+    auto *right = graph_.GetBlocks()[2].get();
+    auto *merge = graph_.GetBlocks()[3].get();
+    auto *yes = graph_.GetBlocks()[4].get();
+
+    JumpThreading pass(&graph_);
+    EXPECT_EQ(pass.Run(), 1);
+    ASSERT_EQ(graph_.GetBlocks().size(), 7);
+    auto *copy = graph_.GetBlocks()[6].get();
+    EXPECT_EQ(left->GetSuccessors(), std::vector<BasicBlock*> {copy});
+    EXPECT_EQ(copy->GetSuccessors(), std::vector<BasicBlock*> {yes});
+    EXPECT_EQ(merge->GetPredecessors(), std::vector<BasicBlock*> {right});
+    EXPECT_EQ(yes->GetPredecessors(), (std::vector<BasicBlock*> {merge, copy}));
+    // The copy needs no compare, and yes merges both sums.
+    EXPECT_EQ(CountOpcode(copy, OpType::CMP), 0);
+    EXPECT_EQ(CountOpcode(yes, OpType::PHI), 1);
+    ExpectConsistent(&graph_);
+    ExpectSameResults(BuildFlagMerge, &graph_);
+}
+
+TEST_F(JumpThreadingTest, ALL_EDGES_THREADED) {
+    BuildKnownOnBothEdges(&graph_);
+    auto *left = graph_.GetBlocks()[1].get();
+    auto *right = graph_.GetBlocks()[2].get();
+    auto *big = graph_.GetBlocks()[4].get();
+    auto *small = graph_.GetBlocks()[5].get();
+
+    JumpThreading pass(&graph_);
+    EXPECT_EQ(pass.Run(), 2);
+    // The merge block lost every predecessor and is gone.
+    EXPECT_EQ(graph_.GetBlocks().size(), 8);
+    ASSERT_EQ(left->GetSuccessors().size(), 1);
+    ASSERT_EQ(right->GetSuccessors().size(), 1);
+    EXPECT_EQ(left->GetSuccessors()[0]->GetSuccessors(), std::vector<BasicBlock*> {small});
+    EXPECT_EQ(right->GetSuccessors()[0]->GetSuccessors(), std::vector<BasicBlock*> {big});
+    ExpectConsistent(&graph_);
+    ExpectSameResults(BuildKnownOnBothEdges, &graph_);
+}
+
+TEST_F(JumpThreadingTest, UNKNOWN_INPUTS_NOT_THREADED) {
+    BuildSmallMerge(&graph_);
+    JumpThreading pass(&graph_);
+    EXPECT_EQ(pass.Run(), 0);
+    EXPECT_EQ(graph_.GetBlocks().size(), 5);
+}
+
+TEST_F(JumpThreadingTest, LOOP_HEADER_NOT_THREADED) {
+    /*
+        for(i = 0; i < 5; ++i); ret i
+    */
+    IrBuilder builder(&graph_);
+    auto *entry = builder.CreateBB();
+    auto *header = builder.CreateBB();
+    auto *body = builder.CreateBB();
+    auto *exit = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    builder.SealBlock(entry);
+    auto *bound = builder.CreateInt32Constant(5);
+    builder.WriteVariable(IV, builder.CreateInt32Constant(0));
+    builder.CreateJmp(header);
+
+    // The compare is known on the entry edge, but threading it would give the
+    // loop a second entry.
+    builder.SetBasicBlockScope(header);
+    auto *iv = builder.ReadVariable(IV);
+    builder.CreateJae(builder.CreateCmp(iv, bound), exit, body);
+
+    builder.SetBasicBlockScope(body);
+    builder.SealBlock(body);
+    builder.WriteVariable(IV, builder.CreateAdd(DataType::U32, iv, builder.CreateInt32Constant(1)));
+    builder.CreateJmp(header);
+    builder.SealBlock(header);
+
+    builder.SetBasicBlockScope(exit);
+    builder.SealBlock(exit);
+    builder.CreateRet(DataType::U32, builder.ReadVariable(IV));
+
+    JumpThreading pass(&graph_);
+    EXPECT_EQ(pass.Run(), 0);
+    EXPECT_EQ(graph_.GetBlocks().size(), 4);
+}
+
+TEST_F(JumpThreadingTest, SIZE_LIMIT) {
+    BuildFlagMerge(&graph_);
+    JumpThreading pass(&graph_, 2);
+    EXPECT_EQ(pass.Run(), 0);
+    EXPECT_EQ(graph_.GetBlocks().size(), 6);
+}
+
+class TailDuplicationTest: public ::testing::Test {
+protected:
+    Graph graph_;
+};
+
+TEST_F(TailDuplicationTest, SMALL_MERGE_DUPLICATED) {
+    BuildSmallMerge(&graph_);
+    auto *left = graph_.GetBlocks()[1].get();
+    auto *right = graph_.GetBlocks()[2].get();
+    auto *merge = graph_.GetBlocks()[3].get();
+    auto *exit = graph_.GetBlocks()[4].get();
+
+    TailDuplication pass(&graph_);
+    // The exit gains a predecessor from the copy and is duplicated as well.
+    EXPECT_EQ(pass.Run(), 2);
+    ASSERT_EQ(graph_.GetBlocks().size(), 7);
+    auto *copy = graph_.GetBlocks()[5].get();
+    auto *exitCopy = graph_.GetBlocks()[6].get();
+    EXPECT_EQ(left->GetSuccessors(), std::vector<BasicBlock*> {copy});
+    EXPECT_EQ(right->GetSuccessors(), std::vector<BasicBlock*> {merge});
+    EXPECT_EQ(merge->GetPredecessors(), std::vector<BasicBlock*> {right});
+    EXPECT_EQ(CountOpcode(copy, OpType::PHI), 0);
+    EXPECT_EQ(CountOpcode(copy, OpType::MUL), 1);
+    EXPECT_EQ(merge->GetSuccessors(), std::vector<BasicBlock*> {exitCopy});
+    EXPECT_EQ(exit->GetPredecessors(), std::vector<BasicBlock*> {copy});
+    EXPECT_EQ(CountOpcode(exitCopy, OpType::RET), 1);
+    ExpectConsistent(&graph_);
+    ExpectSameResults(BuildSmallMerge, &graph_);
+}
+
+TEST_F(TailDuplicationTest, CHAINED_MERGES) {
+    BuildKnownOnBothEdges(&graph_);
+    TailDuplication pass(&graph_, 2);
+    // The merge goes into both of its jumping predecessors but one, and so
+    // does the exit.
+    EXPECT_EQ(pass.Run(), 2);
+    ExpectConsistent(&graph_);
+    ExpectSameResults(BuildKnownOnBothEdges, &graph_);
+}
+
+TEST_F(TailDuplicationTest, SIZE_LIMIT) {
+    BuildSmallMerge(&graph_);
+    TailDuplication pass(&graph_, 2);
+    EXPECT_EQ(pass.Run(), 0);
+    EXPECT_EQ(graph_.GetBlocks().size(), 5);
+}
@@ -0,0 +1,234 @@
+#include <gtest/gtest.h>
+
+#include "LazyCodeMotion/lazycodemotion.hpp"
+#include "Interpreter/interpreter.hpp"
+#include "irbuilder.hpp"
+#include "testutils.hpp"
+
+namespace {
+
+constexpr uint32_t IV = 0;
+constexpr uint32_t SUM = 1;
+
+size_t CountOpcode(BasicBlock* block, OpType op) {
+    size_t count = 0;
+    for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+        count += instr->GetOpType() == op;
+    }
+    return count;
+}
+
+/*
+    if(a >= 10) { x = a + b; a2 = x + x } else { a2 = a }
+    ret a + b + a2
+*/
+void BuildDiamond(Graph* graph) {
+    IrBuilder builder(graph);
+    auto *entry = builder.CreateBB();
+    auto *computes = builder.CreateBB();
+    auto *skips = builder.CreateBB();
+    auto *merge = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    auto *a = builder.CreateParameter(0);
+    auto *b = builder.CreateParameter(1);
+    builder.CreateJae(builder.CreateCmp(a, builder.CreateInt32Constant(10)), computes, skips);
+
+    builder.SetBasicBlockScope(computes);
+    auto *x = builder.CreateAdd(DataType::U32, a, b);
+    auto *doubled = builder.CreateAdd(DataType::U32, x, x);
+    builder.CreateJmp(merge);
+
+    builder.SetBasicBlockScope(skips);
+    builder.CreateJmp(merge);
+
+    builder.SetBasicBlockScope(merge);
+    auto *phi = builder.CreatePhi(DataType::U32);
+    phi->AddInput(doubled);
+    phi->AddInput(a);
+    builder.CreateRet(DataType::U32, builder.CreateAdd(DataType::U32, builder.CreateAdd(DataType::U32, b, a), phi));
+}
+
+/*
+    if(a >= 10) x = a * b
+    ret a * b
+*/
+void BuildCriticalEdge(Graph* graph) {
+    IrBuilder builder(graph);
+    auto *entry = builder.CreateBB();
+    auto *computes = builder.CreateBB();
+    auto *merge = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    auto *a = builder.CreateParameter(0);
+    auto *b = builder.CreateParameter(1);
+    builder.CreateJae(builder.CreateCmp(a, builder.CreateInt32Constant(10)), computes, merge);
+
+    builder.SetBasicBlockScope(computes);
+    builder.CreateStore(builder.CreateNewObject(1), 0, builder.CreateMul(DataType::U32, a, b));
+    builder.CreateJmp(merge);
+
+    builder.SetBasicBlockScope(merge);
+    builder.CreateRet(DataType::U32, builder.CreateMul(DataType::U32, a, b));
+}
+
+/*
+    sum = 0; for(i = 0; i < (n & (a - k)); ++i) sum += a * k
+    ret sum + (a - k)
+*/
+void BuildLoop(Graph* graph) {
+    IrBuilder builder(graph);
+    auto *entry = builder.CreateBB();
+    auto *header = builder.CreateBB();
+    auto *body = builder.CreateBB();
+    auto *exit = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    builder.SealBlock(entry);
+    auto *a = builder.CreateParameter(0);
+    auto *k = builder.CreateParameter(1);
+    auto *n = builder.CreateParameter(2);
+    builder.WriteVariable(IV, builder.CreateInt32Constant(0));
+    builder.WriteVariable(SUM, builder.CreateInt32Constant(0));
+    builder.CreateJmp(header);
+
+    builder.SetBasicBlockScope(header);
+    auto *iv = builder.ReadVariable(IV);
+    auto *limit = builder.CreateAnd(DataType::U32, n, builder.CreateSub(DataType::U32, a, k));
+    builder.CreateJae(builder.CreateCmp(iv, limit), exit, body);
+
+    builder.SetBasicBlockScope(body);
+    builder.SealBlock(body);
+    auto *product = builder.CreateMul(DataType::U32, a, k);
+    builder.WriteVariable(SUM, builder.CreateAdd(DataType::U32, builder.ReadVariable(SUM), product));
+    auto *next = builder.CreateAdd(DataType::U32, iv, builder.CreateInt32Constant(1));
+    builder.WriteVariable(IV, next);
+    builder.CreateJmp(header);
+    builder.SealBlock(header);
+
+    builder.SetBasicBlockScope(exit);
+    builder.SealBlock(exit);
+    auto *sub = builder.CreateSub(DataType::U32, a, k);
+    builder.CreateRet(DataType::U32, builder.CreateAdd(DataType::U32, builder.ReadVariable(SUM), sub));
+}
+
+// Values of a, b and c the results are compared on.
+const std::vector<std::vector<uint64_t>> ARG_VALUES = {{0, 3, 10, 25}, {0, 2, 7}, {0, 5, 40}};
+
+}  // namespace
+
+class LazyCodeMotionTest: public ::testing::Test {
+protected:
+    Graph graph_;
+};
+
+TEST_F(LazyCodeMotionTest, PARTIALLY_REDUNDANT_AFTER_MERGE) {
+    BuildDiamond(&graph_);
+    auto *skips = graph_.GetBlocks()[2].get();
+    auto *merge = graph_.GetBlocks()[3].get();
+
+    LazyCodeMotion pass(&graph_);
+    EXPECT_EQ(pass.Run(), 1);
+    EXPECT_EQ(pass.GetInsertedCount(), 1);
+    // The commuted add in the merge now reads a phi of both computations.
+    EXPECT_EQ(graph_.GetBlocks().size(), 4);
+    EXPECT_EQ(CountOpcode(skips, OpType::ADD), 1);
+    EXPECT_EQ(CountOpcode(merge, OpType::ADD), 1);
+    EXPECT_EQ(CountOpcode(merge, OpType::PHI), 2);
+    ExpectSameResults(BuildDiamond, &graph_, ARG_VALUES);
+}
+
+TEST_F(LazyCodeMotionTest, CRITICAL_EDGE_SPLIT) {
+    BuildCriticalEdge(&graph_);
+    auto *entry = graph_.GetStartBlock();
+    auto *merge = graph_.GetBlocks()[2].get();
+
+    LazyCodeMotion pass(&graph_);
+    EXPECT_EQ(pass.Run(), 1);
+    EXPECT_EQ(pass.GetInsertedCount(), 1);
+    ASSERT_EQ(graph_.GetBlocks().size(), 4);
+    auto *split = graph_.GetBlocks()[3].get();
+    EXPECT_EQ(CountOpcode(split, OpType::MUL), 1);
+    EXPECT_EQ(CountOpcode(merge, OpType::MUL), 0);
+    EXPECT_EQ(static_cast<CjmpInstr*>(entry->GetLastInstr())->GetFalseBranchBB(), split);
+    EXPECT_EQ(split->GetSuccessors(), std::vector<BasicBlock*> {merge});
+    EXPECT_EQ(merge->GetPredecessors()[0], split);
+    ExpectSameResults(BuildCriticalEdge, &graph_, ARG_VALUES);
+}
+
+TEST_F(LazyCodeMotionTest, HEADER_INVARIANT_LEAVES_LOOP) {
+    BuildLoop(&graph_);
+    auto *entry = graph_.GetStartBlock();
+    auto *header = graph_.GetBlocks()[1].get();
+    auto *body = graph_.GetBlocks()[2].get();
+    auto *exit = graph_.GetBlocks()[3].get();
+
+    // a - k runs on every iteration and again at the exit; a * k may not run
+    // at all, so it stays in the body.
+    LazyCodeMotion pass(&graph_);
+    EXPECT_EQ(pass.Run(), 2);
+    EXPECT_EQ(pass.GetInsertedCount(), 1);
+    EXPECT_EQ(CountOpcode(entry, OpType::SUB), 1);
+    EXPECT_EQ(CountOpcode(header, OpType::SUB), 0);
+    EXPECT_EQ(CountOpcode(exit, OpType::SUB), 0);
+    EXPECT_EQ(CountOpcode(body, OpType::MUL), 1);
+    ExpectSameResults(BuildLoop, &graph_, ARG_VALUES);
+}
+
+TEST_F(LazyCodeMotionTest, FULL_AND_LOCAL_REDUNDANCY) {
+    /*
+        x = a + b; y = b + a; if(a >= 10) ret x * (a + b) else ret y - b
+    */
+    IrBuilder builder(&graph_);
+    auto *entry = builder.CreateBB();
+    auto *left = builder.CreateBB();
+    auto *right = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    auto *a = builder.CreateParameter(0);
+    auto *b = builder.CreateParameter(1);
+    auto *x = builder.CreateAdd(DataType::U32, a, b);
+    auto *y = builder.CreateAdd(DataType::U32, b, a);
+    builder.CreateJae(builder.CreateCmp(a, builder.CreateInt32Constant(10)), left, right);
+
+    builder.SetBasicBlockScope(left);
+    builder.CreateRet(DataType::U32, builder.CreateMul(DataType::U32, x, builder.CreateAdd(DataType::U32, a, b)));
+
+    builder.SetBasicBlockScope(right);
+    builder.CreateRet(DataType::U32, builder.CreateSub(DataType::U32, y, b));
+
+    LazyCodeMotion pass(&graph_);
+    EXPECT_EQ(pass.Run(), 2);
+    EXPECT_EQ(pass.GetInsertedCount(), 0);
+    EXPECT_EQ(CountOpcode(&graph_, OpType::ADD), 1);
+    EXPECT_EQ(Interpreter(&graph_).Run({12, 3}), 225);
+    EXPECT_EQ(Interpreter(&graph_).Run({2, 3}), 2);
+}
+
+TEST_F(LazyCodeMotionTest, NOTHING_SAVED_ON_ANY_PATH) {
+    /*
+        if(a >= 10) ret a + b else ret (a + b) * 2
+    */
+    IrBuilder builder(&graph_);
+    auto *entry = builder.CreateBB();
+    auto *left = builder.CreateBB();
+    auto *right = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    auto *a = builder.CreateParameter(0);
+    auto *b = builder.CreateParameter(1);
+    builder.CreateJae(builder.CreateCmp(a, builder.CreateInt32Constant(10)), left, right);
+
+    builder.SetBasicBlockScope(left);
+    builder.CreateRet(DataType::U32, builder.CreateAdd(DataType::U32, a, b));
+
+    builder.SetBasicBlockScope(right);
+    auto *sum = builder.CreateAdd(DataType::U32, a, b);
+    builder.CreateRet(DataType::U32, builder.CreateMul(DataType::U32, sum, builder.CreateInt32Constant(2)));
+
+    LazyCodeMotion pass(&graph_);
+    EXPECT_EQ(pass.Run(), 0);
+    EXPECT_EQ(pass.GetInsertedCount(), 0);
+    EXPECT_EQ(CountOpcode(left, OpType::ADD), 1);
+    EXPECT_EQ(CountOpcode(right, OpType::ADD), 1);
+}
@@ -0,0 +1,237 @@
+#include <gtest/gtest.h>
+
+#include "Interpreter/interpreter.hpp"
+#include "OSR/osr.hpp"
+#include "irbuilder.hpp"
+
+class OsrTest: public ::testing::Test {
+protected:
+    /*
+        BB_0: v0 = param 0, v1 = const 1, v2 = const 2; jmp BB_1
+        BB_1: v4 = phi(v1, v8), v5 = phi(v2, v9), v6 = cmp v5, v0; ja v6, BB_3, BB_2
+        BB_2: v8 = mul v4, v5, v9 = add v5, v1; jmp BB_1
+        BB_3: ret v4
+    */
+    void BuildFactorial() {
+        IrBuilder builder(&graph_);
+
+        auto *entryBB = builder.CreateBB();
+        auto *bb1 = builder.CreateBB();
+        auto *bb2 = builder.CreateBB();
+        auto *bb3 = builder.CreateBB();
+
+        builder.SetBasicBlockScope(entryBB);
+        auto *v0 = builder.CreateParameter(0);
+        auto *v1 = builder.CreateInt64Constant(1);
+        auto *v2 = builder.CreateInt64Constant(2);
+        builder.CreateJmp(bb1);
+
+        builder.SetBasicBlockScope(bb1);
+        auto *v4 = builder.CreatePhi(DataType::U64);
+        auto *v5 = builder.CreatePhi(DataType::U32);
+        auto *v6 = builder.CreateCmp(v5, v0);
+        builder.CreateJa(v6, bb3, bb2);
+
+        builder.SetBasicBlockScope(bb2);
+        auto *v8 = builder.CreateMul(DataType::U64, v4, v5);
+        auto *v9 = builder.CreateAdd(DataType::U32, v5, v1);
+        builder.CreateJmp(bb1);
+
+        v4->AddInput(v1);
+        v4->AddInput(v8);
+        v5->AddInput(v2);
+        v5->AddInput(v9);
+
+        builder.SetBasicBlockScope(bb3);
+        builder.CreateRet(DataType::U64, v4);
+
+        loopHeader_ = bb1;
+    }
+
+    /*
+        acc = 0
+        for(i = 0; i < n; ++i) {
+            t = i * 3
+            for(j = 0; j < m; ++j) {
+                acc = acc + t + j
+            }
+        }
+        return acc
+    */
+    void BuildNestedLoops() {
+        IrBuilder builder(&graph_);
+
+        auto *entryBB = builder.CreateBB();
+        auto *outerHeader = builder.CreateBB();
+        auto *outerBody = builder.CreateBB();
+        auto *innerHeader = builder.CreateBB();
+        auto *innerBody = builder.CreateBB();
+        auto *outerLatch = builder.CreateBB();
+        auto *exitBB = builder.CreateBB();
+
+        builder.SetBasicBlockScope(entryBB);
+        auto *n = builder.CreateParameter(0);
+        auto *m = builder.CreateParameter(1);
+        auto *zero = builder.CreateInt64Constant(0);
+        auto *one = builder.CreateInt64Constant(1);
+        auto *three = builder.CreateInt64Constant(3);
+        builder.CreateJmp(outerHeader);
+
+        builder.SetBasicBlockScope(outerHeader);
+        auto *i = builder.CreatePhi(DataType::U64);
+        auto *acc = builder.CreatePhi(DataType::U64);
+        auto *outerCmp = builder.CreateCmp(i, n);
+        builder.CreateJae(outerCmp, exitBB, outerBody);
+
+        builder.SetBasicBlockScope(outerBody);
+        auto *t = builder.CreateMul(DataType::U64, i, three);
+        builder.CreateJmp(innerHeader);
+
+        builder.SetBasicBlockScope(innerHeader);
+        auto *j = builder.CreatePhi(DataType::U64);
+        auto *accIn = builder.CreatePhi(DataType::U64);
+        auto *innerCmp = builder.CreateCmp(j, m);
+        builder.CreateJae(innerCmp, outerLatch, innerBody);
+
+        builder.SetBasicBlockScope(innerBody);
+        auto *sum = builder.CreateAdd(DataType::U64, accIn, t);
+        auto *accNext = builder.CreateAdd(DataType::U64, sum, j);
+        auto *jNext = builder.CreateAdd(DataType::U64, j, one);
+        builder.CreateJmp(innerHeader);
+
+        builder.SetBasicBlockScope(outerLatch);
+        auto *iNext = builder.CreateAdd(DataType::U64, i, one);
+        builder.CreateJmp(outerHeader);
+
+        builder.SetBasicBlockScope(exitBB);
+        builder.CreateRet(DataType::U64, acc);
+
+        i->AddInput(zero);
+        i->AddInput(iNext);
+        acc->AddInput(zero);
+        acc->AddInput(accIn);
+        j->AddInput(zero);
+        j->AddInput(jNext);
+        accIn->AddInput(acc);
+        accIn->AddInput(accNext);
+
+        loopHeader_ = innerHeader;
+    }
+
+    uint64_t NestedLoopsReference(uint64_t n, uint64_t m) {
+        uint64_t acc = 0;
+        for(uint64_t i = 0; i < n; ++i) {
+            for(uint64_t j = 0; j < m; ++j) {
+                acc = acc + i * 3 + j;
+            }
+        }
+        return acc;
+    }
+
+    Graph graph_;
+    BasicBlock* loopHeader_ = nullptr;
+};
+
+TEST_F(OsrTest, INTERPRETER_RUNS_LOOP) {
+    BuildFactorial();
+
+    Interpreter interpreter(&graph_);
+    auto result = interpreter.Run({5});
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, 120);
+}
+
+TEST_F(OsrTest, ENTRY_LIVE_INS) {
+    BuildFactorial();
+
+    OsrCompiler compiler(&graph_);
+    auto *entry = compiler.GetEntry(loopHeader_);
+    ASSERT_NE(entry, nullptr);
+
+    auto &liveIns = entry->GetLiveIns();
+    ASSERT_EQ(liveIns.size(), 3);
+    EXPECT_TRUE(liveIns[0]->IsPhi());
+    EXPECT_TRUE(liveIns[1]->IsPhi());
+    EXPECT_EQ(liveIns[2]->GetOpType(), OpType::PRM);
+
+    EXPECT_EQ(compiler.GetEntry(loopHeader_), entry);
+    EXPECT_EQ(compiler.GetEntry(graph_.GetStartBlock()), nullptr);
+}
+
+TEST_F(OsrTest, HOT_LOOP_TRANSFERS_TO_OSR_ENTRY) {
+    BuildFactorial();
+
+    OsrCompiler compiler(&graph_);
+    Interpreter interpreter(&graph_);
+    interpreter.EnableOsr(&compiler, 3);
+
+    auto result = interpreter.Run({10});
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, 3628800);
+    EXPECT_EQ(interpreter.GetOsrTransitionsCount(), 1);
+    EXPECT_EQ(interpreter.GetBackEdgeCount(loopHeader_), 3);
+}
+
+TEST_F(OsrTest, COLD_LOOP_STAYS_IN_INTERPRETER) {
+    BuildFactorial();
+
+    OsrCompiler compiler(&graph_);
+    Interpreter interpreter(&graph_);
+    interpreter.EnableOsr(&compiler, 100);
+
+    auto result = interpreter.Run({4});
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, 24);
+    EXPECT_EQ(interpreter.GetOsrTransitionsCount(), 0);
+}
+
+TEST_F(OsrTest, CUSTOM_CODE_GENERATOR) {
+    BuildFactorial();
+
+    size_t generated = 0;
+    OsrCompiler compiler(&graph_, [&generated](Graph* osrGraph) -> OsrCode {
+        ++generated;
+        return [osrGraph](const std::vector<uint64_t> &liveIns) {
+            Interpreter interpreter(osrGraph);
+            return interpreter.Run(liveIns);
+        };
+    });
+    Interpreter interpreter(&graph_);
+    interpreter.EnableOsr(&compiler, 1);
+
+    auto result = interpreter.Run({6});
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, 720);
+    EXPECT_EQ(generated, 1);
+}
+
+TEST_F(OsrTest, INNER_LOOP_OF_NEST) {
+    BuildNestedLoops();
+
+    for(size_t threshold: {1, 2, 5, 17}) {
+        OsrCompiler compiler(&graph_);
+        Interpreter interpreter(&graph_);
+        interpreter.EnableOsr(&compiler, threshold);
+
+        auto result = interpreter.Run({4, 7});
+        ASSERT_TRUE(result.has_value());
+        EXPECT_EQ(*result, NestedLoopsReference(4, 7));
+        EXPECT_EQ(interpreter.GetOsrTransitionsCount(), 1);
+    }
+}
+
+TEST_F(OsrTest, OUTER_LOOP_OF_NEST) {
+    BuildNestedLoops();
+
+    OsrCompiler compiler(&graph_);
+    auto *outerHeader = graph_.GetBlocks()[1].get();
+    ASSERT_NE(compiler.GetEntry(outerHeader), nullptr);
+
+    Interpreter interpreter(&graph_);
+    interpreter.EnableOsr(&compiler, 2);
+
+    auto result = interpreter.Run({5, 3});
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, NestedLoopsReference(5, 3));
+    EXPECT_EQ(interpreter.GetOsrTransitionsCount(), 1);
+}
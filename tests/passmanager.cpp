@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+
+#include "PassManager/alloccounter.hpp"
+#include "PassManager/passmanager.hpp"
+#include "Scheduler/listscheduler.hpp"
+#include "irbuilder.hpp"
+
+#include <cstdio>
+#include <sstream>
+
+class PassManagerTest: public ::testing::Test {
+protected:
+    /*
+        BB_0: a = param 0; ret a * a + a
+        BB_1: ret a          (unreachable)
+    */
+    void BuildGraph() {
+        IrBuilder builder(&graph_);
+
+        auto *entryBB = builder.CreateBB();
+        auto *deadBB = builder.CreateBB();
+
+        builder.SetBasicBlockScope(entryBB);
+        auto *a = builder.CreateParameter(0);
+        auto *square = builder.CreateMul(DataType::U64, a, a);
+        builder.CreateRet(DataType::U64, builder.CreateAdd(DataType::U64, square, a));
+
+        builder.SetBasicBlockScope(deadBB);
+        builder.CreateRet(DataType::U64, a);
+    }
+
+    Graph graph_;
+    std::vector<uint8_t> buffer_;
+};
+
+TEST_F(PassManagerTest, RECORDS_PASS_STATS) {
+    BuildGraph();
+
+    PassManager manager;
+    manager.AddPass("schedule", [](Graph* graph) {
+        ListScheduler(graph).Run();
+        return true;
+    });
+    manager.AddPass("remove-unreachable", [](Graph* graph) {
+        graph->RemoveUnreachableBlocks();
+        return true;
+    });
+    manager.AddPass("allocate", [this](Graph*) {
+        buffer_.resize(1 << 20);
+        return true;
+    });
+    ASSERT_TRUE(manager.Run(&graph_));
+
+    auto &stats = manager.GetStats();
+    ASSERT_EQ(stats.size(), 3);
+    EXPECT_EQ(stats[0].name, "schedule");
+    EXPECT_EQ(stats[0].instrsBefore, 5);
+    EXPECT_EQ(stats[0].instrsAfter, 5);
+    EXPECT_EQ(stats[1].blocksBefore, 2);
+    EXPECT_EQ(stats[1].blocksAfter, 1);
+    EXPECT_EQ(stats[1].instrsAfter, 4);
+    EXPECT_LE(stats[0].startNs + stats[0].durationNs, stats[1].startNs);
+
+    // The tests link the operator new replacement.
+    ASSERT_TRUE(AreAllocationCountersEnabled());
+    EXPECT_GE(stats[2].bytesAllocated, 1 << 20);
+    EXPECT_GE(stats[2].allocationsCount, 1);
+}
+
+TEST_F(PassManagerTest, FAILED_PASS_STOPS_PIPELINE) {
+    BuildGraph();
+
+    PassManager manager;
+    manager.AddPass("fail", [](Graph*) { return false; });
+    manager.AddPass("never", [](Graph*) { return true; });
+
+    EXPECT_FALSE(manager.Run(&graph_));
+    ASSERT_EQ(manager.GetStats().size(), 1);
+    EXPECT_FALSE(manager.GetStats()[0].succeeded);
+
+    manager.ClearStats();
+    EXPECT_TRUE(manager.GetStats().empty());
+}
+
+TEST_F(PassManagerTest, JSON_AND_TRACE_OUTPUT) {
+    BuildGraph();
+
+    PassManager manager;
+    manager.AddPass("quote\"pass", [](Graph*) { return true; });
+    manager.Run(&graph_);
+    manager.Run(&graph_);
+
+    std::stringstream json;
+    manager.DumpJson(json);
+    EXPECT_NE(json.str().find("\"name\": \"quote\\\"pass\""), std::string::npos);
+    EXPECT_NE(json.str().find("\"instructions_before\": 5"), std::string::npos);
+    EXPECT_NE(json.str().find("\"total_ns\""), std::string::npos);
+
+    std::stringstream trace;
+    manager.DumpChromeTrace(trace);
+    EXPECT_NE(trace.str().find("\"traceEvents\""), std::string::npos);
+
+    size_t events = 0;
+    for(size_t pos = trace.str().find("\"ph\": \"X\""); pos != std::string::npos;
+        pos = trace.str().find("\"ph\": \"X\"", pos + 1)) {
+        ++events;
+    }
+    EXPECT_EQ(events, 2);
+}
+
+TEST_F(PassManagerTest, TRACE_TIMESTAMPS_PAST_ONE_SECOND) {
+    BuildGraph();
+
+    PassManager manager(std::chrono::steady_clock::now() - std::chrono::seconds(2));
+    manager.AddPass("late", [](Graph*) { return true; });
+    manager.Run(&graph_);
+    auto startNs = manager.GetStats().front().startNs;
+    ASSERT_GT(startNs, 1000000000ULL);
+
+    std::stringstream trace;
+    manager.DumpChromeTrace(trace);
+    EXPECT_EQ(trace.str().find("e+"), std::string::npos);
+
+    char expected[64];
+    std::snprintf(expected, sizeof(expected), "\"ts\": %llu.%03llu,",
+                  static_cast<unsigned long long>(startNs / 1000), static_cast<unsigned long long>(startNs % 1000));
+    EXPECT_NE(trace.str().find(expected), std::string::npos) << trace.str();
+}
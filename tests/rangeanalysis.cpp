@@ -0,0 +1,281 @@
+#include <gtest/gtest.h>
+
+#include "RangeAnalysis/checkelimination.hpp"
+#include "Interpreter/interpreter.hpp"
+#include "irbuilder.hpp"
+#include "testutils.hpp"
+
+#include <optional>
+
+namespace {
+
+constexpr uint32_t ACC = 0;
+constexpr uint32_t IV = 1;
+
+// acc = 0; for(i = 0; i < bound; ++i) { boundscheck i + offset, length; acc += i } return acc
+// where bound and length default to parameters 0 and 1. A conditional check
+// only runs on odd iterations.
+struct LoopShape {
+    std::optional<uint64_t> bound;
+    std::optional<uint64_t> length;
+    bool lengthIsBound = false;
+    uint64_t offset = 0;
+    bool conditionalCheck = false;
+};
+
+void BuildLoop(Graph* graph, const LoopShape &shape) {
+    IrBuilder builder(graph);
+    auto *entry = builder.CreateBB();
+    auto *header = builder.CreateBB();
+    auto *body = builder.CreateBB();
+    auto *odd = shape.conditionalCheck ? builder.CreateBB() : nullptr;
+    auto *latch = shape.conditionalCheck ? builder.CreateBB() : body;
+    auto *exit = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    builder.SealBlock(entry);
+    auto *n = builder.CreateParameter(0);
+    auto *len = builder.CreateParameter(1);
+    builder.WriteVariable(ACC, builder.CreateConstant(uint64_t{0}, DataType::U64));
+    builder.WriteVariable(IV, builder.CreateConstant(uint64_t{0}, DataType::U32));
+    auto *bound = shape.bound ? builder.CreateConstant(*shape.bound, DataType::U32) : n;
+    auto *length = shape.lengthIsBound ? bound :
+                   shape.length ? builder.CreateConstant(*shape.length, DataType::U32) : len;
+    builder.CreateJmp(header);
+
+    builder.SetBasicBlockScope(header);
+    builder.CreateJae(builder.CreateCmp(builder.ReadVariable(IV), bound), exit, body);
+
+    builder.SetBasicBlockScope(body);
+    builder.SealBlock(body);
+    auto *iv = builder.ReadVariable(IV);
+    auto *one = builder.CreateConstant(uint64_t{1}, DataType::U32);
+    if(shape.conditionalCheck) {
+        builder.CreateJe(builder.CreateCmp(builder.CreateAnd(DataType::U32, iv, one), one), odd, latch);
+        builder.SetBasicBlockScope(odd);
+        builder.SealBlock(odd);
+    }
+    auto *index = iv;
+    if(shape.offset != 0) {
+        index = builder.CreateAdd(DataType::U32, iv, builder.CreateConstant(shape.offset, DataType::U32));
+    }
+    builder.CreateBoundsCheck(index, length);
+    if(shape.conditionalCheck) {
+        builder.CreateJmp(latch);
+        builder.SetBasicBlockScope(latch);
+        builder.SealBlock(latch);
+    }
+    builder.WriteVariable(ACC, builder.CreateAdd(DataType::U64, builder.ReadVariable(ACC), iv));
+    builder.WriteVariable(IV, builder.CreateAdd(DataType::U32, iv, one));
+    builder.CreateJmp(header);
+    builder.SealBlock(header);
+
+    builder.SetBasicBlockScope(exit);
+    builder.SealBlock(exit);
+    builder.CreateRet(DataType::U64, builder.ReadVariable(ACC));
+}
+
+Instruction* FindFirst(Graph* graph, OpType op) {
+    for(auto &instr: graph->GetInstructions()) {
+        if(instr->GetOpType() == op && instr->GetParentBB() != nullptr) {
+            return instr.get();
+        }
+    }
+    return nullptr;
+}
+
+}  // namespace
+
+class RangeAnalysisTest: public ::testing::Test {
+protected:
+    // Runs the check elimination on a copy of the loop and checks it against
+    // the original, traps included.
+    void ExpectSameResults(const LoopShape &shape,
+                           std::vector<uint64_t> bounds = {0, 1, 2, 5, 9, 10},
+                           std::vector<uint64_t> lengths = {0, 1, 5, 6, 10, 11}) {
+        Graph original;
+        BuildLoop(&original, shape);
+        optimized_ = std::make_unique<Graph>();
+        BuildLoop(optimized_.get(), shape);
+        CheckElimination elimination(optimized_.get());
+        removedCount_ = elimination.Run();
+        hoistedCount_ = elimination.GetHoistedCount();
+
+        Interpreter originalInterpreter(&original);
+        Interpreter optimizedInterpreter(optimized_.get());
+        for(auto n: bounds) {
+            for(auto len: lengths) {
+                EXPECT_EQ(optimizedInterpreter.Run({n, len}), originalInterpreter.Run({n, len}))
+                    << "n = " << n << ", len = " << len;
+            }
+        }
+    }
+
+    std::unique_ptr<Graph> optimized_;
+    size_t removedCount_ = 0;
+    size_t hoistedCount_ = 0;
+};
+
+TEST_F(RangeAnalysisTest, INTERPRETER_TRAPS_ON_FAILING_CHECKS) {
+    Graph graph;
+    IrBuilder builder(&graph);
+    builder.SetBasicBlockScope(builder.CreateBB());
+    auto *a = builder.CreateParameter(0);
+    auto *b = builder.CreateParameter(1);
+    builder.CreateBoundsCheck(a, b);
+    builder.CreateOverflowCheck(OpType::ADD, DataType::U8, a, b);
+    builder.CreateRet(DataType::U64, builder.CreateAdd(DataType::U64, a, b));
+
+    Interpreter interpreter(&graph);
+    EXPECT_EQ(interpreter.Run({1, 2}), 3);
+    EXPECT_EQ(interpreter.Run({2, 2}), std::nullopt);
+    EXPECT_EQ(interpreter.Run({100, 155}), 255);
+    EXPECT_EQ(interpreter.Run({100, 156}), std::nullopt);
+}
+
+TEST_F(RangeAnalysisTest, EXACT_RANGES_OF_ARITHMETIC) {
+    auto range = [](uint64_t min, uint64_t max) {
+        return ValueRange{min, max};
+    };
+    EXPECT_EQ(RangeAnalysis::GetExactRange(OpType::ADD, DataType::U8, range(0, 200), range(0, 55)), range(0, 255));
+    EXPECT_EQ(RangeAnalysis::GetExactRange(OpType::ADD, DataType::U8, range(0, 200), range(0, 56)), std::nullopt);
+    EXPECT_EQ(RangeAnalysis::GetExactRange(OpType::SUB, DataType::U32, range(5, 10), range(0, 5)), range(0, 10));
+    EXPECT_EQ(RangeAnalysis::GetExactRange(OpType::SUB, DataType::U32, range(5, 10), range(0, 6)), std::nullopt);
+    EXPECT_EQ(RangeAnalysis::GetExactRange(OpType::MUL, DataType::U16, range(2, 255), range(0, 257)),
+              range(0, 65535));
+
+    // Signed values are kept sign-extended, so a result crossing zero fits
+    // the type but spans every 64-bit number.
+    auto minusFive = static_cast<uint64_t>(-5);
+    auto minusOne = static_cast<uint64_t>(-1);
+    EXPECT_EQ(RangeAnalysis::GetExactRange(OpType::SUB, DataType::I32, range(0, 10), range(20, 30)),
+              range(static_cast<uint64_t>(-30), static_cast<uint64_t>(-10)));
+    EXPECT_EQ(RangeAnalysis::GetExactRange(OpType::SUB, DataType::I32, range(0, 10), range(5, 15)), ValueRange{});
+    EXPECT_EQ(RangeAnalysis::GetExactRange(OpType::MUL, DataType::I8, range(minusFive, minusOne), range(1, 25)),
+              range(static_cast<uint64_t>(-125), minusOne));
+    EXPECT_EQ(RangeAnalysis::GetExactRange(OpType::MUL, DataType::I8, range(minusFive, minusOne), range(0, 26)),
+              std::nullopt);
+    EXPECT_EQ(RangeAnalysis::GetExactRange(OpType::ADD, DataType::I32, range(0, 0x7fffffff), range(1, 1)),
+              std::nullopt);
+}
+
+TEST_F(RangeAnalysisTest, BRANCHES_NARROW_RANGES) {
+    /*
+        BB_0: a = param 0; cmp a, 10; jae BB_2, BB_1
+        BB_1: x = a + 5; ovfcheck add u8 x, 240; ret x
+        BB_2: ret a
+    */
+    Graph graph;
+    IrBuilder builder(&graph);
+    auto *entry = builder.CreateBB();
+    auto *below = builder.CreateBB();
+    auto *above = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    auto *a = builder.CreateParameter(0);
+    auto *ten = builder.CreateConstant(uint64_t{10}, DataType::U32);
+    builder.CreateJae(builder.CreateCmp(a, ten), above, below);
+
+    builder.SetBasicBlockScope(below);
+    auto *x = builder.CreateAdd(DataType::U32, a, builder.CreateConstant(uint64_t{5}, DataType::U32));
+    auto *check = builder.CreateOverflowCheck(OpType::ADD, DataType::U8, x,
+                                              builder.CreateConstant(uint64_t{240}, DataType::U8));
+    builder.CreateRet(DataType::U32, x);
+
+    builder.SetBasicBlockScope(above);
+    auto *ret = builder.CreateRet(DataType::U32, a);
+
+    RangeAnalysis analysis(&graph);
+    analysis.Analyze();
+    EXPECT_EQ(analysis.GetRange(a), ValueRange::OfType(DataType::U32));
+    EXPECT_EQ(analysis.GetRange(a, check), (ValueRange{0, 9}));
+    EXPECT_EQ(analysis.GetRange(x), (ValueRange{5, 14}));
+    EXPECT_EQ(analysis.GetRange(a, ret), (ValueRange{10, 0xffffffff}));
+    EXPECT_TRUE(analysis.IsKnownBelow(a, ten, check));
+    EXPECT_FALSE(analysis.IsKnownBelow(a, ten, ret));
+
+    // 14 + 240 still fits a byte.
+    EXPECT_EQ(CheckElimination(&graph).Run(), 1);
+    EXPECT_EQ(CountOpcode(&graph, OpType::OVERFLOW_CHECK), 0);
+    EXPECT_EQ(Interpreter(&graph).Run({9}), 14);
+    EXPECT_EQ(Interpreter(&graph).Run({11}), 11);
+}
+
+TEST_F(RangeAnalysisTest, LOOP_COUNTER_RANGE) {
+    LoopShape shape;
+    shape.bound = 16;
+    Graph graph;
+    BuildLoop(&graph, shape);
+
+    RangeAnalysis analysis(&graph);
+    analysis.Analyze();
+    auto *check = FindFirst(&graph, OpType::BOUNDS_CHECK);
+    ASSERT_NE(check, nullptr);
+    auto *iv = check->GetInputs()[0].GetValue();
+    ASSERT_EQ(iv->GetOpType(), OpType::PHI);
+    EXPECT_EQ(analysis.GetRange(iv), (ValueRange{0, 16}));
+    EXPECT_EQ(analysis.GetRange(iv, check), (ValueRange{0, 15}));
+}
+
+TEST_F(RangeAnalysisTest, CONSTANT_LENGTH_CHECK_REMOVED) {
+    LoopShape shape;
+    shape.bound = 16;
+    shape.length = 16;
+    ExpectSameResults(shape);
+    EXPECT_EQ(removedCount_, 1);
+    EXPECT_EQ(hoistedCount_, 0);
+    EXPECT_EQ(CountOpcode(optimized_.get(), OpType::BOUNDS_CHECK), 0);
+}
+
+TEST_F(RangeAnalysisTest, CHECK_AGAINST_LOOP_BOUND_REMOVED) {
+    LoopShape shape;
+    shape.lengthIsBound = true;
+    ExpectSameResults(shape);
+    EXPECT_EQ(removedCount_, 1);
+    EXPECT_EQ(CountOpcode(optimized_.get(), OpType::BOUNDS_CHECK), 0);
+}
+
+TEST_F(RangeAnalysisTest, CHECK_HOISTED_OUT_OF_LOOP) {
+    LoopShape shape;
+    shape.offset = 1;
+    ExpectSameResults(shape);
+    EXPECT_EQ(removedCount_, 0);
+    EXPECT_EQ(hoistedCount_, 1);
+    ASSERT_EQ(CountOpcode(optimized_.get(), OpType::BOUNDS_CHECK), 1);
+
+    LoopAnalyzer analyzer(optimized_.get());
+    analyzer.Analyze();
+    ASSERT_EQ(analyzer.GetLoops().size(), 1);
+    auto *loop = analyzer.GetLoops()[0].get();
+    EXPECT_FALSE(loop->Contains(FindFirst(optimized_.get(), OpType::BOUNDS_CHECK)->GetParentBB()));
+}
+
+TEST_F(RangeAnalysisTest, CONDITIONAL_CHECK_STAYS_IN_LOOP) {
+    LoopShape shape;
+    shape.offset = 1;
+    shape.conditionalCheck = true;
+    ExpectSameResults(shape);
+    EXPECT_EQ(removedCount_, 0);
+    EXPECT_EQ(hoistedCount_, 0);
+    EXPECT_EQ(CountOpcode(optimized_.get(), OpType::BOUNDS_CHECK), 1);
+}
+
+TEST_F(RangeAnalysisTest, REPEATED_OVERFLOW_CHECK_REMOVED) {
+    Graph graph;
+    IrBuilder builder(&graph);
+    builder.SetBasicBlockScope(builder.CreateBB());
+    auto *a = builder.CreateParameter(0);
+    auto *b = builder.CreateParameter(1);
+    builder.CreateOverflowCheck(OpType::MUL, DataType::U32, a, b);
+    auto *product = builder.CreateMul(DataType::U32, a, b);
+    builder.CreateOverflowCheck(OpType::MUL, DataType::U32, b, a);
+    builder.CreateOverflowCheck(OpType::SUB, DataType::U32, a, b);
+    builder.CreateRet(DataType::U32, product);
+
+    EXPECT_EQ(CheckElimination(&graph).Run(), 1);
+    EXPECT_EQ(CountOpcode(&graph, OpType::OVERFLOW_CHECK), 2);
+    Interpreter interpreter(&graph);
+    EXPECT_EQ(interpreter.Run({7, 6}), 42);
+    EXPECT_EQ(interpreter.Run({6, 7}), std::nullopt);
+    EXPECT_EQ(interpreter.Run({0x10000, 0x10000}), std::nullopt);
+}
@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+
+#include "Interpreter/interpreter.hpp"
+#include "Scheduler/listscheduler.hpp"
+#include "irbuilder.hpp"
+
+#include <unordered_map>
+
+class SchedulerTest: public ::testing::Test {
+protected:
+    /*
+        BB_0: a = param 0, b = param 1
+              d = div a, b; e = add d, 3
+              m = mul a, a; f = add m, b
+              g = add a, b; h = add g, 3
+              s = add e, f; r = add s, h; ret r
+    */
+    void BuildLongLatencyChain() {
+        IrBuilder builder(&graph_);
+
+        block_ = builder.CreateBB();
+        builder.SetBasicBlockScope(block_);
+        auto *a = builder.CreateParameter(0);
+        auto *b = builder.CreateParameter(1);
+        auto *three = builder.CreateInt64Constant(3);
+        auto *e = builder.CreateAdd(DataType::U64, builder.CreateDiv(DataType::U64, a, b), three);
+        auto *f = builder.CreateAdd(DataType::U64, builder.CreateMul(DataType::U64, a, a), b);
+        auto *h = builder.CreateAdd(DataType::U64, builder.CreateAdd(DataType::U64, a, b), three);
+        auto *s = builder.CreateAdd(DataType::U64, e, f);
+        builder.CreateRet(DataType::U64, builder.CreateAdd(DataType::U64, s, h));
+    }
+
+    /*
+        BB_0: a = param 0; jmp BB_1
+        BB_1: i = phi(a, j); j = sub i, 1; x = mul i, i; y = div x, 7; cmp j, 0; je BB_2, BB_1
+        BB_2: ret y
+    */
+    void BuildLoop() {
+        IrBuilder builder(&graph_);
+
+        auto *entryBB = builder.CreateBB();
+        block_ = builder.CreateBB();
+        auto *exitBB = builder.CreateBB();
+
+        builder.SetBasicBlockScope(entryBB);
+        auto *a = builder.CreateParameter(0);
+        auto *zero = builder.CreateInt64Constant(0);
+        auto *one = builder.CreateInt64Constant(1);
+        auto *seven = builder.CreateInt64Constant(7);
+        builder.CreateJmp(block_);
+
+        builder.SetBasicBlockScope(block_);
+        auto *i = builder.CreatePhi(DataType::U64);
+        auto *j = builder.CreateSub(DataType::U64, i, one);
+        auto *x = builder.CreateMul(DataType::U64, i, i);
+        auto *y = builder.CreateDiv(DataType::U64, x, seven);
+        builder.CreateJe(builder.CreateCmp(j, zero), exitBB, block_);
+
+        builder.SetBasicBlockScope(exitBB);
+        builder.CreateRet(DataType::U64, y);
+
+        i->AddInput(a);
+        i->AddInput(j);
+    }
+
+    void ExpectInputsDefinedFirst(BasicBlock* block) {
+        std::unordered_map<Instruction*, size_t> position;
+        size_t pos = 0;
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            position[instr] = pos++;
+        }
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            if(instr->IsPhi()) {
+                continue;
+            }
+            for(auto &input: instr->GetInputs()) {
+                auto it = position.find(input.GetValue());
+                if(it != position.end()) {
+                    EXPECT_LT(it->second, position[instr]);
+                }
+            }
+        }
+    }
+
+    Graph graph_;
+    BasicBlock* block_ = nullptr;
+};
+
+TEST_F(SchedulerTest, HIDES_LONG_LATENCY) {
+    BuildLongLatencyChain();
+
+    LatencyModel model;
+    uint32_t before = EstimateBlockCycles(block_, model);
+    auto expected = Interpreter(&graph_).Run({100, 7});
+
+    ListScheduler(&graph_, model).Run();
+
+    EXPECT_LT(EstimateBlockCycles(block_, model), before);
+    EXPECT_EQ(block_->GetLastInstr()->GetOpType(), OpType::RET);
+    ExpectInputsDefinedFirst(block_);
+    EXPECT_EQ(Interpreter(&graph_).Run({100, 7}), expected);
+}
+
+TEST_F(SchedulerTest, KEEPS_PHIS_AND_TERMINATOR) {
+    BuildLoop();
+
+    auto expected = Interpreter(&graph_).Run({5});
+    ListScheduler(&graph_).Run();
+
+    EXPECT_TRUE(block_->GetFirstInstr()->IsPhi());
+    EXPECT_EQ(block_->GetLastInstr()->GetOpType(), OpType::JE);
+    // Multiplication feeds the division and starts first; sub fills the gap.
+    EXPECT_EQ(block_->GetFirstInstr()->GetNext()->GetOpType(), OpType::MUL);
+    ExpectInputsDefinedFirst(block_);
+    EXPECT_EQ(Interpreter(&graph_).Run({5}), expected);
+}
+
+TEST_F(SchedulerTest, CUSTOM_LATENCY_MODEL) {
+    BuildLoop();
+
+    LatencyModel model;
+    model.SetLatency(OpType::MUL, 1);
+    model.SetLatency(OpType::DIV, 1);
+    model.SetLatency(OpType::SUB, 5);
+    EXPECT_EQ(model.GetLatency(OpType::SUB), 5);
+
+    ListScheduler(&graph_, model).Run();
+    EXPECT_EQ(block_->GetFirstInstr()->GetNext()->GetOpType(), OpType::SUB);
+    ExpectInputsDefinedFirst(block_);
+}
+
+TEST_F(SchedulerTest, REGISTER_PRESSURE_LIMIT) {
+    BuildLongLatencyChain();
+
+    auto expected = Interpreter(&graph_).Run({100, 7});
+    ListScheduler(&graph_, LatencyModel(), 2).Run();
+
+    ExpectInputsDefinedFirst(block_);
+    EXPECT_EQ(Interpreter(&graph_).Run({100, 7}), expected);
+}
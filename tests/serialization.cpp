@@ -0,0 +1,315 @@
+#include <gtest/gtest.h>
+
+#include "DivisionByConstant/divisionbyconstant.hpp"
+#include "GraphHash/graphhash.hpp"
+#include "Interpreter/interpreter.hpp"
+#include "Scheduler/listscheduler.hpp"
+#include "Serialization/graphserializer.hpp"
+#include "irbuilder.hpp"
+
+#include <algorithm>
+#include <unistd.h>
+
+class SerializationTest: public ::testing::Test {
+protected:
+    /*
+        BB_0: v0 = param 0, v1 = const 1, v2 = const 2; jmp BB_1
+        BB_1: v4 = phi(v1, v8), v5 = phi(v2, v9), v6 = cmp v5, v0; ja v6, BB_3, BB_2
+        BB_2: v8 = mul v4, v5, v9 = add v5, v1, v10 = div v8, v5; jmp BB_1
+        BB_3: ret v4
+    */
+    void BuildFactorial() {
+        IrBuilder builder(&graph_);
+
+        auto *entryBB = builder.CreateBB();
+        auto *bb1 = builder.CreateBB();
+        auto *bb2 = builder.CreateBB();
+        auto *bb3 = builder.CreateBB();
+
+        builder.SetBasicBlockScope(entryBB);
+        auto *v0 = builder.CreateParameter(0);
+        auto *v1 = builder.CreateInt64Constant(1);
+        auto *v2 = builder.CreateInt32Constant(2);
+        builder.CreateJmp(bb1);
+
+        builder.SetBasicBlockScope(bb1);
+        auto *v4 = builder.CreatePhi(DataType::U64);
+        auto *v5 = builder.CreatePhi(DataType::U64);
+        auto *v6 = builder.CreateCmp(v5, v0);
+        builder.CreateJa(v6, bb3, bb2);
+
+        builder.SetBasicBlockScope(bb2);
+        auto *v8 = builder.CreateMul(DataType::U64, v4, v5);
+        auto *v9 = builder.CreateAdd(DataType::U64, v5, v1);
+        builder.CreateDiv(DataType::U64, v8, v5);
+        builder.CreateJmp(bb1);
+
+        v4->AddInput(v1);
+        v4->AddInput(v8);
+        v5->AddInput(v2);
+        v5->AddInput(v9);
+
+        builder.SetBasicBlockScope(bb3);
+        builder.CreateRet(DataType::U64, v4);
+    }
+
+    static std::string Dump(Graph* graph) {
+        std::stringstream ss;
+        graph->Dump(ss);
+        return ss.str();
+    }
+
+    void ExpectSameGraph(Graph* graph) {
+        EXPECT_EQ(Dump(graph), Dump(&graph_));
+        EXPECT_EQ(GraphHasher(graph).Run(), GraphHasher(&graph_).Run());
+        for(uint64_t n: {1, 5, 10}) {
+            EXPECT_EQ(Interpreter(graph).Run({n}), Interpreter(&graph_).Run({n}));
+        }
+    }
+
+    Graph graph_;
+};
+
+TEST_F(SerializationTest, ROUND_TRIP_IN_MEMORY) {
+    BuildFactorial();
+
+    auto image = GraphSerializer(&graph_).Run();
+    ASSERT_TRUE(image.has_value());
+    auto view = GraphImageView::Create(image->data(), image->size());
+    ASSERT_TRUE(view.has_value());
+
+    auto graph = GraphDeserializer(*view).Run();
+    ASSERT_NE(graph, nullptr);
+    ExpectSameGraph(graph.get());
+}
+
+TEST_F(SerializationTest, REORDERED_BLOCK_ROUND_TRIP) {
+    BuildFactorial();
+    // Scheduling moves the division in front of the add, so the list order
+    // no longer follows instruction ids.
+    ListScheduler(&graph_).Run();
+
+    auto image = GraphSerializer(&graph_).Run();
+    ASSERT_TRUE(image.has_value());
+    auto view = GraphImageView::Create(image->data(), image->size());
+    ASSERT_TRUE(view.has_value());
+    ExpectSameGraph(GraphDeserializer(*view).Run().get());
+}
+
+TEST_F(SerializationTest, REMOVED_INSTRUCTIONS_ARE_DROPPED) {
+    BuildFactorial();
+    IrBuilder builder(&graph_);
+    builder.SetBasicBlockScope(graph_.GetStartBlock());
+    auto *unused = builder.CreateAdd(DataType::U64, builder.CreateInt64Constant(3), builder.CreateInt64Constant(4));
+    ASSERT_TRUE(graph_.RemoveInstruction(unused));
+
+    auto image = GraphSerializer(&graph_).Run();
+    ASSERT_TRUE(image.has_value());
+    auto view = GraphImageView::Create(image->data(), image->size());
+    ASSERT_TRUE(view.has_value());
+    // The two constants are still placed; only the add is dropped.
+    EXPECT_EQ(view->GetInstructionsCount(), graph_.GetInstructions().size() - 1);
+    auto graph = GraphDeserializer(*view).Run();
+    ASSERT_NE(graph, nullptr);
+    EXPECT_EQ(GraphHasher(graph.get()).Run(), GraphHasher(&graph_).Run());
+    for(uint64_t n: {1, 5, 10}) {
+        EXPECT_EQ(Interpreter(graph.get()).Run({n}), Interpreter(&graph_).Run({n}));
+    }
+}
+
+TEST_F(SerializationTest, OPTIMIZED_GRAPH_ROUND_TRIP) {
+    IrBuilder builder(&graph_);
+    builder.SetBasicBlockScope(builder.CreateBB());
+    auto *a = builder.CreateParameter(0);
+    auto *quotient = builder.CreateDiv(DataType::U32, a, builder.CreateInt32Constant(7));
+    auto *remainder = builder.CreateMod(DataType::U32, a, builder.CreateInt32Constant(10));
+    builder.CreateRet(DataType::U32, builder.CreateAdd(DataType::U32, quotient, remainder));
+    // The rewrite removes the original DIV and MOD from their block.
+    ASSERT_EQ(DivisionByConstant(&graph_).Run(), 2);
+
+    auto image = GraphSerializer(&graph_).Run();
+    ASSERT_TRUE(image.has_value());
+    auto view = GraphImageView::Create(image->data(), image->size());
+    ASSERT_TRUE(view.has_value());
+    EXPECT_LT(view->GetInstructionsCount(), graph_.GetInstructions().size());
+    auto graph = GraphDeserializer(*view).Run();
+    ASSERT_NE(graph, nullptr);
+    EXPECT_EQ(GraphHasher(graph.get()).Run(), GraphHasher(&graph_).Run());
+    for(uint64_t n: {0ULL, 6ULL, 7ULL, 1234ULL, 0xffffffffULL}) {
+        EXPECT_EQ(Interpreter(graph.get()).Run({n}), (n / 7 + n % 10) & 0xffffffff);
+    }
+}
+
+TEST_F(SerializationTest, MAPPED_FILE_ZERO_COPY) {
+    BuildFactorial();
+
+    std::string path = ::testing::TempDir() + "graph_" + std::to_string(getpid()) + ".irg";
+    ASSERT_TRUE(GraphSerializer(&graph_).WriteFile(path));
+
+    MappedGraphFile file;
+    ASSERT_TRUE(file.Open(path));
+    auto &view = *file.GetView();
+    ASSERT_EQ(view.GetBlocksCount(), 4);
+    ASSERT_EQ(view.GetInstructionsCount(), graph_.GetInstructions().size());
+
+    size_t phis = 0;
+    for(size_t id = 0; id < view.GetInstructionsCount(); ++id) {
+        auto &instr = view.GetInstruction(id);
+        if(static_cast<OpType>(instr.opcode) == OpType::PHI) {
+            ++phis;
+            EXPECT_EQ(view.GetOperands(instr).size(), 2);
+        }
+    }
+    EXPECT_EQ(phis, 2);
+    EXPECT_EQ(view.GetPredecessors(view.GetBlock(1)).size(), 2);
+    EXPECT_EQ(view.GetSuccessors(view.GetBlock(1))[0], 3);
+
+    ExpectSameGraph(GraphDeserializer(view).Run().get());
+    file.Close();
+    unlink(path.c_str());
+}
+
+TEST_F(SerializationTest, REJECTS_BROKEN_IMAGES) {
+    BuildFactorial();
+
+    auto image = *GraphSerializer(&graph_).Run();
+    EXPECT_FALSE(GraphImageView::Create(image.data(), image.size() - 4).has_value());
+
+    auto badMagic = image;
+    badMagic[0] = 'X';
+    EXPECT_FALSE(GraphImageView::Create(badMagic.data(), badMagic.size()).has_value());
+
+    // Point an operand of the first binary instruction outside of the table.
+    auto badOperand = image;
+    auto *header = reinterpret_cast<GraphFileHeader*>(badOperand.data());
+    auto *instrs = reinterpret_cast<InstrRecord*>(badOperand.data() + sizeof(GraphFileHeader) +
+                                                  header->blocksCount * sizeof(BlockRecord));
+    auto *words = reinterpret_cast<uint32_t*>(instrs + header->instrsCount);
+    auto *binary = std::find_if(instrs, instrs + header->instrsCount, [](auto &instr) {
+        return instr.operandsCount == 2;
+    });
+    words[binary->firstWord] = header->instrsCount;
+    EXPECT_FALSE(GraphImageView::Create(badOperand.data(), badOperand.size()).has_value());
+}
+
+TEST_F(SerializationTest, REJECTS_GUARDS) {
+    BuildFactorial();
+
+    auto *block = graph_.GetBlocks()[1].get();
+    auto *cmp = block->GetLastInstr()->GetInputs()[0].GetValue();
+    auto guard = std::make_unique<GuardInstr>(cmp, OpType::JA, false, block, block);
+    block->InsertBefore(block->GetLastInstr(), guard.get());
+    graph_.AddInstruction(std::move(guard));
+
+    EXPECT_FALSE(GraphSerializer(&graph_).Run().has_value());
+}
+
+TEST_F(SerializationTest, CHECKS_ROUND_TRIP) {
+    IrBuilder builder(&graph_);
+    builder.SetBasicBlockScope(builder.CreateBB());
+    auto *a = builder.CreateParameter(0);
+    auto *b = builder.CreateInt64Constant(3);
+    builder.CreateBoundsCheck(a, b);
+    builder.CreateOverflowCheck(OpType::MUL, DataType::I8, a, builder.CreateConstant(uint64_t{50}, DataType::I8));
+    builder.CreateRet(DataType::U64, a);
+
+    auto image = GraphSerializer(&graph_).Run();
+    ASSERT_TRUE(image.has_value());
+    auto view = GraphImageView::Create(image->data(), image->size());
+    ASSERT_TRUE(view.has_value());
+    auto graph = GraphDeserializer(*view).Run();
+    ASSERT_NE(graph, nullptr);
+    EXPECT_EQ(Dump(graph.get()), Dump(&graph_));
+    EXPECT_EQ(GraphHasher(graph.get()).Run(), GraphHasher(&graph_).Run());
+    for(uint64_t n: {0, 2, 3}) {
+        EXPECT_EQ(Interpreter(graph.get()).Run({n}), Interpreter(&graph_).Run({n}));
+    }
+}
+
+TEST_F(SerializationTest, OBJECTS_ROUND_TRIP) {
+    IrBuilder builder(&graph_);
+    builder.SetBasicBlockScope(builder.CreateBB());
+    auto *object = builder.CreateNewObject(3);
+    builder.CreateStoreField(object, 2, builder.CreateParameter(0));
+    builder.CreateRet(DataType::U32, builder.CreateLoadField(DataType::U32, object, 2));
+
+    auto image = GraphSerializer(&graph_).Run();
+    ASSERT_TRUE(image.has_value());
+    auto view = GraphImageView::Create(image->data(), image->size());
+    ASSERT_TRUE(view.has_value());
+    auto graph = GraphDeserializer(*view).Run();
+    ASSERT_NE(graph, nullptr);
+    EXPECT_EQ(Dump(graph.get()), Dump(&graph_));
+    EXPECT_EQ(GraphHasher(graph.get()).Run(), GraphHasher(&graph_).Run());
+    EXPECT_EQ(Interpreter(graph.get()).Run({5}), 5);
+}
+
+TEST_F(SerializationTest, LOADS_AND_STORES_ROUND_TRIP) {
+    IrBuilder builder(&graph_);
+    auto *entry = builder.CreateBB();
+    auto *inside = builder.CreateBB();
+    auto *outside = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    auto *a = builder.CreateParameter(0);
+    auto *object = builder.CreateNewObject(2);
+    builder.CreateStore(object, 9, a);
+    builder.CreateJae(builder.CreateCmp(a, builder.CreateInt32Constant(100)), outside, inside);
+
+    builder.SetBasicBlockScope(inside);
+    builder.CreateRet(DataType::U16, builder.CreateLoad(DataType::U16, object, 8));
+
+    builder.SetBasicBlockScope(outside);
+    builder.CreateRet(DataType::U8, builder.CreateLoad(DataType::U8, object, -1));
+
+    auto image = GraphSerializer(&graph_).Run();
+    ASSERT_TRUE(image.has_value());
+    auto view = GraphImageView::Create(image->data(), image->size());
+    ASSERT_TRUE(view.has_value());
+    auto graph = GraphDeserializer(*view).Run();
+    ASSERT_NE(graph, nullptr);
+    EXPECT_EQ(Dump(graph.get()), Dump(&graph_));
+    EXPECT_EQ(GraphHasher(graph.get()).Run(), GraphHasher(&graph_).Run());
+    EXPECT_EQ(Interpreter(graph.get()).Run({5}), 0x500);
+    EXPECT_EQ(Interpreter(graph.get()).Run({100}), std::nullopt);
+}
+
+TEST_F(SerializationTest, SELECTS_ROUND_TRIP) {
+    IrBuilder builder(&graph_);
+    builder.SetBasicBlockScope(builder.CreateBB());
+    auto *a = builder.CreateParameter(0);
+    auto *ten = builder.CreateInt32Constant(10);
+    auto *cmp = builder.CreateCmp(a, ten);
+    builder.CreateRet(DataType::U32, builder.CreateSelect(DataType::U32, OpType::JA, cmp, a, ten));
+
+    auto image = GraphSerializer(&graph_).Run();
+    ASSERT_TRUE(image.has_value());
+    auto view = GraphImageView::Create(image->data(), image->size());
+    ASSERT_TRUE(view.has_value());
+    auto graph = GraphDeserializer(*view).Run();
+    ASSERT_NE(graph, nullptr);
+    EXPECT_EQ(Dump(graph.get()), Dump(&graph_));
+    EXPECT_EQ(GraphHasher(graph.get()).Run(), GraphHasher(&graph_).Run());
+    EXPECT_EQ(Interpreter(graph.get()).Run({25}), 25);
+    EXPECT_EQ(Interpreter(graph.get()).Run({3}), 10);
+}
+
+TEST_F(SerializationTest, DIVISION_HELPERS_ROUND_TRIP) {
+    IrBuilder builder(&graph_);
+    builder.SetBasicBlockScope(builder.CreateBB());
+    auto *a = builder.CreateParameter(0);
+    auto *remainder = builder.CreateMod(DataType::U32, a, builder.CreateInt32Constant(10));
+    auto *high = builder.CreateMulHigh(DataType::U32, a, builder.CreateInt32Constant(0xcccccccd));
+    auto *quotient = builder.CreateShr(DataType::U32, high, builder.CreateInt32Constant(3));
+    builder.CreateRet(DataType::U32, builder.CreateAdd(DataType::U32, remainder, quotient));
+
+    auto image = GraphSerializer(&graph_).Run();
+    ASSERT_TRUE(image.has_value());
+    auto view = GraphImageView::Create(image->data(), image->size());
+    ASSERT_TRUE(view.has_value());
+    auto graph = GraphDeserializer(*view).Run();
+    ASSERT_NE(graph, nullptr);
+    EXPECT_EQ(Dump(graph.get()), Dump(&graph_));
+    EXPECT_EQ(GraphHasher(graph.get()).Run(), GraphHasher(&graph_).Run());
+    EXPECT_EQ(Interpreter(graph.get()).Run({1234}), 4 + 123);
+}
@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+
+#include "Interpreter/interpreter.hpp"
+#include "Liveness/liveness.hpp"
+#include "Speculation/branchspeculation.hpp"
+#include "irbuilder.hpp"
+
+class SpeculationTest: public ::testing::Test {
+protected:
+    /*
+        BB_0: a = param 0, k = mul a, 7, cmp a, 0; je BB_2, BB_1
+        BB_1: h = add a, 7; jmp BB_2
+        BB_2: r = phi(k, h); ret r
+    */
+    void BuildMerge() {
+        IrBuilder builder(&graph_);
+
+        auto *bb0 = builder.CreateBB();
+        auto *bb1 = builder.CreateBB();
+        auto *bb2 = builder.CreateBB();
+
+        builder.SetBasicBlockScope(bb0);
+        auto *a = builder.CreateParameter(0);
+        auto *zero = builder.CreateInt64Constant(0);
+        auto *seven = builder.CreateInt64Constant(7);
+        auto *k = builder.CreateMul(DataType::U64, a, seven);
+        auto *cmp = builder.CreateCmp(a, zero);
+        builder.CreateJe(cmp, bb2, bb1);
+
+        builder.SetBasicBlockScope(bb1);
+        auto *h = builder.CreateAdd(DataType::U64, a, seven);
+        builder.CreateJmp(bb2);
+
+        builder.SetBasicBlockScope(bb2);
+        auto *r = builder.CreatePhi(DataType::U64);
+        builder.CreateRet(DataType::U64, r);
+
+        r->AddInput(k);
+        r->AddInput(h);
+
+        mulValue_ = k;
+    }
+
+    /*
+        BB_0: a = param 0, cmp a, 100; ja BB_2, BB_1
+        BB_1: ret a * 2
+        BB_2: ret a - 100
+    */
+    void BuildColdExit() {
+        IrBuilder builder(&graph_);
+
+        auto *bb0 = builder.CreateBB();
+        auto *bb1 = builder.CreateBB();
+        auto *bb2 = builder.CreateBB();
+
+        builder.SetBasicBlockScope(bb0);
+        auto *a = builder.CreateParameter(0);
+        auto *two = builder.CreateInt64Constant(2);
+        auto *hundred = builder.CreateInt64Constant(100);
+        auto *cmp = builder.CreateCmp(a, hundred);
+        builder.CreateJa(cmp, bb2, bb1);
+
+        builder.SetBasicBlockScope(bb1);
+        builder.CreateRet(DataType::U64, builder.CreateMul(DataType::U64, a, two));
+
+        builder.SetBasicBlockScope(bb2);
+        builder.CreateRet(DataType::U64, builder.CreateSub(DataType::U64, a, hundred));
+    }
+
+    void Profile(const std::vector<uint64_t> &inputs) {
+        Interpreter interpreter(&graph_);
+        interpreter.SetBranchProfile(&profile_);
+        for(auto input: inputs) {
+            ASSERT_TRUE(interpreter.Run({input}).has_value());
+        }
+    }
+
+    size_t CountGuards(Graph* graph) {
+        size_t count = 0;
+        for(auto &block: graph->GetBlocks()) {
+            for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+                count += instr->GetOpType() == OpType::DEOPT;
+            }
+        }
+        return count;
+    }
+
+    Graph graph_;
+    BranchProfile profile_;
+    Instruction* mulValue_ = nullptr;
+};
+
+TEST_F(SpeculationTest, LIVE_ON_EDGE) {
+    BuildMerge();
+
+    LivenessAnalyzer liveness(&graph_);
+    liveness.Analyze();
+
+    auto &blocks = graph_.GetBlocks();
+    auto live = liveness.GetLiveOnEdge(blocks[0].get(), blocks[2].get());
+    ASSERT_EQ(live.size(), 1);
+    EXPECT_EQ(live[0], mulValue_);
+
+    EXPECT_TRUE(liveness.GetLiveIn(blocks[2].get()).count(blocks[2]->GetFirstInstr()));
+    EXPECT_EQ(liveness.GetLiveOut(blocks[1].get()).size(), 1);
+}
+
+TEST_F(SpeculationTest, GUARD_DEOPTS_INTO_MERGE_PHI) {
+    BuildMerge();
+    Profile({3, 5, 8});
+
+    BranchSpeculation speculation(&graph_, &profile_, 3);
+    auto optimized = speculation.Run();
+    ASSERT_NE(optimized, nullptr);
+    EXPECT_EQ(speculation.GetGuardsCount(), 1);
+    EXPECT_EQ(CountGuards(optimized.get()), 1);
+
+    auto *merge = optimized->GetBlocks()[2].get();
+    EXPECT_EQ(merge->GetPredecessors().size(), 1);
+    EXPECT_EQ(merge->GetFirstInstr()->GetInputs().size(), 1);
+
+    Interpreter interpreter(optimized.get());
+    EXPECT_EQ(interpreter.Run({9}), 16);
+    EXPECT_EQ(interpreter.GetDeoptsCount(), 0);
+
+    EXPECT_EQ(interpreter.Run({0}), 0);
+    EXPECT_EQ(interpreter.GetDeoptsCount(), 1);
+}
+
+TEST_F(SpeculationTest, COLD_BLOCK_IS_REMOVED) {
+    BuildColdExit();
+    Profile({1, 2, 3, 50});
+
+    BranchSpeculation speculation(&graph_, &profile_);
+    auto optimized = speculation.Run();
+    ASSERT_NE(optimized, nullptr);
+    EXPECT_EQ(optimized->GetBlocks().size(), 2);
+
+    Interpreter interpreter(optimized.get());
+    EXPECT_EQ(interpreter.Run({21}), 42);
+    EXPECT_EQ(interpreter.Run({150}), 50);
+    EXPECT_EQ(interpreter.GetDeoptsCount(), 1);
+}
+
+TEST_F(SpeculationTest, MIXED_BRANCH_IS_KEPT) {
+    BuildColdExit();
+    Profile({1, 200});
+
+    BranchSpeculation speculation(&graph_, &profile_);
+    auto optimized = speculation.Run();
+    ASSERT_NE(optimized, nullptr);
+    EXPECT_EQ(speculation.GetGuardsCount(), 0);
+    EXPECT_EQ(optimized->GetBlocks().size(), 3);
+}
+
+TEST_F(SpeculationTest, TOO_FEW_SAMPLES) {
+    BuildColdExit();
+    Profile({1});
+
+    BranchSpeculation speculation(&graph_, &profile_, 10);
+    auto optimized = speculation.Run();
+    EXPECT_EQ(speculation.GetGuardsCount(), 0);
+}
@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+
+#include "irbuilder.hpp"
+#include "Interpreter/interpreter.hpp"
+
+class SsaConstructionTest: public ::testing::Test {
+protected:
+    static size_t CountPhis(BasicBlock* block) {
+        size_t count = 0;
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            count += instr->IsPhi() ? 1 : 0;
+        }
+        return count;
+    }
+
+    static constexpr uint32_t X = 0;
+    static constexpr uint32_t Y = 1;
+
+    Graph graph_;
+};
+
+// res = 1; i = 2; while(i <= n) { res *= i; ++i; } return res;
+TEST_F(SsaConstructionTest, LOOP_GETS_PHIS_IN_HEADER) {
+    IrBuilder builder(&graph_);
+    auto *entry = builder.CreateBB();
+    auto *header = builder.CreateBB();
+    auto *body = builder.CreateBB();
+    auto *exit = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    builder.SealBlock(entry);
+    auto *n = builder.CreateParameter(0);
+    auto *one = builder.CreateInt64Constant(1);
+    builder.WriteVariable(X, one);
+    builder.WriteVariable(Y, builder.CreateInt64Constant(2));
+    builder.CreateJmp(header);
+
+    builder.SetBasicBlockScope(header);
+    builder.CreateJa(builder.CreateCmp(builder.ReadVariable(Y), n), exit, body);
+
+    builder.SetBasicBlockScope(body);
+    builder.SealBlock(body);
+    auto *i = builder.ReadVariable(Y);
+    builder.WriteVariable(X, builder.CreateMul(DataType::U64, builder.ReadVariable(X), i));
+    builder.WriteVariable(Y, builder.CreateAdd(DataType::U64, i, one));
+    builder.CreateJmp(header);
+    builder.SealBlock(header);
+
+    builder.SetBasicBlockScope(exit);
+    builder.SealBlock(exit);
+    builder.CreateRet(DataType::U64, builder.ReadVariable(X));
+
+    EXPECT_EQ(CountPhis(header), 2);
+    EXPECT_EQ(CountPhis(body), 0);
+    EXPECT_EQ(CountPhis(exit), 0);
+    for(auto *instr = header->GetFirstInstr(); instr->IsPhi(); instr = instr->GetNext()) {
+        EXPECT_EQ(instr->GetInputs().size(), 2);
+    }
+
+    Interpreter interpreter(&graph_);
+    EXPECT_EQ(interpreter.Run({5}), 120u);
+    EXPECT_EQ(interpreter.Run({1}), 1u);
+}
+
+// A diamond that writes the variable on one side only needs a phi; a variable
+// untouched by both sides does not.
+TEST_F(SsaConstructionTest, DIAMOND_MERGES_ONLY_CHANGED_VARIABLES) {
+    IrBuilder builder(&graph_);
+    auto *entry = builder.CreateBB();
+    auto *left = builder.CreateBB();
+    auto *right = builder.CreateBB();
+    auto *join = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    builder.SealBlock(entry);
+    auto *a = builder.CreateParameter(0);
+    auto *ten = builder.CreateInt64Constant(10);
+    builder.WriteVariable(X, a);
+    builder.WriteVariable(Y, ten);
+    builder.CreateJa(builder.CreateCmp(a, ten), left, right);
+
+    builder.SetBasicBlockScope(left);
+    builder.SealBlock(left);
+    builder.WriteVariable(X, builder.CreateAdd(DataType::U64, builder.ReadVariable(X), builder.ReadVariable(Y)));
+    builder.CreateJmp(join);
+
+    builder.SetBasicBlockScope(right);
+    builder.SealBlock(right);
+    builder.CreateJmp(join);
+
+    builder.SetBasicBlockScope(join);
+    builder.SealBlock(join);
+    auto *x = builder.ReadVariable(X);
+    auto *y = builder.ReadVariable(Y);
+    builder.CreateRet(DataType::U64, builder.CreateAdd(DataType::U64, x, y));
+
+    EXPECT_TRUE(x->IsPhi());
+    EXPECT_EQ(y, ten);
+    EXPECT_EQ(CountPhis(join), 1);
+
+    Interpreter interpreter(&graph_);
+    EXPECT_EQ(interpreter.Run({11}), 31u);
+    EXPECT_EQ(interpreter.Run({3}), 13u);
+}
+
+// The header is read before the back edge exists, so a phi is placed there;
+// once sealed it turns out trivial and its uses are rewired.
+TEST_F(SsaConstructionTest, LOOP_INVARIANT_PHI_IS_REMOVED) {
+    IrBuilder builder(&graph_);
+    auto *entry = builder.CreateBB();
+    auto *header = builder.CreateBB();
+    auto *exit = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    builder.SealBlock(entry);
+    auto *a = builder.CreateParameter(0);
+    builder.WriteVariable(X, a);
+    builder.WriteVariable(Y, builder.CreateInt64Constant(0));
+    builder.CreateJmp(header);
+
+    builder.SetBasicBlockScope(header);
+    auto *sum = builder.CreateAdd(DataType::U64, builder.ReadVariable(Y), builder.ReadVariable(X));
+    builder.WriteVariable(Y, sum);
+    auto *cmp = builder.CreateCmp(sum, builder.ReadVariable(X));
+    builder.CreateJa(cmp, exit, header);
+    EXPECT_EQ(CountPhis(header), 2);
+    builder.SealBlock(header);
+
+    builder.SetBasicBlockScope(exit);
+    builder.SealBlock(exit);
+    builder.CreateRet(DataType::U64, builder.ReadVariable(Y));
+
+    EXPECT_EQ(CountPhis(header), 1);
+    EXPECT_EQ(sum->GetInputs()[1].GetValue(), a);
+    EXPECT_EQ(cmp->GetInputs()[1].GetValue(), a);
+    EXPECT_EQ(builder.ReadVariable(X), a);
+}
+
+TEST_F(SsaConstructionTest, UNDEFINED_VARIABLE_READS_ZERO) {
+    IrBuilder builder(&graph_);
+    auto *entry = builder.CreateBB();
+    auto *next = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    builder.SealBlock(entry);
+    builder.CreateJmp(next);
+
+    builder.SetBasicBlockScope(next);
+    builder.SealBlock(next);
+    auto *value = builder.ReadVariable(X);
+    builder.CreateRet(DataType::U64, value);
+
+    EXPECT_EQ(value->GetOpType(), OpType::CONST);
+    EXPECT_EQ(value->GetParentBB(), entry);
+    EXPECT_EQ(builder.ReadVariable(X), value);
+
+    Interpreter interpreter(&graph_);
+    EXPECT_EQ(interpreter.Run({}), 0u);
+}
@@ -0,0 +1,54 @@
+#ifndef IR_TESTS_TEST_UTILS_HPP
+#define IR_TESTS_TEST_UTILS_HPP
+
+#include <gtest/gtest.h>
+
+#include "Interpreter/interpreter.hpp"
+#include "irbuilder.hpp"
+
+#include <functional>
+#include <sstream>
+#include <vector>
+
+// Number of instructions with the given opcode that are still in a block.
+inline size_t CountOpcode(Graph* graph, OpType op) {
+    size_t count = 0;
+    for(auto &block: graph->GetBlocks()) {
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            count += instr->GetOpType() == op;
+        }
+    }
+    return count;
+}
+
+// Builds a fresh copy of the graph and expects it and the optimized graph to
+// return the same on every combination of argument values, one list per
+// parameter.
+inline void ExpectSameResults(const std::function<void(Graph*)> &build, Graph* optimized,
+                              const std::vector<std::vector<uint64_t>> &argValues = {{0, 3, 10, 25}, {0, 1, 7}}) {
+    Graph original;
+    build(&original);
+    Interpreter originalInterpreter(&original);
+    Interpreter interpreter(optimized);
+
+    std::vector<size_t> positions(argValues.size(), 0);
+    std::vector<uint64_t> args(argValues.size());
+    for(;;) {
+        std::stringstream names;
+        for(size_t idx = 0; idx < argValues.size(); ++idx) {
+            args[idx] = argValues[idx][positions[idx]];
+            names << (idx == 0 ? "args = " : ", ") << args[idx];
+        }
+        EXPECT_EQ(interpreter.Run(args), originalInterpreter.Run(args)) << names.str();
+
+        size_t idx = argValues.size();
+        while(idx > 0 && ++positions[idx - 1] == argValues[idx - 1].size()) {
+            positions[--idx] = 0;
+        }
+        if(idx == 0) {
+            return;
+        }
+    }
+}
+
+#endif  // IR_TESTS_TEST_UTILS_HPP
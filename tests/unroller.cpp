@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+
+#include "Unroller/loopunroller.hpp"
+#include "Interpreter/interpreter.hpp"
+#include "irbuilder.hpp"
+
+#include <optional>
+
+namespace {
+
+constexpr uint32_t ACC = 0;
+constexpr uint32_t IV = 1;
+
+// acc = 1; for(i = init; !(i exitCondition bound); i += step) acc = acc * 3 + i; return acc
+// where init and bound default to parameters 1 and 0. A branchy body adds i * i
+// on odd iterations and subtracts parameter 1 on even ones instead.
+struct LoopShape {
+    DataType ivType = DataType::U32;
+    OpType exitCondition = OpType::JA;
+    uint64_t step = 1;
+    std::optional<uint64_t> ivInit;
+    std::optional<uint64_t> bound;
+    bool branchyBody = false;
+};
+
+void BuildLoop(Graph* graph, const LoopShape &shape) {
+    IrBuilder builder(graph);
+    auto *entry = builder.CreateBB();
+    auto *header = builder.CreateBB();
+    auto *body = builder.CreateBB();
+    auto *odd = shape.branchyBody ? builder.CreateBB() : nullptr;
+    auto *even = shape.branchyBody ? builder.CreateBB() : nullptr;
+    auto *latch = shape.branchyBody ? builder.CreateBB() : body;
+    auto *exit = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    builder.SealBlock(entry);
+    auto *n = builder.CreateParameter(0);
+    auto *k = builder.CreateParameter(1);
+    builder.WriteVariable(ACC, builder.CreateConstant(uint64_t{1}, DataType::U64));
+    builder.WriteVariable(IV, shape.ivInit ? builder.CreateConstant(*shape.ivInit, shape.ivType) : k);
+    auto *bound = shape.bound ? builder.CreateConstant(*shape.bound, DataType::U32) : n;
+    builder.CreateJmp(header);
+
+    builder.SetBasicBlockScope(header);
+    auto *cmp = builder.CreateCmp(builder.ReadVariable(IV), bound);
+    if(shape.exitCondition == OpType::JA) {
+        builder.CreateJa(cmp, exit, body);
+    } else {
+        builder.CreateJae(cmp, exit, body);
+    }
+
+    builder.SetBasicBlockScope(body);
+    builder.SealBlock(body);
+    auto *iv = builder.ReadVariable(IV);
+    auto *three = builder.CreateConstant(uint64_t{3}, DataType::U64);
+    auto *acc = builder.CreateAdd(DataType::U64, builder.CreateMul(DataType::U64, builder.ReadVariable(ACC), three), iv);
+    builder.WriteVariable(ACC, acc);
+    if(shape.branchyBody) {
+        auto *one = builder.CreateConstant(uint64_t{1}, shape.ivType);
+        builder.CreateJe(builder.CreateCmp(builder.CreateAnd(shape.ivType, iv, one), one), odd, even);
+
+        builder.SetBasicBlockScope(odd);
+        builder.SealBlock(odd);
+        builder.WriteVariable(ACC, builder.CreateAdd(DataType::U64, acc, builder.CreateMul(DataType::U64, iv, iv)));
+        builder.CreateJmp(latch);
+
+        builder.SetBasicBlockScope(even);
+        builder.SealBlock(even);
+        builder.WriteVariable(ACC, builder.CreateSub(DataType::U64, acc, k));
+        builder.CreateJmp(latch);
+
+        builder.SetBasicBlockScope(latch);
+        builder.SealBlock(latch);
+    }
+    auto *step = builder.CreateConstant(shape.step, shape.ivType);
+    builder.WriteVariable(IV, builder.CreateAdd(shape.ivType, builder.ReadVariable(IV), step));
+    builder.CreateJmp(header);
+    builder.SealBlock(header);
+
+    builder.SetBasicBlockScope(exit);
+    builder.SealBlock(exit);
+    builder.CreateRet(DataType::U64, builder.ReadVariable(ACC));
+}
+
+size_t CountLoops(Graph* graph) {
+    LoopAnalyzer analyzer(graph);
+    analyzer.Analyze();
+    return analyzer.GetLoops().size();
+}
+
+}  // namespace
+
+class UnrollerTest: public ::testing::Test {
+protected:
+    // Unrolls a copy of the loop and checks it against the original.
+    void ExpectSameResults(const LoopShape &shape,
+                           std::vector<uint64_t> bounds = {0, 1, 2, 3, 4, 5, 7, 8, 9, 31},
+                           std::vector<uint64_t> params = {0, 1, 2, 3}) {
+        Graph original;
+        BuildLoop(&original, shape);
+        unrolled_ = std::make_unique<Graph>();
+        BuildLoop(unrolled_.get(), shape);
+        LoopUnroller unroller(unrolled_.get(), factor_, maxFullUnrollTrips_, maxUnrolledInstrs_);
+        unrolledCount_ = unroller.Run();
+        fullyUnrolledCount_ = unroller.GetFullyUnrolledCount();
+
+        Interpreter originalInterpreter(&original);
+        Interpreter unrolledInterpreter(unrolled_.get());
+        for(auto n: bounds) {
+            for(auto k: params) {
+                auto expected = originalInterpreter.Run({n, k});
+                ASSERT_TRUE(expected.has_value());
+                EXPECT_EQ(unrolledInterpreter.Run({n, k}), expected) << "n = " << n << ", k = " << k;
+            }
+        }
+    }
+
+    size_t factor_ = 4;
+    size_t maxFullUnrollTrips_ = 8;
+    size_t maxUnrolledInstrs_ = 256;
+
+    std::unique_ptr<Graph> unrolled_;
+    size_t unrolledCount_ = 0;
+    size_t fullyUnrolledCount_ = 0;
+};
+
+TEST_F(UnrollerTest, RUNTIME_TRIP_COUNT_KEEPS_REMAINDER_LOOP) {
+    LoopShape shape;
+    ExpectSameResults(shape);
+    EXPECT_EQ(unrolledCount_, 1);
+    EXPECT_EQ(fullyUnrolledCount_, 0);
+    EXPECT_EQ(CountLoops(unrolled_.get()), 2);
+}
+
+TEST_F(UnrollerTest, BRANCHY_BODY) {
+    LoopShape shape;
+    shape.branchyBody = true;
+    shape.exitCondition = OpType::JAE;
+    factor_ = 3;
+    ExpectSameResults(shape);
+    EXPECT_EQ(unrolledCount_, 1);
+    EXPECT_EQ(CountLoops(unrolled_.get()), 2);
+}
+
+TEST_F(UnrollerTest, WRAPPING_IV_RUNS_REMAINDER) {
+    LoopShape shape;
+    shape.ivType = DataType::U8;
+    shape.step = 3;
+    ExpectSameResults(shape, {200, 251, 252, 253}, {0, 1, 2, 250});
+    EXPECT_EQ(unrolledCount_, 1);
+}
+
+TEST_F(UnrollerTest, CONSTANT_TRIP_COUNT_UNROLLS_FULLY) {
+    LoopShape shape;
+    shape.ivInit = 2;
+    shape.bound = 6;
+    shape.branchyBody = true;
+    ExpectSameResults(shape, {0});
+    EXPECT_EQ(unrolledCount_, 1);
+    EXPECT_EQ(fullyUnrolledCount_, 1);
+    EXPECT_EQ(CountLoops(unrolled_.get()), 0);
+}
+
+TEST_F(UnrollerTest, ZERO_TRIP_COUNT_UNROLLS_FULLY) {
+    LoopShape shape;
+    shape.ivInit = 10;
+    shape.bound = 5;
+    ExpectSameResults(shape, {0});
+    EXPECT_EQ(fullyUnrolledCount_, 1);
+    EXPECT_EQ(CountLoops(unrolled_.get()), 0);
+    EXPECT_EQ(unrolled_->GetBlocks().size(), 3);
+}
+
+TEST_F(UnrollerTest, LONG_CONSTANT_TRIP_COUNT_KEEPS_REMAINDER_LOOP) {
+    LoopShape shape;
+    shape.ivInit = 0;
+    shape.bound = 1001;
+    shape.step = 2;
+    shape.exitCondition = OpType::JAE;
+    ExpectSameResults(shape, {0});
+    EXPECT_EQ(unrolledCount_, 1);
+    EXPECT_EQ(fullyUnrolledCount_, 0);
+}
+
+TEST_F(UnrollerTest, LARGE_LOOP_IS_KEPT) {
+    LoopShape shape;
+    shape.branchyBody = true;
+    maxUnrolledInstrs_ = 16;
+    ExpectSameResults(shape);
+    EXPECT_EQ(unrolledCount_, 0);
+    EXPECT_EQ(CountLoops(unrolled_.get()), 1);
+}
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include "irbuilder.hpp"
+
+#include <algorithm>
+
+class UseListTest: public ::testing::Test {
+protected:
+    static std::vector<Instruction*> GetUsers(Instruction* value) {
+        std::vector<Instruction*> users;
+        for(auto &use: value->GetUses()) {
+            EXPECT_EQ(use.GetValue(), value);
+            EXPECT_EQ(&use.GetUser()->GetInputs()[use.GetIndex()], &use);
+            users.push_back(use.GetUser());
+        }
+        return users;
+    }
+
+    static size_t CountUser(Instruction* value, Instruction* user) {
+        auto users = GetUsers(value);
+        return std::count(users.begin(), users.end(), user);
+    }
+
+    Graph graph_;
+};
+
+TEST_F(UseListTest, PHI_INPUTS_ARE_USES) {
+    IrBuilder builder(&graph_);
+    builder.SetBasicBlockScope(builder.CreateBB());
+    auto *a = builder.CreateParameter(0);
+    auto *b = builder.CreateParameter(1);
+    auto *phi = builder.CreatePhi(DataType::U64);
+
+    // Enough inputs to reallocate the operand vector several times.
+    for(size_t idx = 0; idx < 33; ++idx) {
+        phi->AddInput(idx % 2 == 0 ? a : b);
+    }
+    EXPECT_EQ(CountUser(a, phi), 17);
+    EXPECT_EQ(CountUser(b, phi), 16);
+
+    phi->RemoveInput(0);
+    phi->RemoveInput(5);
+    EXPECT_EQ(a->GetUsesCount() + b->GetUsesCount(), 31);
+    GetUsers(a);
+    GetUsers(b);
+}
+
+TEST_F(UseListTest, SET_INPUT_AND_RAUW) {
+    IrBuilder builder(&graph_);
+    builder.SetBasicBlockScope(builder.CreateBB());
+    auto *a = builder.CreateParameter(0);
+    auto *b = builder.CreateParameter(1);
+    auto *sum = builder.CreateAdd(DataType::U64, a, a);
+    auto *mul = builder.CreateMul(DataType::U64, sum, a);
+    auto *ret = builder.CreateRet(DataType::U64, mul);
+
+    EXPECT_EQ(a->GetUsesCount(), 3);
+    sum->SetInput(1, b);
+    EXPECT_EQ(a->GetUsesCount(), 2);
+    EXPECT_EQ(CountUser(b, sum), 1);
+
+    a->ReplaceAllUsesWith(b);
+    EXPECT_FALSE(a->HasUses());
+    EXPECT_EQ(b->GetUsesCount(), 3);
+    EXPECT_EQ(sum->GetInputs()[0].GetValue(), b);
+    EXPECT_EQ(mul->GetInputs()[1].GetValue(), b);
+
+    mul->ReplaceAllUsesWith(sum);
+    EXPECT_EQ(ret->GetInputs()[0].GetValue(), sum);
+    EXPECT_EQ(CountUser(sum, ret), 1);
+    EXPECT_EQ(CountUser(sum, mul), 1);
+}
+
+TEST_F(UseListTest, REMOVE_INSTRUCTION) {
+    IrBuilder builder(&graph_);
+    auto *block = builder.CreateBB();
+    builder.SetBasicBlockScope(block);
+    auto *a = builder.CreateParameter(0);
+    auto *dead = builder.CreateAdd(DataType::U64, a, a);
+    auto *sum = builder.CreateAdd(DataType::U64, a, a);
+    builder.CreateRet(DataType::U64, sum);
+
+    EXPECT_FALSE(graph_.RemoveInstruction(sum));
+    EXPECT_TRUE(graph_.RemoveInstruction(dead));
+    EXPECT_EQ(dead->GetParentBB(), nullptr);
+    EXPECT_TRUE(dead->GetInputs().empty());
+    EXPECT_EQ(a->GetUsesCount(), 2);
+    EXPECT_EQ(a->GetNext(), sum);
+    EXPECT_EQ(graph_.GetInstructions().size(), 4);
+}
@@ -0,0 +1,219 @@
+#include <gtest/gtest.h>
+
+#include "Vectorizer/loopvectorizer.hpp"
+#include "Codegen/instrselector.hpp"
+#include "Codegen/naivelowering.hpp"
+#include "Interpreter/interpreter.hpp"
+#include "irbuilder.hpp"
+
+#include <functional>
+
+namespace {
+
+constexpr uint32_t ACC = 0;
+constexpr uint32_t IV = 1;
+
+// acc = accInit; for(i = ivInit; !(i exitCondition n); ++i) acc = acc accOp body(i, k); return acc
+// with n and k being parameters 0 and 1.
+struct LoopShape {
+    DataType type = DataType::I32;
+    DataType ivType = DataType::U32;
+    OpType accOp = OpType::ADD;
+    OpType exitCondition = OpType::JAE;
+    uint64_t accInit = 5;
+    Instruction* ivInit = nullptr;
+    std::function<Instruction*(IrBuilder&, Instruction* iv, Instruction* k)> body;
+};
+
+void BuildLoop(Graph* graph, const LoopShape &shape, uint64_t ivInit = 0) {
+    IrBuilder builder(graph);
+    auto *entry = builder.CreateBB();
+    auto *header = builder.CreateBB();
+    auto *body = builder.CreateBB();
+    auto *exit = builder.CreateBB();
+
+    builder.SetBasicBlockScope(entry);
+    builder.SealBlock(entry);
+    auto *n = builder.CreateParameter(0);
+    auto *k = builder.CreateParameter(1);
+    builder.WriteVariable(ACC, builder.CreateConstant(shape.accInit, shape.type));
+    builder.WriteVariable(IV, builder.CreateConstant(ivInit, shape.ivType));
+    builder.CreateJmp(header);
+
+    builder.SetBasicBlockScope(header);
+    auto *cmp = builder.CreateCmp(builder.ReadVariable(IV), n);
+    if(shape.exitCondition == OpType::JA) {
+        builder.CreateJa(cmp, exit, body);
+    } else {
+        builder.CreateJae(cmp, exit, body);
+    }
+
+    builder.SetBasicBlockScope(body);
+    builder.SealBlock(body);
+    auto *iv = builder.ReadVariable(IV);
+    auto *value = shape.body(builder, iv, k);
+    auto *acc = builder.ReadVariable(ACC);
+    switch(shape.accOp) {
+        case OpType::MUL:
+            builder.WriteVariable(ACC, builder.CreateMul(shape.type, acc, value));
+            break;
+        case OpType::AND:
+            builder.WriteVariable(ACC, builder.CreateAnd(shape.type, acc, value));
+            break;
+        default:
+            builder.WriteVariable(ACC, builder.CreateAdd(shape.type, acc, value));
+            break;
+    }
+    builder.WriteVariable(IV, builder.CreateAdd(shape.ivType, iv, builder.CreateConstant(uint64_t{1}, shape.ivType)));
+    builder.CreateJmp(header);
+    builder.SealBlock(header);
+
+    builder.SetBasicBlockScope(exit);
+    builder.SealBlock(exit);
+    builder.CreateRet(shape.type, builder.ReadVariable(ACC));
+}
+
+size_t CountVectorInstrs(Graph* graph) {
+    size_t count = 0;
+    for(auto &block: graph->GetBlocks()) {
+        for(auto *instr = block->GetFirstInstr(); instr != nullptr; instr = instr->GetNext()) {
+            count += IsVectorType(instr->GetResultType()) ? 1 : 0;
+        }
+    }
+    return count;
+}
+
+}  // namespace
+
+static_assert(GetVectorType(DataType::U32, 4) == DataType::V4I32);
+static_assert(GetVectorType(DataType::I16, 16) == DataType::V16I16);
+static_assert(GetVectorType(DataType::I8, 16) == DataType::UNDEFINED);
+static_assert(GetElementType(DataType::V2I64) == DataType::I64 && GetLanesCount(DataType::V8I32) == 8);
+static_assert(!IsVectorType(DataType::U64) && IsVectorType(DataType::V8I16));
+
+class VectorizerTest: public ::testing::Test {
+protected:
+    // Vectorizes a copy of the loop and checks it against the original.
+    void ExpectSameResults(const LoopShape &shape, VectorIsa isa, size_t expectedLoops, uint64_t ivInit = 0,
+                           std::vector<uint64_t> bounds = {0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 100}) {
+        Graph scalar;
+        Graph vectorized;
+        BuildLoop(&scalar, shape, ivInit);
+        BuildLoop(&vectorized, shape, ivInit);
+
+        ASSERT_EQ(LoopVectorizer(&vectorized, isa).Run(), expectedLoops);
+        EXPECT_EQ(CountVectorInstrs(&vectorized) != 0, expectedLoops != 0);
+
+        Interpreter scalarInterpreter(&scalar);
+        Interpreter vectorInterpreter(&vectorized);
+        for(auto n: bounds) {
+            for(uint64_t k: {0ULL, 3ULL, 0xffffULL}) {
+                auto expected = scalarInterpreter.Run({n, k});
+                ASSERT_TRUE(expected.has_value());
+                EXPECT_EQ(vectorInterpreter.Run({n, k}), expected) << "n = " << n << ", k = " << k;
+            }
+        }
+    }
+};
+
+TEST_F(VectorizerTest, SUM_OF_EXPRESSION_SSE2) {
+    LoopShape shape;
+    shape.body = [](IrBuilder &builder, Instruction* iv, Instruction* k) {
+        auto *sum = builder.CreateAdd(DataType::I32, iv, k);
+        return builder.CreateSub(DataType::I32, sum, builder.CreateConstant(uint64_t{3}, DataType::I32));
+    };
+    ExpectSameResults(shape, VectorIsa::SSE2, 1);
+}
+
+TEST_F(VectorizerTest, SUM_OF_SQUARES_NEEDS_AVX2) {
+    LoopShape shape;
+    shape.exitCondition = OpType::JA;
+    shape.body = [](IrBuilder &builder, Instruction* iv, Instruction*) {
+        return builder.CreateMul(DataType::I32, iv, iv);
+    };
+    ExpectSameResults(shape, VectorIsa::SSE2, 0);
+    ExpectSameResults(shape, VectorIsa::AVX2, 1);
+}
+
+TEST_F(VectorizerTest, PRODUCT_OF_I16_LANES) {
+    LoopShape shape;
+    shape.type = DataType::I16;
+    shape.ivType = DataType::U16;
+    shape.accOp = OpType::MUL;
+    shape.accInit = 1;
+    shape.body = [](IrBuilder &builder, Instruction* iv, Instruction* k) {
+        auto *masked = builder.CreateAnd(DataType::I16, iv, builder.CreateConstant(uint64_t{7}, DataType::I16));
+        return builder.CreateAdd(DataType::I16, masked, k);
+    };
+    ExpectSameResults(shape, VectorIsa::SSE2, 1);
+    ExpectSameResults(shape, VectorIsa::AVX2, 1);
+}
+
+TEST_F(VectorizerTest, AND_OF_I64_LANES) {
+    LoopShape shape;
+    shape.type = DataType::U64;
+    shape.ivType = DataType::U64;
+    shape.accOp = OpType::AND;
+    shape.accInit = ~0ULL;
+    shape.body = [](IrBuilder &builder, Instruction* iv, Instruction* k) {
+        return builder.CreateSub(DataType::U64, k, iv);
+    };
+    ExpectSameResults(shape, VectorIsa::SSE2, 1);
+}
+
+// The last lane of a vector iteration would wrap past the bound; such
+// iterations are left to the scalar epilogue.
+TEST_F(VectorizerTest, WRAPPING_LANES_RUN_SCALAR) {
+    LoopShape shape;
+    shape.body = [](IrBuilder &builder, Instruction* iv, Instruction* k) {
+        return builder.CreateAdd(DataType::I32, iv, k);
+    };
+    ExpectSameResults(shape, VectorIsa::SSE2, 1, 0xfffffff0ULL, {0xfffffff2ULL, 0xfffffffeULL, 0xffffffffULL});
+}
+
+TEST_F(VectorizerTest, DIVISION_IS_NOT_VECTORIZED) {
+    LoopShape shape;
+    shape.body = [](IrBuilder &builder, Instruction* iv, Instruction*) {
+        return builder.CreateDiv(DataType::I32, iv, builder.CreateConstant(uint64_t{3}, DataType::I32));
+    };
+    ExpectSameResults(shape, VectorIsa::AVX2, 0);
+}
+
+// acc feeds the body value as well as its own update, so iterations depend
+// on each other.
+TEST_F(VectorizerTest, LOOP_CARRIED_DEPENDENCE_IS_NOT_VECTORIZED) {
+    LoopShape shape;
+    shape.body = [](IrBuilder &builder, Instruction* iv, Instruction*) {
+        return builder.CreateAdd(DataType::I32, iv, builder.ReadVariable(ACC));
+    };
+    ExpectSameResults(shape, VectorIsa::SSE2, 0);
+}
+
+TEST_F(VectorizerTest, LOWERING_PICKS_ISA_BY_VECTOR_WIDTH) {
+    LoopShape shape;
+    shape.body = [](IrBuilder &builder, Instruction* iv, Instruction* k) {
+        return builder.CreateAdd(DataType::I32, iv, k);
+    };
+
+    Graph sse;
+    BuildLoop(&sse, shape);
+    ASSERT_EQ(LoopVectorizer(&sse, VectorIsa::SSE2).Run(), 1);
+    auto selected = InstructionSelector(&sse).Run();
+    EXPECT_GE(selected.CountOpcode(MOpcode::PADDD), 2);
+    EXPECT_EQ(selected.CountOpcode(MOpcode::VPADDD), 0);
+    EXPECT_EQ(selected.CountOpcode(MOpcode::PSRLDQ), 2);
+    EXPECT_EQ(NaiveLowering(&sse).Run().CountOpcode(MOpcode::PADDD), selected.CountOpcode(MOpcode::PADDD));
+
+    Graph avx;
+    shape.body = [](IrBuilder &builder, Instruction* iv, Instruction*) {
+        return builder.CreateMul(DataType::I32, iv, iv);
+    };
+    BuildLoop(&avx, shape);
+    ASSERT_EQ(LoopVectorizer(&avx, VectorIsa::AVX2).Run(), 1);
+    selected = InstructionSelector(&avx).Run();
+    EXPECT_EQ(selected.CountOpcode(MOpcode::VPMULLD), 1);
+    EXPECT_GE(selected.CountOpcode(MOpcode::VPADDD), 2);
+    EXPECT_EQ(selected.CountOpcode(MOpcode::VEXTRACTI128), 1);
+    EXPECT_EQ(selected.CountOpcode(MOpcode::VINSERTI128), 1);
+    EXPECT_EQ(selected.CountOpcode(MOpcode::PADDD), 0);
+}
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include "irbuilder.hpp"
+#include "Instr/visitor.hpp"
+#include "Interpreter/interpreter.hpp"
+
+static_assert(IsCommutative(OpType::ADD) && IsCommutative(OpType::MUL) && IsCommutative(OpType::AND));
+static_assert(!IsCommutative(OpType::SUB) && !IsCommutative(OpType::CMP));
+static_assert(HasSideEffects(OpType::DIV) && HasSideEffects(OpType::DEOPT) && !HasSideEffects(OpType::ADD));
+static_assert(IsTerminator(OpType::JMP) && IsTerminator(OpType::JE) && IsTerminator(OpType::RET));
+static_assert(!IsTerminator(OpType::DEOPT) && !IsTerminator(OpType::PHI));
+static_assert(GetOperandsCount(OpType::ADD) == 2 && GetOperandsCount(OpType::JA) == 1);
+static_assert(GetOperandsCount(OpType::CONST) == 0 && GetOperandsCount(OpType::PHI) == -1);
+
+static_assert(IsInstanceOf<CjmpInstr>(OpType::JAE) && IsInstanceOf<ArithmeticInstr>(OpType::CMP));
+static_assert(IsInstanceOf<Instruction>(OpType::MOV) && !IsInstanceOf<AddInstr>(OpType::AND));
+static_assert(!IsInstanceOf<CjmpInstr>(OpType::JMP) && !IsInstanceOf<ArithmeticInstr>(OpType::PHI));
+
+class VisitorTest: public ::testing::Test {
+protected:
+    Graph graph_;
+};
+
+TEST_F(VisitorTest, AS_CHECKS_OPCODE) {
+    IrBuilder builder(&graph_);
+    auto *entry = builder.CreateBB();
+    auto *exit = builder.CreateBB();
+    builder.SetBasicBlockScope(entry);
+    auto *a = builder.CreateParameter(0);
+    auto *b = builder.CreateParameter(1);
+    auto *andInstr = builder.CreateAnd(DataType::U32, a, b);
+    auto *cmp = builder.CreateCmp(andInstr, b);
+    auto *branch = builder.CreateJe(cmp, exit, exit);
+
+    EXPECT_EQ(andInstr->As<AndInstr>(), andInstr);
+    EXPECT_EQ(andInstr->As<ArithmeticInstr>(), andInstr);
+    EXPECT_EQ(andInstr->As<AddInstr>(), nullptr);
+    EXPECT_EQ(cmp->As<CmpInstr>(), cmp);
+    EXPECT_EQ(branch->As<CjmpInstr>(), branch);
+    EXPECT_EQ(branch->As<JaInstr>(), nullptr);
+    EXPECT_EQ(branch->As<JmpInstr>(), nullptr);
+    EXPECT_NE(static_cast<const Instruction*>(a)->As<ParameterInstr>(), nullptr);
+    EXPECT_TRUE(branch->IsBranch());
+    EXPECT_FALSE(andInstr->IsBranch());
+}
+
+TEST_F(VisitorTest, DISPATCH_PICKS_MOST_SPECIFIC_HANDLER) {
+    IrBuilder builder(&graph_);
+    auto *entry = builder.CreateBB();
+    auto *exit = builder.CreateBB();
+    builder.SetBasicBlockScope(entry);
+    auto *a = builder.CreateParameter(0);
+    auto *c = builder.CreateInt32Constant(7);
+    auto *sum = builder.CreateAdd(DataType::U32, a, c);
+    auto *cmp = builder.CreateCmp(sum, c);
+    auto *branch = builder.CreateJa(cmp, exit, exit);
+    builder.SetBasicBlockScope(exit);
+    auto *ret = builder.CreateRet(DataType::U32, sum);
+
+    auto kind = [](Instruction* instr) {
+        return VisitInstruction(instr, Overloaded{
+            [](ConstantInstr* constant) { return static_cast<int>(constant->GetAsUnsignedInt()); },
+            [](AddInstr*) { return 1; },
+            [](ArithmeticInstr*) { return 2; },
+            [](CjmpInstr*) { return 3; },
+            [](Instruction*) { return 0; },
+        });
+    };
+    EXPECT_EQ(kind(c), 7);
+    EXPECT_EQ(kind(sum), 1);
+    EXPECT_EQ(kind(cmp), 2);
+    EXPECT_EQ(kind(branch), 3);
+    EXPECT_EQ(kind(a), 0);
+    EXPECT_EQ(kind(ret), 0);
+}
+
+TEST_F(VisitorTest, AND_HAS_ITS_OWN_OPCODE) {
+    IrBuilder builder(&graph_);
+    builder.SetBasicBlockScope(builder.CreateBB());
+    auto *a = builder.CreateParameter(0);
+    auto *b = builder.CreateParameter(1);
+    auto *andInstr = builder.CreateAnd(DataType::U32, a, b);
+    builder.CreateRet(DataType::U32, andInstr);
+
+    EXPECT_EQ(andInstr->GetOpType(), OpType::AND);
+    Interpreter interpreter(&graph_);
+    EXPECT_EQ(interpreter.Run({0b1100, 0b1010}), 0b1000u);
+}